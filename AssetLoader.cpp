@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "AssetLoader.h"
+#include <cassert>
+#include <iomanip>
+
+namespace dae
+{
+	AssetLoader::AssetLoader(ThreadPool* pThreadPool)
+		: m_pThreadPool{ pThreadPool }
+	{
+		assert(pThreadPool && "AssetLoader needs a thread pool");
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		for (PendingLoad& pending : m_Pending)
+			pending.work.wait();
+	}
+
+	bool AssetLoader::Update()
+	{
+		for (size_t i{}; i < m_Pending.size();)
+		{
+			PendingLoad& pending = m_Pending[i];
+			if (pending.work.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+			{
+				++i;
+				continue;
+			}
+
+			//Rethrows what the worker threw
+			pending.work.get();
+			pending.finish();
+			pending.pEntry->residentMs = GetElapsedMs(m_Start);
+			m_Finished.push_back(std::move(pending.pEntry));
+
+			m_Pending[i] = std::move(m_Pending.back());
+			m_Pending.pop_back();
+		}
+		return !m_Pending.empty();
+	}
+
+	void AssetLoader::MarkFirstFrame()
+	{
+		if (m_FirstFrameMs < 0.0)
+			m_FirstFrameMs = GetElapsedMs(m_Start);
+	}
+
+	void AssetLoader::PrintTimeline() const
+	{
+		if (m_Finished.empty())
+			return;
+
+		//In the order they were queued, not finished
+		std::vector<std::shared_ptr<TimelineEntry>> entries{ m_Finished };
+		std::sort(entries.begin(), entries.end(), [](const auto& pA, const auto& pB) { return pA->queuedMs < pB->queuedMs; });
+
+		double endMs{}, loadMs{}, firstLoadStartMs{ INFINITY };
+		for (const auto& pEntry : entries)
+		{
+			endMs = std::max(endMs, pEntry->residentMs);
+			loadMs += pEntry->loadEndMs - pEntry->loadStartMs;
+			firstLoadStartMs = std::min(firstLoadStartMs, pEntry->loadStartMs);
+		}
+
+		//One column per slice of the total, '.' queued, '=' loading on a worker, '+' waiting to be made resident
+		constexpr int numColumns{ 48 };
+		const auto toColumn = [&](double ms) { return std::clamp(static_cast<int>(ms / endMs * numColumns), 0, numColumns - 1); };
+
+		const std::ios::fmtflags flags = std::cout.flags();
+		const std::streamsize precision = std::cout.precision();
+		std::cout << "--- Asset loading timeline (ms since startup) ---\n";
+		std::cout << std::fixed << std::setprecision(1);
+		for (const auto& pEntry : entries)
+		{
+			std::string bar(numColumns, ' ');
+			for (int column{ toColumn(pEntry->queuedMs) }; column < toColumn(pEntry->loadStartMs); ++column)
+				bar[column] = '.';
+			for (int column{ toColumn(pEntry->loadStartMs) }; column <= toColumn(pEntry->loadEndMs); ++column)
+				bar[column] = '=';
+			for (int column{ toColumn(pEntry->loadEndMs) + 1 }; column <= toColumn(pEntry->residentMs); ++column)
+				bar[column] = '+';
+
+			std::cout << std::left << std::setw(20) << pEntry->name << std::right
+				<< " queued " << std::setw(7) << pEntry->queuedMs
+				<< " loaded " << std::setw(7) << pEntry->loadStartMs << " - " << std::setw(7) << pEntry->loadEndMs
+				<< " resident " << std::setw(7) << pEntry->residentMs << " |" << bar << "|\n";
+		}
+
+		//Above 1 means loads ran side by side, the serial path would have taken about the summed time
+		const double wallMs = endMs - firstLoadStartMs;
+		std::cout << "Load work " << loadMs << " ms in " << wallMs << " ms wall, " << std::setprecision(2)
+			<< (wallMs > 0.0 ? loadMs / wallMs : 1.0) << "x overlap on " << m_pThreadPool->GetNumWorkers() << " workers\n";
+		std::cout << std::setprecision(1);
+		if (m_FirstFrameMs >= 0.0)
+			std::cout << "First frame at " << m_FirstFrameMs << " ms, all assets resident at " << endMs << " ms\n";
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	double AssetLoader::GetElapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
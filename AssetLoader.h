@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace dae
+{
+	//Runs asset imports on the thread pool and hands the results back on the thread that polls it, so GPU resources
+	//get created as soon as each one is decoded. Every step is timed for the startup timeline.
+	class AssetLoader final
+	{
+	public:
+		AssetLoader(ThreadPool* pThreadPool);
+		//Waits for the imports still running, their results are dropped
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) noexcept = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader& operator=(AssetLoader&&) noexcept = delete;
+
+		//load runs on a worker, onReady on the thread calling Update once load returned (with nullptr if it failed)
+		template<typename Asset>
+		void Load(const std::string& name, std::function<std::unique_ptr<Asset>()> load, std::function<void(std::unique_ptr<Asset>)> onReady)
+		{
+			const auto pEntry = std::make_shared<TimelineEntry>();
+			pEntry->name = name;
+			pEntry->queuedMs = GetElapsedMs(m_Start);
+
+			//Only shared state is captured, the work never touches the loader itself
+			const auto pResult = std::make_shared<std::unique_ptr<Asset>>();
+			PendingLoad pending{};
+			pending.pEntry = pEntry;
+			pending.work = m_pThreadPool->Submit([start = m_Start, pEntry, pResult, load = std::move(load)]()
+				{
+					pEntry->loadStartMs = GetElapsedMs(start);
+					*pResult = load();
+					pEntry->loadEndMs = GetElapsedMs(start);
+				});
+			pending.finish = [pResult, onReady = std::move(onReady)]() { onReady(std::move(*pResult)); };
+			m_Pending.push_back(std::move(pending));
+		}
+
+		//Finishes every load that is done, returns true while any is still pending
+		bool Update();
+		//The first presented frame, to show how much of the loading it didn't wait for
+		void MarkFirstFrame();
+		//Per asset: queued, decoded on a worker and resident on the GPU, with the overlap between them
+		void PrintTimeline() const;
+
+	private:
+		struct TimelineEntry
+		{
+			std::string name{};
+			double queuedMs{};
+			double loadStartMs{};
+			double loadEndMs{};
+			double residentMs{};
+		};
+
+		struct PendingLoad
+		{
+			std::shared_ptr<TimelineEntry> pEntry{};
+			std::future<void> work{};
+			std::function<void()> finish{};
+		};
+
+		ThreadPool* m_pThreadPool{};
+		std::chrono::steady_clock::time_point m_Start{ std::chrono::steady_clock::now() };
+		std::vector<PendingLoad> m_Pending{};
+		std::vector<std::shared_ptr<TimelineEntry>> m_Finished{};
+		double m_FirstFrameMs{ -1.0 };
+
+		static double GetElapsedMs(std::chrono::steady_clock::time_point start);
+	};
+}
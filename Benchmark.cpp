@@ -0,0 +1,2530 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "Utils.h"
+#include "AssetLoader.h"
+#include "ThreadPool.h"
+#include "MeshAsset.h"
+#include "MeshOptimizer.h"
+#include "Quantization.h"
+#include "IndexPacking.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "MipMaps.h"
+#include "TextureAsset.h"
+#ifndef DAE_CPU_ONLY
+#include "TextureManager.h"
+#endif
+#include "TextureStreamer.h"
+#include "CPUTexture.h"
+#include "SoftwareRasterizer.h"
+#include "VertexProcessing.h"
+#include "DepthFormat.h"
+#include "Camera.h"
+#include <array>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+
+namespace dae
+{
+	namespace
+	{
+		//Fastest of a number of runs in milliseconds, which is the least noisy figure for load-style work
+		double MeasureBestMs(int iterations, const std::function<void()>& function)
+		{
+			double bestMs{ DBL_MAX };
+			for (int i{}; i < iterations; ++i)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				function();
+				const auto end = std::chrono::steady_clock::now();
+				bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(end - start).count());
+			}
+			return bestMs;
+		}
+
+		std::string GetArgument(const std::vector<std::string>& arguments, size_t index, const std::string& defaultValue)
+		{
+			return index < arguments.size() ? arguments[index] : defaultValue;
+		}
+
+		int GetArgument(const std::vector<std::string>& arguments, size_t index, int defaultValue)
+		{
+			return index < arguments.size() ? std::stoi(arguments[index]) : defaultValue;
+		}
+
+		float GetArgument(const std::vector<std::string>& arguments, size_t index, float defaultValue)
+		{
+			return index < arguments.size() ? std::stof(arguments[index]) : defaultValue;
+		}
+
+		//Closest point on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+		Vector3 ClosestPointOnTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c)
+		{
+			const Vector3 ab = b - a, ac = c - a, ap = p - a;
+			const float d1 = Vector3::Dot(ab, ap), d2 = Vector3::Dot(ac, ap);
+			if (d1 <= 0.f && d2 <= 0.f)
+				return a;
+
+			const Vector3 bp = p - b;
+			const float d3 = Vector3::Dot(ab, bp), d4 = Vector3::Dot(ac, bp);
+			if (d3 >= 0.f && d4 <= d3)
+				return b;
+
+			const float vc = d1 * d4 - d3 * d2;
+			if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+				return a + ab * (d1 / (d1 - d3));
+
+			const Vector3 cp = p - c;
+			const float d5 = Vector3::Dot(ab, cp), d6 = Vector3::Dot(ac, cp);
+			if (d6 >= 0.f && d5 <= d6)
+				return c;
+
+			const float vb = d5 * d2 - d1 * d6;
+			if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+				return a + ac * (d2 / (d2 - d6));
+
+			const float va = d3 * d6 - d5 * d4;
+			if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+				return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+			const float denominator = 1.f / (va + vb + vc);
+			return a + ab * (vb * denominator) + ac * (vc * denominator);
+		}
+
+		//Uniform grid over the triangles of a mesh for nearest surface point queries
+		class SurfaceGrid final
+		{
+		public:
+			SurfaceGrid(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const BoundingBox& bounds)
+				: m_Vertices{ vertices }
+				, m_Indices{ indices }
+				, m_Min{ bounds.min }
+			{
+				const Vector3 extent = bounds.max - bounds.min;
+				const float maxExtent = std::max({ extent.x, extent.y, extent.z, FLT_EPSILON });
+				const float cellsPerUnit = std::clamp(std::cbrt(static_cast<float>(indices.size() / 3)), 1.f, 64.f) / maxExtent;
+				m_CellSize = 1.f / cellsPerUnit;
+				for (int axis{}; axis < 3; ++axis)
+					m_NumCells[axis] = std::max(1, static_cast<int>(std::ceil(extent[axis] * cellsPerUnit)));
+
+				//Counting sort of the triangles into every cell their bounds touch
+				std::vector<std::pair<uint32_t, uint32_t>> cellTriangles{};
+				for (uint32_t i{}; i < indices.size(); i += 3)
+				{
+					int minCell[3]{}, maxCell[3]{};
+					for (int axis{}; axis < 3; ++axis)
+					{
+						const float low = std::min({ vertices[indices[i]].position[axis], vertices[indices[i + 1]].position[axis], vertices[indices[i + 2]].position[axis] });
+						const float high = std::max({ vertices[indices[i]].position[axis], vertices[indices[i + 1]].position[axis], vertices[indices[i + 2]].position[axis] });
+						minCell[axis] = GetCell(low, axis);
+						maxCell[axis] = GetCell(high, axis);
+					}
+					for (int z{ minCell[2] }; z <= maxCell[2]; ++z)
+						for (int y{ minCell[1] }; y <= maxCell[1]; ++y)
+							for (int x{ minCell[0] }; x <= maxCell[0]; ++x)
+								cellTriangles.emplace_back(GetCellIndex(x, y, z), i / 3);
+				}
+				std::sort(cellTriangles.begin(), cellTriangles.end());
+
+				m_CellOffsets.assign(static_cast<size_t>(m_NumCells[0]) * m_NumCells[1] * m_NumCells[2] + 1, 0);
+				for (const auto& cellTriangle : cellTriangles)
+					++m_CellOffsets[cellTriangle.first + 1];
+				for (size_t i{ 1 }; i < m_CellOffsets.size(); ++i)
+					m_CellOffsets[i] += m_CellOffsets[i - 1];
+				m_CellTriangles.reserve(cellTriangles.size());
+				for (const auto& cellTriangle : cellTriangles)
+					m_CellTriangles.push_back(cellTriangle.second);
+			}
+
+			//Searches rings of cells around the point until no closer triangle can be left
+			float GetDistance(const Vector3& point) const
+			{
+				const int center[3]{ GetCell(point.x, 0), GetCell(point.y, 1), GetCell(point.z, 2) };
+				const int maxRing = std::max({ m_NumCells[0], m_NumCells[1], m_NumCells[2] });
+				float bestSquared{ FLT_MAX };
+				for (int ring{}; ring <= maxRing; ++ring)
+				{
+					for (int z{ center[2] - ring }; z <= center[2] + ring; ++z)
+					{
+						for (int y{ center[1] - ring }; y <= center[1] + ring; ++y)
+						{
+							for (int x{ center[0] - ring }; x <= center[0] + ring; ++x)
+							{
+								const bool isShell = std::abs(x - center[0]) == ring || std::abs(y - center[1]) == ring || std::abs(z - center[2]) == ring;
+								if (!isShell || x < 0 || y < 0 || z < 0 || x >= m_NumCells[0] || y >= m_NumCells[1] || z >= m_NumCells[2])
+									continue;
+
+								const uint32_t cell = GetCellIndex(x, y, z);
+								for (uint32_t t{ m_CellOffsets[cell] }; t < m_CellOffsets[cell + 1]; ++t)
+								{
+									const uint32_t* pTriangle = &m_Indices[m_CellTriangles[t] * 3];
+									const Vector3 closest = ClosestPointOnTriangle(point, m_Vertices[pTriangle[0]].position,
+										m_Vertices[pTriangle[1]].position, m_Vertices[pTriangle[2]].position);
+									bestSquared = std::min(bestSquared, (closest - point).SqrMagnitude());
+								}
+							}
+						}
+					}
+
+					//Everything outside this ring is at least ring cells away
+					const float reach = ring * m_CellSize;
+					if (bestSquared <= reach * reach)
+						break;
+				}
+				return std::sqrt(bestSquared);
+			}
+
+		private:
+			std::span<const Vertex> m_Vertices;
+			std::span<const uint32_t> m_Indices;
+			Vector3 m_Min;
+			float m_CellSize{};
+			int m_NumCells[3]{};
+			std::vector<uint32_t> m_CellOffsets{};
+			std::vector<uint32_t> m_CellTriangles{};
+
+			int GetCell(float value, int axis) const
+			{
+				return std::clamp(static_cast<int>((value - m_Min[axis]) / m_CellSize), 0, m_NumCells[axis] - 1);
+			}
+
+			uint32_t GetCellIndex(int x, int y, int z) const
+			{
+				return static_cast<uint32_t>((z * m_NumCells[1] + y) * m_NumCells[0] + x);
+			}
+		};
+	}
+
+	namespace Benchmark
+	{
+		bool Run(const std::vector<std::string>& arguments)
+		{
+			const std::string defaultMesh{ "Resources/vehicle.obj" };
+			const std::string name = GetArgument(arguments, 0, std::string{});
+
+			if (name == "obj")
+			{
+				OBJParsing(GetArgument(arguments, 1, defaultMesh), GetArgument(arguments, 2, 5));
+				return true;
+			}
+
+			if (name == "weld")
+			{
+				VertexWelding(GetArgument(arguments, 1, defaultMesh), GetArgument(arguments, 2, 5));
+				return true;
+			}
+
+			if (name == "objthreads")
+			{
+				OBJThreadScaling(GetArgument(arguments, 1, defaultMesh), GetArgument(arguments, 2, 3));
+				return true;
+			}
+
+			if (name == "meshcache")
+			{
+				MeshCacheStartup(GetArgument(arguments, 1, defaultMesh), GetArgument(arguments, 2, 5));
+				return true;
+			}
+
+			if (name == "meshopt")
+			{
+				MeshOptimization(GetArgument(arguments, 1, defaultMesh));
+				return true;
+			}
+
+			if (name == "quantize")
+			{
+				VertexQuantization(GetArgument(arguments, 1, defaultMesh));
+				return true;
+			}
+
+			if (name == "indices")
+			{
+				IndexPacking16(GetArgument(arguments, 1, defaultMesh));
+				return true;
+			}
+
+			if (name == "simplify")
+			{
+				MeshSimplification(GetArgument(arguments, 1, defaultMesh));
+				return true;
+			}
+
+			if (name == "meshlets")
+			{
+				MeshletCulling(GetArgument(arguments, 1, defaultMesh));
+				return true;
+			}
+
+			if (name == "mips")
+			{
+				MipGeneration(GetArgument(arguments, 1, 2048));
+				return true;
+			}
+
+			if (name == "bc")
+			{
+				TextureCompression(GetArgument(arguments, 1, std::string{ "Resources" }));
+				return true;
+			}
+
+			if (name == "startup")
+			{
+				AsyncStartup(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, -1));
+				return true;
+			}
+
+			if (name == "textures")
+			{
+				TextureSharing(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 16));
+				return true;
+			}
+
+			if (name == "packing")
+			{
+				ChannelPacking(GetArgument(arguments, 1, std::string{ "Resources" }));
+				return true;
+			}
+
+			if (name == "streaming")
+			{
+				TextureStreaming(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 2048));
+				return true;
+			}
+
+			if (name == "texlayout")
+			{
+				TexelLayouts(GetArgument(arguments, 1, 4096));
+				return true;
+			}
+
+			if (name == "software")
+			{
+				SoftwareRendering(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 60), GetArgument(arguments, 3, std::string{}));
+				return true;
+			}
+
+			if (name == "rasterscaling")
+			{
+				RasterScaling(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))),
+					GetArgument(arguments, 3, 10));
+				return true;
+			}
+
+			if (name == "rasterkernel")
+			{
+				RasterKernels(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 300), GetArgument(arguments, 3, 1));
+				return true;
+			}
+
+			if (name == "hiz")
+			{
+				HierarchicalZ(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 10));
+				return true;
+			}
+
+			if (name == "shading")
+			{
+				ShadingKernels(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 5));
+				return true;
+			}
+
+			if (name == "vertices")
+			{
+				VertexProcessing(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 20));
+				return true;
+			}
+
+			if (name == "clipping")
+			{
+				Clipping(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 10));
+				return true;
+			}
+
+			if (name == "setup")
+			{
+				TriangleSetup(GetArgument(arguments, 1, std::string{ "Resources" }), GetArgument(arguments, 2, 10));
+				return true;
+			}
+
+			if (name == "depth")
+			{
+				DepthPrecision(GetArgument(arguments, 1, 0.1f), GetArgument(arguments, 2, 100.f), GetArgument(arguments, 3, 0.001f));
+				return true;
+			}
+
+			std::cout << "Unknown benchmark \"" << name << "\", available: obj, weld, objthreads, meshcache, meshopt, quantize, indices, simplify, meshlets, mips, bc, startup, textures, packing, streaming, texlayout, software, rasterscaling, rasterkernel, hiz, shading, vertices, clipping, setup, depth\n";
+			return false;
+		}
+
+		void OBJParsing(const std::string& filename, int iterations)
+		{
+			std::ifstream file(filename, std::ios::binary | std::ios::ate);
+			if (!file)
+			{
+				std::cout << "Couldn't open " << filename << "\n";
+				return;
+			}
+			const double megaBytes = static_cast<double>(file.tellg()) / (1024.0 * 1024.0);
+
+			std::vector<Vertex> referenceVertices{}, vertices{};
+			std::vector<uint32_t> referenceIndices{}, indices{};
+
+			const double referenceMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJReference(filename, referenceVertices, referenceIndices); });
+			const double mappedMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJ(filename, vertices, indices, { .weldVertices = false }); });
+
+			const bool isIdentical = vertices.size() == referenceVertices.size() && indices == referenceIndices &&
+				std::memcmp(vertices.data(), referenceVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+
+			const double triangles = static_cast<double>(indices.size() / 3);
+			std::cout << std::fixed << std::setprecision(2)
+				<< "OBJ parsing: " << filename << " (" << megaBytes << " MB, " << indices.size() / 3 << " triangles, best of " << iterations << ")\n"
+				<< "  reference (ifstream): " << referenceMs << " ms, " << megaBytes / (referenceMs / 1000.0) << " MB/s, "
+				<< triangles / (referenceMs / 1000.0) / 1e6 << " Mtris/s\n"
+				<< "  memory-mapped:        " << mappedMs << " ms, " << megaBytes / (mappedMs / 1000.0) << " MB/s, "
+				<< triangles / (mappedMs / 1000.0) / 1e6 << " Mtris/s\n"
+				<< "  speedup: " << referenceMs / mappedMs << "x, output identical: " << (isIdentical ? "yes" : "no") << "\n";
+		}
+
+		void VertexWelding(const std::string& filename, int iterations)
+		{
+			std::vector<Vertex> vertices{}, weldedVertices{};
+			std::vector<uint32_t> indices{}, weldedIndices{};
+
+			const double unweldedMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJ(filename, vertices, indices, { .weldVertices = false }); });
+			const double weldedMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJ(filename, weldedVertices, weldedIndices); });
+			if (vertices.empty())
+			{
+				std::cout << "Couldn't load " << filename << "\n";
+				return;
+			}
+
+			const double reduction = 100.0 * (1.0 - static_cast<double>(weldedVertices.size()) / vertices.size());
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Vertex welding: " << filename << " (" << indices.size() / 3 << " triangles, best of " << iterations << ")\n"
+				<< "  unwelded: " << vertices.size() << " vertices, " << vertices.size() * sizeof(Vertex) / 1024 << " KB, " << unweldedMs << " ms\n"
+				<< "  welded:   " << weldedVertices.size() << " vertices, " << weldedVertices.size() * sizeof(Vertex) / 1024 << " KB, " << weldedMs << " ms\n"
+				<< "  vertex count reduced by " << reduction << "%\n";
+		}
+
+		void OBJThreadScaling(const std::string& filename, int iterations)
+		{
+			std::vector<Vertex> serialVertices{};
+			std::vector<uint32_t> serialIndices{};
+			const double serialMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJ(filename, serialVertices, serialIndices); });
+			if (serialVertices.empty())
+			{
+				std::cout << "Couldn't load " << filename << "\n";
+				return;
+			}
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< "OBJ thread scaling: " << filename << " (" << serialIndices.size() / 3 << " triangles, best of " << iterations << ")\n"
+				<< "  serial:     " << serialMs << " ms\n";
+
+			const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+			for (uint32_t numThreads{ 1 }; numThreads <= maxThreads; numThreads = numThreads < maxThreads ? std::min(numThreads * 2, maxThreads) : numThreads + 1)
+			{
+				ThreadPool threadPool{ numThreads - 1 };
+				std::vector<Vertex> vertices{};
+				std::vector<uint32_t> indices{};
+				const double parallelMs = MeasureBestMs(iterations, [&]() { Utils::ParseOBJ(filename, vertices, indices, { .pThreadPool = &threadPool }); });
+
+				const bool isIdentical = indices == serialIndices && vertices.size() == serialVertices.size() &&
+					std::memcmp(vertices.data(), serialVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+				std::cout << "  " << std::setw(2) << numThreads << " threads: " << parallelMs << " ms, " << serialMs / parallelMs
+					<< "x, identical to serial: " << (isIdentical ? "yes" : "no") << "\n";
+			}
+		}
+
+		void MeshCacheStartup(const std::string& filename, int iterations)
+		{
+			ThreadPool threadPool{};
+			const MeshImportOptions options{ .obj = { .pThreadPool = &threadPool } };
+			const std::string cachePath = MeshAsset::GetCachePath(filename);
+
+			size_t numVertices{}, numIndices{};
+			bool isCold{ true };
+			const double coldMs = MeasureBestMs(iterations, [&]()
+				{
+					std::filesystem::remove(cachePath);
+					const auto pAsset = MeshAsset::Load(filename, options);
+					isCold = isCold && pAsset && !pAsset->IsFromCache();
+				});
+
+			bool isWarm{ true };
+			const double warmMs = MeasureBestMs(iterations, [&]()
+				{
+					const auto pAsset = MeshAsset::Load(filename, options);
+					isWarm = isWarm && pAsset && pAsset->IsFromCache();
+					if (pAsset)
+					{
+						numVertices = pAsset->GetVertices().size();
+						numIndices = pAsset->GetIndices().size();
+					}
+				});
+
+			if (!isCold || !isWarm)
+			{
+				std::cout << "Couldn't load or cache " << filename << "\n";
+				return;
+			}
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Mesh cache: " << filename << " -> " << cachePath << " (" << numVertices << " vertices, " << numIndices / 3
+				<< " triangles, " << std::filesystem::file_size(cachePath) / 1024 << " KB, best of " << iterations << ")\n"
+				<< "  cold start (parse + write cache): " << coldMs << " ms\n"
+				<< "  warm start (hash + map cache):    " << warmMs << " ms\n"
+				<< "  saved " << coldMs - warmMs << " ms (" << coldMs / warmMs << "x)\n";
+		}
+
+		void MeshOptimization(const std::string& filename)
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!Utils::ParseOBJ(filename, vertices, indices))
+			{
+				std::cout << "Couldn't load " << filename << "\n";
+				return;
+			}
+
+			std::cout << std::fixed << std::setprecision(3)
+				<< "Mesh optimization: " << filename << " (" << vertices.size() << " vertices, " << indices.size() / 3 << " triangles)\n"
+				<< "  stage            ACMR(16)  ACMR(32)  ATVR(16)  overdraw      ms\n";
+
+			const auto report = [&](const char* pStage, double ms)
+				{
+					const MeshOptimizer::VertexCacheStats cache16 = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), 16);
+					const MeshOptimizer::VertexCacheStats cache32 = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), 32);
+					const MeshOptimizer::OverdrawStats overdraw = MeshOptimizer::AnalyzeOverdraw(indices, vertices);
+					std::cout << "  " << std::left << std::setw(15) << pStage << std::right
+						<< std::setw(10) << cache16.acmr << std::setw(10) << cache32.acmr << std::setw(10) << cache16.atvr
+						<< std::setw(10) << overdraw.overdraw << std::setw(10) << std::setprecision(2) << ms << std::setprecision(3) << "\n";
+				};
+
+			report("original", 0.0);
+			report("vertex cache", MeasureBestMs(1, [&]() { MeshOptimizer::OptimizeVertexCache(indices, vertices.size()); }));
+			report("overdraw", MeasureBestMs(1, [&]() { MeshOptimizer::OptimizeOverdraw(indices, vertices); }));
+			report("vertex fetch", MeasureBestMs(1, [&]() { MeshOptimizer::OptimizeVertexFetch(vertices, indices); }));
+		}
+
+		void VertexQuantization(const std::string& filename)
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!Utils::ParseOBJ(filename, vertices, indices) || vertices.empty())
+			{
+				std::cout << "Couldn't load " << filename << "\n";
+				return;
+			}
+
+			BoundingBox bounds{};
+			for (const Vertex& vertex : vertices)
+				bounds.Grow(vertex.position);
+			const Quantization::PositionDequantization dequantization = Quantization::GetPositionDequantization(bounds);
+
+			//Half a quantization step per axis, with some slack for the float math
+			Vector3 maxPositionError{}, positionBound{};
+			for (int i{}; i < 3; ++i)
+				positionBound[i] = dequantization.scale[i] / 65535.f * 0.5f * 1.001f + FLT_EPSILON * std::max(std::abs(bounds.min[i]), std::abs(bounds.max[i]));
+
+			float maxUVRelativeError{}, maxNormalDegrees{}, maxTangentDegrees{};
+			bool isUVInBounds{ true };
+			const auto angleDegrees = [](const Vector3& original, const Vector3& decoded)
+				{
+					const float length = original.Magnitude();
+					if (length <= 0.f)
+						return 0.f;
+					return std::acos(Clamp(Vector3::Dot(original / length, decoded), -1.f, 1.f)) * TO_DEGREES;
+				};
+
+			for (const Vertex& vertex : vertices)
+			{
+				const Vertex decoded = Quantization::DecodeVertex(Quantization::EncodeVertex(vertex, dequantization), dequantization);
+
+				for (int i{}; i < 3; ++i)
+					maxPositionError[i] = std::max(maxPositionError[i], std::abs(decoded.position[i] - vertex.position[i]));
+
+				//Half floats keep 11 significant bits, so the rounding error is at most 2^-11 relative (or 2^-25 absolute for denormals)
+				for (int i{}; i < 2; ++i)
+				{
+					const float error = std::abs(decoded.uv[i] - vertex.uv[i]);
+					isUVInBounds = isUVInBounds && error <= std::max(std::abs(vertex.uv[i]) * 0x1p-11f, 0x1p-25f);
+					if (vertex.uv[i] != 0.f)
+						maxUVRelativeError = std::max(maxUVRelativeError, error / std::abs(vertex.uv[i]));
+				}
+
+				maxNormalDegrees = std::max(maxNormalDegrees, angleDegrees(vertex.normal, decoded.normal));
+				maxTangentDegrees = std::max(maxTangentDegrees, angleDegrees(vertex.tangent, decoded.tangent));
+			}
+
+			//Every finite half has to survive half -> float -> half unchanged
+			bool isHalfExact{ true };
+			for (uint32_t half{}; half <= 0xFFFFu; ++half)
+			{
+				if ((half & 0x7C00u) == 0x7C00u && (half & 0x3FFu) != 0)
+					continue;
+				isHalfExact = isHalfExact && Quantization::FloatToHalf(Quantization::HalfToFloat(static_cast<uint16_t>(half))) == half;
+			}
+
+			//SNORM16 octahedral cells are 1/32767 wide, the sphere stretches them to at most ~0.03 degrees
+			constexpr float maxAngleBound{ 0.04f };
+			const bool isPositionInBounds = maxPositionError.x <= positionBound.x && maxPositionError.y <= positionBound.y && maxPositionError.z <= positionBound.z;
+			const bool isNormalInBounds = maxNormalDegrees <= maxAngleBound && maxTangentDegrees <= maxAngleBound;
+
+			const size_t fullBytes = vertices.size() * sizeof(Vertex);
+			const size_t compactBytes = vertices.size() * sizeof(VertexCompact);
+			std::cout << std::setprecision(6)
+				<< "Vertex quantization: " << filename << " (" << vertices.size() << " vertices)\n"
+				<< "  position error:  " << maxPositionError.x << ", " << maxPositionError.y << ", " << maxPositionError.z
+				<< " (bound " << positionBound.x << ", " << positionBound.y << ", " << positionBound.z << ") " << (isPositionInBounds ? "ok" : "FAILED") << "\n"
+				<< "  uv error:        " << maxUVRelativeError << " relative (bound " << 0x1p-11f << ") " << (isUVInBounds ? "ok" : "FAILED") << "\n"
+				<< "  normal error:    " << maxNormalDegrees << " deg, tangent error: " << maxTangentDegrees << " deg (bound "
+				<< maxAngleBound << ") " << (isNormalInBounds ? "ok" : "FAILED") << "\n"
+				<< "  half round trip: " << (isHalfExact ? "ok" : "FAILED") << "\n"
+				<< "  " << sizeof(Vertex) << " -> " << sizeof(VertexCompact) << " bytes per vertex, " << fullBytes / 1024 << " KB -> "
+				<< compactBytes / 1024 << " KB (saved " << (fullBytes - compactBytes) / 1024 << " KB, "
+				<< std::setprecision(1) << std::fixed << 100.0 * (fullBytes - compactBytes) / fullBytes << "%)\n";
+		}
+
+		void IndexPacking16(const std::string& filename)
+		{
+			std::cout << std::fixed << std::setprecision(2) << "16-bit index packing\n"
+				<< "  mesh                      vertices  triangles  ranges  drawn from  32-bit KB  16-bit KB      ms  draws exact\n";
+
+			const auto report = [](const std::string& meshName, std::span<const uint32_t> indices, size_t numVertices)
+				{
+					IndexPacking::PackedIndices packed{};
+					const double ms = MeasureBestMs(3, [&]() { packed = IndexPacking::PackIndices16(indices, numVertices); });
+					const bool isExact = IndexPacking::ValidateDrawRanges(packed, indices, numVertices);
+
+					//Rebuilt vertex buffers store the vertices shared by two ranges twice (and drop unused ones)
+					const size_t numDrawnVertices = IndexPacking::GetNumVertices(packed, numVertices);
+					const size_t bytes32 = indices.size() * sizeof(uint32_t);
+					const size_t bytes16 = packed.indices.size() * sizeof(uint16_t);
+					std::cout << "  " << std::left << std::setw(24) << meshName << std::right << std::setw(10) << numVertices
+						<< std::setw(11) << indices.size() / 3 << std::setw(8) << packed.ranges.size() << std::setw(12) << numDrawnVertices
+						<< std::setw(11) << bytes32 / 1024.0 << std::setw(11) << bytes16 / 1024.0 << std::setw(8) << ms
+						<< "  " << (isExact ? "yes" : "NO") << "\n";
+				};
+
+			//Same optimized data the renderer hands to Mesh
+			if (const auto pAsset = MeshAsset::Load(filename))
+			{
+				report(std::filesystem::path{ filename }.filename().string(), pAsset->GetIndices(), pAsset->GetVertices().size());
+			}
+			else
+			{
+				std::cout << "  Couldn't load " << filename << "\n";
+			}
+
+			//Strip over 300k vertices: every triangle is local, so only range splits are needed
+			constexpr uint32_t numSyntheticVertices{ 300'000 };
+			std::vector<uint32_t> stripIndices{};
+			for (uint32_t i{}; i + 2 < numSyntheticVertices; ++i)
+				stripIndices.insert(stripIndices.end(), { i, i + 1, i + 2 });
+			report("strip (300k)", stripIndices, numSyntheticVertices);
+
+			//Uniformly random corners: worst case, no window fits so every range gets its own vertices
+			std::mt19937 random{ 7 };
+			std::uniform_int_distribution<uint32_t> distribution{ 0, numSyntheticVertices - 1 };
+			std::vector<uint32_t> randomIndices(300'000);
+			for (uint32_t& index : randomIndices)
+				index = distribution(random);
+			report("random (300k)", randomIndices, numSyntheticVertices);
+
+			//Local triangles with an occasional long jump back to the first vertices
+			std::vector<uint32_t> mixedIndices{ stripIndices };
+			for (size_t i{}; i < mixedIndices.size(); i += 3 * 1000)
+				mixedIndices[i] = distribution(random) % 100;
+			report("strip + far jumps", mixedIndices, numSyntheticVertices);
+		}
+
+		void MeshSimplification(const std::string& filename)
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!Utils::ParseOBJ(filename, vertices, indices) || indices.empty())
+			{
+				std::cout << "Couldn't load " << filename << "\n";
+				return;
+			}
+
+			BoundingBox bounds{};
+			for (const Vertex& vertex : vertices)
+				bounds.Grow(vertex.position);
+			const float diagonal = (bounds.max - bounds.min).Magnitude();
+
+			constexpr float ratios[]{ 0.5f, 0.25f, 0.1f, 0.05f };
+			std::vector<MeshLOD> lods{};
+			const double ms = MeasureBestMs(1, [&]() { lods = MeshSimplifier::BuildLODChain(vertices, indices, ratios); });
+
+			const std::span<const uint32_t> sourceIndices{ indices.data(), lods[0].numIndices };
+			const SurfaceGrid sourceGrid{ vertices, sourceIndices, bounds };
+
+			std::cout << std::fixed << std::setprecision(3)
+				<< "Mesh simplification: " << filename << " (" << vertices.size() << " vertices, diagonal " << diagonal << ", " << ms << " ms for the chain)\n"
+				<< "  LOD  triangles       %  simplifier error  measured max  measured rms  max % of diagonal\n";
+
+			for (size_t lod{}; lod < lods.size(); ++lod)
+			{
+				const std::span<const uint32_t> lodIndices{ indices.data() + lods[lod].firstIndex, lods[lod].numIndices };
+				const SurfaceGrid lodGrid{ vertices, lodIndices, bounds };
+
+				//Two-sided distance: original vertices to the LOD surface and LOD triangle centers to the original surface
+				std::vector<uint8_t> isSourceVertex(vertices.size(), 0);
+				for (uint32_t index : sourceIndices)
+					isSourceVertex[index] = 1;
+
+				float maxDistance{};
+				double sumSquared{};
+				size_t numSamples{};
+				for (size_t v{}; v < vertices.size(); ++v)
+				{
+					if (!isSourceVertex[v])
+						continue;
+					const float distance = lodGrid.GetDistance(vertices[v].position);
+					maxDistance = std::max(maxDistance, distance);
+					sumSquared += double(distance) * distance;
+					++numSamples;
+				}
+				for (size_t i{}; i < lodIndices.size(); i += 3)
+				{
+					const Vector3 center = (vertices[lodIndices[i]].position + vertices[lodIndices[i + 1]].position + vertices[lodIndices[i + 2]].position) / 3.f;
+					const float distance = sourceGrid.GetDistance(center);
+					maxDistance = std::max(maxDistance, distance);
+					sumSquared += double(distance) * distance;
+					++numSamples;
+				}
+
+				std::cout << "  " << std::setw(3) << lod << std::setw(11) << lods[lod].numIndices / 3
+					<< std::setw(8) << std::setprecision(1) << 100.0 * lods[lod].numIndices / lods[0].numIndices << std::setprecision(4)
+					<< std::setw(18) << lods[lod].error << std::setw(14) << maxDistance << std::setw(14) << std::sqrt(sumSquared / numSamples)
+					<< std::setw(19) << std::setprecision(3) << 100.f * maxDistance / diagonal << "\n";
+			}
+		}
+
+		void MeshletCulling(const std::string& filename)
+		{
+			const auto pAsset = MeshAsset::Load(filename);
+			if (!pAsset || pAsset->GetLODs().empty() || pAsset->GetLODs()[0].numMeshlets == 0)
+			{
+				std::cout << "Couldn't load " << filename << " with meshlets\n";
+				return;
+			}
+
+			const std::span<const Vertex> vertices = pAsset->GetVertices();
+			const std::span<const uint32_t> indices = pAsset->GetIndices();
+			const MeshLOD& lod = pAsset->GetLODs()[0];
+			const std::span<const Meshlet> meshlets = pAsset->GetMeshlets().subspan(lod.firstMeshlet, lod.numMeshlets);
+
+			const BoundingBox& bounds = pAsset->GetBounds();
+			const Vector3 center = (bounds.min + bounds.max) * 0.5f;
+			const float radius = (bounds.max - bounds.min).Magnitude() * 0.5f;
+
+			float averageTriangles{};
+			for (const Meshlet& meshlet : meshlets)
+				averageTriangles += meshlet.numIndices / 3.f;
+			averageTriangles /= meshlets.size();
+
+			//Same view volume as the renderer: 45 degrees, 640x480
+			const Meshlets::ViewFrustum frustum{ std::tan(45.f * TO_RADIANS / 2.f), 640.f / 480.f, 0.1f, 100.f };
+			constexpr int numSteps{ 72 };
+
+			std::cout << std::fixed << std::setprecision(1)
+				<< "Meshlet culling: " << filename << " (" << lod.numIndices / 3 << " triangles, " << meshlets.size() << " meshlets, "
+				<< averageTriangles << " triangles per meshlet, orbit of " << numSteps << " steps)\n"
+				<< "  orbit                frustum %  back-face %  culled %  triangles culled %      us  conservative\n";
+
+			//Far orbit like the renderer's start position, close orbit where the mesh overflows the screen
+			const std::pair<const char*, float> orbits[]{ { "distance 50", 50.f }, { "close (1.2 radius)", radius * 1.2f } };
+			for (const auto& [pName, distance] : orbits)
+			{
+				uint64_t numMeshlets{}, numFrustumCulled{}, numBackFaceCulled{}, numVisibleIndices{};
+				uint32_t numMissed{};
+				double totalMs{};
+				std::vector<Meshlets::IndexInterval> visible{};
+				for (int step{}; step < numSteps; ++step)
+				{
+					//Around the vertical axis, bobbing up and down so the top and bottom get seen too
+					const float angle = step * 2.f * PI / numSteps;
+					const Vector3 origin = center + Vector3{ std::sin(angle), 0.5f * std::sin(angle * 2.f), -std::cos(angle) }.Normalized() * distance;
+					const Vector3 forward = (center - origin).Normalized();
+					const Matrix worldView = Matrix::CreateLookAtLH(origin, forward, Vector3::UnitY);
+
+					visible.clear();
+					Meshlets::CullStats stats{};
+					totalMs += MeasureBestMs(1, [&]() { stats = Meshlets::CullMeshlets(meshlets, worldView, frustum, visible); });
+					numMeshlets += stats.numMeshlets;
+					numFrustumCulled += stats.numFrustumCulled;
+					numBackFaceCulled += stats.numBackFaceCulled;
+					numVisibleIndices += stats.numVisibleIndices;
+
+					//Brute force: every front-facing triangle with a corner inside the frustum has to be in a visible interval
+					std::vector<uint8_t> isVisible(lod.numIndices / 3, 0);
+					for (const Meshlets::IndexInterval& interval : visible)
+						std::fill_n(isVisible.begin() + (interval.firstIndex - lod.firstIndex) / 3, interval.numIndices / 3, uint8_t{ 1 });
+
+					for (uint32_t t{}; t < lod.numIndices / 3; ++t)
+					{
+						if (isVisible[t])
+							continue;
+
+						const uint32_t* pTriangle = &indices[lod.firstIndex + t * 3];
+						const Vector3& p0 = vertices[pTriangle[0]].position;
+						const Vector3 normal = Vector3::Cross(vertices[pTriangle[1]].position - p0, vertices[pTriangle[2]].position - p0);
+						if (Vector3::Dot(normal, p0 - origin) >= 0.f)
+							continue;
+
+						for (uint32_t corner{}; corner < 3; ++corner)
+						{
+							const Vector3 p = worldView.TransformPoint(vertices[pTriangle[corner]].position);
+							if (p.z >= frustum.nearPlane && p.z <= frustum.farPlane &&
+								std::abs(p.x) <= p.z * frustum.fov * frustum.aspectRatio && std::abs(p.y) <= p.z * frustum.fov)
+							{
+								++numMissed;
+								break;
+							}
+						}
+					}
+				}
+
+				std::cout << "  " << std::left << std::setw(20) << pName << std::right
+					<< std::setw(11) << 100.0 * numFrustumCulled / numMeshlets << std::setw(13) << 100.0 * numBackFaceCulled / numMeshlets
+					<< std::setw(10) << 100.0 * (numFrustumCulled + numBackFaceCulled) / numMeshlets
+					<< std::setw(20) << 100.0 * (1.0 - double(numVisibleIndices) / (double(lod.numIndices) * numSteps))
+					<< std::setw(8) << std::setprecision(2) << totalMs * 1000.0 / numSteps << std::setprecision(1)
+					<< "  " << (numMissed == 0 ? "yes" : "NO, " + std::to_string(numMissed) + " visible triangles dropped") << "\n";
+			}
+		}
+
+		void MipGeneration(int size)
+		{
+			const uint32_t width = static_cast<uint32_t>(size), height = static_cast<uint32_t>(size);
+			const size_t numBytes = size_t(width) * height * 4;
+
+			//Noisy color with a 1-texel black and white checker in the top left quarter, and bumpy normals
+			std::mt19937 random{ 42 };
+			std::uniform_int_distribution<int> byteDistribution{ 0, 255 };
+			std::vector<uint8_t> colorPixels(numBytes), normalPixels(numBytes);
+			for (uint32_t y{}; y < height; ++y)
+			{
+				for (uint32_t x{}; x < width; ++x)
+				{
+					uint8_t* pColor = &colorPixels[(size_t(y) * width + x) * 4];
+					const bool isChecker = x < width / 2 && y < height / 2;
+					for (int c{}; c < 3; ++c)
+						pColor[c] = isChecker ? ((x + y) % 2 ? 255 : 0) : static_cast<uint8_t>(byteDistribution(random));
+					pColor[3] = 255;
+
+					const float u = x * 2.f * PI / 64.f, v = y * 2.f * PI / 64.f;
+					const Vector3 normal = Vector3{ 0.6f * std::sin(u), 0.6f * std::cos(v), 1.f }.Normalized();
+					uint8_t* pNormal = &normalPixels[(size_t(y) * width + x) * 4];
+					for (int c{}; c < 3; ++c)
+						pNormal[c] = static_cast<uint8_t>((normal[c] * 0.5f + 0.5f) * 255.f + 0.5f);
+					pNormal[3] = 255;
+				}
+			}
+
+			ThreadPool threadPool{};
+			std::cout << std::fixed << std::setprecision(2)
+				<< "Mip generation: " << width << "x" << height << " RGBA8, " << MipMaps::GetNumLevels(width, height) << " levels, "
+				<< threadPool.GetNumWorkers() + 1 << " threads\n"
+				<< "  filter   content   serial ms  parallel ms  speedup\n";
+
+			const std::pair<const char*, MipFilter> filters[]{ { "box", MipFilter::Box }, { "kaiser", MipFilter::Kaiser }, { "lanczos", MipFilter::Lanczos } };
+			const std::pair<const char*, MipContent> contents[]{ { "color", MipContent::Color }, { "data", MipContent::Data }, { "normal", MipContent::Normal } };
+			for (const auto& [pFilterName, filter] : filters)
+			{
+				for (const auto& [pContentName, content] : contents)
+				{
+					const std::vector<uint8_t>& pixels = content == MipContent::Normal ? normalPixels : colorPixels;
+					const double serialMs = MeasureBestMs(3, [&]() { MipMaps::GenerateMipChain(pixels.data(), width, height, width * 4, { filter, content }); });
+					const double parallelMs = MeasureBestMs(3, [&]() { MipMaps::GenerateMipChain(pixels.data(), width, height, width * 4, { filter, content, &threadPool }); });
+					std::cout << "  " << std::left << std::setw(9) << pFilterName << std::setw(8) << pContentName << std::right
+						<< std::setw(11) << serialMs << std::setw(13) << parallelMs << std::setw(8) << std::setprecision(1) << serialMs / parallelMs << "x\n" << std::setprecision(2);
+				}
+			}
+
+			//A constant image has to stay constant through every level, whatever the filter rings
+			bool isConstantKept{ true };
+			const std::vector<uint8_t> constantPixels(numBytes, 77);
+			for (const auto& [pFilterName, filter] : filters)
+			{
+				for (const auto& [pContentName, content] : contents)
+				{
+					if (content == MipContent::Normal)
+						continue;
+					const MipChain chain = MipMaps::GenerateMipChain(constantPixels.data(), width, height, width * 4, { filter, content, &threadPool });
+					isConstantKept &= std::all_of(chain.pixels.begin(), chain.pixels.end(), [](uint8_t value) { return std::abs(value - 77) <= 1; });
+				}
+			}
+
+			//The checker averages to half the light, 188 in sRGB, where averaging the sRGB bytes gives 128
+			const MipChain colorChain = MipMaps::GenerateMipChain(colorPixels.data(), width, height, width * 4, { MipFilter::Box, MipContent::Color, &threadPool });
+			const MipChain dataChain = MipMaps::GenerateMipChain(colorPixels.data(), width, height, width * 4, { MipFilter::Box, MipContent::Data, &threadPool });
+			const MipLevel& checkerLevel = colorChain.levels[2];
+			const size_t checkerTexel = checkerLevel.offset + (size_t(checkerLevel.height / 8) * checkerLevel.width + checkerLevel.width / 8) * 4;
+
+			float maxNormalError{};
+			const MipChain normalChain = MipMaps::GenerateMipChain(normalPixels.data(), width, height, width * 4, { MipFilter::Kaiser, MipContent::Normal, &threadPool });
+			for (size_t i{}; i < normalChain.pixels.size(); i += 4)
+			{
+				const Vector3 normal{ normalChain.pixels[i] / 127.5f - 1.f, normalChain.pixels[i + 1] / 127.5f - 1.f, normalChain.pixels[i + 2] / 127.5f - 1.f };
+				maxNormalError = std::max(maxNormalError, std::abs(normal.Magnitude() - 1.f));
+			}
+
+			std::cout << "  constant image kept by every filter: " << (isConstantKept ? "yes" : "NO") << "\n"
+				<< "  checker at level 2: " << int(colorChain.pixels[checkerTexel]) << " gamma-aware, " << int(dataChain.pixels[checkerTexel]) << " averaging sRGB bytes (expected 188)\n"
+				<< "  normal length error over all levels: " << std::setprecision(4) << maxNormalError << " (8-bit rounding allows about 0.007)\n";
+		}
+
+		void TextureCompression(const std::string& directory)
+		{
+			//The same maps and formats as Renderer
+			const std::tuple<const char*, MipContent, TextureFormat> textures[]{
+				{ "vehicle_diffuse.png", MipContent::Color, TextureFormat::BC1 },
+				{ "vehicle_normal.png", MipContent::Normal, TextureFormat::BC5 },
+				{ "vehicle_specular.png", MipContent::Data, TextureFormat::BC1 },
+				{ "vehicle_gloss.png", MipContent::Data, TextureFormat::BC4 } };
+			const char* formatNames[]{ "RGBA8", "BC1", "BC4", "BC5", "BC3" };
+
+			ThreadPool threadPool{};
+			std::cout << std::fixed << std::setprecision(2) << "Texture compression: " << directory << ", " << threadPool.GetNumWorkers() + 1 << " threads\n"
+				<< "  texture               format  encode ms  parallel ms  import ms  cached ms  PSNR dB  RGBA8 MB  stored MB  saved %\n";
+
+			size_t totalUncompressed{}, totalStored{};
+			for (const auto& [pName, content, format] : textures)
+			{
+				const std::string path = (std::filesystem::path{ directory } / pName).string();
+				const TextureImportOptions options{ { .content = content, .pThreadPool = &threadPool }, format };
+
+				//The uncompressed chain to time the encoder on its own, then the real import which leaves a valid cache behind
+				std::filesystem::remove(TextureAsset::GetCachePath(path));
+				const auto pChain = TextureAsset::Load(path, { options.mips, TextureFormat::RGBA8 });
+				if (!pChain)
+				{
+					std::cout << "  couldn't load " << path << "\n";
+					continue;
+				}
+
+				const std::span<const MipLevel> levels = pChain->GetLevels();
+				size_t encodedSize{};
+				for (const MipLevel& level : levels)
+					encodedSize += BlockCompression::GetLevelSize(format, level.width, level.height);
+				std::vector<uint8_t> encoded(encodedSize);
+				const auto encode = [&](ThreadPool* pThreadPool)
+					{
+						size_t offset{};
+						for (const MipLevel& level : levels)
+						{
+							BlockCompression::Compress(pChain->GetData().data() + level.offset, level.width, level.height, format, &encoded[offset], pThreadPool);
+							offset += BlockCompression::GetLevelSize(format, level.width, level.height);
+						}
+					};
+				const double serialMs = MeasureBestMs(3, [&]() { encode(nullptr); });
+				const double parallelMs = MeasureBestMs(3, [&]() { encode(&threadPool); });
+
+				std::filesystem::remove(TextureAsset::GetCachePath(path));
+				std::unique_ptr<TextureAsset> pAsset{};
+				const double importMs = MeasureBestMs(1, [&]() { pAsset = TextureAsset::Load(path, options); });
+				const double cachedMs = MeasureBestMs(5, [&]() { pAsset = TextureAsset::Load(path, options); });
+				if (!pAsset || !pAsset->IsFromCache())
+				{
+					std::cout << "  " << path << " didn't come back from its cache\n";
+					continue;
+				}
+
+				totalUncompressed += pAsset->GetUncompressedSize();
+				totalStored += pAsset->GetData().size();
+				constexpr double bytesPerMB{ 1024.0 * 1024.0 };
+				std::cout << "  " << std::left << std::setw(22) << pName << std::setw(6) << formatNames[static_cast<uint32_t>(pAsset->GetFormat())] << std::right
+					<< std::setw(11) << serialMs << std::setw(13) << parallelMs << std::setw(11) << importMs << std::setw(11) << cachedMs
+					<< std::setw(9) << pAsset->GetPSNR() << std::setw(10) << pAsset->GetUncompressedSize() / bytesPerMB << std::setw(11) << pAsset->GetData().size() / bytesPerMB
+					<< std::setw(9) << 100.0 * (1.0 - double(pAsset->GetData().size()) / pAsset->GetUncompressedSize()) << "\n";
+			}
+
+			if (totalUncompressed > 0)
+			{
+				std::cout << "  total: " << totalUncompressed / (1024.0 * 1024.0) << " MB -> " << totalStored / (1024.0 * 1024.0) << " MB ("
+					<< 100.0 * (1.0 - double(totalStored) / totalUncompressed) << "% saved)\n";
+			}
+		}
+
+		void AsyncStartup(const std::string& directory, int numWorkers)
+		{
+			//The same maps and formats as Renderer, the second name is packed into alpha
+			const std::tuple<const char*, const char*, MipContent, TextureFormat> textures[]{
+				{ "vehicle_diffuse.png", nullptr, MipContent::Color, TextureFormat::BC1 },
+				{ "vehicle_normal.png", nullptr, MipContent::Normal, TextureFormat::BC5 },
+				{ "vehicle_specular.png", "vehicle_gloss.png", MipContent::Data, TextureFormat::BC3 } };
+			const std::string meshPath = (std::filesystem::path{ directory } / "vehicle.obj").string();
+			const size_t numAssets = std::size(textures) + 1;
+
+			//A negative count keeps the default of one worker per extra hardware thread
+			ThreadPool threadPool{ numWorkers < 0 ? std::max(1u, std::thread::hardware_concurrency()) - 1 : static_cast<uint32_t>(numWorkers) };
+			const auto getPath = [&](const char* pName) { return pName ? (std::filesystem::path{ directory } / pName).string() : std::string{}; };
+			const auto loadTexture = [&threadPool](const std::string& path, const std::string& alphaPath, MipContent content, TextureFormat format)
+				{
+					const TextureImportOptions options{ { .content = content, .pThreadPool = &threadPool }, format };
+					return alphaPath.empty() ? TextureAsset::Load(path, options) : TextureAsset::LoadPacked(path, alphaPath, options);
+				};
+			const auto removeCaches = [&]()
+				{
+					for (const auto& [pName, pAlphaName, content, format] : textures)
+						std::filesystem::remove(pAlphaName ? TextureAsset::GetPackedCachePath(getPath(pName), getPath(pAlphaName)) : TextureAsset::GetCachePath(getPath(pName)));
+					std::filesystem::remove(MeshAsset::GetCachePath(meshPath));
+				};
+
+			std::cout << std::fixed << std::setprecision(2) << "Async startup: " << directory << ", " << threadPool.GetNumWorkers() << " workers\n";
+			for (const bool isCold : { true, false })
+			{
+				//What Renderer used to do: every asset imported on the main thread before the first frame
+				if (isCold)
+					removeCaches();
+				size_t numSerial{};
+				const double serialMs = MeasureBestMs(1, [&]()
+					{
+						for (const auto& [pName, pAlphaName, content, format] : textures)
+							numSerial += loadTexture(getPath(pName), getPath(pAlphaName), content, format) != nullptr;
+						numSerial += MeshAsset::Load(meshPath, { .obj = { .pThreadPool = &threadPool } }) != nullptr;
+					});
+
+				if (isCold)
+					removeCaches();
+				size_t numResident{};
+				int numFrames{};
+				const auto start = std::chrono::steady_clock::now();
+				double firstFrameMs{}, asyncMs{};
+				{
+					AssetLoader loader{ &threadPool };
+					for (const auto& [pName, pAlphaName, content, format] : textures)
+					{
+						loader.Load<TextureAsset>(pName, [&, path = getPath(pName), alphaPath = getPath(pAlphaName), content, format]() { return loadTexture(path, alphaPath, content, format); },
+							[&numResident](std::unique_ptr<TextureAsset> pAsset) { numResident += pAsset != nullptr; });
+					}
+					loader.Load<MeshAsset>("vehicle.obj", [&]() { return MeshAsset::Load(meshPath, { .obj = { .pThreadPool = &threadPool } }); },
+						[&numResident](std::unique_ptr<MeshAsset> pAsset) { numResident += pAsset != nullptr; });
+
+					//Stand-in frames that poll the loader like Renderer::Update does
+					while (loader.Update())
+					{
+						loader.MarkFirstFrame();
+						if (numFrames++ == 0)
+							firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+						std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+					}
+					asyncMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+					std::cout << (isCold ? "Cold" : "Warm") << " start, serial " << serialMs << " ms (" << numSerial << "/" << numAssets << " loaded), async " << asyncMs
+						<< " ms (" << numResident << "/" << numAssets << " resident) over " << numFrames << " frames, first frame after " << firstFrameMs << " ms\n";
+					loader.PrintTimeline();
+				}
+			}
+		}
+
+		void TextureSharing(const std::string& directory, int numVehicles)
+		{
+#ifdef DAE_CPU_ONLY
+			std::cout << "Texture sharing needs a D3D11 device, it isn't in the CPU-only build\n";
+#else
+			//No window needed, the textures only have to be created
+			ID3D11Device* pDevice{};
+			D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+			if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, 0, &featureLevel, 1, D3D11_SDK_VERSION, &pDevice, nullptr, nullptr)))
+			{
+				std::cout << "Couldn't create a D3D11 device\n";
+				return;
+			}
+
+			//Like a duplicated file in the content folder, found by its content instead of its path
+			const std::filesystem::path directoryPath{ directory };
+			const std::string copyPath = (std::filesystem::temp_directory_path() / "vehicle_diffuse_copy.png").string();
+			std::error_code error{};
+			std::filesystem::copy_file(directoryPath / "vehicle_diffuse.png", copyPath, std::filesystem::copy_options::overwrite_existing, error);
+
+			ThreadPool threadPool{};
+			const TextureImportOptions diffuseOptions{ { .content = MipContent::Color, .pThreadPool = &threadPool }, TextureFormat::BC1 };
+			const TextureImportOptions normalOptions{ { .content = MipContent::Normal, .pThreadPool = &threadPool }, TextureFormat::BC5 };
+			const TextureImportOptions specularOptions{ { .content = MipContent::Data, .pThreadPool = &threadPool }, TextureFormat::BC1 };
+			const TextureImportOptions glossOptions{ { .content = MipContent::Data, .pThreadPool = &threadPool }, TextureFormat::BC4 };
+
+			std::cout << "Texture sharing: " << numVehicles << " vehicles from " << directory << "\n";
+			{
+				TextureManager textureManager{ pDevice };
+				std::vector<std::array<std::shared_ptr<Texture>, 4>> vehicles(numVehicles);
+				const auto start = std::chrono::steady_clock::now();
+				for (int i{}; i < numVehicles; ++i)
+				{
+					//Every other vehicle spells its paths differently, every third one uses the copied diffuse map
+					const std::filesystem::path vehicleDirectory = i % 2 == 0 ? directoryPath : directoryPath / "." / ".." / directoryPath.filename();
+					vehicles[i][0] = textureManager.Acquire(i % 3 == 1 ? copyPath : (vehicleDirectory / "vehicle_diffuse.png").string(), diffuseOptions);
+					vehicles[i][1] = textureManager.Acquire((vehicleDirectory / "vehicle_normal.png").string(), normalOptions);
+					vehicles[i][2] = textureManager.Acquire((vehicleDirectory / "vehicle_specular.png").string(), specularOptions);
+					vehicles[i][3] = textureManager.Acquire((vehicleDirectory / "vehicle_gloss.png").string(), glossOptions);
+				}
+				const double acquireMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				std::cout << "  acquired " << numVehicles * 4 << " maps in " << acquireMs << " ms\n  ";
+				textureManager.PrintStats();
+
+				//The diffuse copy doesn't count, it is the same image
+				const TextureManager::Stats& stats = textureManager.GetStats();
+				std::cout << "  " << (stats.numResident == 4 ? "one copy per map" : "maps were uploaded more than once") << "\n";
+
+				for (int i{}; i < numVehicles; ++i)
+				{
+					vehicles[i] = {};
+					if (i == numVehicles / 2 - 1 || i == numVehicles - 1)
+						std::cout << "  after releasing " << i + 1 << " vehicles: " << stats.numResident << " resident, " << stats.residentBytes << " bytes\n";
+				}
+			}
+
+			std::filesystem::remove(copyPath, error);
+			pDevice->Release();
+#endif
+		}
+
+		void ChannelPacking(const std::string& directory)
+		{
+			const std::string specularPath = (std::filesystem::path{ directory } / "vehicle_specular.png").string();
+			const std::string glossPath = (std::filesystem::path{ directory } / "vehicle_gloss.png").string();
+
+			ThreadPool threadPool{};
+			const MipOptions mips{ .content = MipContent::Data, .pThreadPool = &threadPool };
+			const auto pSpecular = TextureAsset::Load(specularPath, { mips, TextureFormat::BC1 });
+			const auto pGloss = TextureAsset::Load(glossPath, { mips, TextureFormat::BC4 });
+			std::filesystem::remove(TextureAsset::GetPackedCachePath(specularPath, glossPath));
+			std::unique_ptr<TextureAsset> pPacked{};
+			const double packMs = MeasureBestMs(1, [&]() { pPacked = TextureAsset::LoadPacked(specularPath, glossPath, { mips, TextureFormat::BC3 }); });
+			if (!pSpecular || !pGloss || !pPacked)
+			{
+				std::cout << "Couldn't load " << specularPath << " and " << glossPath << "\n";
+				return;
+			}
+
+			//The packed chain mips every channel on its own like the separate ones, so a BC3 block has to be the BC4 block then the BC1 block
+			size_t numBlocks{}, numIdentical{};
+			for (size_t level{}; level < pPacked->GetLevels().size(); ++level)
+			{
+				const MipLevel& packedLevel = pPacked->GetLevels()[level];
+				const uint8_t* pPackedBlock = pPacked->GetData().data() + packedLevel.offset;
+				const uint8_t* pSpecularBlock = pSpecular->GetData().data() + pSpecular->GetLevels()[level].offset;
+				const uint8_t* pGlossBlock = pGloss->GetData().data() + pGloss->GetLevels()[level].offset;
+				const size_t numLevelBlocks = BlockCompression::GetLevelSize(TextureFormat::BC3, packedLevel.width, packedLevel.height) / 16;
+				for (size_t block{}; block < numLevelBlocks; ++block)
+					numIdentical += std::memcmp(pPackedBlock + block * 16, pGlossBlock + block * 8, 8) == 0 && std::memcmp(pPackedBlock + block * 16 + 8, pSpecularBlock + block * 8, 8) == 0;
+				numBlocks += numLevelBlocks;
+			}
+
+			std::cout << std::fixed << std::setprecision(2) << "Channel packing: " << specularPath << " rgb + " << glossPath << " r -> BC3 in " << packMs << " ms, "
+				<< numIdentical << "/" << numBlocks << " blocks identical to the separate BC1 + BC4, PSNR " << pPacked->GetPSNR() << " dB over rgba\n";
+
+			//Texels a filter reads per fetch: one for point, a 2x2 footprint for bilinear, two of them for trilinear
+			struct Layout
+			{
+				const char* pName;
+				std::vector<TextureFormat> formats;
+			};
+			const Layout layouts[]{
+				{ "separate BC1/BC5/BC1/BC4", { TextureFormat::BC1, TextureFormat::BC5, TextureFormat::BC1, TextureFormat::BC4 } },
+				{ "packed BC1/BC5/BC3", { TextureFormat::BC1, TextureFormat::BC5, TextureFormat::BC3 } },
+				{ "separate RGBA8", { TextureFormat::RGBA8, TextureFormat::RGBA8, TextureFormat::RGBA8, TextureFormat::RGBA8 } },
+				{ "packed RGBA8", { TextureFormat::RGBA8, TextureFormat::RGBA8, TextureFormat::RGBA8 } } };
+
+			std::cout << "  layout                     SRVs  fetches/px  B/texel  point B/px  bilinear B/px  trilinear B/px\n";
+			for (const Layout& layout : layouts)
+			{
+				double bytesPerTexel{};
+				for (TextureFormat format : layout.formats)
+					bytesPerTexel += BlockCompression::GetLevelSize(format, 4, 4) / 16.0;
+
+				std::cout << "  " << std::left << std::setw(26) << layout.pName << std::right << std::setw(5) << layout.formats.size() << std::setw(12) << layout.formats.size()
+					<< std::setw(9) << bytesPerTexel << std::setw(12) << bytesPerTexel << std::setw(15) << bytesPerTexel * 4 << std::setw(16) << bytesPerTexel * 8 << "\n";
+			}
+		}
+
+		void TextureStreaming(const std::string& directory, int budgetKB)
+		{
+			const std::filesystem::path directoryPath{ directory };
+			ThreadPool threadPool{};
+			const auto pMesh = MeshAsset::Load((directoryPath / "vehicle.obj").string());
+			const std::shared_ptr<const TextureAsset> pAssets[]{
+				TextureAsset::Load((directoryPath / "vehicle_diffuse.png").string(), { { .content = MipContent::Color, .pThreadPool = &threadPool }, TextureFormat::BC1 }),
+				TextureAsset::Load((directoryPath / "vehicle_normal.png").string(), { { .content = MipContent::Normal, .pThreadPool = &threadPool }, TextureFormat::BC5 }),
+				TextureAsset::LoadPacked((directoryPath / "vehicle_specular.png").string(), (directoryPath / "vehicle_gloss.png").string(), { { .content = MipContent::Data, .pThreadPool = &threadPool }, TextureFormat::BC3 }) };
+			if (!pMesh || !pAssets[0] || !pAssets[1] || !pAssets[2])
+			{
+				std::cout << "Couldn't load the vehicle from " << directory << "\n";
+				return;
+			}
+
+			//Like the renderer: 45 degrees at 640x480
+			constexpr float viewportHeight{ 480.f };
+			Camera camera{};
+			camera.Initialize(45.f, {}, 640.f / viewportHeight);
+
+			const MeshLOD& lod = pMesh->GetLODs().empty() ? MeshLOD{ 0, static_cast<uint32_t>(pMesh->GetIndices().size()) } : pMesh->GetLODs()[0];
+			const float worldPerUV = TextureStreamer::ComputeWorldPerUV(pMesh->GetVertices(), pMesh->GetIndices().subspan(lod.firstIndex, lod.numIndices));
+			const BoundingBox& bounds = pMesh->GetBounds();
+			const Vector3 center = (bounds.min + bounds.max) * 0.5f;
+			const float radius = (bounds.max - bounds.min).Magnitude() * 0.5f;
+
+			//A row of vehicles with their own maps each, so the full chains don't all fit
+			constexpr int numVehicles{ 6 };
+			const float spacing = radius * 4.f;
+			size_t fullBytes{};
+			for (const auto& pAsset : pAssets)
+				fullBytes += pAsset->GetData().size();
+
+			//Null device: only remembers what would be on the GPU and checks every upload against the asset
+			struct NullTexture
+			{
+				uint32_t firstLevel{};
+				size_t size{};
+			};
+			std::vector<NullTexture> deviceTextures(numVehicles * std::size(pAssets));
+			uint32_t numBadUploads{};
+
+			TextureStreamer streamer{ &threadPool, { .budgetBytes = static_cast<size_t>(budgetKB) * 1024 } };
+			std::vector<TextureStreamer::Handle> handles{};
+			for (int vehicle{}; vehicle < numVehicles; ++vehicle)
+			{
+				for (size_t map{}; map < std::size(pAssets); ++map)
+				{
+					NullTexture& deviceTexture = deviceTextures[vehicle * std::size(pAssets) + map];
+					const std::string name = "vehicle " + std::to_string(vehicle) + " " + std::array{ "diffuse", "normal", "specular+gloss" }[map];
+					handles.push_back(streamer.Register(name, pAssets[map], [&deviceTexture, &numBadUploads](const TextureAsset& asset, uint32_t firstLevel, const uint8_t* pLevels)
+						{
+							const size_t offset = asset.GetLevels()[firstLevel].offset;
+							if (std::memcmp(pLevels, asset.GetData().data() + offset, asset.GetData().size() - offset) != 0)
+								++numBadUploads;
+							deviceTexture = { firstLevel, asset.GetData().size() - offset };
+						}));
+				}
+			}
+
+			constexpr double bytesPerMB{ 1024.0 * 1024.0 };
+			std::cout << std::fixed << std::setprecision(2) << "Texture streaming: " << numVehicles << " vehicles with " << std::size(pAssets) << " maps each ("
+				<< numVehicles * fullBytes / bytesPerMB << " MB at full resolution) in a budget of " << budgetKB / 1024.0 << " MB, " << threadPool.GetNumWorkers() << " workers\n"
+				<< "  frame  camera z  resident MB  loads  evicted  pending  blurry maps  levels per vehicle (diffuse, normal, spec+gloss)\n";
+
+			//Fly past the row just beside it and back out far away, where everything drops to its coarse levels again
+			constexpr int numFrames{ 360 };
+			const float startZ = center.z - spacing * 2.f;
+			const float endZ = center.z + spacing * (numVehicles + 1);
+			uint32_t numOverBudget{}, numMismatches{}, numBlurryFrames{};
+			double totalUpdateMs{}, maxUpdateMs{};
+			for (int frame{}; frame < numFrames; ++frame)
+			{
+				const float t = frame < numFrames * 2 / 3 ? frame / (numFrames * 2 / 3.f) : 1.f;
+				camera.origin = Vector3{ center.x + radius * 1.5f, center.y, startZ + (endZ - startZ) * t };
+				if (frame >= numFrames * 2 / 3)
+					camera.origin.x += spacing * 4.f * (frame - numFrames * 2 / 3);
+
+				for (int vehicle{}; vehicle < numVehicles; ++vehicle)
+				{
+					const Vector3 vehicleCenter = center + Vector3{ 0.f, 0.f, spacing * vehicle };
+					const float uvPerPixel = TextureStreamer::ComputeUVPerPixel(worldPerUV, vehicleCenter, radius, camera, viewportHeight);
+					for (size_t map{}; map < std::size(pAssets); ++map)
+						streamer.Request(handles[vehicle * std::size(pAssets) + map], uvPerPixel);
+				}
+
+				const double updateMs = MeasureBestMs(1, [&]() { streamer.Update(); });
+				totalUpdateMs += updateMs;
+				maxUpdateMs = std::max(maxUpdateMs, updateMs);
+
+				//The null device has to agree with the streamer's bookkeeping, which has to stay in the budget
+				size_t deviceBytes{};
+				uint32_t numBlurry{};
+				for (size_t texture{}; texture < handles.size(); ++texture)
+				{
+					deviceBytes += deviceTextures[texture].size;
+					if (deviceTextures[texture].firstLevel != streamer.GetResidentLevel(handles[texture]))
+						++numMismatches;
+					if (streamer.GetResidentLevel(handles[texture]) > streamer.GetRequestedLevel(handles[texture]))
+						++numBlurry;
+				}
+				const TextureStreamer::Stats& stats = streamer.GetStats();
+				if (deviceBytes != stats.residentBytes)
+					++numMismatches;
+				if (stats.residentBytes > static_cast<size_t>(budgetKB) * 1024)
+					++numOverBudget;
+				numBlurryFrames += numBlurry != 0;
+
+				if (frame % 20 == 0 || frame == numFrames - 1)
+				{
+					std::cout << std::setw(7) << frame << std::setw(10) << camera.origin.z << std::setw(13) << stats.residentBytes / bytesPerMB << std::setw(7) << stats.numLoads
+						<< std::setw(9) << stats.numEvictions << std::setw(9) << streamer.GetNumPendingLoads() << std::setw(13) << numBlurry << "  ";
+					for (int vehicle{}; vehicle < numVehicles; ++vehicle)
+					{
+						for (size_t map{}; map < std::size(pAssets); ++map)
+							std::cout << (map == 0 ? " " : "") << streamer.GetResidentLevel(handles[vehicle * std::size(pAssets) + map]);
+					}
+					std::cout << "\n";
+				}
+			}
+
+			std::cout << "  Update: " << totalUpdateMs / numFrames << " ms per frame on average, " << maxUpdateMs << " ms at most\n  ";
+			streamer.PrintStats();
+			std::cout << "  " << numFrames - numBlurryFrames << " of " << numFrames << " frames with every map at the level requested\n"
+				<< "  " << (numOverBudget == 0 ? "stayed in the budget" : std::to_string(numOverBudget) + " frames over the budget") << ", "
+				<< (numMismatches == 0 && numBadUploads == 0 ? "null device matches the streamer" : std::to_string(numMismatches + numBadUploads) + " mismatches with the null device") << "\n";
+
+			for (const TextureStreamer::Handle handle : handles)
+				streamer.Unregister(handle);
+			std::cout << "  after unregistering: " << streamer.GetStats().numTextures << " textures, " << streamer.GetStats().residentBytes << " bytes\n";
+		}
+
+		void TexelLayouts(int size)
+		{
+			const uint32_t width = static_cast<uint32_t>(size), height = static_cast<uint32_t>(size);
+			std::mt19937 random{ 42 };
+			std::uniform_int_distribution<int> byteDistribution{ 0, 255 };
+			std::vector<uint8_t> pixels(size_t(width) * height * 4);
+			for (uint8_t& value : pixels)
+				value = static_cast<uint8_t>(byteDistribution(random));
+
+			ThreadPool threadPool{};
+			const MipChain chain = MipMaps::GenerateMipChain(pixels.data(), width, height, width * 4, { MipFilter::Box, MipContent::Data, &threadPool });
+			const std::pair<const char*, TexelLayout> layouts[]{ { "linear", TexelLayout::Linear }, { "tiled 4x4", TexelLayout::Tiled }, { "morton", TexelLayout::Morton } };
+			std::vector<std::unique_ptr<CPUTexture>> textures{};
+			for (const auto& [pName, layout] : layouts)
+				textures.push_back(std::make_unique<CPUTexture>(chain.pixels, chain.levels, layout));
+
+			//Every layout has to return the same texel for the same uv, and bilinear at a texel center has to be that texel
+			constexpr int numChecks{ 100000 };
+			std::uniform_real_distribution<float> uvDistribution{ -2.f, 3.f };
+			std::uniform_real_distribution<float> lodDistribution{ -1.f, static_cast<float>(chain.levels.size()) };
+			uint32_t numMismatches{};
+			const auto isEqual = [](const Vector4& a, const Vector4& b) { return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w; };
+			for (int check{}; check < numChecks; ++check)
+			{
+				const Vector2 uv{ uvDistribution(random), uvDistribution(random) };
+				const float lod = lodDistribution(random);
+				for (size_t layout{ 1 }; layout < textures.size(); ++layout)
+				{
+					numMismatches += !isEqual(textures[0]->SamplePoint(uv, lod), textures[layout]->SamplePoint(uv, lod));
+					numMismatches += !isEqual(textures[0]->SampleTrilinear(uv, lod), textures[layout]->SampleTrilinear(uv, lod));
+				}
+
+				const uint32_t level = check % textures[0]->GetNumLevels();
+				const uint32_t x = random() % textures[0]->GetWidth(level), y = random() % textures[0]->GetHeight(level);
+				const Vector2 center{ (x + 0.5f) / textures[0]->GetWidth(level), (y + 0.5f) / textures[0]->GetHeight(level) };
+				for (const auto& pTexture : textures)
+				{
+					const uint8_t* pExpected = &chain.pixels[chain.levels[level].offset + (size_t(y) * chain.levels[level].width + x) * 4];
+					const Vector4 sample = pTexture->SampleBilinear(center, level);
+					for (int channel{}; channel < 4; ++channel)
+						numMismatches += std::abs(sample[channel] * 255.f - pExpected[channel]) > 1e-3f;
+				}
+			}
+
+			//A 1024x1024 screen: random uvs, then scanlines over the texture at an angle, at level 0 and minified by 4
+			constexpr uint32_t screenSize{ 1024 };
+			std::vector<Vector2> randomUVs(size_t(screenSize) * screenSize);
+			std::uniform_real_distribution<float> unitDistribution{ 0.f, 1.f };
+			for (Vector2& uv : randomUVs)
+				uv = { unitDistribution(random), unitDistribution(random) };
+
+			struct Pattern
+			{
+				std::string name{};
+				std::function<float(const CPUTexture&)> run{};
+			};
+			std::vector<Pattern> patterns{};
+			patterns.push_back({ "random uv, point", [&](const CPUTexture& texture)
+				{
+					float sum{};
+					for (const Vector2& uv : randomUVs)
+						sum += texture.SamplePoint(uv, 0.f).x;
+					return sum;
+				} });
+			patterns.push_back({ "random uv, trilinear lod 1.5", [&](const CPUTexture& texture)
+				{
+					float sum{};
+					for (const Vector2& uv : randomUVs)
+						sum += texture.SampleTrilinear(uv, 1.5f).x;
+					return sum;
+				} });
+			for (const float degrees : { 0.f, 30.f, 90.f })
+			{
+				for (const auto& [pFilter, scale] : { std::pair{ "bilinear", 1.f }, std::pair{ "trilinear 4x minified", 4.f } })
+				{
+					//One screen pixel steps scale texels of level 0 along the rotated axes
+					const float cosAngle = std::cos(degrees * TO_RADIANS) * scale / width;
+					const float sinAngle = std::sin(degrees * TO_RADIANS) * scale / width;
+					const float lod = std::log2(scale);
+					const bool isTrilinear = scale > 1.f;
+					std::ostringstream name{};
+					name << "scanlines at " << degrees << " deg, " << pFilter;
+					patterns.push_back({ name.str(), [=](const CPUTexture& texture)
+						{
+							float sum{};
+							for (uint32_t y{}; y < screenSize; ++y)
+							{
+								for (uint32_t x{}; x < screenSize; ++x)
+								{
+									const Vector2 uv{ x * cosAngle - y * sinAngle + 0.25f, x * sinAngle + y * cosAngle + 0.25f };
+									sum += isTrilinear ? texture.SampleTrilinear(uv, lod).x : texture.SampleBilinear(uv, 0).x;
+								}
+							}
+							return sum;
+						} });
+				}
+			}
+
+			std::cout << std::fixed << std::setprecision(1) << "Texel layouts: " << width << "x" << height << " RGBA8, " << chain.levels.size() << " levels, "
+				<< screenSize << "x" << screenSize << " samples per pattern\n"
+				<< "  pattern                                          linear Ms/s  tiled Ms/s  morton Ms/s   tiled  morton\n";
+			constexpr double numSamples{ double(screenSize) * screenSize };
+			for (const Pattern& pattern : patterns)
+			{
+				double rates[3]{};
+				float sums[3]{};
+				for (size_t layout{}; layout < textures.size(); ++layout)
+				{
+					const double ms = MeasureBestMs(3, [&]() { sums[layout] = pattern.run(*textures[layout]); });
+					rates[layout] = numSamples / (ms * 1000.0);
+				}
+				numMismatches += sums[0] != sums[1] || sums[0] != sums[2];
+				std::cout << "  " << std::left << std::setw(47) << pattern.name << std::right << std::setw(13) << rates[0] << std::setw(12) << rates[1] << std::setw(13) << rates[2]
+					<< std::setw(7) << rates[1] / rates[0] << "x" << std::setw(7) << rates[2] / rates[0] << "x\n";
+			}
+
+			constexpr double bytesPerMB{ 1024.0 * 1024.0 };
+			std::cout << "  sizes: " << textures[0]->GetSize() / bytesPerMB << " / " << textures[1]->GetSize() / bytesPerMB << " / " << textures[2]->GetSize() / bytesPerMB
+				<< " MB, " << (numMismatches == 0 ? "every layout samples the same" : std::to_string(numMismatches) + " mismatches between layouts") << "\n";
+		}
+
+		void SoftwareRendering(const std::string& directory, int numFrames, const std::string& imagePath)
+		{
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			ThreadPool threadPool{};
+
+			//Fill rule: two triangles sharing the diagonal of the whole screen have to cover every pixel exactly once
+			const Vertex quadVertices[]{ { { -1.f, 1.f, 0.5f } }, { { 1.f, 1.f, 0.5f } }, { { 1.f, -1.f, 0.5f } }, { { -1.f, -1.f, 0.5f } } };
+			const uint32_t quadIndices[]{ 0, 1, 2, 0, 2, 3 };
+			SoftwareRasterizer quadRasterizer{ width, height };
+			quadRasterizer.Clear({});
+			quadRasterizer.Draw({ quadVertices, quadIndices });
+			const bool isWatertight = quadRasterizer.GetStats().numPixelsCovered == uint64_t(width) * height;
+
+			//The same assets and formats as Renderer
+			const std::string meshPath = (std::filesystem::path{ directory } / "vehicle.obj").string();
+			const auto pMesh = MeshAsset::Load(meshPath, { .obj = { .pThreadPool = &threadPool } });
+			if (!pMesh)
+			{
+				std::cout << "Couldn't load " << meshPath << "\n";
+				return;
+			}
+			const auto getPath = [&directory](const char* pName) { return (std::filesystem::path{ directory } / pName).string(); };
+			const auto pDiffuse = TextureAsset::Load(getPath("vehicle_diffuse.png"), { { .content = MipContent::Color, .pThreadPool = &threadPool }, TextureFormat::BC1 });
+			const auto pNormal = TextureAsset::Load(getPath("vehicle_normal.png"), { { .content = MipContent::Normal, .pThreadPool = &threadPool }, TextureFormat::BC5 });
+			const auto pSpecularGloss = TextureAsset::LoadPacked(getPath("vehicle_specular.png"), getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &threadPool }, TextureFormat::BC3 });
+			if (!pDiffuse || !pNormal || !pSpecularGloss)
+			{
+				std::cout << "Couldn't load the maps in " << directory << "\n";
+				return;
+			}
+			const auto pDiffuseTexture = CPUTexture::Create(*pDiffuse, TexelLayout::Tiled);
+			const auto pNormalTexture = CPUTexture::Create(*pNormal, TexelLayout::Tiled);
+			const auto pSpecularGlossTexture = CPUTexture::Create(*pSpecularGloss, TexelLayout::Tiled);
+
+			const std::span<const uint32_t> indices = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, static_cast<float>(width) / height);
+			camera.CalculateViewMatrix();
+
+			SoftwareRasterizer::DrawCall drawCall{};
+			drawCall.vertices = pMesh->GetVertices();
+			drawCall.indices = indices;
+			drawCall.cameraPosition = camera.origin;
+			drawCall.material = { pDiffuseTexture.get(), pNormalTexture.get(), pSpecularGlossTexture.get() };
+
+			std::cout << std::fixed << std::setprecision(2) << "Software rendering: " << meshPath << ", " << pMesh->GetVertices().size() << " vertices, " << indices.size() / 3
+				<< " triangles at " << width << "x" << height << ", " << numFrames << " frames of a full turn, " << (isWatertight ? "fill rule watertight" : "fill rule leaves gaps or overlaps") << "\n"
+				<< "  filter        threads  ms/frame     fps  visible tris  covered px  shaded px  overdraw\n";
+
+			const std::pair<const char*, SamplerFilter> filters[]{ { "point", SamplerFilter::Point }, { "linear", SamplerFilter::Linear }, { "anisotropic", SamplerFilter::Anisotropic } };
+			for (const auto& [pName, filter] : filters)
+			{
+				for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+				{
+					SoftwareRasterizer rasterizer{ width, height, pThreadPool };
+					drawCall.filter = filter;
+
+					//Stats summed over the turn, the frame time is the mean
+					SoftwareRasterizer::Stats total{};
+					const auto start = std::chrono::steady_clock::now();
+					for (int frame{}; frame < numFrames; ++frame)
+					{
+						drawCall.worldMatrix = Matrix::CreateRotationY(360.f * TO_RADIANS * frame / numFrames);
+						drawCall.worldViewProjMatrix = drawCall.worldMatrix * camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+						rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+						rasterizer.Draw(drawCall);
+
+						const SoftwareRasterizer::Stats& stats = rasterizer.GetStats();
+						total.numRasterized += stats.numRasterized;
+						total.numPixelsCovered += stats.numPixelsCovered;
+						total.numPixelsShaded += stats.numPixelsShaded;
+					}
+					const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+					const uint32_t numThreads = pThreadPool ? pThreadPool->GetNumWorkers() + 1 : 1;
+					std::cout << "  " << std::left << std::setw(12) << pName << std::right << std::setw(9) << numThreads << std::setw(10) << frameMs << std::setw(8) << 1000.0 / frameMs
+						<< std::setw(14) << total.numRasterized / numFrames << std::setw(12) << total.numPixelsCovered / numFrames << std::setw(11) << total.numPixelsShaded / numFrames
+						<< std::setw(10) << double(total.numPixelsCovered) / std::max(total.numPixelsShaded, uint64_t(1)) << "\n";
+
+					//The last frame of the threaded linear run, as a binary PPM
+					if (!imagePath.empty() && pThreadPool && filter == SamplerFilter::Linear)
+					{
+						std::ofstream image{ imagePath, std::ios::binary };
+						image << "P6\n" << width << " " << height << "\n255\n";
+						for (const uint32_t texel : rasterizer.GetColorBuffer())
+						{
+							const char rgb[3]{ static_cast<char>(texel & 0xFF), static_cast<char>((texel >> 8) & 0xFF), static_cast<char>((texel >> 16) & 0xFF) };
+							image.write(rgb, 3);
+						}
+						std::cout << "  wrote " << imagePath << "\n";
+					}
+				}
+			}
+		}
+
+		void RasterScaling(const std::string& directory, int maxThreads, int numFrames)
+		{
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			ThreadPool loadPool{};
+			const std::string meshPath = (std::filesystem::path{ directory } / "vehicle.obj").string();
+			const auto pMesh = MeshAsset::Load(meshPath, { .obj = { .pThreadPool = &loadPool } });
+			const auto getPath = [&directory](const char* pName) { return (std::filesystem::path{ directory } / pName).string(); };
+			const auto pDiffuse = TextureAsset::Load(getPath("vehicle_diffuse.png"), { { .content = MipContent::Color, .pThreadPool = &loadPool }, TextureFormat::BC1 });
+			const auto pNormal = TextureAsset::Load(getPath("vehicle_normal.png"), { { .content = MipContent::Normal, .pThreadPool = &loadPool }, TextureFormat::BC5 });
+			const auto pSpecularGloss = TextureAsset::LoadPacked(getPath("vehicle_specular.png"), getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC3 });
+			if (!pMesh || !pDiffuse || !pNormal || !pSpecularGloss)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const auto pDiffuseTexture = CPUTexture::Create(*pDiffuse, TexelLayout::Tiled);
+			const auto pNormalTexture = CPUTexture::Create(*pNormal, TexelLayout::Tiled);
+			const auto pSpecularGlossTexture = CPUTexture::Create(*pSpecularGloss, TexelLayout::Tiled);
+			const SoftwareMaterial material{ pDiffuseTexture.get(), pNormalTexture.get(), pSpecularGlossTexture.get() };
+
+			//Screen aligned grids straight in clip space, layers front facing and drawn back to front so every layer gets shaded
+			const auto createGrid = [](float left, float top, float right, float bottom, uint32_t numColumns, uint32_t numRows, uint32_t numLayers, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+				{
+					for (uint32_t layer{}; layer < numLayers; ++layer)
+					{
+						const float depth = 0.9f - 0.8f * layer / numLayers;
+						const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+						for (uint32_t row{}; row <= numRows; ++row)
+						{
+							for (uint32_t column{}; column <= numColumns; ++column)
+							{
+								const float u = static_cast<float>(column) / numColumns, v = static_cast<float>(row) / numRows;
+								vertices.push_back({ { left + (right - left) * u, top + (bottom - top) * v, depth }, { u * 4.f, v * 4.f }, { 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f } });
+							}
+						}
+						for (uint32_t row{}; row < numRows; ++row)
+						{
+							for (uint32_t column{}; column < numColumns; ++column)
+							{
+								const uint32_t topLeft = firstVertex + row * (numColumns + 1) + column, bottomLeft = topLeft + numColumns + 1;
+								indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft + 1, topLeft, bottomLeft + 1, bottomLeft });
+							}
+						}
+					}
+				};
+
+			struct Scene
+			{
+				std::string name{};
+				std::vector<Vertex> vertices{};
+				std::vector<uint32_t> indices{};
+				//The vehicle turns, the grids stand still
+				bool isTurning{};
+			};
+			std::vector<Scene> scenes(3);
+			scenes[0].name = "vehicle";
+			scenes[0].vertices.assign(pMesh->GetVertices().begin(), pMesh->GetVertices().end());
+			const std::span<const uint32_t> lod0 = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+			scenes[0].indices.assign(lod0.begin(), lod0.end());
+			scenes[0].isTurning = true;
+			//About 3x3 pixel quads over the whole screen, every tile alike
+			scenes[1].name = "dense grid";
+			createGrid(-1.f, 1.f, 1.f, -1.f, 213, 160, 1, scenes[1].vertices, scenes[1].indices);
+			//As many triangles in 8 layers over a 128x128 spot, a few tiles hold all the work like the vehicle's front end
+			scenes[2].name = "dense hotspot";
+			createGrid(-0.2f, 0.2667f, 0.2f, -0.2667f, 75, 57, 8, scenes[2].vertices, scenes[2].indices);
+
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, static_cast<float>(width) / height);
+			camera.CalculateViewMatrix();
+
+			std::vector<uint32_t> threadCounts{};
+			for (uint32_t numThreads{ 1 }; numThreads < static_cast<uint32_t>(maxThreads); numThreads *= 2)
+				threadCounts.push_back(numThreads);
+			threadCounts.push_back(static_cast<uint32_t>(std::max(maxThreads, 1)));
+
+			std::cout << std::fixed << std::setprecision(2) << "Raster scaling: " << width << "x" << height << " in 64x64 tiles, " << numFrames << " frames per run, "
+				<< std::thread::hardware_concurrency() << " hardware threads\n"
+				<< "  scene          triangles  threads  ms/frame  speedup  steals/frame  max/mean tile  max/mean thread  image\n";
+			for (Scene& scene : scenes)
+			{
+				double singleThreadMs{};
+				std::vector<uint32_t> reference{};
+				for (const uint32_t numThreads : threadCounts)
+				{
+					ThreadPool threadPool{ numThreads - 1 };
+					SoftwareRasterizer rasterizer{ width, height, &threadPool };
+					SoftwareRasterizer::DrawCall drawCall{ scene.vertices, scene.indices };
+					drawCall.material = material;
+					drawCall.cameraPosition = scene.isTurning ? camera.origin : Vector3{ 0.f, 0.f, -1.f };
+
+					//Tile and thread time summed over the frames, so one slow frame doesn't decide the imbalance
+					std::vector<double> tileMs(size_t(rasterizer.GetNumTilesX()) * rasterizer.GetNumTilesY());
+					std::vector<double> threadMs(numThreads);
+					uint32_t numSteals{};
+					const auto start = std::chrono::steady_clock::now();
+					for (int frame{}; frame < numFrames; ++frame)
+					{
+						if (scene.isTurning)
+						{
+							drawCall.worldMatrix = Matrix::CreateRotationY(360.f * TO_RADIANS * frame / numFrames);
+							drawCall.worldViewProjMatrix = drawCall.worldMatrix * camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+						}
+						rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+						rasterizer.Draw(drawCall);
+
+						numSteals += rasterizer.GetStats().numSteals;
+						const std::span<const SoftwareRasterizer::TileStats> tiles = rasterizer.GetTileStats();
+						for (size_t tile{}; tile < tiles.size(); ++tile)
+						{
+							tileMs[tile] += tiles[tile].ms;
+							threadMs[tiles[tile].thread] += tiles[tile].ms;
+						}
+					}
+					const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+					//Every thread count has to draw the very same last frame
+					const std::span<const uint32_t> colorBuffer = rasterizer.GetColorBuffer();
+					if (reference.empty())
+					{
+						reference.assign(colorBuffer.begin(), colorBuffer.end());
+						singleThreadMs = frameMs;
+					}
+					const bool isIdentical = std::equal(colorBuffer.begin(), colorBuffer.end(), reference.begin());
+
+					const auto getImbalance = [](const std::vector<double>& values)
+						{
+							const double sum = std::accumulate(values.begin(), values.end(), 0.0);
+							return sum > 0.0 ? *std::max_element(values.begin(), values.end()) * values.size() / sum : 1.0;
+						};
+					std::cout << "  " << std::left << std::setw(13) << scene.name << std::right << std::setw(11) << scene.indices.size() / 3 << std::setw(9) << numThreads
+						<< std::setw(10) << frameMs << std::setw(8) << singleThreadMs / frameMs << "x" << std::setw(14) << double(numSteals) / numFrames
+						<< std::setw(15) << getImbalance(tileMs) << std::setw(17) << getImbalance(threadMs) << "  " << (isIdentical ? "same" : "DIFFERS") << "\n";
+				}
+			}
+		}
+
+		void RasterKernels(const std::string& directory, int numBatches, int seed)
+		{
+			std::vector<RasterKernel> kernels{ RasterKernel::Scalar, RasterKernel::SSE };
+			if (SoftwareRasterizer::GetBestKernel() == RasterKernel::AVX2)
+				kernels.push_back(RasterKernel::AVX2);
+			const auto getKernelName = [](RasterKernel kernel) { return kernel == RasterKernel::Scalar ? "scalar" : kernel == RasterKernel::SSE ? "sse" : "avx2"; };
+
+			//Coverage against a plain 64 bit edge function rasterizer. At 256x256 a corner given in 1/16 pixels survives the trip through clip
+			//space exactly. Every triangle has its own constant depth rising with draw order, so the depth buffer tells which triangle
+			//owns a pixel: the first one covering it. Hierarchical Z is off, the kernels have to cover every pixel themselves.
+			constexpr int size{ 256 };
+			struct Corner
+			{
+				int64_t x{};
+				int64_t y{};
+			};
+			const auto referenceRaster = [](const Corner* pCorners, std::vector<int>& owners, std::vector<int>& coverage, int triangle)
+				{
+					//Clockwise on screen (y down) is front facing, pixels exactly on a top or left edge are covered
+					const auto cross = [](const Corner& from, const Corner& to, int64_t x, int64_t y) { return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x); };
+					if (cross(pCorners[0], pCorners[1], pCorners[2].x, pCorners[2].y) <= 0)
+						return;
+					bool isTopLeft[3]{};
+					for (int edge{}; edge < 3; ++edge)
+					{
+						const Corner& from = pCorners[edge];
+						const Corner& to = pCorners[(edge + 1) % 3];
+						isTopLeft[edge] = (to.y == from.y && to.x > from.x) || to.y < from.y;
+					}
+					//Whole pixels around the corners, the edge functions decide the rest
+					const auto [minX, maxX] = std::minmax({ pCorners[0].x, pCorners[1].x, pCorners[2].x });
+					const auto [minY, maxY] = std::minmax({ pCorners[0].y, pCorners[1].y, pCorners[2].y });
+					for (int y{ std::max(static_cast<int>(minY / 16) - 1, 0) }; y <= std::min(static_cast<int>(maxY / 16) + 1, size - 1); ++y)
+					{
+						for (int x{ std::max(static_cast<int>(minX / 16) - 1, 0) }; x <= std::min(static_cast<int>(maxX / 16) + 1, size - 1); ++x)
+						{
+							bool isInside{ true };
+							for (int edge{}; edge < 3 && isInside; ++edge)
+							{
+								const int64_t value = cross(pCorners[edge], pCorners[(edge + 1) % 3], x * 16 + 8, y * 16 + 8);
+								isInside = value > 0 || (value == 0 && isTopLeft[edge]);
+							}
+							if (!isInside)
+								continue;
+							const size_t pixel = size_t(y) * size + x;
+							++coverage[pixel];
+							if (owners[pixel] < 0)
+								owners[pixel] = triangle;
+						}
+					}
+				};
+
+			std::mt19937 random{ static_cast<uint32_t>(seed) };
+			std::cout << "Raster kernels: " << getKernelName(SoftwareRasterizer::GetBestKernel()) << " is the widest this CPU runs\n"
+				<< "  coverage of " << numBatches << " random batches at " << size << "x" << size << " against a 64 bit reference:\n"
+				<< "  kernel    triangles  covered px  wrong owners  wrong counts\n";
+			std::vector<uint64_t> wrongOwners(kernels.size()), wrongCounts(kernels.size());
+			uint64_t numTriangles{}, numCovered{}, numGridPixels{}, numGridMisses{}, numGridOverlaps{};
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<Corner> corners{};
+			for (int batch{}; batch < numBatches; ++batch)
+			{
+				//Batches take turns: corners anywhere on the 1/16 grid, corners on half pixels so edges run through pixel centers, and a
+				//jittered grid of shared edges that has to cover every pixel exactly once
+				corners.clear();
+				const int kind{ batch % 3 };
+				if (kind < 2)
+				{
+					const int64_t snap = kind == 0 ? 1 : 8;
+					std::uniform_int_distribution<int> countDistribution{ 50, 400 };
+					std::uniform_int_distribution<int64_t> positionDistribution{ -16 * 16, (size + 16) * 16 };
+					std::uniform_int_distribution<int64_t> extentDistribution{ -24 * 16, 24 * 16 };
+					std::uniform_int_distribution<int64_t> largeExtentDistribution{ -160 * 16, 160 * 16 };
+					const int count = countDistribution(random);
+					for (int triangle{}; triangle < count; ++triangle)
+					{
+						//Mostly small ones, every tenth spans several tiles. Either winding, the back facing ones have to stay out.
+						const Corner first{ positionDistribution(random) / snap * snap, positionDistribution(random) / snap * snap };
+						auto& extents = triangle % 10 == 0 ? largeExtentDistribution : extentDistribution;
+						corners.push_back(first);
+						for (int corner{ 1 }; corner < 3; ++corner)
+							corners.push_back({ (first.x + extents(random)) / snap * snap, (first.y + extents(random)) / snap * snap });
+					}
+				}
+				else
+				{
+					//Inner grid points jitter by less than a quarter cell so the quads stay convex, those on the border stay on the screen's edge
+					constexpr int numCells{ 16 };
+					constexpr int64_t cellSize{ size * 16 / numCells };
+					std::uniform_int_distribution<int64_t> jitterDistribution{ -cellSize * 3 / 16, cellSize * 3 / 16 };
+					std::vector<Corner> points{};
+					for (int row{}; row <= numCells; ++row)
+					{
+						for (int column{}; column <= numCells; ++column)
+						{
+							const bool isBorderX = column == 0 || column == numCells, isBorderY = row == 0 || row == numCells;
+							points.push_back({ column * cellSize + (isBorderX ? 0 : jitterDistribution(random)), row * cellSize + (isBorderY ? 0 : jitterDistribution(random)) });
+						}
+					}
+					for (int row{}; row < numCells; ++row)
+					{
+						for (int column{}; column < numCells; ++column)
+						{
+							const int topLeft{ row * (numCells + 1) + column }, bottomLeft{ topLeft + numCells + 1 };
+							corners.insert(corners.end(), { points[topLeft], points[topLeft + 1], points[bottomLeft + 1], points[topLeft], points[bottomLeft + 1], points[bottomLeft] });
+						}
+					}
+				}
+
+				const uint32_t count = static_cast<uint32_t>(corners.size() / 3);
+				vertices.clear();
+				indices.clear();
+				for (uint32_t index{}; index < corners.size(); ++index)
+				{
+					const float depth = (index / 3 + 1.f) / (count + 1.f);
+					vertices.push_back({ { corners[index].x / 2048.f - 1.f, 1.f - corners[index].y / 2048.f, depth } });
+					indices.push_back(index);
+				}
+
+				std::vector<int> owners(size_t(size) * size, -1), coverage(size_t(size) * size);
+				for (uint32_t triangle{}; triangle < count; ++triangle)
+					referenceRaster(&corners[size_t(triangle) * 3], owners, coverage, static_cast<int>(triangle));
+				const uint64_t batchCovered = std::accumulate(coverage.begin(), coverage.end(), uint64_t{});
+				numTriangles += count;
+				numCovered += batchCovered;
+				if (kind == 2)
+				{
+					numGridPixels += coverage.size();
+					numGridMisses += std::count(coverage.begin(), coverage.end(), 0);
+					numGridOverlaps += std::count_if(coverage.begin(), coverage.end(), [](int covered) { return covered > 1; });
+				}
+
+				for (size_t kernel{}; kernel < kernels.size(); ++kernel)
+				{
+					SoftwareRasterizer rasterizer{ size, size };
+					rasterizer.SetKernel(kernels[kernel]);
+					rasterizer.SetHierarchicalZ(false);
+					SoftwareRasterizer::DrawCall drawCall{ vertices, indices };
+					drawCall.isDepthOnly = true;
+					rasterizer.Clear(ColorRGB{});
+					rasterizer.Draw(drawCall);
+
+					const std::span<const float> depthBuffer = rasterizer.GetDepthBuffer();
+					for (size_t pixel{}; pixel < depthBuffer.size(); ++pixel)
+					{
+						const int owner = depthBuffer[pixel] < 1.f ? static_cast<int>(std::lround(depthBuffer[pixel] * (count + 1.f))) - 1 : -1;
+						wrongOwners[kernel] += owner != owners[pixel];
+					}
+					wrongCounts[kernel] += rasterizer.GetStats().numPixelsCovered != batchCovered;
+				}
+			}
+			for (size_t kernel{}; kernel < kernels.size(); ++kernel)
+			{
+				std::cout << "  " << std::left << std::setw(8) << getKernelName(kernels[kernel]) << std::right << std::setw(11) << numTriangles << std::setw(12) << numCovered
+					<< std::setw(14) << wrongOwners[kernel] << std::setw(14) << wrongCounts[kernel] << "\n";
+			}
+			std::cout << "  shared edge grids: " << numGridPixels << " px, " << numGridMisses << " missed, " << numGridOverlaps << " covered twice\n";
+
+			//Throughput on the vehicle and on large random triangles at 640x480, single threaded and over the time spent in tiles so
+			//only the kernel differs
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			ThreadPool loadPool{};
+			const auto getPath = [&directory](const char* pName) { return (std::filesystem::path{ directory } / pName).string(); };
+			const auto pMesh = MeshAsset::Load(getPath("vehicle.obj"), { .obj = { .pThreadPool = &loadPool } });
+			const auto pDiffuse = TextureAsset::Load(getPath("vehicle_diffuse.png"), { { .content = MipContent::Color, .pThreadPool = &loadPool }, TextureFormat::BC1 });
+			const auto pNormal = TextureAsset::Load(getPath("vehicle_normal.png"), { { .content = MipContent::Normal, .pThreadPool = &loadPool }, TextureFormat::BC5 });
+			const auto pSpecularGloss = TextureAsset::LoadPacked(getPath("vehicle_specular.png"), getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC3 });
+			if (!pMesh || !pDiffuse || !pNormal || !pSpecularGloss)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const auto pDiffuseTexture = CPUTexture::Create(*pDiffuse, TexelLayout::Tiled);
+			const auto pNormalTexture = CPUTexture::Create(*pNormal, TexelLayout::Tiled);
+			const auto pSpecularGlossTexture = CPUTexture::Create(*pSpecularGloss, TexelLayout::Tiled);
+
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, static_cast<float>(width) / height);
+			camera.CalculateViewMatrix();
+			const std::span<const uint32_t> lod0 = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+			SoftwareRasterizer::DrawCall vehicle{ pMesh->GetVertices(), lod0 };
+			vehicle.material = { pDiffuseTexture.get(), pNormalTexture.get(), pSpecularGlossTexture.get() };
+			vehicle.cameraPosition = camera.origin;
+			vehicle.worldMatrix = Matrix::CreateRotationY(30.f * TO_RADIANS);
+			vehicle.worldViewProjMatrix = vehicle.worldMatrix * camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+
+			//Front facing, each 20 to 120 pixels across with a slope in depth and w so the perspective correction does something
+			std::vector<Vertex> largeVertices{};
+			std::vector<uint32_t> largeIndices{};
+			std::uniform_real_distribution<float> centerDistribution{ -1.f, 1.f }, extentDistribution{ 20.f, 120.f }, angleDistribution{ 0.f, 2.f * PI }, wDistribution{ 1.f, 3.f };
+			for (uint32_t triangle{}; triangle < 2000; ++triangle)
+			{
+				const float centerX = centerDistribution(random), centerY = centerDistribution(random), angle = angleDistribution(random);
+				const float radiusX = extentDistribution(random) / width, radiusY = extentDistribution(random) / height;
+				for (int corner{}; corner < 3; ++corner)
+				{
+					//Counterclockwise in clip space is clockwise on screen
+					const float cornerAngle = angle + corner * 2.f * PI / 3.f;
+					const float w = wDistribution(random);
+					largeVertices.push_back({ { (centerX + std::cos(cornerAngle) * radiusX) * w, (centerY + std::sin(cornerAngle) * radiusY) * w, 0.5f * w }, { corner * 0.5f, corner % 2 * 1.f },
+						{ 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f } });
+					largeIndices.push_back(static_cast<uint32_t>(largeIndices.size()));
+				}
+			}
+			SoftwareRasterizer::DrawCall large{ largeVertices, largeIndices };
+			large.material = vehicle.material;
+			large.cameraPosition = { 0.f, 0.f, -1.f };
+
+			struct Scene
+			{
+				const char* pName{};
+				const SoftwareRasterizer::DrawCall* pDrawCall{};
+			};
+			const Scene scenes[]{ { "vehicle", &vehicle }, { "large triangles", &large } };
+			constexpr int numFrames{ 10 };
+			std::cout << std::fixed << std::setprecision(2) << "  throughput at " << width << "x" << height << ", " << numFrames << " frames, 1 thread, covered Mpixels per second rasterizing tiles:\n"
+				<< "  scene            kernel   depth only  speedup    shaded  speedup  image\n";
+			for (const Scene& scene : scenes)
+			{
+				double scalarRates[2]{};
+				std::vector<uint32_t> reference{};
+				for (const RasterKernel kernel : kernels)
+				{
+					SoftwareRasterizer rasterizer{ width, height };
+					rasterizer.SetKernel(kernel);
+					rasterizer.SetHierarchicalZ(false);
+					double rates[2]{};
+					for (int pass{}; pass < 2; ++pass)
+					{
+						SoftwareRasterizer::DrawCall drawCall = *scene.pDrawCall;
+						drawCall.isDepthOnly = pass == 0;
+						uint64_t numPixels{};
+						double tileMs{};
+						for (int frame{}; frame < numFrames; ++frame)
+						{
+							rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+							rasterizer.Draw(drawCall);
+							numPixels += rasterizer.GetStats().numPixelsCovered;
+							for (const SoftwareRasterizer::TileStats& tile : rasterizer.GetTileStats())
+								tileMs += tile.ms;
+						}
+						rates[pass] = numPixels / (tileMs * 1000.0);
+						if (kernel == RasterKernel::Scalar)
+							scalarRates[pass] = rates[pass];
+					}
+
+					//The shaded frame has to match the scalar kernel's bit for bit
+					const std::span<const uint32_t> colorBuffer = rasterizer.GetColorBuffer();
+					if (reference.empty())
+						reference.assign(colorBuffer.begin(), colorBuffer.end());
+					const bool isIdentical = std::equal(colorBuffer.begin(), colorBuffer.end(), reference.begin());
+					std::cout << "  " << std::left << std::setw(17) << scene.pName << std::setw(6) << getKernelName(kernel) << std::right << std::setw(13) << rates[0]
+						<< std::setw(8) << rates[0] / scalarRates[0] << "x" << std::setw(10) << rates[1] << std::setw(8) << rates[1] / scalarRates[1] << "x  "
+						<< (isIdentical ? "same" : "DIFFERS") << "\n";
+				}
+			}
+		}
+
+		void HierarchicalZ(const std::string& directory, int numFrames)
+		{
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			ThreadPool loadPool{};
+			const auto getPath = [&directory](const char* pName) { return (std::filesystem::path{ directory } / pName).string(); };
+			const auto pMesh = MeshAsset::Load(getPath("vehicle.obj"), { .obj = { .pThreadPool = &loadPool } });
+			const auto pDiffuse = TextureAsset::Load(getPath("vehicle_diffuse.png"), { { .content = MipContent::Color, .pThreadPool = &loadPool }, TextureFormat::BC1 });
+			const auto pNormal = TextureAsset::Load(getPath("vehicle_normal.png"), { { .content = MipContent::Normal, .pThreadPool = &loadPool }, TextureFormat::BC5 });
+			const auto pSpecularGloss = TextureAsset::LoadPacked(getPath("vehicle_specular.png"), getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC3 });
+			if (!pMesh || !pDiffuse || !pNormal || !pSpecularGloss)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const auto pDiffuseTexture = CPUTexture::Create(*pDiffuse, TexelLayout::Tiled);
+			const auto pNormalTexture = CPUTexture::Create(*pNormal, TexelLayout::Tiled);
+			const auto pSpecularGlossTexture = CPUTexture::Create(*pSpecularGloss, TexelLayout::Tiled);
+			const SoftwareMaterial material{ pDiffuseTexture.get(), pNormalTexture.get(), pSpecularGlossTexture.get() };
+
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, static_cast<float>(width) / height);
+			camera.CalculateViewMatrix();
+			const Matrix viewProjection = camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+			const std::span<const uint32_t> lod0 = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+
+			//A column of vehicles straight ahead, each a bit off the line so the ones behind peek out
+			constexpr int numVehicles{ 8 };
+			std::vector<SoftwareRasterizer::DrawCall> vehicles{};
+			for (int vehicle{}; vehicle < numVehicles; ++vehicle)
+			{
+				SoftwareRasterizer::DrawCall drawCall{ pMesh->GetVertices(), lod0 };
+				drawCall.material = material;
+				drawCall.cameraPosition = camera.origin;
+				drawCall.worldMatrix = Matrix::CreateRotationY(40.f * TO_RADIANS * vehicle) * Matrix::CreateTranslation({ 1.5f * (vehicle % 3 - 1), 0.5f * (vehicle % 2), 12.f * vehicle });
+				drawCall.worldViewProjMatrix = drawCall.worldMatrix * viewProjection;
+				vehicles.push_back(drawCall);
+			}
+
+			//Screen filling walls of small quads straight in clip space, front facing and one behind the other
+			constexpr int numWalls{ 8 }, numColumns{ 64 }, numRows{ 48 };
+			std::vector<Vertex> wallVertices{};
+			std::vector<uint32_t> wallIndices{};
+			for (int wall{}; wall < numWalls; ++wall)
+			{
+				const float depth = 0.1f + 0.8f * static_cast<float>(wall) / numWalls;
+				const uint32_t firstVertex = static_cast<uint32_t>(wallVertices.size());
+				for (int row{}; row <= numRows; ++row)
+				{
+					for (int column{}; column <= numColumns; ++column)
+					{
+						const float u = static_cast<float>(column) / numColumns, v = static_cast<float>(row) / numRows;
+						wallVertices.push_back({ { u * 2.f - 1.f, 1.f - v * 2.f, depth }, { u * 4.f, v * 4.f }, { 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f } });
+					}
+				}
+				for (int row{}; row < numRows; ++row)
+				{
+					for (int column{}; column < numColumns; ++column)
+					{
+						const uint32_t topLeft = firstVertex + row * (numColumns + 1) + column, bottomLeft = topLeft + numColumns + 1;
+						wallIndices.insert(wallIndices.end(), { topLeft, topLeft + 1, bottomLeft + 1, topLeft, bottomLeft + 1, bottomLeft });
+					}
+				}
+			}
+			std::vector<SoftwareRasterizer::DrawCall> walls{};
+			const size_t numWallIndices = wallIndices.size() / numWalls;
+			for (int wall{}; wall < numWalls; ++wall)
+			{
+				SoftwareRasterizer::DrawCall drawCall{ wallVertices, std::span<const uint32_t>{ wallIndices }.subspan(numWallIndices * wall, numWallIndices) };
+				drawCall.material = material;
+				drawCall.cameraPosition = { 0.f, 0.f, -1.f };
+				walls.push_back(drawCall);
+			}
+
+			//Front to back is what hierarchical Z is for, back to front every layer is in front of the last and nothing can be skipped
+			struct Scene
+			{
+				std::string name{};
+				std::vector<SoftwareRasterizer::DrawCall> drawCalls{};
+			};
+			std::vector<Scene> scenes{ { "vehicles near first", vehicles }, { "vehicles far first", { vehicles.rbegin(), vehicles.rend() } },
+				{ "walls near first", walls }, { "walls far first", { walls.rbegin(), walls.rend() } } };
+
+			std::cout << std::fixed << std::setprecision(2) << "Hierarchical Z: " << width << "x" << height << ", 8x8 blocks in 64x64 tiles, " << numFrames
+				<< " frames per run, 1 thread\n"
+				<< "  scene                HiZ  ms/frame  speedup  shaded px  covered px  skipped tris  skipped blocks  skipped px  image\n";
+			for (const Scene& scene : scenes)
+			{
+				double offMs{};
+				std::vector<uint32_t> reference{};
+				for (const bool isEnabled : { false, true })
+				{
+					SoftwareRasterizer rasterizer{ width, height };
+					rasterizer.SetHierarchicalZ(isEnabled);
+					const auto start = std::chrono::steady_clock::now();
+					for (int frame{}; frame < numFrames; ++frame)
+					{
+						rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+						for (const SoftwareRasterizer::DrawCall& drawCall : scene.drawCalls)
+							rasterizer.Draw(drawCall);
+					}
+					const double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+					const std::span<const uint32_t> colorBuffer = rasterizer.GetColorBuffer();
+					if (reference.empty())
+					{
+						reference.assign(colorBuffer.begin(), colorBuffer.end());
+						offMs = frameMs;
+					}
+					const bool isIdentical = std::equal(colorBuffer.begin(), colorBuffer.end(), reference.begin());
+
+					const SoftwareRasterizer::Stats& stats = rasterizer.GetStats();
+					std::cout << "  " << std::left << std::setw(20) << scene.name << std::right << std::setw(5) << (isEnabled ? "on" : "off") << std::setw(10) << frameMs
+						<< std::setw(8) << offMs / frameMs << "x" << std::setw(11) << stats.numPixelsShaded << std::setw(12) << stats.numPixelsCovered << std::setw(14)
+						<< stats.numHiZTriangles << std::setw(16) << stats.numHiZBlocks << std::setw(12) << stats.numHiZPixels << "  " << (isIdentical ? "same" : "DIFFERS") << "\n";
+				}
+			}
+		}
+
+		void ShadingKernels(const std::string& directory, int numFrames)
+		{
+			ThreadPool loadPool{};
+			const auto getPath = [&directory](const char* pName) { return (std::filesystem::path{ directory } / pName).string(); };
+			const auto pMesh = MeshAsset::Load(getPath("vehicle.obj"), { .obj = { .pThreadPool = &loadPool } });
+			const auto pDiffuse = TextureAsset::Load(getPath("vehicle_diffuse.png"), { { .content = MipContent::Color, .pThreadPool = &loadPool }, TextureFormat::BC1 });
+			const auto pNormal = TextureAsset::Load(getPath("vehicle_normal.png"), { { .content = MipContent::Normal, .pThreadPool = &loadPool }, TextureFormat::BC5 });
+			const auto pSpecular = TextureAsset::Load(getPath("vehicle_specular.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC1 });
+			const auto pGlossiness = TextureAsset::Load(getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC4 });
+			const auto pSpecularGloss = TextureAsset::LoadPacked(getPath("vehicle_specular.png"), getPath("vehicle_gloss.png"), { { .content = MipContent::Data, .pThreadPool = &loadPool }, TextureFormat::BC3 });
+			if (!pMesh || !pDiffuse || !pNormal || !pSpecular || !pGlossiness || !pSpecularGloss)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const auto pDiffuseTexture = CPUTexture::Create(*pDiffuse, TexelLayout::Tiled);
+			const auto pNormalTexture = CPUTexture::Create(*pNormal, TexelLayout::Tiled);
+			const auto pSpecularTexture = CPUTexture::Create(*pSpecular, TexelLayout::Tiled);
+			const auto pGlossinessTexture = CPUTexture::Create(*pGlossiness, TexelLayout::Tiled);
+			const auto pSpecularGlossTexture = CPUTexture::Create(*pSpecularGloss, TexelLayout::Tiled);
+			const std::span<const uint32_t> lod0 = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+
+			//Every kernel of the dispatch table: filter x normal map x no, separate or packed specular maps
+			const char* filterNames[]{ "point", "linear", "anisotropic" };
+			const char* specularNames[]{ "none", "separate", "packed" };
+			struct Variant
+			{
+				SamplerFilter filter{};
+				bool isNormalMapped{};
+				int specularMaps{};
+			};
+			std::vector<Variant> variants{};
+			for (const SamplerFilter filter : { SamplerFilter::Point, SamplerFilter::Linear, SamplerFilter::Anisotropic })
+			{
+				for (const bool isNormalMapped : { false, true })
+				{
+					for (int specularMaps{}; specularMaps < 3; ++specularMaps)
+						variants.push_back({ filter, isNormalMapped, specularMaps });
+				}
+			}
+
+			//Close enough for the vehicle to fill most of the screen, single threaded so the shading is all there is to compare
+			const std::pair<uint32_t, uint32_t> resolutions[]{ { 320, 240 }, { 640, 480 }, { 1280, 960 } };
+			std::cout << std::fixed << std::setprecision(2) << "Shading kernels: the vehicle close up, " << numFrames << " frames per run, 1 thread, generic vs specialized\n"
+				<< "  resolution  filter         normal  specular  shaded px  generic ms  specialized ms  Mpx/s generic  Mpx/s specialized  speedup  image\n";
+			for (const auto& [width, height] : resolutions)
+			{
+				Camera camera{};
+				camera.Initialize(45.f, { 0.f, 0.f, -20.f }, static_cast<float>(width) / height);
+				camera.CalculateViewMatrix();
+
+				double sumSpeedups{};
+				for (const Variant& variant : variants)
+				{
+					SoftwareRasterizer::DrawCall drawCall{ pMesh->GetVertices(), lod0 };
+					drawCall.material.pDiffuse = pDiffuseTexture.get();
+					drawCall.material.pNormal = variant.isNormalMapped ? pNormalTexture.get() : nullptr;
+					drawCall.material.pSpecular = variant.specularMaps == 1 ? pSpecularTexture.get() : nullptr;
+					drawCall.material.pGlossiness = variant.specularMaps == 1 ? pGlossinessTexture.get() : nullptr;
+					drawCall.material.pSpecularGloss = variant.specularMaps == 2 ? pSpecularGlossTexture.get() : nullptr;
+					drawCall.filter = variant.filter;
+					drawCall.cameraPosition = camera.origin;
+					drawCall.worldMatrix = Matrix::CreateRotationY(30.f * TO_RADIANS);
+					drawCall.worldViewProjMatrix = drawCall.worldMatrix * camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+
+					//Time in tiles only, setup is the same for both
+					double tileMs[2]{};
+					uint64_t numShaded{};
+					std::vector<uint32_t> images[2]{};
+					for (int mode{}; mode < 2; ++mode)
+					{
+						SoftwareRasterizer rasterizer{ width, height };
+						rasterizer.SetSpecializedShading(mode == 1);
+						for (int frame{}; frame < numFrames; ++frame)
+						{
+							rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+							rasterizer.Draw(drawCall);
+							for (const SoftwareRasterizer::TileStats& tile : rasterizer.GetTileStats())
+								tileMs[mode] += tile.ms;
+						}
+						tileMs[mode] /= numFrames;
+						numShaded = rasterizer.GetStats().numPixelsShaded;
+						images[mode].assign(rasterizer.GetColorBuffer().begin(), rasterizer.GetColorBuffer().end());
+					}
+					sumSpeedups += tileMs[0] / tileMs[1];
+
+					std::cout << "  " << std::setw(4) << width << "x" << std::left << std::setw(6) << height << "  " << std::setw(13) << filterNames[static_cast<int>(variant.filter)]
+						<< std::setw(8) << (variant.isNormalMapped ? "yes" : "no") << std::setw(8) << specularNames[variant.specularMaps] << std::right << std::setw(11) << numShaded
+						<< std::setw(12) << tileMs[0] << std::setw(16) << tileMs[1] << std::setw(15) << numShaded / (tileMs[0] * 1000.0) << std::setw(19)
+						<< numShaded / (tileMs[1] * 1000.0) << std::setw(8) << tileMs[0] / tileMs[1] << "x  " << (images[0] == images[1] ? "same" : "DIFFERS") << "\n";
+				}
+				std::cout << "  " << width << "x" << height << " mean speedup " << sumSpeedups / variants.size() << "x\n";
+			}
+		}
+
+		void VertexProcessing(const std::string& directory, int repeats)
+		{
+			ThreadPool pool{};
+			const auto pMesh = MeshAsset::Load((std::filesystem::path{ directory } / "vehicle.obj").string(), { .obj = { .pThreadPool = &pool } });
+			if (!pMesh)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+
+			//A million vertices around the vehicle's size, some outside every plane of the frustum
+			std::vector<Vertex> synthetic(1 << 20);
+			std::mt19937 random{ 1 };
+			std::uniform_real_distribution<float> position{ -40.f, 40.f };
+			std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+			for (Vertex& vertex : synthetic)
+			{
+				vertex.position = { position(random), position(random), position(random) };
+				vertex.uv = { unit(random), unit(random) };
+				vertex.normal = { unit(random), unit(random), unit(random) + 2.f };
+				vertex.tangent = { unit(random) + 2.f, unit(random), unit(random) };
+			}
+
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, 640.f / 480.f);
+			camera.CalculateViewMatrix();
+			const Matrix world = Matrix::CreateRotationY(30.f * TO_RADIANS);
+			const Matrix worldViewProj = world * camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+
+			//What SoftwareRasterizer::Draw did before: an array of Vertex_Out, one vertex at a time
+			std::vector<Vertex_Out> reference{};
+			const auto transformScalar = [&](std::span<const Vertex> vertices)
+				{
+					reference.resize(vertices.size());
+					for (size_t index{}; index < vertices.size(); ++index)
+					{
+						const Vertex& vertex = vertices[index];
+						Vertex_Out& output = reference[index];
+						output.position = worldViewProj.TransformPoint(Vector4{ vertex.position, 1.f });
+						output.uv = vertex.uv;
+						output.normal = world.TransformVector(vertex.normal.Normalized());
+						output.tangent = world.TransformVector(vertex.tangent.Normalized());
+						output.worldPosition = world.TransformPoint(vertex.position);
+					}
+				};
+			//Bitwise against the reference, clip codes against the frustum tests SetupTriangle did
+			const auto matches = [&reference](const TransformedVertices& output)
+				{
+					for (size_t index{}; index < reference.size(); ++index)
+					{
+						const Vertex_Out actual = output.Get(index);
+						const Vertex_Out& expected = reference[index];
+						if (std::memcmp(&actual.position, &expected.position, sizeof(Vector4)) != 0 || std::memcmp(&actual.uv, &expected.uv, sizeof(Vector2)) != 0
+							|| std::memcmp(&actual.normal, &expected.normal, sizeof(Vector3)) != 0 || std::memcmp(&actual.tangent, &expected.tangent, sizeof(Vector3)) != 0
+							|| std::memcmp(&actual.worldPosition, &expected.worldPosition, sizeof(Vector3)) != 0)
+							return false;
+						const Vector4& p = expected.position;
+						const uint8_t code = (p.x < -p.w ? ClipLeft : 0) | (p.x > p.w ? ClipRight : 0) | (p.y < -p.w ? ClipBottom : 0) | (p.y > p.w ? ClipTop : 0)
+							| (p.w <= 0.f || p.z < 0.f ? ClipNear : 0) | (p.z > p.w ? ClipFar : 0);
+						if (output.clipCodes[index] != code)
+							return false;
+					}
+					return true;
+				};
+
+			const std::pair<const char*, std::span<const Vertex>> buffers[]{ { "vehicle", pMesh->GetVertices() }, { "synthetic", synthetic } };
+			std::cout << std::fixed << std::setprecision(2) << "Vertex processing: best of " << repeats << ", " << pool.GetNumWorkers() + 1 << " threads on the pool\n"
+				<< "  buffer      vertices  path                      ms       Mverts/s  speedup  output\n";
+			for (const auto& [pName, vertices] : buffers)
+			{
+				const double scalarMs = MeasureBestMs(repeats, [&] { transformScalar(vertices); });
+
+				VertexProcessor single{};
+				VertexProcessor parallel{ &pool };
+				const auto print = [&](const char* pPath, double ms, const char* pOutput)
+					{
+						std::cout << "  " << std::left << std::setw(10) << pName << std::right << std::setw(10) << vertices.size() << "  " << std::left << std::setw(22) << pPath
+							<< std::right << std::setw(8) << std::setprecision(3) << ms << std::setw(15) << std::setprecision(1) << vertices.size() / (ms * 1000.0)
+							<< std::setw(8) << std::setprecision(2) << scalarMs / ms << "x  " << pOutput << "\n";
+					};
+				print("AoS TransformPoint", scalarMs, "reference");
+
+				const auto measure = [&](VertexProcessor& processor, bool isSIMDEnabled, const char* pPath)
+					{
+						processor.SetSIMD(isSIMDEnabled);
+						const double ms = MeasureBestMs(repeats, [&] { processor.Invalidate(); processor.Process(vertices, world, worldViewProj); });
+						print(pPath, ms, matches(processor.Process(vertices, world, worldViewProj)) ? "same" : "DIFFERS");
+					};
+				measure(single, false, "SoA scalar, 1 thread");
+				if (SoftwareRasterizer::GetBestKernel() == RasterKernel::AVX2)
+				{
+					measure(single, true, "SoA AVX2, 1 thread");
+					measure(parallel, true, "SoA AVX2, pool");
+				}
+				else
+					std::cout << "  (no AVX2 on this CPU)\n";
+
+				//The matrices didn't change since the last Process
+				const uint32_t numHits = parallel.GetStats().numCacheHits;
+				const double cachedMs = MeasureBestMs(repeats, [&] { parallel.Process(vertices, world, worldViewProj); });
+				std::cout << "  " << std::left << std::setw(10) << pName << std::right << std::setw(10) << vertices.size() << "  " << std::left << std::setw(22) << "cached"
+					<< std::right << std::setw(8) << std::setprecision(3) << cachedMs << std::setw(15) << "-" << std::setw(9) << "-" << "  "
+					<< (parallel.GetStats().numCacheHits - numHits == static_cast<uint32_t>(repeats) ? "hit" : "MISSED") << "\n";
+			}
+		}
+
+		void Clipping(const std::string& directory, int numFrames)
+		{
+			ThreadPool pool{};
+			const auto pMesh = MeshAsset::Load((std::filesystem::path{ directory } / "vehicle.obj").string(), { .obj = { .pThreadPool = &pool } });
+			if (!pMesh)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const std::span<const uint32_t> lod0 = pMesh->GetLODs().empty() ? pMesh->GetIndices() : pMesh->GetIndices().subspan(pMesh->GetLODs()[0].firstIndex, pMesh->GetLODs()[0].numIndices);
+
+			//Looking down +z at the vehicle from in front of its bounds, the near plane is 0.1 and the far plane 100 away
+			const BoundingBox& bounds = pMesh->GetBounds();
+			const Vector3 center = (bounds.min + bounds.max) * 0.5f;
+			const float depth = bounds.max.z - bounds.min.z;
+			struct View
+			{
+				const char* pName{};
+				Vector3 origin{};
+			};
+			const View views[]{
+				{ "overview", { center.x, center.y, bounds.min.z - depth * 2.f } },
+				{ "close up", { center.x, center.y, bounds.min.z - 2.f } },
+				{ "against the hull", { center.x, center.y, bounds.min.z - 0.05f } },
+				{ "inside", center },
+				{ "at the far plane", { center.x, center.y, center.z - 100.f } } };
+
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			std::cout << std::fixed << std::setprecision(2) << "Clipping: the vehicle (" << lod0.size() / 3 << " triangles, " << depth << " deep) at " << width << "x" << height
+				<< ", " << numFrames << " frames, " << pool.GetNumWorkers() + 1 << " threads\n"
+				<< "  view               guard band  outside  inside  guard band  clipped  -> pieces  shaded px  draw ms  differing px\n";
+			for (const View& view : views)
+			{
+				Camera camera{};
+				camera.Initialize(45.f, view.origin, static_cast<float>(width) / height);
+				camera.CalculateViewMatrix();
+				SoftwareRasterizer::DrawCall drawCall{ pMesh->GetVertices(), lod0 };
+				drawCall.cameraPosition = camera.origin;
+				drawCall.worldViewProjMatrix = camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+
+				std::vector<uint32_t> images[2]{};
+				for (const bool isGuardBandEnabled : { true, false })
+				{
+					SoftwareRasterizer rasterizer{ width, height, &pool };
+					rasterizer.SetGuardBand(isGuardBandEnabled);
+					double ms{};
+					for (int frame{}; frame < numFrames; ++frame)
+					{
+						rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+						const auto start = std::chrono::steady_clock::now();
+						rasterizer.Draw(drawCall);
+						ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					}
+					std::vector<uint32_t>& image = images[isGuardBandEnabled ? 0 : 1];
+					image.assign(rasterizer.GetColorBuffer().begin(), rasterizer.GetColorBuffer().end());
+
+					//Every triangle takes exactly one path
+					const SoftwareRasterizer::Stats& stats = rasterizer.GetStats();
+					const bool isConsistent = stats.numOutside + stats.numInside + stats.numGuardBand + stats.numClipped == stats.numTriangles;
+					std::cout << "  " << std::left << std::setw(19) << view.pName << std::setw(10) << (isGuardBandEnabled ? "on" : "off") << std::right << std::setw(9) << stats.numOutside
+						<< std::setw(8) << stats.numInside << std::setw(12) << stats.numGuardBand << std::setw(9) << stats.numClipped << std::setw(11) << stats.numClippedTriangles
+						<< std::setw(11) << stats.numPixelsShaded << std::setw(9) << ms / numFrames;
+					if (!isGuardBandEnabled)
+					{
+						//Clipping at the screen instead of the guard band moves corners by rounding only, the edges stay where they are
+						size_t numDiffering{};
+						for (size_t pixel{}; pixel < images[0].size(); ++pixel)
+							numDiffering += images[0][pixel] != images[1][pixel];
+						std::cout << std::setw(14) << numDiffering;
+					}
+					std::cout << (isConsistent ? "" : "  COUNTS DON'T ADD UP") << "\n";
+				}
+			}
+		}
+
+		void TriangleSetup(const std::string& directory, int numFrames)
+		{
+			ThreadPool loadPool{};
+			const std::string path = (std::filesystem::path{ directory } / "vehicle.obj").string();
+			const auto pMesh = MeshAsset::Load(path, { .obj = { .pThreadPool = &loadPool } });
+			//Right handed as in the file, front faces counter-clockwise. ParseOBJ emits every face a second time, flipped along with the axis
+			//so the default import is double sided, as is without flipping.
+			const auto pUnflippedMesh = MeshAsset::Load(path, { .obj = { .flipAxisAndWinding = false, .pThreadPool = &loadPool } });
+			if (!pMesh || !pUnflippedMesh)
+			{
+				std::cout << "Couldn't load the vehicle in " << directory << "\n";
+				return;
+			}
+			const auto getLOD0 = [](const MeshAsset& mesh)
+				{
+					return mesh.GetLODs().empty() ? mesh.GetIndices() : mesh.GetIndices().subspan(mesh.GetLODs()[0].firstIndex, mesh.GetLODs()[0].numIndices);
+				};
+
+			//2 triangles per cell of a 1024x512 grid in clip space over the whole screen, clockwise, well under a pixel each at 640x480
+			constexpr uint32_t gridX{ 1024 }, gridY{ 512 };
+			std::vector<Vertex> gridVertices{};
+			std::vector<uint32_t> gridIndices{};
+			for (uint32_t y{}; y <= gridY; ++y)
+			{
+				for (uint32_t x{}; x <= gridX; ++x)
+				{
+					Vertex vertex{};
+					vertex.position = { static_cast<float>(x) / gridX * 2.f - 1.f, static_cast<float>(y) / gridY * 2.f - 1.f, 0.5f };
+					vertex.uv = { static_cast<float>(x) / gridX, static_cast<float>(y) / gridY };
+					vertex.normal = { 0.f, 0.f, -1.f };
+					vertex.tangent = { 1.f, 0.f, 0.f };
+					gridVertices.push_back(vertex);
+				}
+			}
+			for (uint32_t y{}; y < gridY; ++y)
+			{
+				for (uint32_t x{}; x < gridX; ++x)
+				{
+					const uint32_t bottomLeft = y * (gridX + 1) + x, topLeft = bottomLeft + gridX + 1;
+					gridIndices.insert(gridIndices.end(), { topLeft, topLeft + 1, bottomLeft, topLeft + 1, bottomLeft + 1, bottomLeft });
+				}
+			}
+
+			constexpr uint32_t width{ 640 }, height{ 480 };
+			Camera camera{};
+			camera.Initialize(45.f, { 0.f, 0.f, -50.f }, static_cast<float>(width) / height);
+			camera.CalculateViewMatrix();
+			const Matrix viewProjection = camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+			const Matrix world = Matrix::CreateRotationY(30.f * TO_RADIANS);
+
+			struct Scene
+			{
+				const char* pName{};
+				std::span<const Vertex> vertices{};
+				std::span<const uint32_t> indices{};
+				Matrix worldMatrix{};
+				Matrix worldViewProjMatrix{};
+				bool isFrontCounterClockwise{};
+				uint32_t width{};
+				uint32_t height{};
+			};
+			const Scene scenes[]{
+				{ "vehicle", pMesh->GetVertices(), getLOD0(*pMesh), world, world * viewProjection, false, width, height },
+				{ "vehicle 160x120", pMesh->GetVertices(), getLOD0(*pMesh), world, world * viewProjection, false, 160, 120 },
+				{ "unflipped, ccw", pUnflippedMesh->GetVertices(), getLOD0(*pUnflippedMesh), world, world * viewProjection, true, width, height },
+				{ "unflipped, cw", pUnflippedMesh->GetVertices(), getLOD0(*pUnflippedMesh), world, world * viewProjection, false, width, height },
+				{ "tiny grid", gridVertices, gridIndices, Matrix{}, Matrix{}, false, width, height } };
+
+			std::cout << std::fixed << std::setprecision(2) << "Triangle setup: " << numFrames << " frames, 1 thread, one triangle at a time (sse kernel) vs 8 (avx2)\n";
+			if (SoftwareRasterizer::GetBestKernel() != RasterKernel::AVX2)
+			{
+				std::cout << "  no AVX2 on this CPU\n";
+				return;
+			}
+			std::cout << "  scene              triangles  back facing  degenerate  no samples  outside  binned   setup ms 1  setup ms 8  speedup  result\n";
+			std::vector<SoftwareRasterizer::PipelineStatistics> statistics{};
+			for (const Scene& scene : scenes)
+			{
+				SoftwareRasterizer::DrawCall drawCall{ scene.vertices, scene.indices, scene.worldMatrix, scene.worldViewProjMatrix };
+				drawCall.cameraPosition = camera.origin;
+				drawCall.isFrontCounterClockwise = scene.isFrontCounterClockwise;
+
+				double setupMs[2]{};
+				SoftwareRasterizer::Stats stats[2]{};
+				std::vector<uint32_t> images[2]{};
+				for (int mode{}; mode < 2; ++mode)
+				{
+					SoftwareRasterizer rasterizer{ scene.width, scene.height };
+					rasterizer.SetKernel(mode == 0 ? RasterKernel::SSE : RasterKernel::AVX2);
+					for (int frame{}; frame < numFrames; ++frame)
+					{
+						rasterizer.Clear(ColorRGB{ 0.f, 0.f, 0.3f });
+						rasterizer.Draw(drawCall);
+						setupMs[mode] += rasterizer.GetStats().setupMs;
+						//Later frames reuse the transformed vertices
+						if (mode == 1 && frame == 0)
+							statistics.push_back(rasterizer.GetPipelineStatistics());
+					}
+					setupMs[mode] /= numFrames;
+					stats[mode] = rasterizer.GetStats();
+					images[mode].assign(rasterizer.GetColorBuffer().begin(), rasterizer.GetColorBuffer().end());
+				}
+
+				const auto getCounts = [](const SoftwareRasterizer::Stats& stats)
+					{
+						return std::tuple{ stats.numOutside, stats.numInside, stats.numGuardBand, stats.numClipped, stats.numClippedTriangles, stats.numBackFacing,
+							stats.numDegenerate, stats.numMissingSamples, stats.numOutOfRange, stats.numRasterized, stats.numBinned, stats.numPixelsCovered, stats.numPixelsShaded };
+					};
+				const bool isSame = getCounts(stats[0]) == getCounts(stats[1]) && images[0] == images[1];
+				const SoftwareRasterizer::Stats& counts = stats[1];
+				std::cout << "  " << std::left << std::setw(17) << scene.pName << std::right << std::setw(11) << counts.numTriangles << std::setw(13) << counts.numBackFacing
+					<< std::setw(12) << counts.numDegenerate << std::setw(12) << counts.numMissingSamples << std::setw(9) << counts.numOutside << std::setw(8) << counts.numRasterized
+					<< std::setw(12) << setupMs[0] << std::setw(12) << setupMs[1] << std::setw(8) << setupMs[0] / setupMs[1] << "x  " << (isSame ? "same" : "DIFFERS") << "\n";
+			}
+
+			//What a D3D11_QUERY_PIPELINE_STATISTICS query would return around the same draw
+			std::cout << "  pipeline statistics  IAVertices  IAPrimitives  VSInvocations  CInvocations  CPrimitives  rasterized  PSInvocations  early Z rejects\n";
+			for (size_t scene{}; scene < statistics.size(); ++scene)
+			{
+				const SoftwareRasterizer::PipelineStatistics& values = statistics[scene];
+				std::cout << "  " << std::left << std::setw(19) << scenes[scene].pName << std::right << std::setw(12) << values.numIAVertices << std::setw(14) << values.numIAPrimitives
+					<< std::setw(15) << values.numVSInvocations << std::setw(14) << values.numCInvocations << std::setw(13) << values.numCPrimitives << std::setw(12)
+					<< values.numRasterizedPrimitives << std::setw(15) << values.numPSInvocations << std::setw(17) << values.numEarlyZRejects << "\n";
+			}
+		}
+
+		void DepthPrecision(float nearPlane, float farPlane, float gapPercent)
+		{
+			const DepthFormat formats[]{ DepthFormat::D16, DepthFormat::D24S8, DepthFormat::D32F, DepthFormat::D32FReversed };
+			const float distanceFractions[]{ 0.01f, 0.02f, 0.05f, 0.1f, 0.25f, 0.5f, 0.9f };
+
+			//How far apart two surfaces must be at a distance to get different depths
+			std::cout << "Depth precision: near plane " << nearPlane << ", far plane " << farPlane << "\n"
+				<< "  resolution at distance";
+			for (const DepthFormat format : formats)
+				std::cout << std::setw(15) << DepthFormats::GetName(format);
+			std::cout << "\n";
+			for (const float fraction : distanceFractions)
+			{
+				const float distance = farPlane * fraction;
+				std::cout << "  " << std::fixed << std::setprecision(2) << std::setw(22) << distance << std::scientific << std::setprecision(3);
+				for (const DepthFormat format : formats)
+					std::cout << std::setw(15) << DepthFormats::GetResolution(distance, nearPlane, farPlane, format);
+				std::cout << "\n";
+			}
+
+			//Two quads gapPercent apart, the far one drawn first: where the near one fails the depth test they z-fight. Both lean so their
+			//depth sweeps 10% of the distance across the screen, and the near one is the far one scaled towards the eye, so they cover
+			//the same pixels. A third one 5% further back is then drawn behind both, HiZ should skip it by the tile or the block.
+			constexpr uint32_t size{ 256 };
+			const float scale = 1.f + gapPercent / 100.f;
+			constexpr size_t numFractions{ std::size(distanceFractions) }, numFormats{ std::size(formats) };
+			float percentages[numFractions][numFormats]{};
+			std::string hiZRejections[numFractions][numFormats]{};
+			std::string distances[numFractions]{};
+			for (size_t row{}; row < numFractions; ++row)
+			{
+				const float fraction = distanceFractions[row];
+				const float distance = farPlane * fraction / scale;
+				const float halfSize = distance;
+				const auto createQuad = [halfSize, distance](float quadScale)
+					{
+						std::vector<Vertex> vertices{};
+						for (const Vector2& corner : { Vector2{ -1.f, 1.f }, Vector2{ 1.f, 1.f }, Vector2{ 1.f, -1.f }, Vector2{ -1.f, -1.f } })
+						{
+							const Vector3 position{ corner.x * halfSize, corner.y * halfSize, distance * (1.f + 0.05f * corner.x) };
+							vertices.push_back({ position * quadScale, {}, { 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f } });
+						}
+						return vertices;
+					};
+				const std::vector<Vertex> nearVertices = createQuad(1.f), farVertices = createQuad(scale), behindVertices = createQuad(1.05f);
+				//Clockwise on screen
+				const std::vector<uint32_t> indices{ 0, 1, 2, 0, 2, 3 };
+
+				std::ostringstream distanceText{};
+				distanceText << std::fixed << std::setprecision(2) << std::setw(8) << distance << "-" << std::left << std::setw(13) << distance * scale;
+				distances[row] = distanceText.str();
+				for (size_t column{}; column < numFormats; ++column)
+				{
+					const DepthFormat format = formats[column];
+					Camera camera{};
+					camera.nearPlane = nearPlane;
+					camera.farPlane = farPlane;
+					camera.isReversedZ = DepthFormats::IsReversed(format);
+					camera.Initialize(45.f, {}, 1.f);
+					camera.CalculateViewMatrix();
+
+					SoftwareRasterizer rasterizer{ size, size };
+					rasterizer.SetDepthFormat(format);
+					rasterizer.Clear(ColorRGB{});
+					SoftwareRasterizer::DrawCall drawCall{ farVertices, indices };
+					drawCall.worldViewProjMatrix = camera.GetInverseViewMatrix() * camera.GetProjectionMatrix();
+					drawCall.isDepthOnly = true;
+					rasterizer.Draw(drawCall);
+					const uint64_t numFarPixels = rasterizer.GetStats().numPixelsShaded;
+					drawCall.vertices = nearVertices;
+					rasterizer.Draw(drawCall);
+					const uint64_t numNearPixels = rasterizer.GetStats().numPixelsShaded - numFarPixels;
+
+					percentages[row][column] = numFarPixels == 0 ? 0.f : 100.f * (numFarPixels - numNearPixels) / numFarPixels;
+
+					const SoftwareRasterizer::Stats previousStats = rasterizer.GetStats();
+					drawCall.vertices = behindVertices;
+					rasterizer.Draw(drawCall);
+					const SoftwareRasterizer::Stats& stats = rasterizer.GetStats();
+					hiZRejections[row][column] = std::to_string(stats.numHiZTriangles - previousStats.numHiZTriangles) + "/"
+						+ std::to_string(stats.numHiZBlocks - previousStats.numHiZBlocks);
+				}
+			}
+
+			std::cout << std::defaultfloat << "  pixels of the far quad left with the near one " << gapPercent << "% closer, " << size << "x" << size << "\n"
+				<< "  distance              ";
+			for (const DepthFormat format : formats)
+				std::cout << std::setw(15) << DepthFormats::GetName(format);
+			std::cout << "\n";
+			for (size_t row{}; row < numFractions; ++row)
+			{
+				std::cout << "  " << distances[row] << std::fixed << std::setprecision(2);
+				for (size_t column{}; column < numFormats; ++column)
+					std::cout << std::setw(14) << percentages[row][column] << "%";
+				std::cout << "\n";
+			}
+
+			std::cout << "  HiZ rejections of a quad 5% behind both, triangles by the tile/blocks\n"
+				<< "  distance              ";
+			for (const DepthFormat format : formats)
+				std::cout << std::setw(15) << DepthFormats::GetName(format);
+			std::cout << "\n";
+			for (size_t row{}; row < numFractions; ++row)
+			{
+				std::cout << "  " << distances[row];
+				for (size_t column{}; column < numFormats; ++column)
+					std::cout << std::setw(15) << hiZRejections[row][column];
+				std::cout << "\n";
+			}
+		}
+	}
+}
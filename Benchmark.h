@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	//Headless benchmarks, started with DirectX.exe --benchmark <name> [arguments], or DirectXBenchmark <name> [arguments] from the
+	//CPU-only build in CMakeLists.txt, which has all but the ones needing a D3D11 device
+	namespace Benchmark
+	{
+		//Runs the benchmark named by the first argument, returns false if it is unknown
+		bool Run(const std::vector<std::string>& arguments);
+
+		//Reference ifstream parser vs memory-mapped parser
+		void OBJParsing(const std::string& filename, int iterations);
+
+		//Vertex count and import time with and without welding
+		void VertexWelding(const std::string& filename, int iterations);
+
+		//Parallel chunked import from 1 up to all hardware threads
+		void OBJThreadScaling(const std::string& filename, int iterations);
+
+		//Import with an empty .dmesh cache vs loading from it
+		void MeshCacheStartup(const std::string& filename, int iterations);
+
+		//ACMR/ATVR and estimated overdraw after every MeshOptimizer pass
+		void MeshOptimization(const std::string& filename);
+
+		//Encode/decode round trip of every vertex to VertexCompact, checked against the quantization error bounds
+		void VertexQuantization(const std::string& filename);
+
+		//16-bit index ranges for the mesh and for synthetic meshes past 65536 vertices, checked against the original triangles
+		void IndexPacking16(const std::string& filename);
+
+		//Triangle count, simplifier error and measured surface distance of every LOD
+		void MeshSimplification(const std::string& filename);
+
+		//Meshlet frustum + normal cone culling along a scripted camera orbit, checked to never drop a visible front face
+		void MeshletCulling(const std::string& filename);
+
+		//ms per 2048x2048 mip chain for every filter and content type, serial and on the thread pool
+		void MipGeneration(int size);
+
+		//Cold import, warm cache load, encode time, PSNR and bytes saved for the block compressed vehicle textures
+		void TextureCompression(const std::string& directory);
+
+		//Renderer's assets loaded one after the other vs through AssetLoader, cold and warm, with the loader's timeline
+		void AsyncStartup(const std::string& directory, int numWorkers);
+
+		//Many vehicles acquiring the same maps through TextureManager, some under another path or a copied file, then released one by one
+		void TextureSharing(const std::string& directory, int numVehicles);
+
+		//Specular + glossiness packed into one BC3 checked against the separate BC1 + BC4, and the texel bytes per pixel of every layout
+		void ChannelPacking(const std::string& directory);
+
+		//A camera flying past a row of vehicles with TextureStreamer on a null device: residency, loads and evictions under the budget
+		void TextureStreaming(const std::string& directory, int budgetKB);
+
+		//CPUTexture point/bilinear/trilinear fetches over random and rotated scanline UVs, linear vs tiled vs Morton layout
+		void TexelLayouts(int size);
+
+		//SoftwareRasterizer drawing the turning vehicle at 640x480 with every filter, single threaded and on the pool, optionally saving a frame
+		void SoftwareRendering(const std::string& directory, int numFrames, const std::string& imagePath);
+
+		//SoftwareRasterizer on 1 to maxThreads threads for the vehicle and synthetic dense scenes, with the load imbalance over tiles and threads
+		void RasterScaling(const std::string& directory, int maxThreads, int numFrames);
+
+		//Scalar, SSE and AVX2 raster kernels: coverage of random triangles and shared edges against a 64 bit reference, bit-identical
+		//frames, and Mpixels/s depth only and shaded
+		void RasterKernels(const std::string& directory, int numBatches, int seed);
+
+		//SoftwareRasterizer with and without hierarchical Z through a column of vehicles and stacked walls, drawn near and far first
+		void HierarchicalZ(const std::string& directory, int numFrames);
+
+		//SoftwareRasterizer's specialized pixel shaders against the generic one for every filter and map combination at 3 resolutions
+		void ShadingKernels(const std::string& directory, int numFrames);
+
+		//VertexProcessor's SoA AVX2 vertex shader against one Matrix::TransformPoint vertex at a time, for the vehicle and a million
+		//vertex buffer, on 1 thread and the pool, and the cached case. Checks every output stream and clip code for bit-identity.
+		void VertexProcessing(const std::string& directory, int repeats);
+
+		//SoftwareRasterizer's clipping paths with the camera far off, close up, against and inside the vehicle and at the far plane,
+		//guard band on and off: triangles per path, time and how many pixels differ between the two
+		void Clipping(const std::string& directory, int numFrames);
+
+		//SoftwareRasterizer's triangle setup one triangle at a time and 8 at a time in AVX2: culled triangles per reason, setup time, and
+		//the D3D11 style pipeline statistics of the vehicle, the vehicle imported without flipping its winding and a grid of tiny triangles
+		void TriangleSetup(const std::string& directory, int numFrames);
+
+		//How far apart surfaces have to be to get different depths in D16, D24S8, D32F and reversed D32F at distances up to the far plane,
+		//worked out and measured with SoftwareRasterizer: two quads gapPercent apart, how much of the far one the near one doesn't hide
+		void DepthPrecision(float nearPlane, float farPlane, float gapPercent);
+	}
+}
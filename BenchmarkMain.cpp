@@ -0,0 +1,15 @@
+#include "pch.h"
+#include "Benchmark.h"
+
+//Entry point of the CPU-only build in CMakeLists.txt, the same benchmarks as DirectX.exe --benchmark without SDL or D3D11
+int main(int argc, char* args[])
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: " << args[0] << " <benchmark> [arguments]\n";
+		return 1;
+	}
+
+	const std::vector<std::string> arguments(args + 1, args + argc);
+	return dae::Benchmark::Run(arguments) ? 0 : 1;
+}
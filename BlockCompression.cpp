@@ -0,0 +1,504 @@
+#include "pch.h"
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+#include <immintrin.h>
+#include <cmath>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		//Least squares endpoint refinements after the first guess, each one only kept if it lowers the error
+		constexpr int g_NumRefinements{ 2 };
+
+		//16 texels of one channel as 4 SSE registers
+		struct alignas(16) BlockChannel
+		{
+			float values[16]{};
+		};
+
+		//Copies a 4x4 block out of the image, repeating the last row and column past the edges
+		void LoadBlock(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[64])
+		{
+			for (uint32_t y{}; y < 4; ++y)
+			{
+				const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+				for (uint32_t x{}; x < 4; ++x)
+				{
+					const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+					std::memcpy(&block[(y * 4 + x) * 4], &pPixels[(size_t(sourceY) * width + sourceX) * 4], 4);
+				}
+			}
+		}
+
+		//Nearest palette entry for every texel, summed over the channels. Returns the total squared error.
+		template<int numChannels, int numEntries>
+		float FindNearest(const BlockChannel (&channels)[numChannels], const float (&palette)[numEntries][numChannels], uint8_t indices[16])
+		{
+			__m128 totalError = _mm_setzero_ps();
+			for (int i{}; i < 16; i += 4)
+			{
+				__m128 bestError = _mm_set1_ps(FLT_MAX);
+				__m128 bestIndex = _mm_setzero_ps();
+				for (int entry{}; entry < numEntries; ++entry)
+				{
+					__m128 error = _mm_setzero_ps();
+					for (int c{}; c < numChannels; ++c)
+					{
+						const __m128 difference = _mm_sub_ps(_mm_load_ps(&channels[c].values[i]), _mm_set1_ps(palette[entry][c]));
+						error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+					}
+
+					const __m128 isBetter = _mm_cmplt_ps(error, bestError);
+					bestError = _mm_min_ps(error, bestError);
+					bestIndex = _mm_or_ps(_mm_andnot_ps(isBetter, bestIndex), _mm_and_ps(isBetter, _mm_set1_ps(float(entry))));
+				}
+
+				totalError = _mm_add_ps(totalError, bestError);
+				alignas(16) float bestIndices[4]{};
+				_mm_store_ps(bestIndices, bestIndex);
+				for (int j{}; j < 4; ++j)
+					indices[i + j] = static_cast<uint8_t>(bestIndices[j]);
+			}
+
+			alignas(16) float errors[4]{};
+			_mm_store_ps(errors, totalError);
+			return errors[0] + errors[1] + errors[2] + errors[3];
+		}
+
+		//Endpoints minimizing the squared error for fixed indices, where texel i is weights[i] * a + (1 - weights[i]) * b.
+		//Fails when every texel uses the same weight.
+		template<int numChannels>
+		bool SolveEndpoints(const BlockChannel (&channels)[numChannels], const float* pWeights, const uint8_t indices[16], float a[numChannels], float b[numChannels])
+		{
+			float aa{}, ab{}, bb{};
+			float ax[numChannels]{}, bx[numChannels]{};
+			for (int i{}; i < 16; ++i)
+			{
+				const float alpha = pWeights[indices[i]];
+				const float beta = 1.f - alpha;
+				aa += alpha * alpha;
+				ab += alpha * beta;
+				bb += beta * beta;
+				for (int c{}; c < numChannels; ++c)
+				{
+					ax[c] += alpha * channels[c].values[i];
+					bx[c] += beta * channels[c].values[i];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+				return false;
+
+			for (int c{}; c < numChannels; ++c)
+			{
+				a[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+				b[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+			}
+			return true;
+		}
+
+		uint16_t To565(const float color[3])
+		{
+			const auto quantize = [](float value, int maxValue) { return static_cast<uint16_t>(std::clamp(value, 0.f, 255.f) * maxValue / 255.f + 0.5f); };
+			return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+		}
+
+		void From565(uint16_t packed, float color[3])
+		{
+			const uint32_t r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+			color[0] = float((r << 3) | (r >> 2));
+			color[1] = float((g << 2) | (g >> 4));
+			color[2] = float((b << 3) | (b >> 2));
+		}
+
+		//Four color mode: entry 0 and 1 are the endpoints, 2 and 3 lie at a third and two thirds
+		void GetBC1Palette(uint16_t color0, uint16_t color1, float palette[4][3])
+		{
+			From565(color0, palette[0]);
+			From565(color1, palette[1]);
+			for (int c{}; c < 3; ++c)
+			{
+				palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+				palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+			}
+		}
+
+		void EncodeBC1(const uint8_t block[64], uint8_t* pOut)
+		{
+			BlockChannel channels[3]{};
+			float mean[3]{};
+			for (int i{}; i < 16; ++i)
+			{
+				for (int c{}; c < 3; ++c)
+				{
+					channels[c].values[i] = block[i * 4 + c];
+					mean[c] += block[i * 4 + c] / 16.f;
+				}
+			}
+
+			//Principal axis of the colors by power iteration on their covariance
+			float covariance[6]{};
+			for (int i{}; i < 16; ++i)
+			{
+				const float r = channels[0].values[i] - mean[0], g = channels[1].values[i] - mean[1], b = channels[2].values[i] - mean[2];
+				covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+				covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+			}
+			float axis[3]{ 1.f, 1.f, 1.f };
+			for (int iteration{}; iteration < 8; ++iteration)
+			{
+				const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+				const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+				const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+				const float length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+				if (length < 1e-6f)
+					break;
+				axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+			}
+
+			float minProjection{ FLT_MAX }, maxProjection{ -FLT_MAX };
+			float minColor[3]{ 255.f, 255.f, 255.f }, maxColor[3]{};
+			for (int i{}; i < 16; ++i)
+			{
+				const float projection = (channels[0].values[i] - mean[0]) * axis[0] + (channels[1].values[i] - mean[1]) * axis[1] + (channels[2].values[i] - mean[2]) * axis[2];
+				minProjection = std::min(minProjection, projection);
+				maxProjection = std::max(maxProjection, projection);
+				for (int c{}; c < 3; ++c)
+				{
+					minColor[c] = std::min(minColor[c], channels[c].values[i]);
+					maxColor[c] = std::max(maxColor[c], channels[c].values[i]);
+				}
+			}
+
+			//Weight of endpoint 0 for every palette entry
+			constexpr float weights[4]{ 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+			uint16_t bestColor0{}, bestColor1{};
+			uint8_t bestIndices[16]{};
+			float bestError{ FLT_MAX };
+			const auto refine = [&](float endpoint0[3], float endpoint1[3])
+				{
+					for (int refinement{}; refinement <= g_NumRefinements; ++refinement)
+					{
+						const uint16_t color0 = To565(endpoint0), color1 = To565(endpoint1);
+						float palette[4][3]{};
+						GetBC1Palette(color0, color1, palette);
+
+						uint8_t indices[16]{};
+						const float error = FindNearest(channels, palette, indices);
+						if (error < bestError)
+						{
+							bestError = error;
+							bestColor0 = color0;
+							bestColor1 = color1;
+							std::memcpy(bestIndices, indices, sizeof(indices));
+						}
+
+						if (error == 0.f || !SolveEndpoints(channels, weights, indices, endpoint0, endpoint1))
+							break;
+					}
+				};
+
+			//Both the extremes along the principal axis and the corners of the bounding box along the same diagonal,
+			//the axis wins on smooth gradients and the box where a few outliers pull the axis away
+			float endpoint0[3]{}, endpoint1[3]{};
+			for (int c{}; c < 3; ++c)
+			{
+				endpoint0[c] = mean[c] + axis[c] * maxProjection;
+				endpoint1[c] = mean[c] + axis[c] * minProjection;
+			}
+			refine(endpoint0, endpoint1);
+
+			for (int c{}; c < 3; ++c)
+			{
+				endpoint0[c] = axis[c] >= 0.f ? maxColor[c] : minColor[c];
+				endpoint1[c] = axis[c] >= 0.f ? minColor[c] : maxColor[c];
+			}
+			refine(endpoint0, endpoint1);
+
+			//color0 > color1 selects the four color mode, swapping the endpoints swaps index 0 with 1 and 2 with 3
+			if (bestColor0 < bestColor1)
+			{
+				std::swap(bestColor0, bestColor1);
+				for (uint8_t& index : bestIndices)
+					index ^= 1;
+			}
+			else if (bestColor0 == bestColor1)
+			{
+				std::memset(bestIndices, 0, sizeof(bestIndices));
+			}
+
+			uint32_t indexBits{};
+			for (int i{}; i < 16; ++i)
+				indexBits |= uint32_t(bestIndices[i]) << (i * 2);
+
+			std::memcpy(pOut, &bestColor0, 2);
+			std::memcpy(pOut + 2, &bestColor1, 2);
+			std::memcpy(pOut + 4, &indexBits, 4);
+		}
+
+		//Eight value mode: entry 0 and 1 are the endpoints, 2 to 7 lie in between in sevenths
+		void GetBC4Palette(uint8_t value0, uint8_t value1, float palette[8][1])
+		{
+			palette[0][0] = value0;
+			palette[1][0] = value1;
+			for (int entry{ 2 }; entry < 8; ++entry)
+				palette[entry][0] = ((8 - entry) * float(value0) + (entry - 1) * float(value1)) / 7.f;
+		}
+
+		void EncodeBC4(const uint8_t block[64], int channel, uint8_t* pOut)
+		{
+			BlockChannel channels[1]{};
+			float minValue{ 255.f }, maxValue{ 0.f };
+			for (int i{}; i < 16; ++i)
+			{
+				channels[0].values[i] = block[i * 4 + channel];
+				minValue = std::min(minValue, channels[0].values[i]);
+				maxValue = std::max(maxValue, channels[0].values[i]);
+			}
+
+			uint8_t bestValue0 = static_cast<uint8_t>(maxValue), bestValue1 = static_cast<uint8_t>(minValue);
+			uint8_t bestIndices[16]{};
+			if (maxValue > minValue)
+			{
+				constexpr float weights[8]{ 1.f, 0.f, 6.f / 7.f, 5.f / 7.f, 4.f / 7.f, 3.f / 7.f, 2.f / 7.f, 1.f / 7.f };
+				float endpoint0[1]{ maxValue }, endpoint1[1]{ minValue };
+				float bestError{ FLT_MAX };
+				for (int refinement{}; refinement <= g_NumRefinements; ++refinement)
+				{
+					uint8_t value0 = static_cast<uint8_t>(std::clamp(endpoint0[0], 0.f, 255.f) + 0.5f);
+					uint8_t value1 = static_cast<uint8_t>(std::clamp(endpoint1[0], 0.f, 255.f) + 0.5f);
+					//value0 > value1 selects the eight value mode
+					if (value0 < value1)
+						std::swap(value0, value1);
+					if (value0 == value1)
+						break;
+
+					float palette[8][1]{};
+					GetBC4Palette(value0, value1, palette);
+					uint8_t indices[16]{};
+					const float error = FindNearest(channels, palette, indices);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestValue0 = value0;
+						bestValue1 = value1;
+						std::memcpy(bestIndices, indices, sizeof(indices));
+					}
+
+					if (error == 0.f || !SolveEndpoints(channels, weights, indices, endpoint0, endpoint1))
+						break;
+				}
+			}
+
+			uint64_t indexBits{};
+			for (int i{}; i < 16; ++i)
+				indexBits |= uint64_t(bestIndices[i]) << (i * 3);
+
+			pOut[0] = bestValue0;
+			pOut[1] = bestValue1;
+			std::memcpy(pOut + 2, &indexBits, 6);
+		}
+
+		void DecodeBC1(const uint8_t* pBlock, uint8_t block[64])
+		{
+			uint16_t color0{}, color1{};
+			uint32_t indexBits{};
+			std::memcpy(&color0, pBlock, 2);
+			std::memcpy(&color1, pBlock + 2, 2);
+			std::memcpy(&indexBits, pBlock + 4, 4);
+
+			//Only the four color mode is written, three colors + black is decoded for completeness
+			float palette[4][3]{};
+			GetBC1Palette(color0, color1, palette);
+			if (color0 <= color1)
+			{
+				for (int c{}; c < 3; ++c)
+				{
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2.f;
+					palette[3][c] = 0.f;
+				}
+			}
+
+			for (int i{}; i < 16; ++i)
+			{
+				const uint32_t index = (indexBits >> (i * 2)) & 3;
+				for (int c{}; c < 3; ++c)
+					block[i * 4 + c] = static_cast<uint8_t>(palette[index][c] + 0.5f);
+				block[i * 4 + 3] = 255;
+			}
+		}
+
+		void DecodeBC4(const uint8_t* pBlock, int channel, uint8_t block[64])
+		{
+			uint64_t indexBits{};
+			std::memcpy(&indexBits, pBlock + 2, 6);
+
+			float palette[8][1]{};
+			GetBC4Palette(pBlock[0], pBlock[1], palette);
+			if (pBlock[0] <= pBlock[1])
+			{
+				for (int entry{ 2 }; entry < 6; ++entry)
+					palette[entry][0] = ((6 - entry) * float(pBlock[0]) + (entry - 1) * float(pBlock[1])) / 5.f;
+				palette[6][0] = 0.f;
+				palette[7][0] = 255.f;
+			}
+
+			for (int i{}; i < 16; ++i)
+				block[i * 4 + channel] = static_cast<uint8_t>(palette[(indexBits >> (i * 3)) & 7][0] + 0.5f);
+		}
+	}
+
+	namespace BlockCompression
+	{
+		bool IsBlockCompressed(TextureFormat format)
+		{
+			return format != TextureFormat::RGBA8;
+		}
+
+		uint32_t GetNumChannels(TextureFormat format)
+		{
+			switch (format)
+			{
+			case TextureFormat::BC1: return 3;
+			case TextureFormat::BC4: return 1;
+			case TextureFormat::BC5: return 2;
+			default: return 4;
+			}
+		}
+
+		uint32_t GetRowPitch(TextureFormat format, uint32_t width)
+		{
+			const uint32_t numBlocks = (width + 3) / 4;
+			switch (format)
+			{
+			case TextureFormat::BC1:
+			case TextureFormat::BC4:
+				return numBlocks * 8;
+			case TextureFormat::BC5:
+			case TextureFormat::BC3:
+				return numBlocks * 16;
+			default:
+				return width * 4;
+			}
+		}
+
+		size_t GetLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+		{
+			const uint32_t numRows = IsBlockCompressed(format) ? (height + 3) / 4 : height;
+			return size_t(GetRowPitch(format, width)) * numRows;
+		}
+
+		void Compress(const uint8_t* pPixels, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pBlocks, ThreadPool* pThreadPool)
+		{
+			if (!IsBlockCompressed(format))
+			{
+				std::memcpy(pBlocks, pPixels, GetLevelSize(format, width, height));
+				return;
+			}
+
+			const uint32_t numBlocksX = (width + 3) / 4, numBlocksY = (height + 3) / 4;
+			const uint32_t rowPitch = GetRowPitch(format, width);
+			const auto compressRows = [&](size_t begin, size_t end)
+				{
+					uint8_t block[64]{};
+					for (size_t blockY{ begin }; blockY < end; ++blockY)
+					{
+						uint8_t* pOut = pBlocks + blockY * rowPitch;
+						for (uint32_t blockX{}; blockX < numBlocksX; ++blockX)
+						{
+							LoadBlock(pPixels, width, height, blockX, static_cast<uint32_t>(blockY), block);
+							switch (format)
+							{
+							case TextureFormat::BC1:
+								EncodeBC1(block, pOut + blockX * 8);
+								break;
+							case TextureFormat::BC4:
+								EncodeBC4(block, 0, pOut + blockX * 8);
+								break;
+							case TextureFormat::BC3:
+								//The alpha block is a BC4 block, the color block is always read in four color mode which is all EncodeBC1 writes
+								EncodeBC4(block, 3, pOut + blockX * 16);
+								EncodeBC1(block, pOut + blockX * 16 + 8);
+								break;
+							default:
+								EncodeBC4(block, 0, pOut + blockX * 16);
+								EncodeBC4(block, 1, pOut + blockX * 16 + 8);
+								break;
+							}
+						}
+					}
+				};
+
+			if (pThreadPool)
+				pThreadPool->ParallelFor(numBlocksY, compressRows, 4);
+			else
+				compressRows(0, numBlocksY);
+		}
+
+		void Decompress(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pPixels)
+		{
+			if (!IsBlockCompressed(format))
+			{
+				std::memcpy(pPixels, pBlocks, GetLevelSize(format, width, height));
+				return;
+			}
+
+			const uint32_t rowPitch = GetRowPitch(format, width);
+			for (uint32_t blockY{}; blockY < (height + 3) / 4; ++blockY)
+			{
+				for (uint32_t blockX{}; blockX < (width + 3) / 4; ++blockX)
+				{
+					const uint8_t* pBlock = pBlocks + size_t(blockY) * rowPitch;
+					uint8_t block[64]{};
+					for (int i{}; i < 16; ++i)
+						block[i * 4 + 3] = 255;
+
+					switch (format)
+					{
+					case TextureFormat::BC1:
+						DecodeBC1(pBlock + blockX * 8, block);
+						break;
+					case TextureFormat::BC4:
+						DecodeBC4(pBlock + blockX * 8, 0, block);
+						break;
+					case TextureFormat::BC3:
+						DecodeBC1(pBlock + blockX * 16 + 8, block);
+						DecodeBC4(pBlock + blockX * 16, 3, block);
+						break;
+					default:
+						DecodeBC4(pBlock + blockX * 16, 0, block);
+						DecodeBC4(pBlock + blockX * 16 + 8, 1, block);
+						break;
+					}
+
+					for (uint32_t y{}; y < 4 && blockY * 4 + y < height; ++y)
+					{
+						for (uint32_t x{}; x < 4 && blockX * 4 + x < width; ++x)
+							std::memcpy(&pPixels[(size_t(blockY * 4 + y) * width + blockX * 4 + x) * 4], &block[(y * 4 + x) * 4], 4);
+					}
+				}
+			}
+		}
+
+		float ComputePSNR(const uint8_t* pReference, const uint8_t* pPixels, size_t numTexels, uint32_t numChannels)
+		{
+			double squaredError{};
+			for (size_t i{}; i < numTexels; ++i)
+			{
+				for (uint32_t c{}; c < numChannels; ++c)
+				{
+					const double difference = double(pReference[i * 4 + c]) - pPixels[i * 4 + c];
+					squaredError += difference * difference;
+				}
+			}
+
+			if (squaredError == 0.0)
+				return INFINITY;
+			const double meanSquaredError = squaredError / (double(numTexels) * numChannels);
+			return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	class ThreadPool;
+
+	//Texel layouts Texture can upload, the BC formats are 4x4 blocks like DXGI_FORMAT_BCn_UNORM
+	enum class TextureFormat : uint32_t
+	{
+		RGBA8,
+		//RGB at 4 bits per texel, for colors
+		BC1,
+		//One channel at 4 bits per texel, for masks like glossiness
+		BC4,
+		//Two channels at 8 bits per texel, for the x and y of tangent space normals
+		BC5,
+		//RGB like BC1 plus alpha like BC4 at 8 bits per texel, for two maps packed into one
+		BC3
+	};
+
+	namespace BlockCompression
+	{
+		bool IsBlockCompressed(TextureFormat format);
+		//Channels the format keeps, starting at red
+		uint32_t GetNumChannels(TextureFormat format);
+		//Bytes per row of texels, or per row of blocks for the BC formats
+		uint32_t GetRowPitch(TextureFormat format, uint32_t width);
+		size_t GetLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+		//Encodes an RGBA8 image with tightly packed rows, rows of blocks are spread over the thread pool when set.
+		//Sizes that aren't a multiple of 4 repeat the last row and column into the partial blocks.
+		void Compress(const uint8_t* pPixels, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pBlocks, ThreadPool* pThreadPool = nullptr);
+		//Back to RGBA8, channels the format doesn't keep become 0 and alpha 255
+		void Decompress(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pPixels);
+
+		//Peak signal to noise ratio in dB over the first numChannels channels of two RGBA8 images, infinite when equal
+		float ComputePSNR(const uint8_t* pReference, const uint8_t* pPixels, size_t numTexels, uint32_t numChannels);
+	}
+}
@@ -0,0 +1,39 @@
+#include "pch.h"
+#include "CPUFeatures.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		bool DetectAVX2()
+		{
+#if defined(_MSC_VER)
+			int info[4]{};
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+			__cpuidex(info, 7, 0);
+			const bool hasAVX2 = (info[1] & (1 << 5)) != 0;
+			return hasOSXSave && hasAVX2 && (_xgetbv(0) & 6) == 6;
+#else
+			//Checks the OS support too
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+	}
+
+	namespace CPUFeatures
+	{
+		bool HasAVX2()
+		{
+			static const bool hasAVX2{ DetectAVX2() };
+			return hasAVX2;
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+//Functions using instructions beyond x64's SSE2 are marked for them. MSVC emits any intrinsic anywhere, GCC and Clang only inside
+//functions compiled for its instruction set, so the rest of a translation unit stays runnable on any x64 CPU.
+#if defined(_MSC_VER)
+#define DAE_TARGET_AVX2
+#define DAE_FLATTEN
+#else
+#define DAE_TARGET_AVX2 __attribute__((target("avx2")))
+//Inlines everything the function calls into it. Marks a template instantiated for AVX2 inside a DAE_TARGET_AVX2 function, which
+//GCC and Clang otherwise compile without it and so can't inline the AVX2 helpers it calls.
+#define DAE_FLATTEN __attribute__((flatten))
+#endif
+
+namespace dae
+{
+	//What the CPU running the process supports, detected once
+	namespace CPUFeatures
+	{
+		//The instructions and the OS saving the ymm registers
+		bool HasAVX2();
+	}
+}
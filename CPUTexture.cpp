@@ -0,0 +1,202 @@
+#include "pch.h"
+#include "CPUTexture.h"
+#include "BlockCompression.h"
+#include "TextureAsset.h"
+#include <bit>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		//UNORM8 to 0..1, like the hardware reads DXGI_FORMAT_R8G8B8A8_UNORM
+		void Unpack(uint32_t texel, float* pChannels)
+		{
+			constexpr float toUnorm{ 1.f / 255.f };
+			pChannels[0] = (texel & 0xFF) * toUnorm;
+			pChannels[1] = ((texel >> 8) & 0xFF) * toUnorm;
+			pChannels[2] = ((texel >> 16) & 0xFF) * toUnorm;
+			pChannels[3] = (texel >> 24) * toUnorm;
+		}
+
+		//Wrap addressing, 0..1 for any uv. NaN and infinity read at 0, they'd index anywhere once converted.
+		float Wrap(float coordinate)
+		{
+			const float wrapped = coordinate - std::floor(coordinate);
+			return std::isfinite(wrapped) ? wrapped : 0.f;
+		}
+	}
+
+	CPUTexture::CPUTexture(std::span<const uint8_t> pixels, std::span<const MipLevel> levels, TexelLayout layout)
+		: m_Layout{ layout }
+	{
+		size_t numTexels{};
+		for (const MipLevel& source : levels)
+		{
+			Level level{ numTexels, source.width, source.height };
+			switch (m_Layout)
+			{
+			case TexelLayout::Tiled:
+				//Partial tiles on the right and bottom edge are padded
+				level.stride = (source.width + 3) / 4;
+				numTexels += size_t(level.stride) * ((source.height + 3) / 4) * 16;
+				break;
+			case TexelLayout::Morton:
+			{
+				//Padded to powers of two, the shorter side's bits are interleaved
+				const uint32_t widthBits = std::bit_width(std::bit_ceil(source.width)) - 1;
+				const uint32_t heightBits = std::bit_width(std::bit_ceil(source.height)) - 1;
+				level.stride = std::min(widthBits, heightBits);
+				numTexels += size_t(1) << (widthBits + heightBits);
+				break;
+			}
+			default:
+				numTexels += size_t(source.width) * source.height;
+				break;
+			}
+			m_Levels.push_back(level);
+		}
+
+		m_Texels.resize(numTexels);
+		for (size_t index{}; index < levels.size(); ++index)
+		{
+			const Level& level = m_Levels[index];
+			const uint8_t* pLevel = pixels.data() + levels[index].offset;
+			for (uint32_t y{}; y < level.height; ++y)
+			{
+				for (uint32_t x{}; x < level.width; ++x)
+					std::memcpy(&m_Texels[level.offset + GetTexelIndex(level, x, y)], pLevel + (size_t(y) * level.width + x) * 4, sizeof(uint32_t));
+			}
+		}
+	}
+
+	std::unique_ptr<CPUTexture> CPUTexture::Create(const TextureAsset& asset, TexelLayout layout)
+	{
+		const std::span<const MipLevel> sourceLevels = asset.GetLevels();
+		const std::span<const uint8_t> data = asset.GetData();
+
+		std::vector<MipLevel> levels{};
+		std::vector<uint8_t> pixels{};
+		for (const MipLevel& source : sourceLevels)
+		{
+			const MipLevel level{ pixels.size(), source.width, source.height };
+			pixels.resize(pixels.size() + size_t(source.width) * source.height * 4);
+			if (BlockCompression::IsBlockCompressed(asset.GetFormat()))
+				BlockCompression::Decompress(data.data() + source.offset, source.width, source.height, asset.GetFormat(), pixels.data() + level.offset);
+			else
+				std::memcpy(pixels.data() + level.offset, data.data() + source.offset, size_t(source.width) * source.height * 4);
+			levels.push_back(level);
+		}
+		return std::make_unique<CPUTexture>(pixels, levels, layout);
+	}
+
+	Vector4 CPUTexture::SamplePoint(const Vector2& uv, float lod) const
+	{
+		//The nearest level, lod 1.5 already picks level 2. Clamped before converting, a NaN lod picks level 0.
+		const uint32_t lastLevel = GetNumLevels() - 1;
+		const uint32_t levelIndex = !(lod > 0.f) ? 0 : lod + 0.5f >= lastLevel ? lastLevel : static_cast<uint32_t>(lod + 0.5f);
+		const Level& level = m_Levels[levelIndex];
+
+		const uint32_t x = std::min(static_cast<uint32_t>(Wrap(uv.x) * level.width), level.width - 1);
+		const uint32_t y = std::min(static_cast<uint32_t>(Wrap(uv.y) * level.height), level.height - 1);
+		float channels[4];
+		Unpack(m_Texels[level.offset + GetTexelIndex(level, x, y)], channels);
+		return { channels[0], channels[1], channels[2], channels[3] };
+	}
+
+	Vector4 CPUTexture::SampleBilinear(const Vector2& uv, uint32_t levelIndex) const
+	{
+		const Level& level = m_Levels[levelIndex];
+
+		//Texel centers sit at half texels, the left/top neighbour wraps around to the other side
+		const float x = Wrap(uv.x) * level.width - 0.5f;
+		const float y = Wrap(uv.y) * level.height - 0.5f;
+		const float xFloor = std::floor(x);
+		const float yFloor = std::floor(y);
+		const float tx = x - xFloor;
+		const float ty = y - yFloor;
+
+		const uint32_t x0 = xFloor < 0.f ? level.width - 1 : static_cast<uint32_t>(xFloor);
+		const uint32_t y0 = yFloor < 0.f ? level.height - 1 : static_cast<uint32_t>(yFloor);
+		const uint32_t x1 = x0 + 1 == level.width ? 0 : x0 + 1;
+		const uint32_t y1 = y0 + 1 == level.height ? 0 : y0 + 1;
+
+		const uint32_t* pTexels = m_Texels.data() + level.offset;
+		const size_t column0 = GetColumnIndex(level, x0), column1 = GetColumnIndex(level, x1);
+		const size_t row0 = GetRowIndex(level, y0), row1 = GetRowIndex(level, y1);
+		const uint32_t texels[4]{ pTexels[column0 + row0], pTexels[column1 + row0], pTexels[column0 + row1], pTexels[column1 + row1] };
+
+		//Blended as 0..255 and scaled once, the channels stay in registers
+		float channels[4];
+		for (int channel{}; channel < 4; ++channel)
+		{
+			const int shift{ channel * 8 };
+			const float topLeft = static_cast<float>((texels[0] >> shift) & 0xFF);
+			const float topRight = static_cast<float>((texels[1] >> shift) & 0xFF);
+			const float bottomLeft = static_cast<float>((texels[2] >> shift) & 0xFF);
+			const float bottomRight = static_cast<float>((texels[3] >> shift) & 0xFF);
+			const float top = topLeft + (topRight - topLeft) * tx;
+			const float bottom = bottomLeft + (bottomRight - bottomLeft) * tx;
+			channels[channel] = (top + (bottom - top) * ty) * (1.f / 255.f);
+		}
+		return { channels[0], channels[1], channels[2], channels[3] };
+	}
+
+	Vector4 CPUTexture::SampleTrilinear(const Vector2& uv, float lod) const
+	{
+		//Magnified or past the last level: a single bilinear fetch
+		const uint32_t lastLevel = GetNumLevels() - 1;
+		if (!(lod > 0.f))
+			return SampleBilinear(uv, 0);
+		if (lod >= lastLevel)
+			return SampleBilinear(uv, lastLevel);
+
+		const uint32_t level = static_cast<uint32_t>(lod);
+		const float t = lod - level;
+		const Vector4 fine = SampleBilinear(uv, level);
+		const Vector4 coarse = SampleBilinear(uv, level + 1);
+		return { fine.x + (coarse.x - fine.x) * t, fine.y + (coarse.y - fine.y) * t, fine.z + (coarse.z - fine.z) * t, fine.w + (coarse.w - fine.w) * t };
+	}
+
+	Vector4 CPUTexture::SampleAnisotropic(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy, uint32_t maxAnisotropy) const
+	{
+		const float width = static_cast<float>(m_Levels[0].width);
+		const float height = static_cast<float>(m_Levels[0].height);
+		const float lengthDx = std::sqrt(uvDx.x * uvDx.x * width * width + uvDx.y * uvDx.y * height * height);
+		const float lengthDy = std::sqrt(uvDy.x * uvDy.x * width * width + uvDy.y * uvDy.y * height * height);
+		const float major = std::max(lengthDx, lengthDy);
+		const float minor = std::min(lengthDx, lengthDy);
+		if (!(minor > 0.f) || !(major > minor * 1.01f))
+			return SampleTrilinear(uv, ComputeLOD(uvDx, uvDy));
+
+		//Enough taps to cover the long axis at the short axis' level, the level goes up when the taps run out. The ratio is clamped
+		//before converting, it's infinite for an infinite major axis or a denormal minor one.
+		const float ratio = major / minor;
+		const uint32_t numTaps = ratio >= maxAnisotropy ? maxAnisotropy : static_cast<uint32_t>(std::ceil(ratio));
+		const float lod = std::log2(major / numTaps);
+		const Vector2& axis = lengthDx >= lengthDy ? uvDx : uvDy;
+
+		float channels[4]{};
+		for (uint32_t tap{}; tap < numTaps; ++tap)
+		{
+			const float offset = (tap + 0.5f) / numTaps - 0.5f;
+			const Vector4 sample = SampleTrilinear(Vector2{ uv.x + axis.x * offset, uv.y + axis.y * offset }, lod);
+			channels[0] += sample.x;
+			channels[1] += sample.y;
+			channels[2] += sample.z;
+			channels[3] += sample.w;
+		}
+		const float weight = 1.f / numTaps;
+		return { channels[0] * weight, channels[1] * weight, channels[2] * weight, channels[3] * weight };
+	}
+
+	float CPUTexture::ComputeLOD(const Vector2& uvDx, const Vector2& uvDy) const
+	{
+		const float width = static_cast<float>(m_Levels[0].width);
+		const float height = static_cast<float>(m_Levels[0].height);
+		const float lengthDx = uvDx.x * uvDx.x * width * width + uvDx.y * uvDx.y * height * height;
+		const float lengthDy = uvDy.x * uvDy.x * width * width + uvDy.y * uvDy.y * height * height;
+		//log2 of the length is half the log2 of its square
+		return 0.5f * std::log2(std::max(lengthDx, lengthDy));
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "MipMaps.h"
+#include "Vector2.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	class TextureAsset;
+
+	//How the texels of a level are ordered in memory
+	enum class TexelLayout
+	{
+		//Row after row, neighbours above and below are a whole row apart
+		Linear,
+		//4x4 tiles of 64 bytes, one cache line, in row order
+		Tiled,
+		//Z-order curve over the level, close texels are close in memory at every scale
+		Morton
+	};
+
+	//RGBA8 texture with every mip level in system memory for sampling on the CPU. The fetches match the samplers in PosCol3D.fx:
+	//wrap addressing, texel centers at half texels and UNORM channels read as value / 255.
+	class CPUTexture final
+	{
+	public:
+		//RGBA8 levels with tightly packed rows like MipChain, offsets into pixels
+		CPUTexture(std::span<const uint8_t> pixels, std::span<const MipLevel> levels, TexelLayout layout);
+		//Decodes the block compressed levels of the asset
+		static std::unique_ptr<CPUTexture> Create(const TextureAsset& asset, TexelLayout layout);
+
+		uint32_t GetNumLevels() const { return static_cast<uint32_t>(m_Levels.size()); };
+		uint32_t GetWidth(uint32_t level = 0) const { return m_Levels[level].width; };
+		uint32_t GetHeight(uint32_t level = 0) const { return m_Levels[level].height; };
+		TexelLayout GetLayout() const { return m_Layout; };
+		//Bytes over all levels, padding included
+		size_t GetSize() const { return m_Texels.size() * sizeof(uint32_t); };
+
+		//Texel of the level as RGBA8, little endian so red is the lowest byte. x and y have to be inside the level.
+		uint32_t Fetch(uint32_t level, uint32_t x, uint32_t y) const { const Level& info = m_Levels[level]; return m_Texels[info.offset + GetTexelIndex(info, x, y)]; };
+
+		//samPoint: MIN_MAG_MIP_POINT, the nearest texel of the nearest level
+		Vector4 SamplePoint(const Vector2& uv, float lod) const;
+		//The four texels around uv in one level
+		Vector4 SampleBilinear(const Vector2& uv, uint32_t level) const;
+		//samLinear: MIN_MAG_MIP_LINEAR, bilinear in the two levels around lod blended by its fraction
+		Vector4 SampleTrilinear(const Vector2& uv, float lod) const;
+
+		//samAnisotropic: up to maxAnisotropy trilinear taps spread along the longer axis of the pixel's footprint, each taking the
+		//level of the shorter one. uvDx and uvDy are the uv derivatives per pixel.
+		Vector4 SampleAnisotropic(const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy, uint32_t maxAnisotropy = 16) const;
+
+		//log2 of the texels of level 0 a pixel step covers along its longer screen axis, from the uv derivatives per pixel
+		float ComputeLOD(const Vector2& uvDx, const Vector2& uvDy) const;
+
+	private:
+		struct Level
+		{
+			//In texels into m_Texels
+			size_t offset{};
+			uint32_t width{};
+			uint32_t height{};
+			//Tiled: tiles per row. Morton: bits of x and y that are interleaved, the rest of the longer side follows above them.
+			uint32_t stride{};
+		};
+
+		TexelLayout m_Layout{};
+		std::vector<Level> m_Levels{};
+		std::vector<uint32_t> m_Texels{};
+
+		//The index of a texel is the sum of a part for its column and one for its row in every layout, so the four texels of a bilinear
+		//fetch only need two of each
+		size_t GetTexelIndex(const Level& level, uint32_t x, uint32_t y) const
+		{
+			return GetColumnIndex(level, x) + GetRowIndex(level, y);
+		}
+
+		size_t GetColumnIndex(const Level& level, uint32_t x) const
+		{
+			switch (m_Layout)
+			{
+			case TexelLayout::Tiled:
+				return size_t(x >> 2) * 16 + (x & 3);
+			case TexelLayout::Morton:
+				//Past the interleaved bits only the longer side has any, they pick the square block
+				return InterleaveBits(x & ((1u << level.stride) - 1), 0) | (size_t(x >> level.stride) << (2 * level.stride));
+			default:
+				return x;
+			}
+		}
+
+		size_t GetRowIndex(const Level& level, uint32_t y) const
+		{
+			switch (m_Layout)
+			{
+			case TexelLayout::Tiled:
+				return size_t(y >> 2) * level.stride * 16 + (y & 3) * 4;
+			case TexelLayout::Morton:
+				return InterleaveBits(0, y & ((1u << level.stride) - 1)) | (size_t(y >> level.stride) << (2 * level.stride));
+			default:
+				return size_t(y) * level.width;
+			}
+		}
+
+		//Spreads the lower 16 bits of x over the even bits and those of y over the odd ones
+		static uint32_t InterleaveBits(uint32_t x, uint32_t y)
+		{
+			const auto spread = [](uint32_t value)
+				{
+					value = (value | (value << 8)) & 0x00FF00FF;
+					value = (value | (value << 4)) & 0x0F0F0F0F;
+					value = (value | (value << 2)) & 0x33333333;
+					return (value | (value << 1)) & 0x55555555;
+				};
+			return spread(x) | (spread(y) << 1);
+		}
+	};
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include <cassert>
+#ifndef DAE_CPU_ONLY
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
+#endif
 
 #include "Math.h"
 #include "Timer.h"
@@ -35,6 +37,8 @@ namespace dae
 
 		float nearPlane{ 0.1f };
 		float farPlane{ 100.f };
+		//Near plane at depth 1 and far plane at 0, for a DepthFormat::D32FReversed buffer
+		bool isReversedZ{};
 
 		Matrix projectionMatrix{};
 		float aspectRatio{};
@@ -65,7 +69,8 @@ namespace dae
 
 		void CalculateProjectionMatrix()
 		{
-			projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, nearPlane, farPlane);
+			projectionMatrix = isReversedZ ? Matrix::CreatePerspectiveFovReversedLH(fov, aspectRatio, nearPlane, farPlane)
+				: Matrix::CreatePerspectiveFovLH(fov, aspectRatio, nearPlane, farPlane);
 			//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixperspectivefovlh
 		}
 
@@ -83,6 +88,8 @@ namespace dae
 		{
 			return projectionMatrix;
 		}
+#ifndef DAE_CPU_ONLY
+		//Keyboard and mouse through SDL, the CPU-only build has no input
 		void Update(const Timer* pTimer)
 		{
 			const float deltaTime = pTimer->GetElapsed();
@@ -173,5 +180,6 @@ namespace dae
 			CalculateViewMatrix();
 			CalculateProjectionMatrix(); //Try to optimize this - should only be called once or when fov/aspectRatio changes
 		}
+#endif
 	};
 }
\ No newline at end of file
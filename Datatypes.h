@@ -11,12 +11,62 @@ struct Vertex final
 	Vector3 tangent{};
 };
 
+//20 byte alternative to Vertex, decoded by VS_Compact in PosCol3D.fx (see Quantization.h)
+struct VertexCompact final
+{
+	//UNORM16 relative to the mesh bounds, w is padding
+	uint16_t position[4]{};
+	//Half floats
+	uint16_t uv[2]{};
+	//Octahedral SNORM16
+	int16_t normal[2]{};
+	int16_t tangent[2]{};
+};
+
+//VS_OUTPUT of PosCol3D.fx on the CPU, see SoftwareRasterizer
 struct Vertex_Out final
 {
-	Vector3 position{};
+	//Clip space
+	Vector4 position{};
 	Vector2 uv{};
+	//World space, like the shader they aren't normalized again after interpolation
 	Vector3 normal{};
 	Vector3 tangent{};
-	//Vector3 viewDirection{};
+	Vector3 worldPosition{};
 };
 
+struct BoundingBox final
+{
+	Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	void Grow(const Vector3& point)
+	{
+		min = Vector3{ std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+		max = Vector3{ std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+	}
+};
+
+//One level of detail inside a shared index buffer, error is the object space distance the simplification moved the surface
+struct MeshLOD final
+{
+	uint32_t firstIndex{};
+	uint32_t numIndices{};
+	float error{};
+	//Meshlets covering the indices of this level, none if they weren't built
+	uint32_t firstMeshlet{};
+	uint32_t numMeshlets{};
+};
+
+//Small cluster of triangles that is contiguous in the index buffer, with object space culling bounds (see Meshlets.h)
+struct Meshlet final
+{
+	uint32_t firstIndex{};
+	uint32_t numIndices{};
+	Vector3 center{};
+	float radius{};
+	//Average front face direction
+	Vector3 coneAxis{};
+	//Sine of the angle the normals may deviate from the axis, 1 when the cluster can never be back-facing as a whole
+	float coneCutoff{ 1.f };
+};
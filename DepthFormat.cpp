@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "DepthFormat.h"
+#include <cmath>
+
+namespace dae
+{
+	namespace DepthFormats
+	{
+		const char* GetName(DepthFormat format)
+		{
+			switch (format)
+			{
+			case DepthFormat::D16: return "D16";
+			case DepthFormat::D24S8: return "D24S8";
+			case DepthFormat::D32F: return "D32F";
+			default: return "D32F reversed";
+			}
+		}
+
+		bool IsReversed(DepthFormat format)
+		{
+			return format == DepthFormat::D32FReversed;
+		}
+
+		bool HasStencil(DepthFormat format)
+		{
+			return format == DepthFormat::D24S8;
+		}
+
+		float GetClearDepth(DepthFormat format)
+		{
+			return IsReversed(format) ? 0.f : 1.f;
+		}
+
+		uint32_t GetNumLevels(DepthFormat format)
+		{
+			switch (format)
+			{
+			case DepthFormat::D16: return (1u << 16) - 1;
+			case DepthFormat::D24S8: return (1u << 24) - 1;
+			default: return 0;
+			}
+		}
+
+		float Quantize(float depth, DepthFormat format)
+		{
+			const uint32_t numLevels = GetNumLevels(format);
+			if (numLevels == 0)
+				return depth;
+			const float levels = static_cast<float>(numLevels);
+			return std::nearbyint(depth * levels) / levels;
+		}
+
+		double GetDepth(double distance, float nearPlane, float farPlane, DepthFormat format)
+		{
+			//depth = a + b / z, reversed swaps the planes
+			const double zn = IsReversed(format) ? farPlane : nearPlane, zf = IsReversed(format) ? nearPlane : farPlane;
+			return zf / (zf - zn) - zf * zn / ((zf - zn) * distance);
+		}
+
+		double GetResolution(double distance, float nearPlane, float farPlane, DepthFormat format)
+		{
+			//The step between stored values around the depth, a UNORM level or a float's ulp
+			const double depth = GetDepth(distance, nearPlane, farPlane, format);
+			const uint32_t numLevels = GetNumLevels(format);
+			double step{};
+			if (numLevels != 0)
+				step = 1.0 / numLevels;
+			else
+			{
+				const float stored = static_cast<float>(depth);
+				step = double(std::nextafter(stored, 2.f)) - stored;
+			}
+
+			//|dz / ddepth| = z^2 / |b|, b being the same either way round
+			const double b = double(farPlane) * nearPlane / (double(farPlane) - nearPlane);
+			return distance * distance / b * step;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//Depth buffer formats of both backends, each with its projection, clear value and comparison
+	enum class DepthFormat
+	{
+		//UNORM, 65535 steps spread like 1 / z over the range
+		D16,
+		//UNORM with 8 bits of stencil, DXGI_FORMAT_D24_UNORM_S8_UINT
+		D24S8,
+		//Float, forward: its dense values near 0 land on the near plane where 1 / z is dense already
+		D32F,
+		//Float with the near plane at 1 and the far plane at 0, cleared to 0 and compared with greater. The float's dense values
+		//near 0 then make up for 1 / z thinning out, which keeps the precision about even with distance.
+		D32FReversed
+	};
+
+	namespace DepthFormats
+	{
+		const char* GetName(DepthFormat format);
+		bool IsReversed(DepthFormat format);
+		bool HasStencil(DepthFormat format);
+		//The far plane, 1 or 0 when reversed
+		float GetClearDepth(DepthFormat format);
+		//Steps of a UNORM format, 2^bits - 1, 0 for floats
+		uint32_t GetNumLevels(DepthFormat format);
+
+		//The value the buffer stores for depth, rounded to the nearest step of UNORM formats like D3D11 does
+		float Quantize(float depth, DepthFormat format);
+		//Depth after the projection of a point at distance from the eye, of Matrix::CreatePerspectiveFovLH or its reversed variant.
+		//In doubles, before any rounding of the buffer.
+		double GetDepth(double distance, float nearPlane, float farPlane, DepthFormat format);
+		//Smallest change of distance from the eye at distance that changes the stored depth, in the same units. Anything closer
+		//together than this can z-fight.
+		double GetResolution(double distance, float nearPlane, float farPlane, DepthFormat format);
+	}
+}
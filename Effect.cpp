@@ -5,17 +5,23 @@
 Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 	:m_pEffect{LoadEffect(pDevice,assetFile)}
 {
-	m_pPointTechnique = m_pEffect->GetTechniqueByName("PointTechnique");
-	if (!m_pPointTechnique->IsValid())
-		std::wcout << L"Point Technique not valid\n";
-
-	m_pLinearTechnique = m_pEffect->GetTechniqueByName("LinearTechnique");
-	if (!m_pLinearTechnique->IsValid())
-		std::wcout << L"Linear Technique not valid\n";
-
-	m_pAnisotropicTechnique = m_pEffect->GetTechniqueByName("AnisotropicTechnique");
-	if (!m_pAnisotropicTechnique->IsValid())
-		std::wcout << L"Anisotropic Technique not valid\n";
+	//Techniques are named <Filter>[Compact][Packed]Technique in PosCol3D.fx
+	static constexpr const char* techniqueNames[m_NumTechniques]{ "Point", "Linear", "Anisotropic" };
+	static constexpr const char* formatNames[m_NumVertexFormats]{ "", "Compact" };
+	static constexpr const char* layoutNames[m_NumMaterialLayouts]{ "", "Packed" };
+	for (int layout{}; layout < m_NumMaterialLayouts; ++layout)
+	{
+		for (int format{}; format < m_NumVertexFormats; ++format)
+		{
+			for (int technique{}; technique < m_NumTechniques; ++technique)
+			{
+				const std::string name{ std::string{ techniqueNames[technique] } + formatNames[format] + layoutNames[layout] + "Technique" };
+				m_pTechniques[layout][format][technique] = m_pEffect->GetTechniqueByName(name.c_str());
+				if (!m_pTechniques[layout][format][technique]->IsValid())
+					std::cout << name << " not valid\n";
+			}
+		}
+	}
 
 	m_pMatWorldViewProjVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
 	if (!m_pMatWorldViewProjVariable->IsValid())
@@ -38,6 +44,10 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 	m_pGlossinessMapVariable = m_pEffect->GetVariableByName("gGlossinessMap")->AsShaderResource();
 	if (!m_pGlossinessMapVariable->IsValid())
 		std::wcout << L"m_pGlossinessMapVariable not valid!\n";
+
+	m_pSpecularGlossMapVariable = m_pEffect->GetVariableByName("gSpecularGlossMap")->AsShaderResource();
+	if (!m_pSpecularGlossMapVariable->IsValid())
+		std::wcout << L"m_pSpecularGlossMapVariable not valid!\n";
 	
 
 	m_pWorldVariable = m_pEffect->GetVariableByName("gWorldMatrix")->AsMatrix();
@@ -48,7 +58,14 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 	m_pViewInverseVariable = m_pEffect->GetVariableByName("gViewInverseMatrix")->AsMatrix();
 	if (!m_pViewInverseVariable->IsValid())
 		std::wcout << L"m_pViewInverseVariable not valid!\n";
-	
+
+	m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+	if (!m_pPositionOffsetVariable->IsValid())
+		std::wcout << L"m_pPositionOffsetVariable not valid!\n";
+
+	m_pPositionScaleVariable = m_pEffect->GetVariableByName("gPositionScale")->AsVector();
+	if (!m_pPositionScaleVariable->IsValid())
+		std::wcout << L"m_pPositionScaleVariable not valid!\n";
 }
 
 Effect::~Effect()
@@ -62,22 +79,9 @@ ID3DX11Effect* Effect::GetEffect() const
 	return m_pEffect;
 }
 
-ID3DX11EffectTechnique* Effect::GetTechnique(const Technique technique) const
+ID3DX11EffectTechnique* Effect::GetTechnique(const Technique technique, const VertexFormat format, const MaterialLayout layout) const
 {
-	switch (technique)
-	{
-	case (Technique::Point):
-		return m_pPointTechnique;
-		break;
-	case (Technique::Linear):
-		return m_pLinearTechnique;
-		break;
-	case (Technique::Anisotropic):
-		return m_pAnisotropicTechnique;
-		break;
-	default:
-		break;
-	}
+	return m_pTechniques[static_cast<int>(layout)][static_cast<int>(format)][static_cast<int>(technique)];
 }
 
 void Effect::SetWorldViewProjMatrix(const dae::Matrix& matrix)
@@ -95,6 +99,12 @@ void Effect::SetWorldMatrix(const dae::Matrix& matrix)
 	m_pWorldVariable->SetMatrix(reinterpret_cast<const float*>(&matrix));
 }
 
+void Effect::SetPositionDequantization(const dae::Vector3& offset, const dae::Vector3& scale)
+{
+	m_pPositionOffsetVariable->SetFloatVector(reinterpret_cast<const float*>(&offset));
+	m_pPositionScaleVariable->SetFloatVector(reinterpret_cast<const float*>(&scale));
+}
+
 void Effect::SetDiffuseMap(dae::Texture* pDiffuseTexture)
 {
 	if (m_pDiffuseMapVariable)
@@ -119,6 +129,12 @@ void Effect::SetGlossinessMap(dae::Texture* pGlossinessTexture)
 		m_pGlossinessMapVariable->SetResource(pGlossinessTexture->GetResourceView());
 }
 
+void Effect::SetSpecularGlossMap(dae::Texture* pSpecularGlossTexture)
+{
+	if (m_pSpecularGlossMapVariable)
+		m_pSpecularGlossMapVariable->SetResource(pSpecularGlossTexture->GetResourceView());
+}
+
 ID3DX11Effect* Effect::LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile)
 {
 	HRESULT result;
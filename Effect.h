@@ -14,33 +14,45 @@ public:
 	Effect& operator=(Effect&& other) = delete;
 
 	enum class Technique{Point,Linear,Anisotropic};
+	//Full reads Vertex, Compact reads VertexCompact
+	enum class VertexFormat{Full,Compact};
+	//Separate samples the specular and glossiness maps, Packed one map with specular in rgb and glossiness in a
+	enum class MaterialLayout{Separate,Packed};
 
 	ID3DX11Effect* GetEffect() const;
-	ID3DX11EffectTechnique* GetTechnique(const Technique technique) const;
+	ID3DX11EffectTechnique* GetTechnique(const Technique technique, const VertexFormat format = VertexFormat::Full, const MaterialLayout layout = MaterialLayout::Separate) const;
 
 	void SetWorldViewProjMatrix(const dae::Matrix& matrix);
 	void SetInvViewMatrix(const dae::Matrix& matrix);
 	void SetWorldMatrix(const dae::Matrix& matrix);
+	//Maps the UNORM16 positions of VertexCompact back to object space
+	void SetPositionDequantization(const dae::Vector3& offset, const dae::Vector3& scale);
 	
 	void SetDiffuseMap(dae::Texture* pDiffuseTexture);
 	void SetNormalMap(dae::Texture* pNormalTexture);
 	void SetSpecularMap(dae::Texture* pSpecularTexture);
 	void SetGlossinessMap(dae::Texture* pGlossinessTexture);
+	void SetSpecularGlossMap(dae::Texture* pSpecularGlossTexture);
 
 private:
 	ID3DX11Effect* m_pEffect{};
-	ID3DX11EffectTechnique* m_pPointTechnique{};
-	ID3DX11EffectTechnique* m_pLinearTechnique{};
-	ID3DX11EffectTechnique* m_pAnisotropicTechnique{};
+	static constexpr int m_NumTechniques{ 3 };
+	static constexpr int m_NumVertexFormats{ 2 };
+	static constexpr int m_NumMaterialLayouts{ 2 };
+	ID3DX11EffectTechnique* m_pTechniques[m_NumMaterialLayouts][m_NumVertexFormats][m_NumTechniques]{};
 
 	ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable{};
 	ID3DX11EffectMatrixVariable* m_pWorldVariable{};
 	ID3DX11EffectMatrixVariable* m_pViewInverseVariable{};
 
+	ID3DX11EffectVectorVariable* m_pPositionOffsetVariable{};
+	ID3DX11EffectVectorVariable* m_pPositionScaleVariable{};
+
 	ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{};
+	ID3DX11EffectShaderResourceVariable* m_pSpecularGlossMapVariable{};
 
 	static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
 };
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "FileMapping.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+#if defined(_WIN32)
+	FileMapping::FileMapping(const std::string& path)
+	{
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		m_FileHandle = file;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize))
+			return;
+
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+		if (m_Size == 0)
+		{
+			//Empty files can't be mapped, but are still valid
+			m_IsOpen = true;
+			return;
+		}
+
+		m_MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_MappingHandle)
+			return;
+
+		m_pData = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		m_IsOpen = m_pData != nullptr;
+	}
+
+	FileMapping::~FileMapping()
+	{
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+	}
+#else
+	FileMapping::FileMapping(const std::string& path)
+	{
+		m_FileDescriptor = open(path.c_str(), O_RDONLY);
+		if (m_FileDescriptor < 0)
+			return;
+
+		struct stat fileStat {};
+		if (fstat(m_FileDescriptor, &fileStat) != 0)
+			return;
+
+		m_Size = static_cast<size_t>(fileStat.st_size);
+		if (m_Size == 0)
+		{
+			//Empty files can't be mapped, but are still valid
+			m_IsOpen = true;
+			return;
+		}
+
+		void* pData = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+		if (pData == MAP_FAILED)
+			return;
+
+		madvise(pData, m_Size, MADV_SEQUENTIAL);
+		m_pData = static_cast<const char*>(pData);
+		m_IsOpen = true;
+	}
+
+	FileMapping::~FileMapping()
+	{
+		if (m_pData)
+			munmap(const_cast<char*>(m_pData), m_Size);
+
+		if (m_FileDescriptor >= 0)
+			close(m_FileDescriptor);
+	}
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+namespace dae
+{
+	//Read-only view of a whole file, memory-mapped by the OS
+	class FileMapping final
+	{
+	public:
+		FileMapping(const std::string& path);
+		~FileMapping();
+
+		FileMapping(const FileMapping&) = delete;
+		FileMapping(FileMapping&&) noexcept = delete;
+		FileMapping& operator=(const FileMapping&) = delete;
+		FileMapping& operator=(FileMapping&&) noexcept = delete;
+
+		bool IsValid() const { return m_IsOpen; };
+		const char* GetData() const { return m_pData; };
+		const char* GetEnd() const { return m_pData + m_Size; };
+		size_t GetSize() const { return m_Size; };
+
+	private:
+		const char* m_pData{};
+		size_t m_Size{};
+		bool m_IsOpen{ false };
+
+#if defined(_WIN32)
+		void* m_FileHandle{};
+		void* m_MappingHandle{};
+#else
+		int m_FileDescriptor{ -1 };
+#endif
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace dae
+{
+	namespace Hash
+	{
+		//64-bit hash over 4 independent lanes (xxHash64 structure), fast enough to key caches on whole files
+		inline uint64_t HashBytes(const void* pData, size_t size, uint64_t seed = 0)
+		{
+			constexpr uint64_t prime1{ 0x9E3779B185EBCA87ull };
+			constexpr uint64_t prime2{ 0xC2B2AE3D27D4EB4Full };
+			constexpr uint64_t prime3{ 0x165667B19E3779F9ull };
+			constexpr uint64_t prime4{ 0x85EBCA77C2B2AE63ull };
+			constexpr uint64_t prime5{ 0x27D4EB2F165667C5ull };
+
+			const auto rotateLeft = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+			const auto round = [&](uint64_t accumulator, uint64_t input)
+				{
+					accumulator += input * prime2;
+					return rotateLeft(accumulator, 31) * prime1;
+				};
+			const auto read64 = [](const uint8_t* p) { uint64_t value; std::memcpy(&value, p, sizeof(value)); return value; };
+
+			const uint8_t* p = static_cast<const uint8_t*>(pData);
+			const uint8_t* pEnd = p + size;
+			uint64_t hash{};
+
+			if (size >= 32)
+			{
+				uint64_t lanes[4]{ seed + prime1 + prime2, seed + prime2, seed, seed - prime1 };
+				for (; pEnd - p >= 32; p += 32)
+				{
+					lanes[0] = round(lanes[0], read64(p));
+					lanes[1] = round(lanes[1], read64(p + 8));
+					lanes[2] = round(lanes[2], read64(p + 16));
+					lanes[3] = round(lanes[3], read64(p + 24));
+				}
+
+				hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+				for (uint64_t lane : lanes)
+					hash = (hash ^ round(0, lane)) * prime1 + prime4;
+			}
+			else
+			{
+				hash = seed + prime5;
+			}
+
+			hash += size;
+			for (; pEnd - p >= 8; p += 8)
+				hash = rotateLeft(hash ^ round(0, read64(p)), 27) * prime1 + prime4;
+			for (; p < pEnd; ++p)
+				hash = rotateLeft(hash ^ (*p * prime5), 11) * prime1;
+
+			hash ^= hash >> 33;
+			hash *= prime2;
+			hash ^= hash >> 29;
+			hash *= prime3;
+			return hash ^ (hash >> 32);
+		}
+
+		inline uint64_t HashString(const std::string& text, uint64_t seed = 0)
+		{
+			return HashBytes(text.data(), text.size(), seed);
+		}
+	}
+}
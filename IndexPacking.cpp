@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "IndexPacking.h"
+#include <cassert>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t g_MaxRangeVertices{ 0x10000 };
+
+		bool IsRangeBreak(std::span<const uint32_t> rangeBreaks, uint32_t index)
+		{
+			return std::find(rangeBreaks.begin(), rangeBreaks.end(), index) != rangeBreaks.end();
+		}
+
+		//Ranges over windows of the original vertex buffer, fails if a single triangle doesn't fit in one window
+		bool PackWindows(std::span<const uint32_t> indices, std::span<const uint32_t> rangeBreaks, IndexPacking::PackedIndices& packed)
+		{
+			uint32_t rangeStart{}, rangeMin{ UINT32_MAX }, rangeMax{};
+			const auto closeRange = [&](uint32_t rangeEnd)
+				{
+					if (rangeEnd == rangeStart)
+						return;
+
+					for (uint32_t i{ rangeStart }; i < rangeEnd; ++i)
+						packed.indices[i] = static_cast<uint16_t>(indices[i] - rangeMin);
+
+					packed.ranges.push_back(IndexPacking::DrawRange{ rangeStart, rangeEnd - rangeStart, static_cast<int32_t>(rangeMin) });
+					rangeStart = rangeEnd;
+				};
+
+			for (uint32_t i{}; i < indices.size(); i += 3)
+			{
+				const uint32_t triangleMin = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+				const uint32_t triangleMax = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+				if (triangleMax - triangleMin >= g_MaxRangeVertices)
+					return false;
+
+				const uint32_t newMin = std::min(rangeMin, triangleMin);
+				const uint32_t newMax = std::max(rangeMax, triangleMax);
+				if (newMax - newMin >= g_MaxRangeVertices || IsRangeBreak(rangeBreaks, i))
+				{
+					closeRange(i);
+					rangeMin = triangleMin;
+					rangeMax = triangleMax;
+				}
+				else
+				{
+					rangeMin = newMin;
+					rangeMax = newMax;
+				}
+			}
+			closeRange(static_cast<uint32_t>(indices.size()));
+			return true;
+		}
+
+		//Ranges with their own vertices, a triangle that would push the range past 65536 vertices starts the next one
+		void PackRemapped(std::span<const uint32_t> indices, size_t numVertices, std::span<const uint32_t> rangeBreaks, IndexPacking::PackedIndices& packed)
+		{
+			//Local index of every source vertex, only valid when its stamp matches the current range
+			std::vector<uint32_t> rangeStamps(numVertices, UINT32_MAX);
+			std::vector<uint16_t> localIndices(numVertices);
+
+			uint32_t rangeStart{}, rangeBase{};
+			const auto closeRange = [&](uint32_t rangeEnd)
+				{
+					packed.ranges.push_back(IndexPacking::DrawRange{ rangeStart, rangeEnd - rangeStart, static_cast<int32_t>(rangeBase) });
+					rangeStart = rangeEnd;
+					rangeBase = static_cast<uint32_t>(packed.vertexRemap.size());
+				};
+
+			for (uint32_t i{}; i < indices.size(); i += 3)
+			{
+				uint32_t rangeId = static_cast<uint32_t>(packed.ranges.size());
+				uint32_t numNew{};
+				for (uint32_t corner{}; corner < 3; ++corner)
+					numNew += rangeStamps[indices[i + corner]] != rangeId;
+
+				if (packed.vertexRemap.size() - rangeBase + numNew > g_MaxRangeVertices || (i > rangeStart && IsRangeBreak(rangeBreaks, i)))
+				{
+					closeRange(i);
+					++rangeId;
+				}
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t index = indices[i + corner];
+					if (rangeStamps[index] != rangeId)
+					{
+						rangeStamps[index] = rangeId;
+						localIndices[index] = static_cast<uint16_t>(packed.vertexRemap.size() - rangeBase);
+						packed.vertexRemap.push_back(index);
+					}
+					packed.indices[i + corner] = localIndices[index];
+				}
+			}
+			if (rangeStart < indices.size())
+				closeRange(static_cast<uint32_t>(indices.size()));
+		}
+	}
+
+	namespace IndexPacking
+	{
+		PackedIndices PackIndices16(std::span<const uint32_t> indices, size_t numVertices, std::span<const uint32_t> rangeBreaks)
+		{
+			assert(indices.size() % 3 == 0);
+
+			PackedIndices packed{};
+			packed.indices.resize(indices.size());
+
+			if (!PackWindows(indices, rangeBreaks, packed))
+			{
+				packed.ranges.clear();
+				PackRemapped(indices, numVertices, rangeBreaks, packed);
+			}
+			return packed;
+		}
+
+		size_t GetNumVertices(const PackedIndices& packed, size_t numVertices)
+		{
+			return packed.vertexRemap.empty() ? numVertices : packed.vertexRemap.size();
+		}
+
+		bool ValidateDrawRanges(const PackedIndices& packed, std::span<const uint32_t> indices, size_t numVertices)
+		{
+			if (packed.indices.size() != indices.size())
+				return false;
+
+			const size_t numDrawnVertices = GetNumVertices(packed, numVertices);
+			uint32_t nextIndex{};
+			for (const DrawRange& range : packed.ranges)
+			{
+				//Ranges have to be back to back, made of whole triangles and inside the vertex buffer
+				if (range.startIndex != nextIndex || range.indexCount == 0 || range.indexCount % 3 != 0 || range.baseVertex < 0)
+					return false;
+				nextIndex += range.indexCount;
+				if (nextIndex > indices.size())
+					return false;
+
+				for (uint32_t i{ range.startIndex }; i < nextIndex; ++i)
+				{
+					const size_t vertex = static_cast<size_t>(range.baseVertex) + packed.indices[i];
+					if (vertex >= numDrawnVertices)
+						return false;
+
+					const size_t sourceVertex = packed.vertexRemap.empty() ? vertex : packed.vertexRemap[vertex];
+					if (sourceVertex != indices[i])
+						return false;
+				}
+			}
+			return nextIndex == indices.size();
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace dae
+{
+	//Splits a 32-bit triangle list into 16-bit index ranges that are drawn with a per-range base vertex
+	namespace IndexPacking
+	{
+		//Arguments of one DrawIndexed call
+		struct DrawRange
+		{
+			uint32_t startIndex{};
+			uint32_t indexCount{};
+			int32_t baseVertex{};
+		};
+
+		struct PackedIndices
+		{
+			std::vector<uint16_t> indices{};
+			std::vector<DrawRange> ranges{};
+			//Empty when the ranges draw from the original vertex buffer, otherwise the source vertex of every
+			//vertex of the rebuilt buffer (vertices shared by two ranges are stored once per range)
+			std::vector<uint32_t> vertexRemap{};
+		};
+
+		//Keeps the triangle order. Ranges are first windows of the original buffer: their indices are relative to the lowest vertex
+		//they use, which is their base vertex, so a mesh with up to 65536 vertices and no breaks is one range. If some triangle is too
+		//spread out for that every range gets its own copy of the vertices it uses instead, based where the copy starts in vertexRemap.
+		//rangeBreaks lists index offsets no range may cross, e.g. where one LOD ends and the next starts
+		PackedIndices PackIndices16(std::span<const uint32_t> indices, size_t numVertices, std::span<const uint32_t> rangeBreaks = {});
+
+		//Number of vertices the ranges draw from
+		size_t GetNumVertices(const PackedIndices& packed, size_t numVertices);
+
+		//True when drawing the ranges produces exactly the original triangles in the original order
+		bool ValidateDrawRanges(const PackedIndices& packed, std::span<const uint32_t> indices, size_t numVertices);
+	}
+}
@@ -164,6 +164,12 @@ namespace dae {
 		Vector4{0,0,-(zf * zn) / (zf - zn),0} };
 	}
 
+	Matrix Matrix::CreatePerspectiveFovReversedLH(float fov, float aspect, float zn, float zf)
+	{
+		//The same projection with the planes swapped
+		return CreatePerspectiveFovLH(fov, aspect, zf, zn);
+	}
+
 	Vector3 Matrix::GetAxisX() const
 	{
 		return data[0];
@@ -50,6 +50,8 @@ namespace dae {
 
 		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
 		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
+		//Depth 1 at the near plane and 0 at the far plane, for DepthFormat::D32FReversed
+		static Matrix CreatePerspectiveFovReversedLH(float fovy, float aspect, float zn, float zf);
 
 		Vector4& operator[](int index);
 		Vector4 operator[](int index) const;
@@ -1,38 +1,45 @@
 #include "pch.h"
 #include "Mesh.h"
 #include "Math.h"
+#include "Quantization.h"
+#include "Camera.h"
+#include "TextureStreamer.h"
+#include <cassert>
 
-Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex> &vertices, const std::vector<uint32_t>& indices, Texture* pDiffuseTexture,
-	Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture)
+Mesh::Mesh(ID3D11Device* pDevice, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods, std::span<const Meshlet> meshlets, Texture* pDiffuseTexture,
+	Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture, Effect::VertexFormat vertexFormat)
 	:m_pEffect{new Effect(pDevice,L"Resources/PosCol3D.fx")}
+	,m_VertexFormat{vertexFormat}
 {
+	const bool isCompact{ m_VertexFormat == Effect::VertexFormat::Compact };
+
 	// Create Vertex Layout
 	static constexpr uint32_t numElements{ 4 };
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
 
 	vertexDesc[0].SemanticName = "POSITION";
-	vertexDesc[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[0].AlignedByteOffset = 0;
+	vertexDesc[0].Format = isCompact ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	vertexDesc[0].AlignedByteOffset = isCompact ? offsetof(VertexCompact, position) : offsetof(Vertex, position);
 	vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	vertexDesc[1].SemanticName = "TEXCOORD";
-	vertexDesc[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	vertexDesc[1].AlignedByteOffset = 12;
+	vertexDesc[1].Format = isCompact ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+	vertexDesc[1].AlignedByteOffset = isCompact ? offsetof(VertexCompact, uv) : offsetof(Vertex, uv);
 	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	vertexDesc[2].SemanticName = "NORMAL";
-	vertexDesc[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[2].AlignedByteOffset = 20;
+	vertexDesc[2].Format = isCompact ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	vertexDesc[2].AlignedByteOffset = isCompact ? offsetof(VertexCompact, normal) : offsetof(Vertex, normal);
 	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	vertexDesc[3].SemanticName = "TANGENT";
-	vertexDesc[3].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	vertexDesc[3].AlignedByteOffset = 32;
+	vertexDesc[3].Format = isCompact ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	vertexDesc[3].AlignedByteOffset = isCompact ? offsetof(VertexCompact, tangent) : offsetof(Vertex, tangent);
 	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	// Create Input Layout
 	D3DX11_PASS_DESC passDesc{};
-	m_pEffect->GetTechnique(m_CurrentTechnique)->GetPassByIndex(0)->GetDesc(&passDesc);
+	m_pEffect->GetTechnique(m_CurrentTechnique, m_VertexFormat)->GetPassByIndex(0)->GetDesc(&passDesc);
 
 	HRESULT result{ pDevice->CreateInputLayout(
 			vertexDesc,
@@ -44,37 +51,90 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::vector<Vertex> &vertices, const std
 	if (FAILED(result))
 		return;
 
+	for (const Vertex& vertex : vertices)
+		m_Bounds.Grow(vertex.position);
+
+	// Split the indices into 16-bit ranges, rebuilding the vertex buffer if the ranges need their own vertices
+	const MeshLOD fullLOD{ 0, static_cast<uint32_t>(indices.size()), 0.f };
+	if (lods.empty())
+		lods = { &fullLOD, 1 };
+	m_WorldPerUV = TextureStreamer::ComputeWorldPerUV(vertices, indices.subspan(lods[0].firstIndex, lods[0].numIndices));
+
+	std::vector<uint32_t> lodStarts{};
+	for (const MeshLOD& lod : lods)
+		lodStarts.push_back(lod.firstIndex);
+
+	IndexPacking::PackedIndices packedIndices{ IndexPacking::PackIndices16(indices, vertices.size(), lodStarts) };
+	assert(IndexPacking::ValidateDrawRanges(packedIndices, indices, vertices.size()));
+
+	// Every LOD starts a range, so it owns the ranges up to the next one
+	for (const MeshLOD& lod : lods)
+	{
+		LODRanges lodRanges{ 0, 0, lod.error, meshlets.empty() ? 0 : lod.firstMeshlet, meshlets.empty() ? 0 : lod.numMeshlets };
+		for (uint32_t range{}; range < packedIndices.ranges.size(); ++range)
+		{
+			const IndexPacking::DrawRange& drawRange = packedIndices.ranges[range];
+			if (drawRange.startIndex < lod.firstIndex || drawRange.startIndex >= lod.firstIndex + lod.numIndices)
+				continue;
+			if (lodRanges.numRanges == 0)
+				lodRanges.firstRange = range;
+			++lodRanges.numRanges;
+		}
+		m_LODs.push_back(lodRanges);
+	}
+	m_Meshlets.assign(meshlets.begin(), meshlets.end());
+
+	std::vector<Vertex> remappedVertices{};
+	if (!packedIndices.vertexRemap.empty())
+	{
+		remappedVertices.reserve(packedIndices.vertexRemap.size());
+		for (uint32_t sourceVertex : packedIndices.vertexRemap)
+			remappedVertices.push_back(vertices[sourceVertex]);
+		vertices = remappedVertices;
+	}
+
+	// Quantize positions to the mesh bounds
+	std::vector<VertexCompact> compactVertices{};
+	if (isCompact)
+	{
+		const Quantization::PositionDequantization dequantization{ vertices.empty() ? Quantization::PositionDequantization{} : Quantization::GetPositionDequantization(m_Bounds) };
+		compactVertices.reserve(vertices.size());
+		for (const Vertex& vertex : vertices)
+			compactVertices.push_back(Quantization::EncodeVertex(vertex, dequantization));
+
+		m_pEffect->SetPositionDequantization(dequantization.offset, dequantization.scale);
+	}
+
 	// Create vertex buffer
 	D3D11_BUFFER_DESC bd{};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
+	bd.ByteWidth = GetVertexStride() * static_cast<uint32_t>(vertices.size());
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData{};
-	initData.pSysMem = vertices.data();
+	initData.pSysMem = isCompact ? static_cast<const void*>(compactVertices.data()) : vertices.data();
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 	if (FAILED(result)) return;
 
 	// Create index buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
+	bd.ByteWidth = sizeof(uint16_t) * static_cast<uint32_t>(packedIndices.indices.size());
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
+	initData.pSysMem = packedIndices.indices.data();
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 	if (FAILED(result)) 
 		return;
 
-	m_pEffect->SetDiffuseMap(pDiffuseTexture);
-	m_pEffect->SetNormalMap(pNormalTexture);
-	m_pEffect->SetSpecularMap(pSpecularTexture);
-	m_pEffect->SetGlossinessMap(pGlossinessTexture);
+	m_DrawRanges = std::move(packedIndices.ranges);
+	ResetVisibleDraws();
+
+	SetMaps(pDiffuseTexture, pNormalTexture, pSpecularTexture, pGlossinessTexture);
 }
 
 Mesh::~Mesh()
@@ -110,20 +170,21 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
 	pDeviceContext->IASetInputLayout(m_pInputLayout);
 
 	//3. Set Vertex Buffer
-	constexpr UINT stride = sizeof(Vertex);
+	const UINT stride = GetVertexStride();
 	constexpr UINT offset = 0;
 	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 
 	//4. Set Index Buffer
-	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
 
 	//5. Draw
 	D3DX11_TECHNIQUE_DESC techDesc{};
-	m_pEffect->GetTechnique(m_CurrentTechnique)->GetDesc(&techDesc);
+	m_pEffect->GetTechnique(m_CurrentTechnique, m_VertexFormat, m_MaterialLayout)->GetDesc(&techDesc);
 	for (UINT p{}; p < techDesc.Passes; ++p)
 	{
-		m_pEffect->GetTechnique(m_CurrentTechnique)->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		m_pEffect->GetTechnique(m_CurrentTechnique, m_VertexFormat, m_MaterialLayout)->GetPassByIndex(p)->Apply(0, pDeviceContext);
+		for (const IndexPacking::DrawRange& drawRange : m_VisibleDraws)
+			pDeviceContext->DrawIndexed(drawRange.indexCount, drawRange.startIndex, drawRange.baseVertex);
 	}
 }
 
@@ -152,6 +213,23 @@ void Mesh::SwitchTechnique()
 	}
 }
 
+void Mesh::SetMaps(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture)
+{
+	m_pEffect->SetDiffuseMap(pDiffuseTexture);
+	m_pEffect->SetNormalMap(pNormalTexture);
+	m_pEffect->SetSpecularMap(pSpecularTexture);
+	m_pEffect->SetGlossinessMap(pGlossinessTexture);
+	m_MaterialLayout = Effect::MaterialLayout::Separate;
+}
+
+void Mesh::SetPackedMaps(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularGlossTexture)
+{
+	m_pEffect->SetDiffuseMap(pDiffuseTexture);
+	m_pEffect->SetNormalMap(pNormalTexture);
+	m_pEffect->SetSpecularGlossMap(pSpecularGlossTexture);
+	m_MaterialLayout = Effect::MaterialLayout::Packed;
+}
+
 void Mesh::SetWorldMatrix(const dae::Matrix& matrix)
 {
 	m_WorldMatrix = matrix;
@@ -161,3 +239,91 @@ dae::Matrix Mesh::GetWorldMatrix() const
 {
 	return m_WorldMatrix;
 }
+
+uint32_t Mesh::GetVertexStride() const
+{
+	return m_VertexFormat == Effect::VertexFormat::Compact ? sizeof(VertexCompact) : sizeof(Vertex);
+}
+
+void Mesh::UpdateLOD(const dae::Camera& camera, float viewportHeight, float maxPixelError)
+{
+	if (m_LODs.empty())
+		return;
+
+	//Bounding sphere in world space, the world matrix only rotates and translates
+	const dae::Vector3 center = m_WorldMatrix.TransformPoint((m_Bounds.min + m_Bounds.max) * 0.5f);
+	const float radius = (m_Bounds.max - m_Bounds.min).Magnitude() * 0.5f;
+	const float distance = std::max((center - camera.origin).Magnitude() - radius, camera.nearPlane);
+
+	//Object space error to pixels at the closest point of the bounds, camera.fov is tan(fovAngle / 2)
+	const float pixelsPerUnit = viewportHeight / (2.f * camera.fov * distance);
+
+	const uint32_t previousLOD{ m_CurrentLOD };
+	m_CurrentLOD = 0;
+	for (uint32_t lod{ 1 }; lod < m_LODs.size(); ++lod)
+	{
+		if (m_LODs[lod].error * pixelsPerUnit > maxPixelError)
+			break;
+		m_CurrentLOD = lod;
+	}
+
+	if (m_CurrentLOD != previousLOD)
+		ResetVisibleDraws();
+}
+
+float Mesh::GetUVPerPixel(const dae::Camera& camera, float viewportHeight) const
+{
+	const dae::Vector3 center = m_WorldMatrix.TransformPoint((m_Bounds.min + m_Bounds.max) * 0.5f);
+	const float radius = (m_Bounds.max - m_Bounds.min).Magnitude() * 0.5f;
+	return TextureStreamer::ComputeUVPerPixel(m_WorldPerUV, center, radius, camera, viewportHeight);
+}
+
+uint32_t Mesh::GetCurrentLOD() const
+{
+	return m_CurrentLOD;
+}
+
+void Mesh::CullMeshlets(const dae::Camera& camera)
+{
+	if (m_LODs.empty() || m_LODs[m_CurrentLOD].numMeshlets == 0)
+		return;
+	const LODRanges& lod = m_LODs[m_CurrentLOD];
+
+	const dae::Meshlets::ViewFrustum frustum{ camera.fov, camera.aspectRatio, camera.nearPlane, camera.farPlane };
+	m_VisibleIntervals.clear();
+	m_CullStats = dae::Meshlets::CullMeshlets({ m_Meshlets.data() + lod.firstMeshlet, lod.numMeshlets }, m_WorldMatrix * camera.GetInverseViewMatrix(), frustum, m_VisibleIntervals);
+
+	//Both the intervals and the ranges are sorted, cut every interval at the 16-bit range borders
+	m_VisibleDraws.clear();
+	uint32_t range{ lod.firstRange };
+	const uint32_t endRange{ lod.firstRange + lod.numRanges };
+	for (const dae::Meshlets::IndexInterval& interval : m_VisibleIntervals)
+	{
+		const uint32_t intervalEnd{ interval.firstIndex + interval.numIndices };
+		while (range < endRange && m_DrawRanges[range].startIndex + m_DrawRanges[range].indexCount <= interval.firstIndex)
+			++range;
+
+		for (uint32_t r{ range }; r < endRange && m_DrawRanges[r].startIndex < intervalEnd; ++r)
+		{
+			const IndexPacking::DrawRange& drawRange = m_DrawRanges[r];
+			const uint32_t start{ std::max(interval.firstIndex, drawRange.startIndex) };
+			const uint32_t end{ std::min(intervalEnd, drawRange.startIndex + drawRange.indexCount) };
+			m_VisibleDraws.push_back(IndexPacking::DrawRange{ start, end - start, drawRange.baseVertex });
+		}
+	}
+}
+
+const dae::Meshlets::CullStats& Mesh::GetCullStats() const
+{
+	return m_CullStats;
+}
+
+void Mesh::ResetVisibleDraws()
+{
+	m_VisibleDraws.clear();
+	if (m_LODs.empty())
+		return;
+
+	const LODRanges& lod = m_LODs[m_CurrentLOD];
+	m_VisibleDraws.assign(m_DrawRanges.begin() + lod.firstRange, m_DrawRanges.begin() + lod.firstRange + lod.numRanges);
+}
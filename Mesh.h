@@ -1,15 +1,22 @@
 #pragma once
 #include "Effect.h"
 #include "Datatypes.h"
-#include <vector>
+#include "IndexPacking.h"
+#include "Meshlets.h"
+#include <span>
 
 class Matrix;
+namespace dae
+{
+	struct Camera;
+}
 
 class Mesh
 {
 public:
-	Mesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Texture* pDiffuseTexture,
-		Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture);
+	//lods index into indices, an empty list draws all indices as a single level. meshlets are indexed by the lods, empty disables culling
+	Mesh(ID3D11Device* pDevice, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const MeshLOD> lods, std::span<const Meshlet> meshlets, Texture* pDiffuseTexture,
+		Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture, Effect::VertexFormat vertexFormat = Effect::VertexFormat::Full);
 	~Mesh();
 	//Rule of 5
 	Mesh(const Mesh& other) = delete;
@@ -20,17 +27,57 @@ public:
 	void Render(ID3D11DeviceContext* pDeviceContext) const;
 	void SetMatrix(const dae::Matrix& matrix, const dae::Matrix& invViewMatrix);
 	void SwitchTechnique();
+	//Rebinds the maps, e.g. when a texture finished loading after the mesh
+	void SetMaps(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture);
+	//Same with specular in rgb and glossiness in a of one map, see TextureAsset::LoadPacked. Switches to the Packed techniques.
+	void SetPackedMaps(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularGlossTexture);
 	void SetWorldMatrix(const dae::Matrix& matrix);
 	dae::Matrix GetWorldMatrix() const;
+	//Picks the coarsest LOD whose error projects to at most maxPixelError pixels on screen
+	void UpdateLOD(const dae::Camera& camera, float viewportHeight, float maxPixelError = 1.f);
+	uint32_t GetCurrentLOD() const;
+	//UV units one pixel covers where the mesh is closest to the camera, what TextureStreamer::Request wants for its maps
+	float GetUVPerPixel(const dae::Camera& camera, float viewportHeight) const;
+	//Drops the meshlets of the current LOD the camera can't see, call after UpdateLOD
+	void CullMeshlets(const dae::Camera& camera);
+	const dae::Meshlets::CullStats& GetCullStats() const;
 
 private:
+	struct LODRanges
+	{
+		uint32_t firstRange{};
+		uint32_t numRanges{};
+		float error{};
+		uint32_t firstMeshlet{};
+		uint32_t numMeshlets{};
+	};
+
+	uint32_t GetVertexStride() const;
+	//Draws every range of the current LOD
+	void ResetVisibleDraws();
+
 	Effect* m_pEffect{};
 	Effect::Technique m_CurrentTechnique{Effect::Technique::Point};
+	Effect::VertexFormat m_VertexFormat{Effect::VertexFormat::Full};
+	Effect::MaterialLayout m_MaterialLayout{Effect::MaterialLayout::Separate};
 	
 	ID3D11InputLayout* m_pInputLayout{};
 	ID3D11Buffer* m_pVertexBuffer{};
-	uint32_t m_NumIndices{};
 	ID3D11Buffer* m_pIndexBuffer{};
+	//16-bit index ranges, one DrawIndexed each, grouped per LOD
+	std::vector<dae::IndexPacking::DrawRange> m_DrawRanges{};
+	std::vector<LODRanges> m_LODs{};
+	uint32_t m_CurrentLOD{};
+
+	std::vector<Meshlet> m_Meshlets{};
+	std::vector<dae::Meshlets::IndexInterval> m_VisibleIntervals{};
+	//What Render draws: the LOD's ranges cut down to the visible meshlets
+	std::vector<dae::IndexPacking::DrawRange> m_VisibleDraws{};
+	dae::Meshlets::CullStats m_CullStats{};
+
+	BoundingBox m_Bounds{};
+	//Object space length per UV unit of LOD 0, see TextureStreamer::ComputeWorldPerUV
+	float m_WorldPerUV{};
 
 	dae::Matrix m_WorldMatrix{};
 };
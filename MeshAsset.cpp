@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "MeshAsset.h"
+#include "FileMapping.h"
+#include "Hash.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		//.dmesh layout: header, MeshLOD[numLODs], Meshlet[numMeshlets], Vertex[numVertices], uint32_t[numIndices]
+		struct DMeshHeader
+		{
+			char magic[4]{ 'D', 'M', 'S', 'H' };
+			uint32_t version{};
+			uint64_t sourceHash{};
+			uint64_t optionsHash{};
+			uint32_t vertexSize{};
+			uint32_t numVertices{};
+			uint32_t numIndices{};
+			uint32_t numLODs{};
+			uint32_t numMeshlets{};
+			BoundingBox bounds{};
+		};
+
+		//Bump whenever the import or the layout changes, old caches are then rebuilt. 5: cache order rebuilt inside every meshlet.
+		constexpr uint32_t g_DMeshVersion{ 5 };
+
+		//Fraction of the full triangle count every generated LOD keeps
+		constexpr float g_LODRatios[]{ 0.5f, 0.25f, 0.1f, 0.05f };
+
+		uint64_t HashOptions(const MeshImportOptions& options)
+		{
+			//Only what changes the output, the thread pool doesn't
+			const uint8_t values[]{ options.obj.flipAxisAndWinding, options.obj.weldVertices, options.optimize, options.generateLODs, options.buildMeshlets };
+			return Hash::HashBytes(values, sizeof(values), g_DMeshVersion);
+		}
+
+		//Forsyth order of one meshlet's triangles, on its own few vertices numbered locally so the pass doesn't touch the whole mesh
+		void OptimizeMeshletVertexCache(std::span<uint32_t> indices)
+		{
+			std::vector<uint32_t> vertices{}, localIndices(indices.size());
+			for (size_t i{}; i < indices.size(); ++i)
+			{
+				const auto it = std::find(vertices.begin(), vertices.end(), indices[i]);
+				localIndices[i] = static_cast<uint32_t>(it - vertices.begin());
+				if (it == vertices.end())
+					vertices.push_back(indices[i]);
+			}
+			MeshOptimizer::OptimizeVertexCache(localIndices, vertices.size());
+			for (size_t i{}; i < indices.size(); ++i)
+				indices[i] = vertices[localIndices[i]];
+		}
+	}
+
+	MeshAsset::~MeshAsset() = default;
+
+	std::unique_ptr<MeshAsset> MeshAsset::Load(const std::string& objPath, const MeshImportOptions& options)
+	{
+		const FileMapping source{ objPath };
+		if (!source.IsValid())
+			return nullptr;
+
+		std::unique_ptr<MeshAsset> pAsset{ new MeshAsset{} };
+
+		const std::string cachePath = GetCachePath(objPath);
+		const uint64_t sourceHash = Hash::HashBytes(source.GetData(), source.GetSize());
+		const uint64_t optionsHash = HashOptions(options);
+		if (pAsset->TryMapCache(cachePath, sourceHash, optionsHash))
+			return pAsset;
+
+		std::vector<Vertex>& vertices = pAsset->m_OwnedVertices;
+		std::vector<uint32_t>& indices = pAsset->m_OwnedIndices;
+		if (!Utils::ParseOBJ(source.GetData(), source.GetEnd(), vertices, indices, options.obj))
+			return nullptr;
+
+		std::vector<MeshLOD>& lods = pAsset->m_OwnedLODs;
+		if (options.generateLODs)
+			lods = MeshSimplifier::BuildLODChain(vertices, indices, g_LODRatios);
+		else
+			lods = { MeshLOD{ 0, static_cast<uint32_t>(indices.size()), 0.f } };
+
+		if (options.optimize)
+		{
+			//Triangle order per LOD, the vertex order follows LOD 0 first
+			std::vector<uint32_t> lodIndices{};
+			for (const MeshLOD& lod : lods)
+			{
+				lodIndices.assign(indices.begin() + lod.firstIndex, indices.begin() + lod.firstIndex + lod.numIndices);
+				MeshOptimizer::OptimizeVertexCache(lodIndices, vertices.size());
+				MeshOptimizer::OptimizeOverdraw(lodIndices, vertices);
+				std::copy(lodIndices.begin(), lodIndices.end(), indices.begin() + lod.firstIndex);
+			}
+		}
+
+		//Clustering regroups the triangles of every LOD, only the order the meshlets grow in follows the passes above. The cache order is
+		//rebuilt inside every meshlet.
+		if (options.buildMeshlets)
+		{
+			std::vector<Meshlet>& meshlets = pAsset->m_OwnedMeshlets;
+			for (MeshLOD& lod : lods)
+			{
+				std::vector<Meshlet> lodMeshlets = Meshlets::BuildMeshlets(vertices, std::span{ indices }.subspan(lod.firstIndex, lod.numIndices));
+				lod.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+				lod.numMeshlets = static_cast<uint32_t>(lodMeshlets.size());
+				for (Meshlet& meshlet : lodMeshlets)
+				{
+					meshlet.firstIndex += lod.firstIndex;
+					if (options.optimize)
+						OptimizeMeshletVertexCache(std::span{ indices }.subspan(meshlet.firstIndex, meshlet.numIndices));
+				}
+				meshlets.insert(meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+			}
+		}
+
+		//Vertex order last, after every pass that moves triangles
+		if (options.optimize)
+			MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		for (const Vertex& vertex : pAsset->m_OwnedVertices)
+			pAsset->m_Bounds.Grow(vertex.position);
+
+		pAsset->m_Vertices = pAsset->m_OwnedVertices;
+		pAsset->m_Indices = pAsset->m_OwnedIndices;
+		pAsset->m_LODs = pAsset->m_OwnedLODs;
+		pAsset->m_Meshlets = pAsset->m_OwnedMeshlets;
+		pAsset->WriteCache(cachePath, sourceHash, optionsHash);
+		return pAsset;
+	}
+
+	std::string MeshAsset::GetCachePath(const std::string& objPath)
+	{
+		return std::filesystem::path{ objPath }.replace_extension(".dmesh").string();
+	}
+
+	bool MeshAsset::TryMapCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash)
+	{
+		auto pMapping = std::make_unique<FileMapping>(cachePath);
+		if (!pMapping->IsValid() || pMapping->GetSize() < sizeof(DMeshHeader))
+			return false;
+
+		DMeshHeader header{};
+		std::memcpy(&header, pMapping->GetData(), sizeof(header));
+
+		const DMeshHeader expected{};
+		if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != g_DMeshVersion ||
+			header.sourceHash != sourceHash || header.optionsHash != optionsHash || header.vertexSize != sizeof(Vertex))
+			return false;
+
+		const size_t lodBytes = size_t(header.numLODs) * sizeof(MeshLOD);
+		const size_t meshletBytes = size_t(header.numMeshlets) * sizeof(Meshlet);
+		const size_t vertexBytes = size_t(header.numVertices) * sizeof(Vertex);
+		const size_t indexBytes = size_t(header.numIndices) * sizeof(uint32_t);
+		if (pMapping->GetSize() != sizeof(DMeshHeader) + lodBytes + meshletBytes + vertexBytes + indexBytes)
+			return false;
+
+		//No per-vertex work: the spans point straight into the mapped file
+		const char* pLODs = pMapping->GetData() + sizeof(DMeshHeader);
+		const char* pMeshlets = pLODs + lodBytes;
+		const char* pVertices = pMeshlets + meshletBytes;
+		m_LODs = { reinterpret_cast<const MeshLOD*>(pLODs), header.numLODs };
+		m_Meshlets = { reinterpret_cast<const Meshlet*>(pMeshlets), header.numMeshlets };
+		m_Vertices = { reinterpret_cast<const Vertex*>(pVertices), header.numVertices };
+		m_Indices = { reinterpret_cast<const uint32_t*>(pVertices + vertexBytes), header.numIndices };
+		m_Bounds = header.bounds;
+		m_pMapping = std::move(pMapping);
+		return true;
+	}
+
+	void MeshAsset::WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash) const
+	{
+		DMeshHeader header{};
+		header.version = g_DMeshVersion;
+		header.sourceHash = sourceHash;
+		header.optionsHash = optionsHash;
+		header.vertexSize = sizeof(Vertex);
+		header.numVertices = static_cast<uint32_t>(m_Vertices.size());
+		header.numIndices = static_cast<uint32_t>(m_Indices.size());
+		header.numLODs = static_cast<uint32_t>(m_LODs.size());
+		header.numMeshlets = static_cast<uint32_t>(m_Meshlets.size());
+		header.bounds = m_Bounds;
+
+		//Write next to it and swap in, so a crash never leaves a half-written cache behind
+		const std::string tempPath = cachePath + ".tmp";
+		bool isWritten{};
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(m_LODs.data()), m_LODs.size_bytes());
+			file.write(reinterpret_cast<const char*>(m_Meshlets.data()), m_Meshlets.size_bytes());
+			file.write(reinterpret_cast<const char*>(m_Vertices.data()), m_Vertices.size_bytes());
+			file.write(reinterpret_cast<const char*>(m_Indices.data()), m_Indices.size_bytes());
+			isWritten = file.good();
+		}
+
+		std::error_code error{};
+		if (isWritten)
+			std::filesystem::rename(tempPath, cachePath, error);
+		if (!isWritten || error)
+			std::filesystem::remove(tempPath, error);
+	}
+}
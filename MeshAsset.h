@@ -0,0 +1,66 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "Datatypes.h"
+#include "ObjParser.h"
+
+namespace dae
+{
+	class FileMapping;
+
+	struct MeshImportOptions
+	{
+		ObjImportOptions obj{};
+		//Vertex cache, overdraw and vertex fetch passes from MeshOptimizer.h
+		bool optimize{ true };
+		//Simplified levels from MeshSimplifier.h appended behind the full mesh in the same index buffer
+		bool generateLODs{ true };
+		//Clusters with culling bounds from Meshlets.h for every LOD, reorders the triangles inside each LOD
+		bool buildMeshlets{ true };
+	};
+
+	//Imported mesh data, either freshly parsed from the OBJ or mapped straight from its .dmesh cache
+	class MeshAsset final
+	{
+	public:
+		~MeshAsset();
+
+		MeshAsset(const MeshAsset&) = delete;
+		MeshAsset(MeshAsset&&) noexcept = delete;
+		MeshAsset& operator=(const MeshAsset&) = delete;
+		MeshAsset& operator=(MeshAsset&&) noexcept = delete;
+
+		//Uses the .dmesh next to the OBJ when it was built from the same file and options, otherwise imports and rewrites it
+		static std::unique_ptr<MeshAsset> Load(const std::string& objPath, const MeshImportOptions& options = {});
+		static std::string GetCachePath(const std::string& objPath);
+
+		std::span<const Vertex> GetVertices() const { return m_Vertices; };
+		//Every LOD back to back, LOD 0 is the full mesh
+		std::span<const uint32_t> GetIndices() const { return m_Indices; };
+		std::span<const MeshLOD> GetLODs() const { return m_LODs; };
+		//Meshlets of every LOD, MeshLOD::firstMeshlet indexes into it
+		std::span<const Meshlet> GetMeshlets() const { return m_Meshlets; };
+		const BoundingBox& GetBounds() const { return m_Bounds; };
+		bool IsFromCache() const { return m_pMapping != nullptr; };
+
+	private:
+		MeshAsset() = default;
+
+		std::unique_ptr<FileMapping> m_pMapping{};
+		std::vector<Vertex> m_OwnedVertices{};
+		std::vector<uint32_t> m_OwnedIndices{};
+		std::vector<MeshLOD> m_OwnedLODs{};
+		std::vector<Meshlet> m_OwnedMeshlets{};
+
+		std::span<const Vertex> m_Vertices{};
+		std::span<const uint32_t> m_Indices{};
+		std::span<const MeshLOD> m_LODs{};
+		std::span<const Meshlet> m_Meshlets{};
+		BoundingBox m_Bounds{};
+
+		bool TryMapCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash);
+		void WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash) const;
+	};
+}
@@ -0,0 +1,457 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include <array>
+#include <numeric>
+
+namespace dae
+{
+	namespace
+	{
+		//Forsyth scoring constants, see "Linear-Speed Vertex Cache Optimisation"
+		constexpr uint32_t g_MaxCacheSize{ 32 };
+		constexpr float g_CacheDecayPower{ 1.5f };
+		constexpr float g_LastTriangleScore{ 0.75f };
+		constexpr float g_ValenceBoostScale{ 2.f };
+		constexpr float g_ValenceBoostPower{ 0.5f };
+
+		//Cache size the overdraw clustering measures its misses with
+		constexpr uint32_t g_ClusterCacheSize{ 16 };
+
+		float CalculateVertexScore(int cachePosition, uint32_t numRemaining)
+		{
+			if (numRemaining == 0)
+				return -1.f;
+
+			float score{};
+			if (cachePosition >= 0)
+			{
+				//The vertices of the last triangle get a fixed score, so the next one doesn't just reuse the same edge
+				if (cachePosition < 3)
+					score = g_LastTriangleScore;
+				else
+					score = powf(1.f - static_cast<float>(cachePosition - 3) / (g_MaxCacheSize - 3), g_CacheDecayPower);
+			}
+
+			//Boost vertices with few triangles left, so they get finished instead of becoming lone stragglers
+			return score + g_ValenceBoostScale * powf(static_cast<float>(numRemaining), -g_ValenceBoostPower);
+		}
+
+		//Vertex -> triangle lists
+		struct Adjacency
+		{
+			std::vector<uint32_t> offsets{};
+			std::vector<uint32_t> counts{};
+			std::vector<uint32_t> triangles{};
+		};
+
+		Adjacency BuildAdjacency(std::span<const uint32_t> indices, size_t numVertices)
+		{
+			Adjacency adjacency{};
+			adjacency.counts.resize(numVertices, 0);
+			adjacency.offsets.resize(numVertices, 0);
+			adjacency.triangles.resize(indices.size());
+
+			for (uint32_t index : indices)
+				++adjacency.counts[index];
+
+			uint32_t offset{};
+			for (size_t i{}; i < numVertices; ++i)
+			{
+				adjacency.offsets[i] = offset;
+				offset += adjacency.counts[i];
+			}
+
+			std::vector<uint32_t> cursors = adjacency.offsets;
+			for (size_t i{}; i < indices.size(); ++i)
+				adjacency.triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+			return adjacency;
+		}
+
+		//FIFO cache simulation based on timestamps, returns the number of misses for one triangle
+		class FifoCache final
+		{
+		public:
+			FifoCache(size_t numVertices, uint32_t cacheSize)
+				: m_Timestamps(numVertices, 0)
+				, m_CacheSize{ cacheSize }
+				, m_Timestamp{ cacheSize + 1 }
+			{
+			}
+
+			uint32_t Update(uint32_t a, uint32_t b, uint32_t c)
+			{
+				return Update(a) + Update(b) + Update(c);
+			}
+
+			void Reset()
+			{
+				m_Timestamp += m_CacheSize + 1;
+			}
+
+		private:
+			std::vector<uint32_t> m_Timestamps;
+			uint32_t m_CacheSize;
+			uint32_t m_Timestamp;
+
+			uint32_t Update(uint32_t vertex)
+			{
+				if (m_Timestamp - m_Timestamps[vertex] <= m_CacheSize)
+					return 0;
+
+				m_Timestamps[vertex] = m_Timestamp++;
+				return 1;
+			}
+		};
+
+		void RasterizeOverdraw(const Vector3& a, const Vector3& b, const Vector3& c, int size, std::vector<float>& depthBuffer, MeshOptimizer::OverdrawStats& stats)
+		{
+			const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (AreEqual(area, 0.f, 1e-12f))
+				return;
+
+			const int minX = std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), 0);
+			const int minY = std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), 0);
+			const int maxX = std::min(static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))), size - 1);
+			const int maxY = std::min(static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))), size - 1);
+
+			const float invArea = 1.f / area;
+			for (int y{ minY }; y <= maxY; ++y)
+			{
+				for (int x{ minX }; x <= maxX; ++x)
+				{
+					const float px = x + 0.5f;
+					const float py = y + 0.5f;
+					const float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * invArea;
+					const float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * invArea;
+					const float w2 = 1.f - w0 - w1;
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+						continue;
+
+					const float depth = w0 * a.z + w1 * b.z + w2 * c.z;
+					float& storedDepth = depthBuffer[static_cast<size_t>(y) * size + x];
+					if (depth < storedDepth)
+					{
+						storedDepth = depth;
+						++stats.numShaded;
+					}
+				}
+			}
+		}
+	}
+
+	namespace MeshOptimizer
+	{
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices)
+		{
+			const size_t numTriangles = indices.size() / 3;
+			if (numTriangles == 0)
+				return;
+
+			Adjacency adjacency = BuildAdjacency(indices, numVertices);
+			std::vector<uint32_t>& numRemaining = adjacency.counts;
+
+			std::vector<int> cachePositions(numVertices, -1);
+			std::vector<float> vertexScores(numVertices);
+			for (size_t v{}; v < numVertices; ++v)
+				vertexScores[v] = CalculateVertexScore(-1, numRemaining[v]);
+
+			std::vector<uint8_t> isEmitted(numTriangles, 0);
+			std::vector<uint32_t> result{};
+			result.reserve(indices.size());
+
+			uint32_t cache[g_MaxCacheSize + 3]{};
+			size_t cacheCount{};
+			int64_t bestTriangle{ -1 };
+			size_t nextCandidate{};
+
+			for (size_t numEmitted{}; numEmitted < numTriangles; ++numEmitted)
+			{
+				if (bestTriangle < 0)
+				{
+					//Nothing in the cache touches a remaining triangle: continue with the next one in input order
+					while (isEmitted[nextCandidate])
+						++nextCandidate;
+					bestTriangle = static_cast<int64_t>(nextCandidate);
+				}
+
+				const size_t triangle = static_cast<size_t>(bestTriangle);
+				const uint32_t* pTriangle = &indices[triangle * 3];
+				isEmitted[triangle] = 1;
+				result.insert(result.end(), pTriangle, pTriangle + 3);
+
+				//Move the triangle's vertices to the front of the LRU cache
+				uint32_t newCache[g_MaxCacheSize + 3]{};
+				size_t newCacheCount{};
+				for (size_t i{}; i < 3; ++i)
+				{
+					if (std::find(newCache, newCache + newCacheCount, pTriangle[i]) == newCache + newCacheCount)
+						newCache[newCacheCount++] = pTriangle[i];
+				}
+				for (size_t i{}; i < cacheCount; ++i)
+				{
+					if (std::find(pTriangle, pTriangle + 3, cache[i]) == pTriangle + 3)
+						newCache[newCacheCount++] = cache[i];
+				}
+
+				//Drop the triangle from the lists of its vertices
+				for (size_t i{}; i < 3; ++i)
+				{
+					const uint32_t vertex = pTriangle[i];
+					uint32_t* pBegin = &adjacency.triangles[adjacency.offsets[vertex]];
+					uint32_t* pEnd = pBegin + numRemaining[vertex];
+					uint32_t* pFound = std::find(pBegin, pEnd, static_cast<uint32_t>(triangle));
+					if (pFound != pEnd)
+					{
+						*pFound = *(pEnd - 1);
+						--numRemaining[vertex];
+					}
+				}
+
+				//Rescore everything that is (or just fell out of) the cache
+				for (size_t i{}; i < newCacheCount; ++i)
+				{
+					const uint32_t vertex = newCache[i];
+					cachePositions[vertex] = i < g_MaxCacheSize ? static_cast<int>(i) : -1;
+					vertexScores[vertex] = CalculateVertexScore(cachePositions[vertex], numRemaining[vertex]);
+				}
+
+				bestTriangle = -1;
+				float bestScore{ -FLT_MAX };
+				for (size_t i{}; i < newCacheCount; ++i)
+				{
+					const uint32_t vertex = newCache[i];
+					const uint32_t* pTriangles = &adjacency.triangles[adjacency.offsets[vertex]];
+					for (uint32_t j{}; j < numRemaining[vertex]; ++j)
+					{
+						const uint32_t other = pTriangles[j];
+						const float score = vertexScores[indices[other * 3]] + vertexScores[indices[other * 3 + 1]] + vertexScores[indices[other * 3 + 2]];
+						if (score > bestScore)
+						{
+							bestScore = score;
+							bestTriangle = other;
+						}
+					}
+				}
+
+				cacheCount = std::min<size_t>(newCacheCount, g_MaxCacheSize);
+				std::copy(newCache, newCache + cacheCount, cache);
+			}
+
+			indices = std::move(result);
+		}
+
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, float threshold)
+		{
+			const size_t numTriangles = indices.size() / 3;
+			if (numTriangles == 0)
+				return;
+
+			//1. Hard boundaries: a triangle that misses the cache with all of its vertices starts a new cluster
+			std::vector<uint32_t> hardClusters{};
+			std::vector<uint8_t> misses(numTriangles);
+			FifoCache cache{ vertices.size(), g_ClusterCacheSize };
+			for (size_t t{}; t < numTriangles; ++t)
+			{
+				misses[t] = static_cast<uint8_t>(cache.Update(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]));
+				if (t == 0 || misses[t] == 3)
+					hardClusters.push_back(static_cast<uint32_t>(t));
+			}
+			hardClusters.push_back(static_cast<uint32_t>(numTriangles));
+
+			//2. Soft boundaries: split further wherever the cluster so far is already as cache efficient as the whole one
+			std::vector<uint32_t> clusters{};
+			for (size_t i{}; i + 1 < hardClusters.size(); ++i)
+			{
+				const uint32_t begin = hardClusters[i];
+				const uint32_t end = hardClusters[i + 1];
+
+				const uint32_t clusterMisses = std::accumulate(misses.begin() + begin, misses.begin() + end, 0u);
+				const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+				cache.Reset();
+				uint32_t start{ begin };
+				uint32_t runningMisses{};
+				clusters.push_back(begin);
+				for (uint32_t t{ begin }; t < end; ++t)
+				{
+					runningMisses += cache.Update(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]);
+					if (t + 1 < end && static_cast<float>(runningMisses) / static_cast<float>(t - start + 1) <= clusterThreshold)
+					{
+						clusters.push_back(t + 1);
+						cache.Reset();
+						start = t + 1;
+						runningMisses = 0;
+					}
+				}
+			}
+			clusters.push_back(static_cast<uint32_t>(numTriangles));
+
+			//3. Sort the clusters on how far they face away from the mesh center, outer ones occlude the inner ones
+			Vector3 meshCenter{};
+			for (const Vertex& vertex : vertices)
+				meshCenter += vertex.position;
+			meshCenter /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+			const auto getFaceNormal = [&](size_t t)
+				{
+					//Clockwise front faces, as rendered by D3D
+					const Vector3& p0 = vertices[indices[t * 3]].position;
+					return Vector3::Cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+				};
+
+			//Double-sided faces (ParseOBJ emits both windings) would cancel out the cluster normal,
+			//so only the twin facing away from the mesh center counts towards it
+			std::vector<std::array<uint32_t, 4>> sortedTriangles(numTriangles);
+			for (size_t t{}; t < numTriangles; ++t)
+			{
+				std::array<uint32_t, 4>& sorted = sortedTriangles[t];
+				sorted = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2], static_cast<uint32_t>(t) };
+				std::sort(sorted.begin(), sorted.begin() + 3);
+			}
+			std::sort(sortedTriangles.begin(), sortedTriangles.end());
+
+			std::vector<uint8_t> isInnerTwin(numTriangles, 0);
+			for (size_t i{ 1 }; i < numTriangles; ++i)
+			{
+				const std::array<uint32_t, 4>& a = sortedTriangles[i - 1];
+				const std::array<uint32_t, 4>& b = sortedTriangles[i];
+				if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2])
+					continue;
+
+				const Vector3& p0 = vertices[a[0]].position;
+				const bool isAOuter = Vector3::Dot(getFaceNormal(a[3]), p0 - meshCenter) >= 0.f;
+				isInnerTwin[isAOuter ? b[3] : a[3]] = 1;
+			}
+
+			const size_t numClusters = clusters.size() - 1;
+			std::vector<float> sortKeys(numClusters);
+			for (size_t i{}; i < numClusters; ++i)
+			{
+				Vector3 center{};
+				Vector3 normal{};
+				float totalArea{};
+				for (uint32_t t{ clusters[i] }; t < clusters[i + 1]; ++t)
+				{
+					if (isInnerTwin[t])
+						continue;
+
+					const Vector3& p0 = vertices[indices[t * 3]].position;
+					const Vector3& p1 = vertices[indices[t * 3 + 1]].position;
+					const Vector3& p2 = vertices[indices[t * 3 + 2]].position;
+
+					const Vector3 areaNormal = getFaceNormal(t);
+					const float area = areaNormal.Magnitude();
+					center += (p0 + p1 + p2) * (area / 3.f);
+					normal += areaNormal;
+					totalArea += area;
+				}
+
+				if (totalArea > 0.f)
+					center /= totalArea;
+				normal.Normalize();
+				sortKeys[i] = Vector3::Dot(center - meshCenter, normal);
+			}
+
+			std::vector<uint32_t> order(numClusters);
+			std::iota(order.begin(), order.end(), 0u);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+			std::vector<uint32_t> result{};
+			result.reserve(indices.size());
+			for (uint32_t cluster : order)
+				result.insert(result.end(), indices.begin() + size_t(clusters[cluster]) * 3, indices.begin() + size_t(clusters[cluster + 1]) * 3);
+
+			indices = std::move(result);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+			std::vector<Vertex> result{};
+			result.reserve(vertices.size());
+
+			for (uint32_t& index : indices)
+			{
+				if (remap[index] == UINT32_MAX)
+				{
+					remap[index] = static_cast<uint32_t>(result.size());
+					result.push_back(vertices[index]);
+				}
+				index = remap[index];
+			}
+
+			vertices = std::move(result);
+		}
+
+		VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t numVertices, uint32_t cacheSize)
+		{
+			VertexCacheStats stats{};
+			FifoCache cache{ numVertices, cacheSize };
+			std::vector<uint8_t> isUsed(numVertices, 0);
+			size_t numUsed{};
+
+			for (size_t i{}; i + 2 < indices.size(); i += 3)
+			{
+				stats.numTransformed += cache.Update(indices[i], indices[i + 1], indices[i + 2]);
+				for (size_t j{}; j < 3; ++j)
+				{
+					numUsed += isUsed[indices[i + j]] == 0;
+					isUsed[indices[i + j]] = 1;
+				}
+			}
+
+			stats.acmr = indices.empty() ? 0.f : static_cast<float>(stats.numTransformed) / (indices.size() / 3);
+			stats.atvr = numUsed == 0 ? 0.f : static_cast<float>(stats.numTransformed) / numUsed;
+			return stats;
+		}
+
+		OverdrawStats AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const Vertex> vertices)
+		{
+			constexpr int viewportSize{ 256 };
+
+			OverdrawStats stats{};
+			BoundingBox bounds{};
+			for (const Vertex& vertex : vertices)
+				bounds.Grow(vertex.position);
+
+			const Vector3 extent = bounds.max - bounds.min;
+			const float scale = (viewportSize - 1) / std::max({ extent.x, extent.y, extent.z, FLT_EPSILON });
+
+			std::vector<float> depthBuffer(viewportSize * viewportSize);
+			for (int axis{}; axis < 3; ++axis)
+			{
+				for (float direction : { 1.f, -1.f })
+				{
+					std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+					//Orthographic view looking along +-axis, screen spanned by the other two
+					const int axisU = (axis + 1) % 3;
+					const int axisV = (axis + 2) % 3;
+					const auto project = [&](const Vector3& p)
+						{
+							return Vector3{ (p[axisU] - bounds.min[axisU]) * scale, (p[axisV] - bounds.min[axisV]) * scale, p[axis] * direction };
+						};
+
+					for (size_t i{}; i + 2 < indices.size(); i += 3)
+					{
+						const Vector3& p0 = vertices[indices[i]].position;
+						const Vector3& p1 = vertices[indices[i + 1]].position;
+						const Vector3& p2 = vertices[indices[i + 2]].position;
+
+						//Back-face culling like the default rasterizer state, the front faces towards the viewer
+						if (Vector3::Cross(p1 - p0, p2 - p0)[axis] * direction >= 0.f)
+							continue;
+
+						RasterizeOverdraw(project(p0), project(p1), project(p2), viewportSize, depthBuffer, stats);
+					}
+
+					stats.numCovered += static_cast<uint32_t>(std::count_if(depthBuffer.begin(), depthBuffer.end(), [](float depth) { return depth != FLT_MAX; }));
+				}
+			}
+
+			stats.overdraw = stats.numCovered == 0 ? 0.f : static_cast<float>(stats.numShaded) / stats.numCovered;
+			return stats;
+		}
+	}
+}
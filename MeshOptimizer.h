@@ -0,0 +1,44 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "Datatypes.h"
+
+namespace dae
+{
+	//Index/vertex reordering passes that run before Mesh creates its buffers
+	namespace MeshOptimizer
+	{
+		//Forsyth-style greedy triangle order for the post-transform vertex cache
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices);
+
+		//Cluster-based overdraw reduction (Sander et al.), clusters are only split where the cache efficiency
+		//stays within threshold of the current order, then sorted so outward-facing clusters draw first
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, std::span<const Vertex> vertices, float threshold = 1.05f);
+
+		//Renumbers vertices in the order the indices first use them and drops unused ones
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		struct VertexCacheStats
+		{
+			uint32_t numTransformed{};
+			//Average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst)
+			float acmr{};
+			//Average transform to vertex ratio: transformed vertices per vertex (1 is ideal)
+			float atvr{};
+		};
+
+		struct OverdrawStats
+		{
+			uint32_t numCovered{};
+			uint32_t numShaded{};
+			//Shaded pixels per covered pixel, 1 means every pixel was shaded once
+			float overdraw{};
+		};
+
+		//Simulates a FIFO post-transform cache of the given size
+		VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t numVertices, uint32_t cacheSize = 16);
+
+		//Rasterizes the mesh from the 6 axis directions with depth test and back-face culling, no GPU needed
+		OverdrawStats AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const Vertex> vertices);
+	}
+}
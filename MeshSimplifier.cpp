@@ -0,0 +1,569 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include <array>
+#include <cassert>
+#include <numeric>
+
+namespace dae
+{
+	namespace
+	{
+		//Borders and seams weigh this much more than the surface, so they only move when nothing else is left
+		constexpr double g_EdgeWeight{ 10.0 };
+		//Collapses per pass stop at this factor over the error of the collapse that would reach the goal
+		constexpr float g_PassErrorFactor{ 1.5f };
+
+		enum class VertexKind : uint8_t
+		{
+			//Interior vertex with one set of attributes, can collapse anywhere
+			Manifold,
+			//On an open edge, only collapses along it
+			Border,
+			//One of two attribute sets at a position on a UV/normal seam, collapses along the seam together with its twin
+			Seam,
+			//Anything more complex (corners, seam junctions, non-manifold), never moves
+			Locked
+		};
+
+		//Symmetric 4x4 quadric plus the total weight, evaluated as the weighted mean squared distance
+		struct Quadric
+		{
+			double a00{}, a11{}, a22{}, a10{}, a20{}, a21{};
+			double b0{}, b1{}, b2{};
+			double c{};
+			double weight{};
+
+			void AddPlane(const Vector3& normal, double distance, double planeWeight)
+			{
+				const double nx{ normal.x }, ny{ normal.y }, nz{ normal.z };
+				a00 += planeWeight * nx * nx;
+				a11 += planeWeight * ny * ny;
+				a22 += planeWeight * nz * nz;
+				a10 += planeWeight * ny * nx;
+				a20 += planeWeight * nz * nx;
+				a21 += planeWeight * nz * ny;
+				b0 += planeWeight * nx * distance;
+				b1 += planeWeight * ny * distance;
+				b2 += planeWeight * nz * distance;
+				c += planeWeight * distance * distance;
+				weight += planeWeight;
+			}
+
+			void Add(const Quadric& other)
+			{
+				a00 += other.a00; a11 += other.a11; a22 += other.a22;
+				a10 += other.a10; a20 += other.a20; a21 += other.a21;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+			}
+
+			float Evaluate(const Vector3& point) const
+			{
+				const double x{ point.x }, y{ point.y }, z{ point.z };
+				const double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z)
+					+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+				return weight > 0.0 ? static_cast<float>(std::abs(error) / weight) : 0.f;
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t from{};
+			uint32_t to{};
+			//Squared distance
+			float error{};
+		};
+
+		uint64_t MakeEdgeKey(uint32_t from, uint32_t to)
+		{
+			return (static_cast<uint64_t>(from) << 32) | to;
+		}
+
+		bool HasEdge(const std::vector<uint64_t>& sortedEdges, uint32_t from, uint32_t to)
+		{
+			return std::binary_search(sortedEdges.begin(), sortedEdges.end(), MakeEdgeKey(from, to));
+		}
+
+		//Maps every vertex to the first vertex with a bitwise identical position
+		std::vector<uint32_t> BuildPositionRemap(std::span<const Vertex> vertices)
+		{
+			std::vector<uint32_t> order(vertices.size());
+			std::iota(order.begin(), order.end(), 0u);
+			const auto less = [&](uint32_t a, uint32_t b)
+				{
+					const Vector3& pa = vertices[a].position;
+					const Vector3& pb = vertices[b].position;
+					if (pa.x != pb.x) return pa.x < pb.x;
+					if (pa.y != pb.y) return pa.y < pb.y;
+					if (pa.z != pb.z) return pa.z < pb.z;
+					return a < b;
+				};
+			std::sort(order.begin(), order.end(), less);
+
+			std::vector<uint32_t> remap(vertices.size());
+			for (size_t i{}; i < order.size(); ++i)
+			{
+				const bool isSame = i > 0 && vertices[order[i]].position.x == vertices[order[i - 1]].position.x &&
+					vertices[order[i]].position.y == vertices[order[i - 1]].position.y && vertices[order[i]].position.z == vertices[order[i - 1]].position.z;
+				remap[order[i]] = isSame ? remap[order[i - 1]] : order[i];
+			}
+			return remap;
+		}
+
+		//Everything derived from the current index buffer, rebuilt every pass
+		struct Topology
+		{
+			std::vector<VertexKind> kinds{};
+			//Next/previous vertex along the open edge of border and seam vertices
+			std::vector<uint32_t> loops{};
+			std::vector<uint32_t> loopBacks{};
+			//Ring of the vertices in use that share a position
+			std::vector<uint32_t> wedges{};
+			//Position -> triangles
+			std::vector<uint32_t> triangleOffsets{};
+			std::vector<uint32_t> triangles{};
+		};
+
+		void BuildTopology(std::span<const uint32_t> indices, std::span<const uint32_t> remap, Topology& topology)
+		{
+			const size_t numVertices = remap.size();
+			std::vector<uint64_t> edges{}, positionEdges{};
+			edges.reserve(indices.size());
+			positionEdges.reserve(indices.size());
+			for (size_t i{}; i < indices.size(); i += 3)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t from = indices[i + corner];
+					const uint32_t to = indices[i + (corner + 1) % 3];
+					edges.push_back(MakeEdgeKey(from, to));
+					positionEdges.push_back(MakeEdgeKey(remap[from], remap[to]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			std::sort(positionEdges.begin(), positionEdges.end());
+
+			//Open edges of every vertex, a second one in either direction makes the count meaningless so it saturates
+			constexpr uint32_t noVertex{ UINT32_MAX };
+			std::vector<uint8_t> numOpenOut(numVertices, 0), numOpenIn(numVertices, 0), isUsed(numVertices, 0);
+			std::vector<uint8_t> hasBorderEdge(numVertices, 0);
+			topology.loops.assign(numVertices, noVertex);
+			topology.loopBacks.assign(numVertices, noVertex);
+			for (size_t i{}; i < indices.size(); i += 3)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t from = indices[i + corner];
+					const uint32_t to = indices[i + (corner + 1) % 3];
+					isUsed[from] = 1;
+					if (HasEdge(edges, to, from))
+						continue;
+
+					numOpenOut[from] = static_cast<uint8_t>(std::min(numOpenOut[from] + 1, 2));
+					numOpenIn[to] = static_cast<uint8_t>(std::min(numOpenIn[to] + 1, 2));
+					topology.loops[from] = to;
+					topology.loopBacks[to] = from;
+
+					//Open in the attribute topology and in the position topology: a real border, not a seam
+					if (!HasEdge(positionEdges, remap[to], remap[from]))
+						hasBorderEdge[from] = hasBorderEdge[to] = 1;
+				}
+			}
+
+			//Wedge rings over the vertices in use, linked in behind the first used vertex of each position
+			std::vector<uint32_t> firstUsed(numVertices, noVertex);
+			topology.wedges.resize(numVertices);
+			std::iota(topology.wedges.begin(), topology.wedges.end(), 0u);
+			for (uint32_t v{}; v < numVertices; ++v)
+			{
+				if (!isUsed[v])
+					continue;
+
+				uint32_t& head = firstUsed[remap[v]];
+				if (head == noVertex)
+				{
+					head = v;
+					continue;
+				}
+				topology.wedges[v] = topology.wedges[head];
+				topology.wedges[head] = v;
+			}
+
+			topology.kinds.assign(numVertices, VertexKind::Locked);
+			for (uint32_t v{}; v < numVertices; ++v)
+			{
+				if (!isUsed[v])
+					continue;
+
+				const uint32_t wedge = topology.wedges[v];
+				if (wedge == v)
+				{
+					if (numOpenOut[v] == 0 && numOpenIn[v] == 0)
+						topology.kinds[v] = VertexKind::Manifold;
+					else if (numOpenOut[v] == 1 && numOpenIn[v] == 1 && hasBorderEdge[v])
+						topology.kinds[v] = VertexKind::Border;
+				}
+				else if (topology.wedges[wedge] == v && !hasBorderEdge[v] && !hasBorderEdge[wedge] &&
+					numOpenOut[v] == 1 && numOpenIn[v] == 1 && numOpenOut[wedge] == 1 && numOpenIn[wedge] == 1)
+				{
+					//Both sides have to run along the same seam, in opposite directions
+					const uint32_t next = topology.loops[v], previous = topology.loopBacks[v];
+					const uint32_t wedgeNext = topology.loops[wedge], wedgePrevious = topology.loopBacks[wedge];
+					if (remap[next] == remap[wedgePrevious] && remap[previous] == remap[wedgeNext])
+						topology.kinds[v] = VertexKind::Seam;
+				}
+			}
+
+			//Position -> triangles
+			topology.triangleOffsets.assign(numVertices + 1, 0);
+			for (uint32_t index : indices)
+				++topology.triangleOffsets[remap[index] + 1];
+			for (size_t v{}; v < numVertices; ++v)
+				topology.triangleOffsets[v + 1] += topology.triangleOffsets[v];
+			topology.triangles.resize(indices.size());
+			std::vector<uint32_t> cursors(topology.triangleOffsets.begin(), topology.triangleOffsets.end() - 1);
+			for (size_t i{}; i < indices.size(); ++i)
+				topology.triangles[cursors[remap[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		bool CanCollapse(const Topology& topology, uint32_t from, uint32_t to)
+		{
+			const VertexKind fromKind = topology.kinds[from];
+			const VertexKind toKind = topology.kinds[to];
+			switch (fromKind)
+			{
+			case VertexKind::Manifold:
+				return true;
+			case VertexKind::Border:
+			case VertexKind::Seam:
+				//Only along the open edge, onto the same kind, so the border/seam keeps its shape
+				return toKind == fromKind && (topology.loops[from] == to || topology.loopBacks[from] == to);
+			default:
+				return false;
+			}
+		}
+
+		//Moving the position of from onto to must not turn any remaining triangle around
+		bool HasTriangleFlip(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const uint32_t> remap,
+			const Topology& topology, uint32_t from, uint32_t to)
+		{
+			const uint32_t fromPosition = remap[from];
+			const uint32_t toPosition = remap[to];
+			const Vector3& target = vertices[to].position;
+			for (uint32_t t{ topology.triangleOffsets[fromPosition] }; t < topology.triangleOffsets[fromPosition + 1]; ++t)
+			{
+				const uint32_t* pTriangle = &indices[topology.triangles[t] * 3];
+				const uint32_t r0 = remap[pTriangle[0]], r1 = remap[pTriangle[1]], r2 = remap[pTriangle[2]];
+				if (r0 == toPosition || r1 == toPosition || r2 == toPosition)
+					continue;
+
+				const Vector3 p0 = vertices[pTriangle[0]].position, p1 = vertices[pTriangle[1]].position, p2 = vertices[pTriangle[2]].position;
+				const Vector3 before = Vector3::Cross(p1 - p0, p2 - p0);
+				const Vector3 q0 = r0 == fromPosition ? target : p0;
+				const Vector3 q1 = r1 == fromPosition ? target : p1;
+				const Vector3 q2 = r2 == fromPosition ? target : p2;
+				const Vector3 after = Vector3::Cross(q1 - q0, q2 - q0);
+				if (Vector3::Dot(before, after) <= 0.f)
+					return true;
+			}
+			return false;
+		}
+
+		//One consistently wound copy of every triangle if each one is present with both windings, otherwise empty
+		std::vector<uint32_t> ExtractSingleSided(std::span<const uint32_t> indices)
+		{
+			const uint32_t numTriangles = static_cast<uint32_t>(indices.size() / 3);
+			if (numTriangles == 0 || numTriangles % 2 != 0)
+				return {};
+
+			//Sorted corners + triangle, equal neighbours after sorting are the two windings
+			std::vector<std::array<uint32_t, 4>> keys(numTriangles);
+			for (uint32_t t{}; t < numTriangles; ++t)
+			{
+				keys[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2], t };
+				std::sort(keys[t].begin(), keys[t].begin() + 3);
+			}
+			std::sort(keys.begin(), keys.end());
+
+			std::vector<uint32_t> uniqueTriangles{};
+			uniqueTriangles.reserve(numTriangles / 2);
+			for (size_t i{}; i < keys.size(); i += 2)
+			{
+				if (!std::equal(keys[i].begin(), keys[i].begin() + 3, keys[i + 1].begin()) ||
+					(i + 2 < keys.size() && std::equal(keys[i].begin(), keys[i].begin() + 3, keys[i + 2].begin())))
+					return {};
+				uniqueTriangles.push_back(keys[i][3]);
+			}
+
+			//Pick the winding of each triangle so neighbours agree, flood filling over shared edges
+			const uint32_t numUnique = static_cast<uint32_t>(uniqueTriangles.size());
+			std::vector<uint64_t> edges{};
+			edges.reserve(numUnique * 3);
+			std::vector<std::array<uint32_t, 3>> corners(numUnique);
+			for (uint32_t u{}; u < numUnique; ++u)
+			{
+				const uint32_t t = uniqueTriangles[u];
+				corners[u] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a = corners[u][corner], b = corners[u][(corner + 1) % 3];
+					edges.push_back(MakeEdgeKey(std::min(a, b), std::max(a, b)));
+				}
+			}
+
+			//Undirected edge -> triangles
+			std::vector<std::pair<uint64_t, uint32_t>> edgeTriangles{};
+			edgeTriangles.reserve(edges.size());
+			for (uint32_t i{}; i < edges.size(); ++i)
+				edgeTriangles.emplace_back(edges[i], i / 3);
+			std::sort(edgeTriangles.begin(), edgeTriangles.end());
+
+			std::vector<uint8_t> isVisited(numUnique, 0), isFlipped(numUnique, 0);
+			std::vector<uint32_t> stack{};
+			const auto hasDirectedEdge = [&](uint32_t u, uint32_t from, uint32_t to)
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						uint32_t a = corners[u][corner], b = corners[u][(corner + 1) % 3];
+						if (isFlipped[u])
+							std::swap(a, b);
+						if (a == from && b == to)
+							return true;
+					}
+					return false;
+				};
+
+			for (uint32_t seed{}; seed < numUnique; ++seed)
+			{
+				if (isVisited[seed])
+					continue;
+				isVisited[seed] = 1;
+				stack.push_back(seed);
+				while (!stack.empty())
+				{
+					const uint32_t u = stack.back();
+					stack.pop_back();
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						uint32_t a = corners[u][corner], b = corners[u][(corner + 1) % 3];
+						if (isFlipped[u])
+							std::swap(a, b);
+
+						const uint64_t key = MakeEdgeKey(std::min(a, b), std::max(a, b));
+						auto it = std::lower_bound(edgeTriangles.begin(), edgeTriangles.end(), std::pair<uint64_t, uint32_t>{ key, 0u });
+						for (; it != edgeTriangles.end() && it->first == key; ++it)
+						{
+							const uint32_t neighbour = it->second;
+							if (isVisited[neighbour])
+								continue;
+							isVisited[neighbour] = 1;
+							//A consistent neighbour runs the shared edge the other way
+							isFlipped[neighbour] = hasDirectedEdge(neighbour, a, b) ? 1 : 0;
+							stack.push_back(neighbour);
+						}
+					}
+				}
+			}
+
+			std::vector<uint32_t> result{};
+			result.reserve(numUnique * 3);
+			for (uint32_t u{}; u < numUnique; ++u)
+			{
+				if (isFlipped[u])
+					result.insert(result.end(), { corners[u][0], corners[u][2], corners[u][1] });
+				else
+					result.insert(result.end(), { corners[u][0], corners[u][1], corners[u][2] });
+			}
+			return result;
+		}
+
+		std::vector<uint32_t> SimplifySingleSided(std::span<const Vertex> vertices, std::span<const uint32_t> sourceIndices, size_t targetIndexCount,
+			float maxError, float& resultError)
+		{
+			const size_t numVertices = vertices.size();
+			const std::vector<uint32_t> remap = BuildPositionRemap(vertices);
+			std::vector<uint32_t> indices(sourceIndices.begin(), sourceIndices.end());
+
+			Topology topology{};
+			BuildTopology(indices, remap, topology);
+
+			//Plane quadrics weighted by area, plus planes through open edges perpendicular to their triangle
+			std::vector<Quadric> quadrics(numVertices);
+			for (size_t i{}; i < indices.size(); i += 3)
+			{
+				const Vector3& p0 = vertices[indices[i]].position;
+				const Vector3& p1 = vertices[indices[i + 1]].position;
+				const Vector3& p2 = vertices[indices[i + 2]].position;
+				const Vector3 cross = Vector3::Cross(p1 - p0, p2 - p0);
+				const float doubleArea = cross.Magnitude();
+				if (doubleArea <= 0.f)
+					continue;
+
+				const Vector3 normal = cross / doubleArea;
+				const double distance = -Vector3::Dot(normal, p0);
+				for (size_t corner{}; corner < 3; ++corner)
+					quadrics[remap[indices[i + corner]]].AddPlane(normal, distance, doubleArea * 0.5);
+
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t from = indices[i + corner];
+					const uint32_t to = indices[i + (corner + 1) % 3];
+					if (topology.loops[from] != to)
+						continue;
+
+					const Vector3 edge = vertices[to].position - vertices[from].position;
+					const float length = edge.Magnitude();
+					if (length <= 0.f)
+						continue;
+
+					const Vector3 edgeNormal = Vector3::Cross(edge / length, normal).Normalized();
+					const double edgeDistance = -Vector3::Dot(edgeNormal, vertices[from].position);
+					const double weight = static_cast<double>(length) * length * g_EdgeWeight;
+					quadrics[remap[from]].AddPlane(edgeNormal, edgeDistance, weight);
+					quadrics[remap[to]].AddPlane(edgeNormal, edgeDistance, weight);
+				}
+			}
+
+			const float maxSquaredError = maxError < FLT_MAX ? maxError * maxError : FLT_MAX;
+			float worstSquaredError{};
+			std::vector<Collapse> collapses{};
+			std::vector<uint32_t> collapseRemap(numVertices);
+			std::vector<uint8_t> isPositionLocked(numVertices);
+
+			while (indices.size() > targetIndexCount)
+			{
+				//Cheapest direction of every collapsible edge
+				collapses.clear();
+				for (size_t i{}; i < indices.size(); i += 3)
+				{
+					for (size_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t v0 = indices[i + corner];
+						const uint32_t v1 = indices[i + (corner + 1) % 3];
+						//Interior edges show up in both triangles, take them once
+						if (topology.kinds[v0] == VertexKind::Manifold && topology.kinds[v1] == VertexKind::Manifold && remap[v0] > remap[v1])
+							continue;
+
+						const bool canForward = CanCollapse(topology, v0, v1);
+						const bool canBackward = CanCollapse(topology, v1, v0);
+						if (!canForward && !canBackward)
+							continue;
+
+						const float forwardError = canForward ? quadrics[remap[v0]].Evaluate(vertices[v1].position) : FLT_MAX;
+						const float backwardError = canBackward ? quadrics[remap[v1]].Evaluate(vertices[v0].position) : FLT_MAX;
+						collapses.push_back(forwardError <= backwardError ? Collapse{ v0, v1, forwardError } : Collapse{ v1, v0, backwardError });
+					}
+				}
+				if (collapses.empty())
+					break;
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+				//Every collapse removes about two triangles, many get skipped because a neighbour already moved this pass
+				const size_t goal = (indices.size() - targetIndexCount) / 3 / 2;
+				const float passErrorLimit = goal < collapses.size() ? collapses[goal].error * g_PassErrorFactor : FLT_MAX;
+
+				std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+				std::fill(isPositionLocked.begin(), isPositionLocked.end(), uint8_t{ 0 });
+				size_t numRemoved{}, numCollapses{};
+				for (const Collapse& collapse : collapses)
+				{
+					if (collapse.error > maxSquaredError || collapse.error > passErrorLimit || numRemoved * 3 >= indices.size() - targetIndexCount)
+						break;
+
+					const uint32_t fromPosition = remap[collapse.from], toPosition = remap[collapse.to];
+					if (isPositionLocked[fromPosition] || isPositionLocked[toPosition])
+						continue;
+					if (HasTriangleFlip(vertices, indices, remap, topology, collapse.from, collapse.to))
+						continue;
+
+					const VertexKind kind = topology.kinds[collapse.from];
+					collapseRemap[collapse.from] = collapse.to;
+					if (kind == VertexKind::Seam)
+					{
+						//The other side of the seam follows along the same edge
+						const uint32_t wedge = topology.wedges[collapse.from];
+						const uint32_t wedgeTarget = topology.loops[collapse.from] == collapse.to ? topology.loopBacks[wedge] : topology.loops[wedge];
+						assert(remap[wedgeTarget] == toPosition);
+						collapseRemap[wedge] = wedgeTarget;
+					}
+
+					quadrics[toPosition].Add(quadrics[fromPosition]);
+					isPositionLocked[fromPosition] = isPositionLocked[toPosition] = 1;
+					numRemoved += kind == VertexKind::Border ? 1 : 2;
+					++numCollapses;
+					worstSquaredError = std::max(worstSquaredError, collapse.error);
+				}
+				if (numCollapses == 0)
+					break;
+
+				//Apply and drop the triangles that became degenerate
+				size_t numKept{};
+				for (size_t i{}; i < indices.size(); i += 3)
+				{
+					const uint32_t a = collapseRemap[indices[i]], b = collapseRemap[indices[i + 1]], c = collapseRemap[indices[i + 2]];
+					if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+						continue;
+					indices[numKept++] = a;
+					indices[numKept++] = b;
+					indices[numKept++] = c;
+				}
+				indices.resize(numKept);
+
+				BuildTopology(indices, remap, topology);
+			}
+
+			resultError = std::sqrt(worstSquaredError);
+			return indices;
+		}
+	}
+
+	namespace MeshSimplifier
+	{
+		std::vector<uint32_t> Simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount,
+			float maxError, float* pResultError)
+		{
+			//Drop the flipped copies of double-sided triangles, they would make every edge look closed
+			const std::vector<uint32_t> singleSided = ExtractSingleSided(indices);
+
+			float resultError{};
+			std::vector<uint32_t> result{};
+			if (singleSided.empty())
+			{
+				result = SimplifySingleSided(vertices, indices, targetIndexCount, maxError, resultError);
+			}
+			else
+			{
+				const std::vector<uint32_t> simplified = SimplifySingleSided(vertices, singleSided, targetIndexCount / 2, maxError, resultError);
+				result.reserve(simplified.size() * 2);
+				for (size_t i{}; i < simplified.size(); i += 3)
+					result.insert(result.end(), { simplified[i], simplified[i + 1], simplified[i + 2], simplified[i], simplified[i + 2], simplified[i + 1] });
+			}
+
+			if (pResultError)
+				*pResultError = resultError;
+			return result;
+		}
+
+		std::vector<MeshLOD> BuildLODChain(std::span<const Vertex> vertices, std::vector<uint32_t>& indices, std::span<const float> ratios)
+		{
+			std::vector<MeshLOD> lods{ MeshLOD{ 0, static_cast<uint32_t>(indices.size()), 0.f } };
+			const size_t numSourceIndices = indices.size();
+
+			//Every level starts from LOD 0, so the quadrics and the error are relative to the original surface
+			for (float ratio : ratios)
+			{
+				const size_t targetIndexCount = static_cast<size_t>(numSourceIndices / 3 * ratio) * 3;
+				float error{};
+				const std::vector<uint32_t> lodIndices = Simplify(vertices, std::span<const uint32_t>{ indices.data(), numSourceIndices }, targetIndexCount, FLT_MAX, &error);
+				if (lodIndices.empty() || lodIndices.size() >= lods.back().numIndices)
+					continue;
+
+				lods.push_back(MeshLOD{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), std::max(error, lods.back().error) });
+				indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+			}
+			return lods;
+		}
+	}
+}
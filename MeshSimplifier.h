@@ -0,0 +1,22 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "Datatypes.h"
+
+namespace dae
+{
+	//Quadric error metric simplification (Garland & Heckbert) by collapsing edges onto existing vertices,
+	//so every level indexes the same vertex buffer
+	namespace MeshSimplifier
+	{
+		//Collapses edges until at most targetIndexCount indices are left or the next collapse would move the surface
+		//further than maxError (object space). UV and normal seams only collapse along themselves, borders likewise.
+		//Double-sided meshes (every triangle also present with flipped winding) are simplified one side at a time.
+		std::vector<uint32_t> Simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount,
+			float maxError = FLT_MAX, float* pResultError = nullptr);
+
+		//Appends a level per ratio (fraction of the LOD 0 triangles) behind the LOD 0 indices.
+		//Levels the simplifier can't make smaller than the previous one are left out.
+		std::vector<MeshLOD> BuildLODChain(std::span<const Vertex> vertices, std::vector<uint32_t>& indices, std::span<const float> ratios);
+	}
+}
@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+namespace dae
+{
+	namespace
+	{
+		//Triangles whose normal is further than this from the cluster's average start a new cluster (about 78 degrees)
+		constexpr float g_MinNormalDot{ 0.2f };
+		//Extra vertices a triangle may cost before a better aligned one is preferred
+		constexpr float g_ConeWeight{ 1.f };
+		constexpr float g_LiveWeight{ 0.01f };
+		//Cones wider than this (dot below it) are never tested, the cluster practically always has a front face
+		constexpr float g_MinConeDot{ 0.1f };
+
+		void ComputeBounds(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const Vector3> normals, Meshlet& meshlet)
+		{
+			BoundingBox bounds{};
+			for (uint32_t i{ meshlet.firstIndex }; i < meshlet.firstIndex + meshlet.numIndices; ++i)
+				bounds.Grow(vertices[indices[i]].position);
+
+			meshlet.center = (bounds.min + bounds.max) * 0.5f;
+			float radiusSquared{};
+			for (uint32_t i{ meshlet.firstIndex }; i < meshlet.firstIndex + meshlet.numIndices; ++i)
+				radiusSquared = std::max(radiusSquared, (vertices[indices[i]].position - meshlet.center).SqrMagnitude());
+			meshlet.radius = std::sqrt(radiusSquared);
+
+			Vector3 normalSum{};
+			for (uint32_t t{ meshlet.firstIndex / 3 }; t < (meshlet.firstIndex + meshlet.numIndices) / 3; ++t)
+				normalSum += normals[t];
+
+			meshlet.coneCutoff = 1.f;
+			const float length = normalSum.Magnitude();
+			if (length <= 0.f)
+				return;
+
+			meshlet.coneAxis = normalSum / length;
+			float minDot{ 1.f };
+			for (uint32_t t{ meshlet.firstIndex / 3 }; t < (meshlet.firstIndex + meshlet.numIndices) / 3; ++t)
+			{
+				if (normals[t].SqrMagnitude() > 0.f)
+					minDot = std::min(minDot, Vector3::Dot(normals[t], meshlet.coneAxis));
+			}
+
+			//The cone holds every normal, so its half angle is acos(minDot) and the test uses sin(acos(minDot))
+			if (minDot > g_MinConeDot)
+				meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		}
+	}
+
+	namespace Meshlets
+	{
+		std::vector<Meshlet> BuildMeshlets(std::span<const Vertex> vertices, std::span<uint32_t> indices, uint32_t maxVertices, uint32_t maxTriangles)
+		{
+			const uint32_t numTriangles = static_cast<uint32_t>(indices.size() / 3);
+			std::vector<Meshlet> meshlets{};
+			if (numTriangles == 0)
+				return meshlets;
+
+			//Unit front face normals, zero for degenerate triangles
+			std::vector<Vector3> normals(numTriangles);
+			for (uint32_t t{}; t < numTriangles; ++t)
+			{
+				const Vector3& p0 = vertices[indices[t * 3]].position;
+				const Vector3 cross = Vector3::Cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+				const float length = cross.Magnitude();
+				normals[t] = length > 0.f ? cross / length : Vector3{};
+			}
+
+			//Vertex -> triangles
+			const size_t numVertices = vertices.size();
+			std::vector<uint32_t> offsets(numVertices + 1, 0);
+			for (uint32_t index : indices)
+				++offsets[index + 1];
+			for (size_t v{}; v < numVertices; ++v)
+				offsets[v + 1] += offsets[v];
+			std::vector<uint32_t> adjacency(indices.size());
+			{
+				std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+				for (uint32_t i{}; i < indices.size(); ++i)
+					adjacency[cursors[indices[i]]++] = i / 3;
+			}
+
+			//Triangles per vertex that still have to be emitted, vertices running out of them are finished first
+			std::vector<uint32_t> liveCounts(numVertices);
+			for (size_t v{}; v < numVertices; ++v)
+				liveCounts[v] = offsets[v + 1] - offsets[v];
+
+			std::vector<uint8_t> isEmitted(numTriangles, 0);
+			std::vector<uint32_t> vertexStamps(numVertices, UINT32_MAX);
+			std::vector<uint32_t> meshletVertices{}, meshletTriangles{}, order{};
+			meshletVertices.reserve(maxVertices);
+			order.reserve(numTriangles);
+
+			uint32_t nextSeed{};
+			while (order.size() < numTriangles)
+			{
+				const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+				Vector3 normalSum{};
+
+				const auto addTriangle = [&](uint32_t t)
+					{
+						isEmitted[t] = 1;
+						meshletTriangles.push_back(t);
+						normalSum += normals[t];
+						for (uint32_t corner{}; corner < 3; ++corner)
+						{
+							const uint32_t vertex = indices[t * 3 + corner];
+							--liveCounts[vertex];
+							if (vertexStamps[vertex] != meshletId)
+							{
+								vertexStamps[vertex] = meshletId;
+								meshletVertices.push_back(vertex);
+							}
+						}
+					};
+
+				//Seed next to the previous meshlet where the fewest triangles are left, so no islands stay behind,
+				//otherwise with the first triangle left in input order so the meshlets roughly follow the optimized order
+				uint32_t seed{ UINT32_MAX };
+				uint32_t seedLive{ UINT32_MAX };
+				for (uint32_t vertex : meshletVertices)
+				{
+					for (uint32_t a{ offsets[vertex] }; a < offsets[vertex + 1]; ++a)
+					{
+						const uint32_t t = adjacency[a];
+						if (isEmitted[t])
+							continue;
+
+						const uint32_t live = liveCounts[indices[t * 3]] + liveCounts[indices[t * 3 + 1]] + liveCounts[indices[t * 3 + 2]];
+						if (live < seedLive)
+						{
+							seedLive = live;
+							seed = t;
+						}
+					}
+				}
+				if (seed == UINT32_MAX)
+				{
+					while (isEmitted[nextSeed])
+						++nextSeed;
+					seed = nextSeed;
+				}
+
+				meshletVertices.clear();
+				meshletTriangles.clear();
+				addTriangle(seed);
+
+				while (meshletTriangles.size() < maxTriangles)
+				{
+					const float normalLength = normalSum.Magnitude();
+					const Vector3 axis = normalLength > 0.f ? normalSum / normalLength : Vector3{};
+
+					//Cheapest unemitted triangle touching the meshlet: few new vertices, normal close to the axis
+					uint32_t bestTriangle{ UINT32_MAX };
+					float bestScore{ FLT_MAX };
+					for (uint32_t vertex : meshletVertices)
+					{
+						for (uint32_t a{ offsets[vertex] }; a < offsets[vertex + 1]; ++a)
+						{
+							const uint32_t t = adjacency[a];
+							if (isEmitted[t])
+								continue;
+
+							uint32_t numNew{};
+							for (uint32_t corner{}; corner < 3; ++corner)
+								numNew += vertexStamps[indices[t * 3 + corner]] != meshletId;
+							if (meshletVertices.size() + numNew > maxVertices)
+								continue;
+
+							const bool isDegenerate = normals[t].SqrMagnitude() == 0.f || normalLength == 0.f;
+							const float normalDot = isDegenerate ? 1.f : Vector3::Dot(normals[t], axis);
+							if (normalDot < g_MinNormalDot)
+								continue;
+
+							//Ties go to the triangle whose vertices have the fewest triangles left
+							const uint32_t live = liveCounts[indices[t * 3]] + liveCounts[indices[t * 3 + 1]] + liveCounts[indices[t * 3 + 2]];
+							const float score = numNew + (1.f - normalDot) * g_ConeWeight + live * g_LiveWeight;
+							if (score < bestScore)
+							{
+								bestScore = score;
+								bestTriangle = t;
+							}
+						}
+					}
+
+					if (bestTriangle == UINT32_MAX)
+						break;
+					addTriangle(bestTriangle);
+				}
+
+				Meshlet meshlet{};
+				meshlet.firstIndex = static_cast<uint32_t>(order.size() * 3);
+				meshlet.numIndices = static_cast<uint32_t>(meshletTriangles.size() * 3);
+				meshlets.push_back(meshlet);
+				order.insert(order.end(), meshletTriangles.begin(), meshletTriangles.end());
+			}
+
+			//Reorder the triangles (and their normals) into meshlet order
+			std::vector<uint32_t> reordered(indices.size());
+			std::vector<Vector3> reorderedNormals(numTriangles);
+			for (uint32_t i{}; i < numTriangles; ++i)
+			{
+				std::copy_n(&indices[order[i] * 3], 3, &reordered[i * 3]);
+				reorderedNormals[i] = normals[order[i]];
+			}
+			std::copy(reordered.begin(), reordered.end(), indices.begin());
+
+			for (Meshlet& meshlet : meshlets)
+				ComputeBounds(vertices, indices, reorderedNormals, meshlet);
+			return meshlets;
+		}
+
+		CullStats CullMeshlets(std::span<const Meshlet> meshlets, const Matrix& worldView, const ViewFrustum& frustum, std::vector<IndexInterval>& visible)
+		{
+			CullStats stats{};
+			stats.numMeshlets = static_cast<uint32_t>(meshlets.size());
+
+			//Side planes through the view space origin, normalized so the distance compares directly with the radius
+			const float tanX = frustum.fov * frustum.aspectRatio;
+			const float tanY = frustum.fov;
+			const float invLengthX = 1.f / std::sqrt(1.f + tanX * tanX);
+			const float invLengthY = 1.f / std::sqrt(1.f + tanY * tanY);
+
+			const size_t firstVisible = visible.size();
+			for (const Meshlet& meshlet : meshlets)
+			{
+				//Camera at the origin looking down +z
+				const Vector3 center = worldView.TransformPoint(meshlet.center);
+				const float radius = meshlet.radius;
+
+				const bool isOutside = center.z + radius < frustum.nearPlane || center.z - radius > frustum.farPlane ||
+					(std::abs(center.x) - tanX * center.z) * invLengthX > radius ||
+					(std::abs(center.y) - tanY * center.z) * invLengthY > radius;
+				if (isOutside)
+				{
+					++stats.numFrustumCulled;
+					continue;
+				}
+
+				//Every triangle faces away if the camera is inside the cone's negative side, widened by the sphere
+				if (meshlet.coneCutoff < 1.f)
+				{
+					const Vector3 axis = worldView.TransformVector(meshlet.coneAxis);
+					if (Vector3::Dot(center, axis) >= meshlet.coneCutoff * center.Magnitude() + radius)
+					{
+						++stats.numBackFaceCulled;
+						continue;
+					}
+				}
+
+				stats.numVisibleIndices += meshlet.numIndices;
+				if (visible.size() > firstVisible && visible.back().firstIndex + visible.back().numIndices == meshlet.firstIndex)
+					visible.back().numIndices += meshlet.numIndices;
+				else
+					visible.push_back(IndexInterval{ meshlet.firstIndex, meshlet.numIndices });
+			}
+			return stats;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "Datatypes.h"
+
+namespace dae
+{
+	//Clusters of triangles with bounding spheres and normal cones, culled on the CPU before drawing
+	namespace Meshlets
+	{
+		constexpr uint32_t g_MaxVertices{ 64 };
+		constexpr uint32_t g_MaxTriangles{ 124 };
+
+		struct IndexInterval
+		{
+			uint32_t firstIndex{};
+			uint32_t numIndices{};
+		};
+
+		//View volume of Camera, fov is tan(fovAngle / 2) like Camera::fov
+		struct ViewFrustum
+		{
+			float fov{};
+			float aspectRatio{};
+			float nearPlane{};
+			float farPlane{};
+		};
+
+		struct CullStats
+		{
+			uint32_t numMeshlets{};
+			uint32_t numFrustumCulled{};
+			uint32_t numBackFaceCulled{};
+			uint32_t numVisibleIndices{};
+		};
+
+		//Grows clusters over shared vertices and reorders the triangles so every meshlet is contiguous. Triangles
+		//facing away from a cluster start a new one, which keeps the two sides of double-sided faces apart.
+		//firstIndex of the returned meshlets is relative to the start of indices.
+		std::vector<Meshlet> BuildMeshlets(std::span<const Vertex> vertices, std::span<uint32_t> indices,
+			uint32_t maxVertices = g_MaxVertices, uint32_t maxTriangles = g_MaxTriangles);
+
+		//Drops meshlets outside the frustum or facing away from the camera. worldView is world * Camera::GetInverseViewMatrix().
+		//The index intervals of the remaining meshlets are appended, neighbours merged into one interval.
+		CullStats CullMeshlets(std::span<const Meshlet> meshlets, const Matrix& worldView, const ViewFrustum& frustum, std::vector<IndexInterval>& visible);
+	}
+}
@@ -0,0 +1,351 @@
+#include "pch.h"
+#include "MipMaps.h"
+#include "ThreadPool.h"
+#include <immintrin.h>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr float g_KaiserWidth{ 3.f };
+		constexpr float g_KaiserAlpha{ 4.f };
+		constexpr float g_LanczosWidth{ 3.f };
+		//Below this a weight doesn't change an 8-bit result and the tap is dropped
+		constexpr float g_MinWeight{ 1e-5f };
+		constexpr size_t g_MinRowsPerBatch{ 8 };
+
+		//Linear -> sRGB table, fine enough that even the steps near black round like the exact curve
+		constexpr uint32_t g_EncodeTableSize{ 16384 };
+
+		struct GammaTables
+		{
+			float toLinear[256]{};
+			uint8_t toSRGB[g_EncodeTableSize]{};
+		};
+
+		const GammaTables& GetGammaTables()
+		{
+			static const GammaTables tables = []()
+				{
+					GammaTables result{};
+					for (uint32_t i{}; i < 256; ++i)
+					{
+						const float srgb = i / 255.f;
+						result.toLinear[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+					}
+					for (uint32_t i{}; i < g_EncodeTableSize; ++i)
+					{
+						const float linear = i / float(g_EncodeTableSize - 1);
+						const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.f / 2.4f) - 0.055f;
+						result.toSRGB[i] = static_cast<uint8_t>(srgb * 255.f + 0.5f);
+					}
+					return result;
+				}();
+			return tables;
+		}
+
+		uint8_t ToUnorm8(float value)
+		{
+			return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+		}
+
+		float Sinc(float x)
+		{
+			if (std::abs(x) < 1e-5f)
+				return 1.f;
+			x *= PI;
+			return std::sin(x) / x;
+		}
+
+		//Modified Bessel function of the first kind, order 0, by its power series
+		float BesselI0(float x)
+		{
+			float sum{ 1.f }, term{ 1.f };
+			for (int k{ 1 }; term > sum * 1e-8f; ++k)
+			{
+				const float factor = x / (2.f * k);
+				term *= factor * factor;
+				sum += term;
+			}
+			return sum;
+		}
+
+		//x in destination texels from the center of the destination texel
+		float EvaluateFilter(MipFilter filter, float x)
+		{
+			switch (filter)
+			{
+			case MipFilter::Kaiser:
+			{
+				if (std::abs(x) >= g_KaiserWidth)
+					return 0.f;
+				const float t = x / g_KaiserWidth;
+				return Sinc(x) * BesselI0(g_KaiserAlpha * std::sqrt(1.f - t * t)) / BesselI0(g_KaiserAlpha);
+			}
+			case MipFilter::Lanczos:
+				return std::abs(x) < g_LanczosWidth ? Sinc(x) * Sinc(x / g_LanczosWidth) : 0.f;
+			default:
+				return 0.f;
+			}
+		}
+
+		//Destination texel i reads source texels indices[i * numTaps + k] with weights[i * numTaps + k], padded with zero weights
+		struct FilterTaps
+		{
+			uint32_t numTaps{};
+			std::vector<uint32_t> indices{};
+			std::vector<float> weights{};
+		};
+
+		FilterTaps BuildTaps(MipFilter filter, uint32_t srcSize, uint32_t dstSize)
+		{
+			const float scale = float(srcSize) / dstSize;
+			const float radius = scale * (filter == MipFilter::Box ? 0.5f : filter == MipFilter::Kaiser ? g_KaiserWidth : g_LanczosWidth);
+
+			//Texel j covers [j, j + 1) in source coordinates
+			std::vector<std::vector<std::pair<uint32_t, float>>> texelTaps(dstSize);
+			uint32_t numTaps{};
+			for (uint32_t i{}; i < dstSize; ++i)
+			{
+				const float center = (i + 0.5f) * scale;
+				const int first = static_cast<int>(std::floor(center - radius));
+				const int last = static_cast<int>(std::ceil(center + radius));
+
+				float sum{};
+				std::vector<std::pair<uint32_t, float>>& taps = texelTaps[i];
+				for (int j{ first }; j <= last; ++j)
+				{
+					float weight{};
+					if (filter == MipFilter::Box)
+						weight = std::max(0.f, std::min(j + 1.f, (i + 1) * scale) - std::max(float(j), i * scale));
+					else
+						weight = EvaluateFilter(filter, (j + 0.5f - center) / scale);
+					if (std::abs(weight) < g_MinWeight)
+						continue;
+
+					//Wrap like the samplers do
+					const int wrapped = ((j % int(srcSize)) + int(srcSize)) % int(srcSize);
+					taps.emplace_back(static_cast<uint32_t>(wrapped), weight);
+					sum += weight;
+				}
+
+				for (auto& tap : taps)
+					tap.second /= sum;
+				numTaps = std::max(numTaps, static_cast<uint32_t>(taps.size()));
+			}
+
+			FilterTaps result{};
+			result.numTaps = numTaps;
+			result.indices.resize(size_t(dstSize) * numTaps);
+			result.weights.resize(size_t(dstSize) * numTaps, 0.f);
+			for (uint32_t i{}; i < dstSize; ++i)
+			{
+				for (uint32_t k{}; k < numTaps; ++k)
+				{
+					const bool isPadding = k >= texelTaps[i].size();
+					result.indices[i * numTaps + k] = texelTaps[i][isPadding ? 0 : k].first;
+					result.weights[i * numTaps + k] = isPadding ? 0.f : texelTaps[i][k].second;
+				}
+			}
+			return result;
+		}
+
+		void ForEachRow(ThreadPool* pThreadPool, uint32_t numRows, const std::function<void(size_t begin, size_t end)>& function)
+		{
+			if (pThreadPool)
+				pThreadPool->ParallelFor(numRows, function, g_MinRowsPerBatch);
+			else
+				function(0, numRows);
+		}
+
+		//One RGBA8 row to RGBA floats, in linear space for colors
+		void DecodeRow(const uint8_t* pRow, uint32_t width, MipContent content, float* pOut)
+		{
+			if (content == MipContent::Color)
+			{
+				const GammaTables& tables = GetGammaTables();
+				for (uint32_t x{}; x < width * 4; x += 4)
+				{
+					pOut[x] = tables.toLinear[pRow[x]];
+					pOut[x + 1] = tables.toLinear[pRow[x + 1]];
+					pOut[x + 2] = tables.toLinear[pRow[x + 2]];
+					pOut[x + 3] = pRow[x + 3] / 255.f;
+				}
+				return;
+			}
+
+			const __m128 scale = _mm_set1_ps(1.f / 255.f);
+			for (uint32_t x{}; x < width * 4; x += 4)
+			{
+				int32_t texel{};
+				std::memcpy(&texel, pRow + x, sizeof(texel));
+				const __m128i bytes = _mm_cvtsi32_si128(texel);
+				const __m128i words = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+				_mm_storeu_ps(pOut + x, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128())), scale));
+			}
+		}
+
+		//Horizontal pass over one row: every RGBA texel is one SSE register, summed over the taps
+		void FilterRow(const float* pRow, float* pOut, uint32_t dstWidth, const FilterTaps& taps)
+		{
+			for (uint32_t x{}; x < dstWidth; ++x)
+			{
+				const uint32_t* pIndices = &taps.indices[size_t(x) * taps.numTaps];
+				const float* pWeights = &taps.weights[size_t(x) * taps.numTaps];
+
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t k{}; k < taps.numTaps; ++k)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[k]), _mm_loadu_ps(pRow + pIndices[k] * 4)));
+				_mm_storeu_ps(pOut + x * 4, sum);
+			}
+		}
+
+		//Vertical pass: the weighted sum of whole source rows, two texels per step
+		void FilterColumns(const float* pSrc, uint32_t width, float* pDst, const FilterTaps& taps, size_t rowBegin, size_t rowEnd)
+		{
+			const size_t numFloats = size_t(width) * 4;
+			std::vector<const float*> rows(taps.numTaps);
+			for (size_t y{ rowBegin }; y < rowEnd; ++y)
+			{
+				const uint32_t* pIndices = &taps.indices[y * taps.numTaps];
+				const float* pWeights = &taps.weights[y * taps.numTaps];
+				for (uint32_t k{}; k < taps.numTaps; ++k)
+					rows[k] = pSrc + pIndices[k] * numFloats;
+
+				float* pOut = pDst + y * numFloats;
+				size_t i{};
+				for (; i + 8 <= numFloats; i += 8)
+				{
+					__m128 sum0 = _mm_setzero_ps();
+					__m128 sum1 = _mm_setzero_ps();
+					for (uint32_t k{}; k < taps.numTaps; ++k)
+					{
+						const __m128 weight = _mm_set1_ps(pWeights[k]);
+						sum0 = _mm_add_ps(sum0, _mm_mul_ps(weight, _mm_loadu_ps(rows[k] + i)));
+						sum1 = _mm_add_ps(sum1, _mm_mul_ps(weight, _mm_loadu_ps(rows[k] + i + 4)));
+					}
+					_mm_storeu_ps(pOut + i, sum0);
+					_mm_storeu_ps(pOut + i + 4, sum1);
+				}
+				for (; i < numFloats; i += 4)
+				{
+					__m128 sum = _mm_setzero_ps();
+					for (uint32_t k{}; k < taps.numTaps; ++k)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[k]), _mm_loadu_ps(rows[k] + i)));
+					_mm_storeu_ps(pOut + i, sum);
+				}
+			}
+		}
+
+		//RGBA floats back to RGBA8: sRGB encoded colors, renormalized normals
+		void EncodeRows(const float* pSrc, uint32_t width, MipContent content, uint8_t* pDst, size_t rowBegin, size_t rowEnd)
+		{
+			const GammaTables& tables = GetGammaTables();
+			for (size_t y{ rowBegin }; y < rowEnd; ++y)
+			{
+				const float* pRow = pSrc + y * width * 4;
+				uint8_t* pOut = pDst + y * width * 4;
+				for (uint32_t x{}; x < width; ++x)
+				{
+					const float* pTexel = pRow + x * 4;
+					uint8_t* pOutTexel = pOut + x * 4;
+					switch (content)
+					{
+					case MipContent::Color:
+						for (int c{}; c < 3; ++c)
+							pOutTexel[c] = tables.toSRGB[static_cast<uint32_t>(std::clamp(pTexel[c], 0.f, 1.f) * (g_EncodeTableSize - 1) + 0.5f)];
+						pOutTexel[3] = ToUnorm8(pTexel[3]);
+						break;
+					case MipContent::Normal:
+					{
+						Vector3 normal{ pTexel[0] * 2.f - 1.f, pTexel[1] * 2.f - 1.f, pTexel[2] * 2.f - 1.f };
+						const float length = normal.Magnitude();
+						normal = length > 1e-6f ? normal / length : Vector3{ 0.f, 0.f, 1.f };
+						for (int c{}; c < 3; ++c)
+							pOutTexel[c] = ToUnorm8(normal[c] * 0.5f + 0.5f);
+						pOutTexel[3] = ToUnorm8(pTexel[3]);
+						break;
+					}
+					default:
+						for (int c{}; c < 4; ++c)
+							pOutTexel[c] = ToUnorm8(pTexel[c]);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	namespace MipMaps
+	{
+		uint32_t GetNumLevels(uint32_t width, uint32_t height)
+		{
+			uint32_t numLevels{ 1 };
+			while (width > 1 || height > 1)
+			{
+				width = std::max(1u, width / 2);
+				height = std::max(1u, height / 2);
+				++numLevels;
+			}
+			return numLevels;
+		}
+
+		MipChain GenerateMipChain(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const MipOptions& options)
+		{
+			MipChain chain{};
+			if (width == 0 || height == 0)
+				return chain;
+
+			size_t size{};
+			for (uint32_t level{}, w{ width }, h{ height }; level < GetNumLevels(width, height); ++level, w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+			{
+				chain.levels.push_back(MipLevel{ size, w, h });
+				size += size_t(w) * h * 4;
+			}
+			chain.pixels.resize(size);
+
+			for (uint32_t y{}; y < height; ++y)
+				std::memcpy(&chain.pixels[size_t(y) * width * 4], pPixels + size_t(y) * pitch, size_t(width) * 4);
+
+			//Every level is filtered from the unrounded floats of the one before, so errors don't pile up.
+			//Level 0 is decoded a row at a time as it is filtered, it never exists as floats as a whole.
+			std::vector<float> current{}, filteredRows{}, next{};
+			for (size_t level{ 1 }; level < chain.levels.size(); ++level)
+			{
+				const MipLevel& source = chain.levels[level - 1];
+				const MipLevel& destination = chain.levels[level];
+
+				const FilterTaps horizontalTaps = BuildTaps(options.filter, source.width, destination.width);
+				filteredRows.resize(size_t(destination.width) * source.height * 4);
+				ForEachRow(options.pThreadPool, source.height, [&](size_t begin, size_t end)
+					{
+						std::vector<float> decodedRow(level == 1 ? size_t(width) * 4 : 0);
+						for (size_t y{ begin }; y < end; ++y)
+						{
+							const float* pRow = current.data() + y * source.width * 4;
+							if (level == 1)
+							{
+								DecodeRow(pPixels + y * pitch, width, options.content, decodedRow.data());
+								pRow = decodedRow.data();
+							}
+							FilterRow(pRow, filteredRows.data() + y * destination.width * 4, destination.width, horizontalTaps);
+						}
+					});
+
+				const FilterTaps verticalTaps = BuildTaps(options.filter, source.height, destination.height);
+				next.resize(size_t(destination.width) * destination.height * 4);
+				ForEachRow(options.pThreadPool, destination.height, [&](size_t begin, size_t end)
+					{
+						FilterColumns(filteredRows.data(), destination.width, next.data(), verticalTaps, begin, end);
+						EncodeRows(next.data(), destination.width, options.content, &chain.pixels[destination.offset], begin, end);
+					});
+
+				std::swap(current, next);
+			}
+			return chain;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool;
+
+	enum class MipFilter
+	{
+		//Average of the texels under the smaller texel, cheapest and softest
+		Box,
+		//Kaiser windowed sinc (width 3, alpha 4), sharper with little ringing
+		Kaiser,
+		//Lanczos3, the sharpest but rings the most on hard edges
+		Lanczos
+	};
+
+	//How the texels are averaged
+	enum class MipContent
+	{
+		//sRGB colors, filtered in linear space so the smaller levels don't darken; alpha stays linear
+		Color,
+		//Plain values like masks and glossiness
+		Data,
+		//Tangent space normals stored as 0.5 * n + 0.5, renormalized after filtering
+		Normal
+	};
+
+	struct MipOptions
+	{
+		MipFilter filter{ MipFilter::Kaiser };
+		MipContent content{ MipContent::Color };
+		//Filters batches of rows in parallel when set
+		ThreadPool* pThreadPool{};
+	};
+
+	struct MipLevel
+	{
+		size_t offset{};
+		uint32_t width{};
+		uint32_t height{};
+	};
+
+	//RGBA8 levels back to back, every row tightly packed (pitch is width * 4)
+	struct MipChain
+	{
+		std::vector<uint8_t> pixels{};
+		std::vector<MipLevel> levels{};
+	};
+
+	namespace MipMaps
+	{
+		//Down to 1x1, every level is half the size of the previous one rounded down
+		uint32_t GetNumLevels(uint32_t width, uint32_t height);
+
+		//Every level from the RGBA8 image (level 0 copied as is), each one filtered from the one before it with wrapping
+		//addressing like the samplers in PosCol3D.fx
+		MipChain GenerateMipChain(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const MipOptions& options = {});
+	}
+}
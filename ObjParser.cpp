@@ -0,0 +1,577 @@
+#include "pch.h"
+#include "ObjParser.h"
+#include "FileMapping.h"
+#include "ThreadPool.h"
+#include <charconv>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		//Face corner as 0-based indices into the attribute arrays, -1 when absent
+		struct ObjCorner
+		{
+			int32_t position;
+			int32_t uv;
+			int32_t normal;
+		};
+
+		//Open-addressing hash map from corner triple to vertex index
+		class VertexWelder final
+		{
+		public:
+			VertexWelder(size_t maxVertices)
+			{
+				size_t capacity{ 16 };
+				while (capacity < maxVertices * 2)
+					capacity *= 2;
+
+				m_Slots.resize(capacity, m_Empty);
+				m_Keys.reserve(maxVertices);
+				m_Mask = static_cast<uint32_t>(capacity - 1);
+			}
+
+			//Returns the index already used for this triple, or registers it as newIndex
+			uint32_t FindOrAdd(const ObjCorner& key, uint32_t newIndex)
+			{
+				uint32_t slot = Hash(key) & m_Mask;
+				while (m_Slots[slot] != m_Empty)
+				{
+					const ObjCorner& other = m_Keys[m_Slots[slot]];
+					if (other.position == key.position && other.uv == key.uv && other.normal == key.normal)
+						return m_Slots[slot];
+
+					slot = (slot + 1) & m_Mask;
+				}
+
+				m_Slots[slot] = newIndex;
+				m_Keys.push_back(key);
+				return newIndex;
+			}
+
+		private:
+			static constexpr uint32_t m_Empty{ UINT32_MAX };
+
+			std::vector<uint32_t> m_Slots{};
+			std::vector<ObjCorner> m_Keys{};
+			uint32_t m_Mask{};
+
+			static uint32_t Hash(const ObjCorner& key)
+			{
+				uint32_t hash = static_cast<uint32_t>(key.position) * 0x9E3779B1u;
+				hash ^= static_cast<uint32_t>(key.uv) * 0x85EBCA77u;
+				hash ^= static_cast<uint32_t>(key.normal) * 0xC2B2AE3Du;
+				return hash ^ (hash >> 15);
+			}
+		};
+
+		//How the indices of one attribute in a chunk relate to the records before the chunk
+		struct ObjChunkIndices
+		{
+			//Largest distance a positive index reaches past the chunk's own records
+			int64_t maxExcess{};
+			bool isResolvable{ true };
+		};
+
+		struct ObjData
+		{
+			std::vector<Vector3> positions{};
+			std::vector<Vector2> UVs{};
+			std::vector<Vector3> normals{};
+			std::vector<ObjCorner> corners{};
+
+			//Chunked parsing only
+			ObjChunkIndices positionIndices{};
+			ObjChunkIndices UVIndices{};
+			ObjChunkIndices normalIndices{};
+		};
+
+		//Relative indices in a chunk are stored chunk-local as -(local + 2), -1 stays "absent"
+		constexpr int32_t ToChunkLocal(int64_t local)
+		{
+			return static_cast<int32_t>(-(local + 2));
+		}
+
+		constexpr int32_t ResolveChunkIndex(int32_t index, size_t prefixCount)
+		{
+			return index >= -1 ? index : static_cast<int32_t>(prefixCount) - index - 2;
+		}
+
+		inline bool IsBlank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline const char* SkipBlanks(const char* p, const char* pEnd)
+		{
+			while (p < pEnd && IsBlank(*p))
+				++p;
+			return p;
+		}
+
+		inline const char* NextLine(const char* p, const char* pEnd)
+		{
+			const void* pNewLine = std::memchr(p, '\n', static_cast<size_t>(pEnd - p));
+			return pNewLine ? static_cast<const char*>(pNewLine) + 1 : pEnd;
+		}
+
+		inline const char* ParseFloat(const char* p, const char* pEnd, float& value)
+		{
+			p = SkipBlanks(p, pEnd);
+			if (p < pEnd && *p == '+')
+				++p;
+
+			value = 0.f;
+			return std::from_chars(p, pEnd, value).ptr;
+		}
+
+		//Resolves 1-based (or negative, relative) OBJ indices to 0-based ones, -1 if out of range
+		inline const char* ParseIndex(const char* p, const char* pEnd, size_t count, int32_t& index)
+		{
+			int64_t value{};
+			const auto result = std::from_chars(p, pEnd, value);
+
+			if (value > 0 && static_cast<size_t>(value) <= count)
+				index = static_cast<int32_t>(value - 1);
+			else if (value < 0 && static_cast<size_t>(-value) <= count)
+				index = static_cast<int32_t>(static_cast<int64_t>(count) + value);
+			else
+				index = -1;
+
+			return result.ptr;
+		}
+
+		//Chunked variant: positive indices are already global, the rest is resolved during the merge
+		inline const char* ParseChunkIndex(const char* p, const char* pEnd, size_t localCount, int32_t& index, ObjChunkIndices& info)
+		{
+			int64_t value{};
+			const auto result = std::from_chars(p, pEnd, value);
+			const int64_t count = static_cast<int64_t>(localCount);
+
+			if (value > 0)
+			{
+				index = static_cast<int32_t>(value - 1);
+				info.maxExcess = std::max(info.maxExcess, value - count);
+			}
+			else if (value < 0 && count + value >= 0)
+			{
+				index = ToChunkLocal(count + value);
+			}
+			else
+			{
+				//Points before the chunk or is invalid, let the serial parser handle the file
+				index = -1;
+				info.isResolvable = false;
+			}
+
+			return result.ptr;
+		}
+
+		//Counts the records up front so every array is allocated exactly once
+		void Reserve(const char* p, const char* pEnd, ObjData& data)
+		{
+			size_t numPositions{}, numUVs{}, numNormals{}, numFaces{};
+			while (p < pEnd)
+			{
+				p = SkipBlanks(p, pEnd);
+				if (pEnd - p > 1)
+				{
+					if (p[0] == 'v')
+					{
+						if (IsBlank(p[1])) ++numPositions;
+						else if (p[1] == 't') ++numUVs;
+						else if (p[1] == 'n') ++numNormals;
+					}
+					else if (p[0] == 'f' && IsBlank(p[1]))
+					{
+						++numFaces;
+					}
+				}
+				p = NextLine(p, pEnd);
+			}
+
+			data.positions.reserve(numPositions);
+			data.UVs.reserve(numUVs);
+			data.normals.reserve(numNormals);
+			data.corners.reserve(numFaces * 3);
+		}
+
+		template<bool IsChunk>
+		bool ParseRecords(const char* p, const char* pEnd, ObjData& data)
+		{
+			while (p < pEnd)
+			{
+				p = SkipBlanks(p, pEnd);
+				const char* pLineEnd = NextLine(p, pEnd);
+
+				//Command is the first word of the line, everything we don't know is ignored (comments, groups, materials)
+				const char* pCommandEnd = p;
+				while (pCommandEnd < pLineEnd && !IsBlank(*pCommandEnd) && *pCommandEnd != '\n')
+					++pCommandEnd;
+				const size_t commandLength = static_cast<size_t>(pCommandEnd - p);
+
+				if (commandLength == 1 && p[0] == 'v')
+				{
+					//Vertex
+					float x, y, z;
+					const char* pValue = ParseFloat(pCommandEnd, pLineEnd, x);
+					pValue = ParseFloat(pValue, pLineEnd, y);
+					ParseFloat(pValue, pLineEnd, z);
+
+					data.positions.emplace_back(x, y, z);
+				}
+				else if (commandLength == 2 && p[0] == 'v' && p[1] == 't')
+				{
+					// Vertex TexCoord
+					float u, v;
+					const char* pValue = ParseFloat(pCommandEnd, pLineEnd, u);
+					ParseFloat(pValue, pLineEnd, v);
+
+					data.UVs.emplace_back(u, 1 - v);
+				}
+				else if (commandLength == 2 && p[0] == 'v' && p[1] == 'n')
+				{
+					// Vertex Normal
+					float x, y, z;
+					const char* pValue = ParseFloat(pCommandEnd, pLineEnd, x);
+					pValue = ParseFloat(pValue, pLineEnd, y);
+					ParseFloat(pValue, pLineEnd, z);
+
+					data.normals.emplace_back(x, y, z);
+				}
+				else if (commandLength == 1 && p[0] == 'f')
+				{
+					// Faces or triangles, like the reference parser only the first 3 corners are used
+					const char* pValue = pCommandEnd;
+					for (size_t iFace = 0; iFace < 3; iFace++)
+					{
+						ObjCorner corner{ -1, -1, -1 };
+
+						pValue = SkipBlanks(pValue, pLineEnd);
+						if constexpr (IsChunk)
+						{
+							pValue = ParseChunkIndex(pValue, pLineEnd, data.positions.size(), corner.position, data.positionIndices);
+						}
+						else
+						{
+							pValue = ParseIndex(pValue, pLineEnd, data.positions.size(), corner.position);
+							if (corner.position < 0)
+								return false;
+						}
+
+						if (pValue < pLineEnd && *pValue == '/')
+						{
+							++pValue;
+
+							// Optional texture coordinate
+							if (pValue < pLineEnd && *pValue != '/')
+							{
+								if constexpr (IsChunk)
+									pValue = ParseChunkIndex(pValue, pLineEnd, data.UVs.size(), corner.uv, data.UVIndices);
+								else
+									pValue = ParseIndex(pValue, pLineEnd, data.UVs.size(), corner.uv);
+							}
+
+							// Optional vertex normal
+							if (pValue < pLineEnd && *pValue == '/')
+							{
+								if constexpr (IsChunk)
+									pValue = ParseChunkIndex(pValue + 1, pLineEnd, data.normals.size(), corner.normal, data.normalIndices);
+								else
+									pValue = ParseIndex(pValue + 1, pLineEnd, data.normals.size(), corner.normal);
+							}
+						}
+
+						data.corners.push_back(corner);
+					}
+				}
+
+				p = pLineEnd;
+			}
+
+			return true;
+		}
+
+		//Splits the file at line boundaries and parses the chunks on the pool, false if the file needs the serial path
+		bool ParseChunks(const char* pBegin, const char* pEnd, ObjData& data, ThreadPool& threadPool)
+		{
+			constexpr size_t minChunkSize{ 256 * 1024 };
+			const size_t fileSize = static_cast<size_t>(pEnd - pBegin);
+			const size_t numChunks = std::max<size_t>(1, std::min(fileSize / minChunkSize, (threadPool.GetNumWorkers() + size_t(1)) * 4));
+
+			std::vector<const char*> boundaries(numChunks + 1, pEnd);
+			boundaries[0] = pBegin;
+			for (size_t i{ 1 }; i < numChunks; ++i)
+				boundaries[i] = NextLine(std::max(boundaries[i - 1], pBegin + fileSize * i / numChunks), pEnd);
+
+			std::vector<ObjData> chunks(numChunks);
+			threadPool.ParallelFor(numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t i{ begin }; i < end; ++i)
+					{
+						Reserve(boundaries[i], boundaries[i + 1], chunks[i]);
+						ParseRecords<true>(boundaries[i], boundaries[i + 1], chunks[i]);
+					}
+				});
+
+			//Prefix sums give every chunk the global offset of its records
+			std::vector<size_t> positionOffsets(numChunks + 1), UVOffsets(numChunks + 1), normalOffsets(numChunks + 1), cornerOffsets(numChunks + 1);
+			for (size_t i{}; i < numChunks; ++i)
+			{
+				const ObjData& chunk = chunks[i];
+				const auto isResolvable = [](const ObjChunkIndices& info, size_t prefixCount)
+					{
+						return info.isResolvable && info.maxExcess <= static_cast<int64_t>(prefixCount);
+					};
+
+				if (!isResolvable(chunk.positionIndices, positionOffsets[i]) || !isResolvable(chunk.UVIndices, UVOffsets[i]) ||
+					!isResolvable(chunk.normalIndices, normalOffsets[i]))
+					return false;
+
+				positionOffsets[i + 1] = positionOffsets[i] + chunk.positions.size();
+				UVOffsets[i + 1] = UVOffsets[i] + chunk.UVs.size();
+				normalOffsets[i + 1] = normalOffsets[i] + chunk.normals.size();
+				cornerOffsets[i + 1] = cornerOffsets[i] + chunk.corners.size();
+			}
+
+			data.positions.resize(positionOffsets[numChunks]);
+			data.UVs.resize(UVOffsets[numChunks]);
+			data.normals.resize(normalOffsets[numChunks]);
+			data.corners.resize(cornerOffsets[numChunks]);
+
+			threadPool.ParallelFor(numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t i{ begin }; i < end; ++i)
+					{
+						const ObjData& chunk = chunks[i];
+						std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + positionOffsets[i]);
+						std::copy(chunk.UVs.begin(), chunk.UVs.end(), data.UVs.begin() + UVOffsets[i]);
+						std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + normalOffsets[i]);
+
+						ObjCorner* pCorners = data.corners.data() + cornerOffsets[i];
+						for (const ObjCorner& corner : chunk.corners)
+						{
+							*pCorners++ = ObjCorner{ ResolveChunkIndex(corner.position, positionOffsets[i]),
+								ResolveChunkIndex(corner.uv, UVOffsets[i]), ResolveChunkIndex(corner.normal, normalOffsets[i]) };
+						}
+					}
+				});
+
+			return true;
+		}
+
+		void BuildVertices(const ObjData& data, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ObjImportOptions& options)
+		{
+			vertices.clear();
+			indices.clear();
+			vertices.reserve(options.weldVertices ? std::max(data.positions.size(), data.normals.size()) : data.corners.size());
+			indices.reserve(data.corners.size() * 2);
+
+			VertexWelder welder{ options.weldVertices ? data.corners.size() : 0 };
+
+			for (size_t iCorner = 0; iCorner < data.corners.size(); iCorner += 3)
+			{
+				//Attributes a corner doesn't specify carry over from the previous corner of the face, as in the reference parser
+				Vertex vertex{};
+				ObjCorner key{ -1, -1, -1 };
+				uint32_t tempIndices[3];
+				for (size_t iFace = 0; iFace < 3; iFace++)
+				{
+					const ObjCorner& corner = data.corners[iCorner + iFace];
+					key.position = corner.position;
+					vertex.position = data.positions[corner.position];
+					if (corner.uv >= 0)
+					{
+						key.uv = corner.uv;
+						vertex.uv = data.UVs[corner.uv];
+					}
+					if (corner.normal >= 0)
+					{
+						key.normal = corner.normal;
+						vertex.normal = data.normals[corner.normal];
+					}
+
+					const uint32_t newIndex = static_cast<uint32_t>(vertices.size());
+					tempIndices[iFace] = options.weldVertices ? welder.FindOrAdd(key, newIndex) : newIndex;
+					if (tempIndices[iFace] == newIndex)
+						vertices.push_back(vertex);
+
+					indices.push_back(tempIndices[iFace]);
+				}
+
+				indices.push_back(tempIndices[0]);
+				if (options.flipAxisAndWinding)
+				{
+					indices.push_back(tempIndices[2]);
+					indices.push_back(tempIndices[1]);
+				}
+				else
+				{
+					indices.push_back(tempIndices[1]);
+					indices.push_back(tempIndices[2]);
+				}
+			}
+		}
+
+		//Without welding every corner is its own vertex, so faces can be built independently
+		void BuildUnweldedVertices(const ObjData& data, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool& threadPool)
+		{
+			const size_t numFaces = data.corners.size() / 3;
+			vertices.resize(numFaces * 3);
+			indices.resize(numFaces * 6);
+
+			threadPool.ParallelFor(numFaces, [&](size_t begin, size_t end)
+				{
+					for (size_t iFace = begin; iFace < end; ++iFace)
+					{
+						Vertex vertex{};
+						for (size_t iCorner = 0; iCorner < 3; iCorner++)
+						{
+							const ObjCorner& corner = data.corners[iFace * 3 + iCorner];
+							vertex.position = data.positions[corner.position];
+							if (corner.uv >= 0)
+								vertex.uv = data.UVs[corner.uv];
+							if (corner.normal >= 0)
+								vertex.normal = data.normals[corner.normal];
+
+							vertices[iFace * 3 + iCorner] = vertex;
+						}
+
+						const uint32_t index0 = static_cast<uint32_t>(iFace * 3);
+						uint32_t* pIndices = indices.data() + iFace * 6;
+						pIndices[0] = index0;
+						pIndices[1] = index0 + 1;
+						pIndices[2] = index0 + 2;
+						pIndices[3] = index0;
+						pIndices[4] = flipAxisAndWinding ? index0 + 2 : index0 + 1;
+						pIndices[5] = flipAxisAndWinding ? index0 + 1 : index0 + 2;
+					}
+				}, 4096);
+		}
+
+		inline Vector3 CalculateTriangleTangent(const std::vector<Vertex>& vertices, uint32_t index0, uint32_t index1, uint32_t index2)
+		{
+			const Vector3& p0 = vertices[index0].position;
+			const Vector3& p1 = vertices[index1].position;
+			const Vector3& p2 = vertices[index2].position;
+			const Vector2& uv0 = vertices[index0].uv;
+			const Vector2& uv1 = vertices[index1].uv;
+			const Vector2& uv2 = vertices[index2].uv;
+
+			const Vector3 edge0 = p1 - p0;
+			const Vector3 edge1 = p2 - p0;
+			const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
+			const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
+			float r = 1.f / Vector2::Cross(diffX, diffY);
+
+			return (edge0 * diffY.y - edge1 * diffY.x) * r;
+		}
+
+		inline void FinishTangent(Vertex& v, bool flipAxisAndWinding)
+		{
+			v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+
+			if (flipAxisAndWinding)
+			{
+				v.position.z *= -1.f;
+				v.normal.z *= -1.f;
+				v.tangent.z *= -1.f;
+			}
+		}
+
+		//Sums the triangle tangents per vertex in ascending triangle order, so the floats match the serial loop bit for bit
+		void CalculateTangentsParallel(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool& threadPool)
+		{
+			const size_t numTriangles = indices.size() / 3;
+			std::vector<Vector3> tangents(numTriangles);
+			threadPool.ParallelFor(numTriangles, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+						tangents[i] = CalculateTriangleTangent(vertices, indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+				}, 4096);
+
+			//Vertex -> triangle lists, filled in triangle order
+			std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+				++offsets[indices[i] + 1];
+			for (size_t i = 1; i < offsets.size(); ++i)
+				offsets[i] += offsets[i - 1];
+
+			std::vector<uint32_t> triangles(numTriangles * 3);
+			std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+				triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+			threadPool.ParallelFor(vertices.size(), [&](size_t begin, size_t end)
+				{
+					for (size_t iVertex = begin; iVertex < end; ++iVertex)
+					{
+						Vertex& v = vertices[iVertex];
+						for (uint32_t i = offsets[iVertex]; i < offsets[iVertex + 1]; ++i)
+							v.tangent += tangents[triangles[i]];
+
+						FinishTangent(v, flipAxisAndWinding);
+					}
+				}, 4096);
+		}
+	}
+
+	namespace Utils
+	{
+		bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ObjImportOptions& options)
+		{
+			const FileMapping file{ filename };
+			if (!file.IsValid())
+				return false;
+
+			return ParseOBJ(file.GetData(), file.GetEnd(), vertices, indices, options);
+		}
+
+		bool ParseOBJ(const char* pBegin, const char* pEnd, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ObjImportOptions& options)
+		{
+			ObjData data{};
+			if (!options.pThreadPool || !ParseChunks(pBegin, pEnd, data, *options.pThreadPool))
+			{
+				data = ObjData{};
+				Reserve(pBegin, pEnd, data);
+				if (!ParseRecords<false>(pBegin, pEnd, data))
+					return false;
+			}
+
+			if (options.pThreadPool && !options.weldVertices)
+				BuildUnweldedVertices(data, vertices, indices, options.flipAxisAndWinding, *options.pThreadPool);
+			else
+				BuildVertices(data, vertices, indices, options);
+
+			CalculateTangents(vertices, indices, options.flipAxisAndWinding, options.pThreadPool);
+			return true;
+		}
+
+		void CalculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool* pThreadPool)
+		{
+			if (pThreadPool)
+			{
+				CalculateTangentsParallel(vertices, indices, flipAxisAndWinding, *pThreadPool);
+				return;
+			}
+
+			//Cheap Tangent Calculations
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				uint32_t index0 = indices[i];
+				uint32_t index1 = indices[i + 1];
+				uint32_t index2 = indices[i + 2];
+
+				const Vector3 tangent = CalculateTriangleTangent(vertices, index0, index1, index2);
+				vertices[index0].tangent += tangent;
+				vertices[index1].tangent += tangent;
+				vertices[index2].tangent += tangent;
+			}
+
+			//Create the Tangents (reject)
+			for (auto& v : vertices)
+				FinishTangent(v, flipAxisAndWinding);
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Datatypes.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	struct ObjImportOptions
+	{
+		bool flipAxisAndWinding{ true };
+		//Share one Vertex between all corners with the same position/uv/normal triple
+		bool weldVertices{ true };
+		//Parses chunks of the file in parallel when set, the output is identical to the serial path
+		ThreadPool* pThreadPool{};
+	};
+
+	namespace Utils
+	{
+		//Memory-mapped OBJ parser, without welding it fills the same outputs as ParseOBJReference (Utils.h)
+		bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ObjImportOptions& options = {});
+
+		//Parses OBJ text that is already in memory
+		bool ParseOBJ(const char* pBegin, const char* pEnd, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const ObjImportOptions& options = {});
+
+		//Cheap tangent accumulation + optional LH conversion, shared by every parse path
+		void CalculateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool* pThreadPool = nullptr);
+	}
+}
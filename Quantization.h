@@ -0,0 +1,177 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "Datatypes.h"
+
+namespace dae
+{
+	namespace Quantization
+	{
+		//IEEE half float with round-to-nearest-even, matches DXGI_FORMAT_R16_FLOAT
+		inline uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+			//NaN stays NaN, inf and overflow become inf
+			if (absBits > 0x7F800000u)
+				return static_cast<uint16_t>(sign | 0x7E00u);
+			if (absBits >= 0x477FF000u)
+				return static_cast<uint16_t>(sign | 0x7C00u);
+
+			//Denormals (and zero)
+			if (absBits < 0x38800000u)
+			{
+				if (absBits < 0x33000000u)
+					return static_cast<uint16_t>(sign);
+
+				const uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+				const uint32_t shift = 126u - (absBits >> 23);
+				uint32_t half = mantissa >> shift;
+				const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+				const uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half & 1u)))
+					++half;
+				return static_cast<uint16_t>(sign | half);
+			}
+
+			uint32_t half = ((absBits - 0x38000000u) >> 13);
+			const uint32_t remainder = absBits & 0x1FFFu;
+			if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+				++half;
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		inline float HalfToFloat(uint16_t half)
+		{
+			const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+			const uint32_t exponent = (half >> 10) & 0x1Fu;
+			uint32_t mantissa = half & 0x3FFu;
+
+			uint32_t bits{};
+			if (exponent == 0x1Fu)
+			{
+				bits = sign | 0x7F800000u | (mantissa << 13);
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+			}
+			else if (mantissa != 0)
+			{
+				//Normalize the denormal
+				uint32_t shiftedExponent{ 113 };
+				while ((mantissa & 0x400u) == 0)
+				{
+					mantissa <<= 1;
+					--shiftedExponent;
+				}
+				bits = sign | (shiftedExponent << 23) | ((mantissa & 0x3FFu) << 13);
+			}
+			else
+			{
+				bits = sign;
+			}
+
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		inline uint16_t ToUnorm16(float value)
+		{
+			return static_cast<uint16_t>(Clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+		}
+
+		inline float FromUnorm16(uint16_t value)
+		{
+			return value / 65535.f;
+		}
+
+		inline int16_t ToSnorm16(float value)
+		{
+			return static_cast<int16_t>(std::round(Clamp(value, -1.f, 1.f) * 32767.f));
+		}
+
+		//Same as the GPU: -32768 and -32767 both map to -1
+		inline float FromSnorm16(int16_t value)
+		{
+			return std::max(value / 32767.f, -1.f);
+		}
+
+		//Octahedral unit vector encoding, the decode is mirrored by DecodeOctahedral in PosCol3D.fx
+		inline Vector2 EncodeOctahedral(const Vector3& n)
+		{
+			const float l1Norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+			if (l1Norm <= 0.f)
+				return Vector2{ 0.f, 0.f };
+
+			Vector2 p{ n.x / l1Norm, n.y / l1Norm };
+			if (n.z < 0.f)
+			{
+				const float signX = p.x >= 0.f ? 1.f : -1.f;
+				const float signY = p.y >= 0.f ? 1.f : -1.f;
+				p = Vector2{ (1.f - std::abs(p.y)) * signX, (1.f - std::abs(p.x)) * signY };
+			}
+			return p;
+		}
+
+		inline Vector3 DecodeOctahedral(const Vector2& e)
+		{
+			Vector3 n{ e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y) };
+			const float t = Saturate(-n.z);
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			return n.Normalized();
+		}
+
+		//Positions are stored relative to the bounds: offset + unorm * scale
+		struct PositionDequantization
+		{
+			Vector3 offset{};
+			Vector3 scale{};
+		};
+
+		inline PositionDequantization GetPositionDequantization(const BoundingBox& bounds)
+		{
+			return PositionDequantization{ bounds.min, bounds.max - bounds.min };
+		}
+
+		inline VertexCompact EncodeVertex(const Vertex& vertex, const PositionDequantization& dequantization)
+		{
+			VertexCompact compact{};
+			for (int i{}; i < 3; ++i)
+			{
+				const float scale = dequantization.scale[i];
+				compact.position[i] = scale > 0.f ? ToUnorm16((vertex.position[i] - dequantization.offset[i]) / scale) : 0;
+			}
+
+			compact.uv[0] = FloatToHalf(vertex.uv.x);
+			compact.uv[1] = FloatToHalf(vertex.uv.y);
+
+			const Vector2 normal = EncodeOctahedral(vertex.normal);
+			compact.normal[0] = ToSnorm16(normal.x);
+			compact.normal[1] = ToSnorm16(normal.y);
+
+			const Vector2 tangent = EncodeOctahedral(vertex.tangent);
+			compact.tangent[0] = ToSnorm16(tangent.x);
+			compact.tangent[1] = ToSnorm16(tangent.y);
+			return compact;
+		}
+
+		inline Vertex DecodeVertex(const VertexCompact& compact, const PositionDequantization& dequantization)
+		{
+			Vertex vertex{};
+			for (int i{}; i < 3; ++i)
+				vertex.position[i] = dequantization.offset[i] + FromUnorm16(compact.position[i]) * dequantization.scale[i];
+
+			vertex.uv = Vector2{ HalfToFloat(compact.uv[0]), HalfToFloat(compact.uv[1]) };
+			vertex.normal = DecodeOctahedral(Vector2{ FromSnorm16(compact.normal[0]), FromSnorm16(compact.normal[1]) });
+			vertex.tangent = DecodeOctahedral(Vector2{ FromSnorm16(compact.tangent[0]), FromSnorm16(compact.tangent[1]) });
+			return vertex;
+		}
+	}
+}
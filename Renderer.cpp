@@ -1,14 +1,49 @@
 #include "pch.h"
 #include "Renderer.h"
-#include "Utils.h"
+#include "AssetLoader.h"
+#include "CPUTexture.h"
+#include "MeshAsset.h"
+#include "TextureManager.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include <filesystem>
 
 namespace dae {
 
-	Renderer::Renderer(SDL_Window* pWindow) :
-		m_pWindow(pWindow)
+	namespace
+	{
+		DXGI_FORMAT GetDXGIFormat(DepthFormat format)
+		{
+			switch (format)
+			{
+			case DepthFormat::D16: return DXGI_FORMAT_D16_UNORM;
+			case DepthFormat::D24S8: return DXGI_FORMAT_D24_UNORM_S8_UINT;
+			default: return DXGI_FORMAT_D32_FLOAT;
+			}
+		}
+	}
+
+	Renderer::Renderer(SDL_Window* pWindow, Backend backend) :
+		m_pWindow(pWindow),
+		m_Backend(backend)
 	{
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+		m_pThreadPool = new ThreadPool{};
+
+		//Initialize camera
+		m_Camera.isReversedZ = DepthFormats::IsReversed(m_DepthFormat);
+		m_Camera.Initialize(45.f,{0.f,0.f,-50.f}, static_cast<float>(m_Width) / m_Height);
+
+		if (m_Backend == Backend::Software)
+		{
+			m_pSoftwareRasterizer = new SoftwareRasterizer{ static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height), m_pThreadPool };
+			m_pSoftwareRasterizer->SetDepthFormat(m_DepthFormat);
+			m_IsInitialized = true;
+			std::cout << "Software rasterizer is initialized and ready!\n";
+			LoadAssets();
+			return;
+		}
 
 		//Initialize DirectX pipeline
 		const HRESULT result = InitializeDirectX();
@@ -21,53 +56,90 @@ namespace dae {
 		{
 			std::cout << "DirectX initialization failed!\n";
 		}
-		
-		
-		//Initialize camera
-		m_Camera.Initialize(45.f,{0.f,0.f,-50.f}, static_cast<float>(m_Width) / m_Height);
 
-		//Initialize textures
-		m_pDiffuseTexture = new Texture{ "Resources/vehicle_diffuse.png",m_pDevice };
-		m_pNormalTexture = new Texture{ "Resources/vehicle_normal.png",m_pDevice };
-		m_pSpecularTexture = new Texture{ "Resources/vehicle_specular.png",m_pDevice };
-		m_pGlossinessTexture = new Texture{ "Resources/vehicle_gloss.png",m_pDevice };
-		//Initialize mesh
-		InitializeMesh();
+		//Less than the 3.3 MB the three maps take at full resolution, so they only sharpen as far as the view needs
+		m_pTextureStreamer = new TextureStreamer{ m_pThreadPool, { .budgetBytes = 2 * 1024 * 1024 } };
+		m_pTextureManager = new TextureManager{ m_pDevice, m_pTextureStreamer };
+
+		//Initialize fallback textures: grey, a flat normal and no specular
+		m_pFallbackDiffuseTexture = new Texture{ m_pDevice, ColorRGB{ 0.5f, 0.5f, 0.5f } };
+		m_pFallbackNormalTexture = new Texture{ m_pDevice, ColorRGB{ 0.5f, 0.5f, 1.f } };
+		m_pFallbackSpecularGlossTexture = new Texture{ m_pDevice, ColorRGB{ 0.f, 0.f, 0.f } };
+
+		//Initialize mesh and textures
+		LoadAssets();
 	}
 
 	Renderer::~Renderer()
 	{
 		//We need to Delete in reverse order
 
-		delete m_pGlossinessTexture;
-		m_pGlossinessTexture = nullptr;
+		//Waits for the loads still running before anything they'd be handed to is gone
+		delete m_pAssetLoader;
+		m_pAssetLoader = nullptr;
+
+		delete m_pFallbackSpecularGlossTexture;
+		m_pFallbackSpecularGlossTexture = nullptr;
+
+		delete m_pFallbackNormalTexture;
+		m_pFallbackNormalTexture = nullptr;
 
-		delete m_pSpecularTexture;
-		m_pSpecularTexture = nullptr;
+		delete m_pFallbackDiffuseTexture;
+		m_pFallbackDiffuseTexture = nullptr;
 
-		delete m_pNormalTexture;
-		m_pNormalTexture = nullptr;
+		//The last handles, which frees them in the manager
+		m_pSpecularGlossTexture.reset();
+		m_pNormalTexture.reset();
+		m_pDiffuseTexture.reset();
 
-		delete m_pDiffuseTexture;
-		m_pDiffuseTexture = nullptr;
+		delete m_pTextureManager;
+		m_pTextureManager = nullptr;
+
+		delete m_pTextureStreamer;
+		m_pTextureStreamer = nullptr;
 
 		delete m_pMesh;
 		m_pMesh = nullptr;
 
-		m_pRenderTargetView->Release();
-		m_pRenderTargetView = nullptr;
+		delete m_pSoftwareRasterizer;
+		m_pSoftwareRasterizer = nullptr;
 
-		m_pRenderTargetBuffer->Release();
-		m_pRenderTargetBuffer = nullptr;
+		//Never created by the software backend
+		if (m_pRenderTargetView)
+		{
+			m_pRenderTargetView->Release();
+			m_pRenderTargetView = nullptr;
+		}
 
-		m_pDepthStencilView->Release();
-		m_pDepthStencilView = nullptr;
+		if (m_pRenderTargetBuffer)
+		{
+			m_pRenderTargetBuffer->Release();
+			m_pRenderTargetBuffer = nullptr;
+		}
 
-		m_pDepthStencilBuffer->Release();
-		m_pDepthStencilBuffer = nullptr;
+		if (m_pDepthStencilState)
+		{
+			m_pDepthStencilState->Release();
+			m_pDepthStencilState = nullptr;
+		}
+
+		if (m_pDepthStencilView)
+		{
+			m_pDepthStencilView->Release();
+			m_pDepthStencilView = nullptr;
+		}
 
-		m_pSwapChain->Release();
-		m_pSwapChain = nullptr;
+		if (m_pDepthStencilBuffer)
+		{
+			m_pDepthStencilBuffer->Release();
+			m_pDepthStencilBuffer = nullptr;
+		}
+
+		if (m_pSwapChain)
+		{
+			m_pSwapChain->Release();
+			m_pSwapChain = nullptr;
+		}
 
 		if (m_pDeviceContext)
 		{
@@ -76,29 +148,69 @@ namespace dae {
 			m_pDeviceContext->Release();
 		}
 
-		m_pDevice->Release();
-		m_pDevice = nullptr;
+		if (m_pDevice)
+		{
+			m_pDevice->Release();
+			m_pDevice = nullptr;
+		}
+
+		delete m_pThreadPool;
+		m_pThreadPool = nullptr;
 	}
 
 	void Renderer::Update(const Timer* pTimer)
 	{
-		m_Camera.Update(pTimer);
-		m_pMesh->SetMatrix(m_Camera.GetInverseViewMatrix()* m_Camera.GetProjectionMatrix(),m_Camera.GetInverseViewMatrix());
+		//Makes whatever finished loading resident, the timeline is printed once everything is
+		if (m_pAssetLoader && !m_pAssetLoader->Update())
+		{
+			m_pAssetLoader->PrintTimeline();
+			if (m_pTextureManager)
+			{
+				m_pTextureManager->PrintStats();
+				m_pTextureStreamer->PrintStats();
+			}
+			delete m_pAssetLoader;
+			m_pAssetLoader = nullptr;
+		}
 
+		m_Camera.Update(pTimer);
 		if (m_UsesRotation)
 		{
 			const float rotSpeed{ 50.f };
-			m_pMesh->SetWorldMatrix(Matrix::CreateRotationY(pTimer->GetElapsed() * rotSpeed * TO_RADIANS) * m_pMesh->GetWorldMatrix());
+			m_WorldMatrix = Matrix::CreateRotationY(pTimer->GetElapsed() * rotSpeed * TO_RADIANS) * m_WorldMatrix;
 		}
 
+		if (m_pMesh)
+		{
+			//The shader takes the camera's position from the last row of the view inverse, the camera to world matrix
+			m_pMesh->SetWorldMatrix(m_WorldMatrix);
+			m_pMesh->SetMatrix(m_Camera.GetInverseViewMatrix() * m_Camera.GetProjectionMatrix(), m_Camera.GetViewMatrix());
+
+			m_pMesh->UpdateLOD(m_Camera, static_cast<float>(m_Height));
+			m_pMesh->CullMeshlets(m_Camera);
+
+			const float uvPerPixel = m_pMesh->GetUVPerPixel(m_Camera, static_cast<float>(m_Height));
+			for (const std::shared_ptr<Texture>& pTexture : { m_pDiffuseTexture, m_pNormalTexture, m_pSpecularGlossTexture })
+				m_pTextureManager->Request(pTexture.get(), uvPerPixel);
+		}
+
+		//Recreated textures come with new views
+		if (m_pTextureStreamer && m_pTextureStreamer->Update())
+			BindMaps();
+
 		const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
 
 		if (pKeyboardState[SDL_SCANCODE_F2])
 		{
-			if (!m_IsF2Pressed)
+			if (!m_IsF2Pressed && m_pMesh)
 			{
 				m_pMesh->SwitchTechnique();
 			}
+			else if (!m_IsF2Pressed && m_Backend == Backend::Software)
+			{
+				m_SoftwareFilter = m_SoftwareFilter == SamplerFilter::Point ? SamplerFilter::Linear :
+					m_SoftwareFilter == SamplerFilter::Linear ? SamplerFilter::Anisotropic : SamplerFilter::Point;
+			}
 			m_IsF2Pressed = true;
 		}
 		else
@@ -118,6 +230,26 @@ namespace dae {
 		{
 			m_IsF5Pressed = false;
 		}
+
+		if (pKeyboardState[SDL_SCANCODE_F6])
+		{
+			if (!m_IsF6Pressed)
+			{
+				m_DepthFormat = static_cast<DepthFormat>((static_cast<int>(m_DepthFormat) + 1) % (static_cast<int>(DepthFormat::D32FReversed) + 1));
+				m_Camera.isReversedZ = DepthFormats::IsReversed(m_DepthFormat);
+				m_Camera.CalculateProjectionMatrix();
+				if (m_Backend == Backend::Software)
+					m_pSoftwareRasterizer->SetDepthFormat(m_DepthFormat);
+				else if (m_IsInitialized && FAILED(CreateDepthBuffer()))
+					std::cout << "Depth buffer creation failed!\n";
+				std::cout << "Depth buffer: " << DepthFormats::GetName(m_DepthFormat) << '\n';
+			}
+			m_IsF6Pressed = true;
+		}
+		else
+		{
+			m_IsF6Pressed = false;
+		}
 	}
 
 	void Renderer::Render() const
@@ -125,17 +257,63 @@ namespace dae {
 		if (!m_IsInitialized)
 			return;
 
+		if (m_Backend == Backend::Software)
+		{
+			RenderSoftware();
+			if (m_pAssetLoader)
+				m_pAssetLoader->MarkFirstFrame();
+			return;
+		}
+
 		// 1. CLEAR RTV & DSV
 		ColorRGB clearColor{ 0.0f, 0.0f, 0.3f };
 		m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, &clearColor.r);
-		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+		const UINT clearFlags = DepthFormats::HasStencil(m_DepthFormat) ? D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL : D3D11_CLEAR_DEPTH;
+		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, clearFlags, DepthFormats::GetClearDepth(m_DepthFormat), 0);
 
 		// 2. SET PIPELINE + INVOKE DRAWCALLS (= RENDER)
-		m_pMesh->Render(m_pDeviceContext);
+		//The effect's passes set no depth state of their own, so this one holds for the draws
+		m_pDeviceContext->OMSetDepthStencilState(m_pDepthStencilState, 0);
+		if (m_pMesh)
+			m_pMesh->Render(m_pDeviceContext);
 
 		// 3. PRESENT BACKBUFFER (SWAP)
 		m_pSwapChain->Present(0, 0);
 
+		if (m_pAssetLoader)
+			m_pAssetLoader->MarkFirstFrame();
+
+	}
+
+	void Renderer::RenderSoftware() const
+	{
+		// 1. CLEAR COLOR & DEPTH
+		m_pSoftwareRasterizer->Clear(ColorRGB{ 0.0f, 0.0f, 0.3f });
+
+		// 2. RASTERIZE LOD 0
+		if (m_pMeshAsset)
+		{
+			const std::span<const uint32_t> indices = m_pMeshAsset->GetIndices();
+			const std::span<const MeshLOD> lods = m_pMeshAsset->GetLODs();
+
+			SoftwareRasterizer::DrawCall drawCall{};
+			drawCall.vertices = m_pMeshAsset->GetVertices();
+			drawCall.indices = lods.empty() ? indices : indices.subspan(lods[0].firstIndex, lods[0].numIndices);
+			drawCall.worldMatrix = m_WorldMatrix;
+			drawCall.worldViewProjMatrix = m_WorldMatrix * m_Camera.GetInverseViewMatrix() * m_Camera.GetProjectionMatrix();
+			drawCall.cameraPosition = m_Camera.origin;
+			drawCall.material = { m_pSoftwareDiffuseTexture.get(), m_pSoftwareNormalTexture.get(), m_pSoftwareSpecularGlossTexture.get() };
+			drawCall.filter = m_SoftwareFilter;
+			m_pSoftwareRasterizer->Draw(drawCall);
+		}
+
+		// 3. BLIT TO THE WINDOW
+		const std::span<const uint32_t> colorBuffer = m_pSoftwareRasterizer->GetColorBuffer();
+		SDL_Surface* pFrame = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<uint32_t*>(colorBuffer.data()), m_Width, m_Height, 32,
+			m_Width * static_cast<int>(sizeof(uint32_t)), SDL_PIXELFORMAT_RGBA32);
+		SDL_BlitSurface(pFrame, nullptr, SDL_GetWindowSurface(m_pWindow), nullptr);
+		SDL_FreeSurface(pFrame);
+		SDL_UpdateWindowSurface(m_pWindow);
 	}
 
 	HRESULT Renderer::InitializeDirectX()
@@ -189,14 +367,65 @@ namespace dae {
 		if (FAILED(result)) 
 			return result;
 
-		// 3. Create DepthStencil (DS) and DepthStencilView (DSV)
+		// 3. Create RenderTarget (RT) and RenderTargetView (RTV)
+
+		// Resource
+		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
+		if (FAILED(result)) 
+			return result;
+
+		// View
+		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
+		if (FAILED(result)) 
+			return result;
+
+		// 4. Create DepthStencil (DS), DepthStencilView (DSV) and bind them with the RTV to Output Merger Stage
+
+		result = CreateDepthBuffer();
+		if (FAILED(result))
+			return result;
+
+		// 5. Set viewport
+
+		D3D11_VIEWPORT viewport{};
+		viewport.Width = static_cast<FLOAT>(m_Width);
+		viewport.Height = static_cast<FLOAT>(m_Height);
+		viewport.TopLeftX = 0;
+		viewport.TopLeftY = 0;
+		viewport.MinDepth = 0;
+		viewport.MaxDepth = 1;
+		m_pDeviceContext->RSSetViewports(1, &viewport);
+
+		return S_OK;
+	}
+
+	HRESULT Renderer::CreateDepthBuffer()
+	{
+		if (m_pDepthStencilState)
+		{
+			m_pDepthStencilState->Release();
+			m_pDepthStencilState = nullptr;
+		}
+
+		if (m_pDepthStencilView)
+		{
+			m_pDepthStencilView->Release();
+			m_pDepthStencilView = nullptr;
+		}
+
+		if (m_pDepthStencilBuffer)
+		{
+			m_pDepthStencilBuffer->Release();
+			m_pDepthStencilBuffer = nullptr;
+		}
+
 		// Resource
 		D3D11_TEXTURE2D_DESC depthStencilDesc{};
 		depthStencilDesc.Width = m_Width;
 		depthStencilDesc.Height = m_Height;
 		depthStencilDesc.MipLevels = 1;
 		depthStencilDesc.ArraySize = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		depthStencilDesc.Format = GetDXGIFormat(m_DepthFormat);
 		depthStencilDesc.SampleDesc.Count = 1;
 		depthStencilDesc.SampleDesc.Quality = 0;
 		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -210,51 +439,114 @@ namespace dae {
 		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
 		depthStencilViewDesc.Texture2D.MipSlice = 0;
 
-		result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
-		if (FAILED(result)) 
+		HRESULT result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
+		if (FAILED(result))
 			return result;
 
 		result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &depthStencilViewDesc, &m_pDepthStencilView);
-		if (FAILED(result)) 
+		if (FAILED(result))
 			return result;
 
-		// 4. Create RenderTarget (RT) and RenderTargetView (RTV)
+		// State, the default one but for the comparison
+		D3D11_DEPTH_STENCIL_DESC depthStencilStateDesc{};
+		depthStencilStateDesc.DepthEnable = true;
+		depthStencilStateDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+		depthStencilStateDesc.DepthFunc = DepthFormats::IsReversed(m_DepthFormat) ? D3D11_COMPARISON_GREATER : D3D11_COMPARISON_LESS;
+		depthStencilStateDesc.StencilEnable = false;
 
-		// Resource
-		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
-		if (FAILED(result)) 
-			return result;
-
-		// View
-		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
-		if (FAILED(result)) 
+		result = m_pDevice->CreateDepthStencilState(&depthStencilStateDesc, &m_pDepthStencilState);
+		if (FAILED(result))
 			return result;
 
-		// 5. Bind RTV and DSV to Output Merger Stage
-		
 		m_pDeviceContext->OMSetRenderTargets(1, &m_pRenderTargetView, m_pDepthStencilView);
+		return S_OK;
+	}
 
-		// 6. Set viewport
-
-		D3D11_VIEWPORT viewport{};
-		viewport.Width = static_cast<FLOAT>(m_Width);
-		viewport.Height = static_cast<FLOAT>(m_Height);
-		viewport.TopLeftX = 0;
-		viewport.TopLeftY = 0;
-		viewport.MinDepth = 0;
-		viewport.MaxDepth = 1;
-		m_pDeviceContext->RSSetViewports(1, &viewport);
+	void Renderer::LoadAssets()
+	{
+		m_pAssetLoader = new AssetLoader{ m_pThreadPool };
 
-		return S_OK;
+		//Decoding, mip generation and encoding run on a worker, only the upload of the start level happens here once it's done
+		//With an alphaPath its red channel is packed into the alpha of path, the pair is then known by the packed cache path
+		//The software backend decodes the blocks on the worker too, into the texture it samples
+		const auto loadTexture = [this](const std::string& path, const TextureImportOptions& options, std::shared_ptr<Texture>& pTexture, std::unique_ptr<CPUTexture>& pSoftwareTexture,
+			const std::string& alphaPath = {})
+			{
+				const std::string name = alphaPath.empty() ? path : TextureAsset::GetPackedCachePath(path, alphaPath);
+
+				if (m_Backend == Backend::Software)
+				{
+					m_pAssetLoader->Load<CPUTexture>(std::filesystem::path{ name }.filename().string(),
+						[path, alphaPath, options]() -> std::unique_ptr<CPUTexture>
+						{
+							const std::unique_ptr<TextureAsset> pAsset = alphaPath.empty() ? TextureAsset::Load(path, options) : TextureAsset::LoadPacked(path, alphaPath, options);
+							return pAsset ? CPUTexture::Create(*pAsset, TexelLayout::Tiled) : nullptr;
+						},
+						[path = name, &pSoftwareTexture](std::unique_ptr<CPUTexture> pLoaded)
+						{
+							if (!pLoaded)
+								std::cout << "Couldn't load " << path << ", keeping the fallback\n";
+							pSoftwareTexture = std::move(pLoaded);
+						});
+					return;
+				}
+
+				//Resident already, e.g. shared with another mesh
+				pTexture = m_pTextureManager->Find(name, options);
+				if (pTexture)
+					return;
+
+				m_pAssetLoader->Load<TextureAsset>(std::filesystem::path{ name }.filename().string(),
+					[path, alphaPath, options]() { return alphaPath.empty() ? TextureAsset::Load(path, options) : TextureAsset::LoadPacked(path, alphaPath, options); },
+					[this, path = name, options, &pTexture](std::unique_ptr<TextureAsset> pAsset)
+					{
+						if (!pAsset)
+						{
+							std::cout << "Couldn't load " << path << ", keeping the fallback\n";
+							return;
+						}
+						pTexture = m_pTextureManager->Add(path, options, std::shared_ptr<const TextureAsset>{ std::move(pAsset) });
+						BindMaps();
+					});
+			};
+
+		//Specular is colored, glossiness only uses red: together they fill a BC3, the same bytes as BC1 + BC4 in one fetch
+		loadTexture("Resources/vehicle_diffuse.png", { { .content = MipContent::Color, .pThreadPool = m_pThreadPool }, TextureFormat::BC1 }, m_pDiffuseTexture, m_pSoftwareDiffuseTexture);
+		loadTexture("Resources/vehicle_normal.png", { { .content = MipContent::Normal, .pThreadPool = m_pThreadPool }, TextureFormat::BC5 }, m_pNormalTexture, m_pSoftwareNormalTexture);
+		loadTexture("Resources/vehicle_specular.png", { { .content = MipContent::Data, .pThreadPool = m_pThreadPool }, TextureFormat::BC3 }, m_pSpecularGlossTexture, m_pSoftwareSpecularGlossTexture, "Resources/vehicle_gloss.png");
+
+		const std::string meshPath{ "Resources/vehicle.obj" };
+		m_pAssetLoader->Load<MeshAsset>("vehicle.obj",
+			[meshPath, pThreadPool = m_pThreadPool]() { return MeshAsset::Load(meshPath, { .obj = { .pThreadPool = pThreadPool } }); },
+			[this, meshPath](std::unique_ptr<MeshAsset> pAsset)
+			{
+				if (!pAsset)
+				{
+					std::cout << "Couldn't load " << meshPath << "\n";
+					return;
+				}
+
+				if (m_Backend == Backend::Software)
+				{
+					std::cout << "Mesh " << (pAsset->IsFromCache() ? "loaded from cache (warm start)" : "imported from OBJ (cold start)") << "\n";
+					m_pMeshAsset = std::move(pAsset);
+					return;
+				}
+
+				//Binds whichever maps are resident by now, the rest follow through BindMaps
+				m_pMesh = new Mesh{ m_pDevice, pAsset->GetVertices(), pAsset->GetIndices(), pAsset->GetLODs(), pAsset->GetMeshlets(),
+					m_pFallbackDiffuseTexture, m_pFallbackNormalTexture, m_pFallbackSpecularGlossTexture, m_pFallbackSpecularGlossTexture, Effect::VertexFormat::Compact };
+				BindMaps();
+				std::cout << "Mesh " << (pAsset->IsFromCache() ? "loaded from cache (warm start)" : "imported from OBJ (cold start)") << "\n";
+			});
 	}
 
-	void Renderer::InitializeMesh()
+	void Renderer::BindMaps() const
 	{
-		std::vector<Vertex> vertices{};
-		std::vector<uint32_t> indices{};
+		if (!m_pMesh)
+			return;
 
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
-		m_pMesh = new Mesh{ m_pDevice, vertices, indices,m_pDiffuseTexture,
-			m_pNormalTexture, m_pSpecularTexture, m_pGlossinessTexture };
+		m_pMesh->SetPackedMaps(m_pDiffuseTexture ? m_pDiffuseTexture.get() : m_pFallbackDiffuseTexture, m_pNormalTexture ? m_pNormalTexture.get() : m_pFallbackNormalTexture,
+			m_pSpecularGlossTexture ? m_pSpecularGlossTexture.get() : m_pFallbackSpecularGlossTexture);
 	}
-}
+}
\ No newline at end of file
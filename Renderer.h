@@ -1,16 +1,30 @@
 #pragma once
 #include "Mesh.h"
 #include "Camera.h"
+#include "SoftwareRasterizer.h"
 
 struct SDL_Window;
 struct SDL_Surface;
 
 namespace dae
 {
+	class ThreadPool;
+	class AssetLoader;
+	class TextureManager;
+	class TextureStreamer;
+	class MeshAsset;
+
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		//What draws the frames: the D3D11 pipeline, or the same pipeline on the CPU blitted to the window surface
+		enum class Backend
+		{
+			DirectX,
+			Software
+		};
+
+		Renderer(SDL_Window* pWindow, Backend backend = Backend::DirectX);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -27,30 +41,64 @@ namespace dae
 		int m_Width{};
 		int m_Height{};
 
+		Backend m_Backend{};
 		bool m_IsInitialized{ false };
 
 		bool m_IsF2Pressed{ false };
 
 		bool m_UsesRotation{ true };
 		bool m_IsF5Pressed{ false };
+
+		//F6 cycles it on either backend, reversed also flips the camera's projection
+		DepthFormat m_DepthFormat{ DepthFormat::D24S8 };
+		bool m_IsF6Pressed{ false };
+
+		ThreadPool* m_pThreadPool{};
 		//DIRECTX
 		HRESULT InitializeDirectX();
+		//Of m_DepthFormat, replacing the last one, and bound with the render target
+		HRESULT CreateDepthBuffer();
 		ID3D11Device* m_pDevice{};
 		ID3D11DeviceContext* m_pDeviceContext{};
 		IDXGISwapChain* m_pSwapChain{};
 		ID3D11Texture2D* m_pDepthStencilBuffer{};
 		ID3D11DepthStencilView* m_pDepthStencilView{};
+		//Less, greater for reversed depth
+		ID3D11DepthStencilState* m_pDepthStencilState{};
 		ID3D11Resource* m_pRenderTargetBuffer{};
 		ID3D11RenderTargetView* m_pRenderTargetView{};
 
-		void InitializeMesh();
+		//Queues the mesh and the textures on the thread pool, they show up as they become resident
+		void LoadAssets();
+		void BindMaps() const;
+		AssetLoader* m_pAssetLoader{};
 		Mesh* m_pMesh{};
 
 		Camera m_Camera;
+		//Rotation of the mesh, shared by both backends
+		Matrix m_WorldMatrix{};
+
+		//Streams the mip levels of the maps the manager hands out
+		TextureStreamer* m_pTextureStreamer{};
+		TextureManager* m_pTextureManager{};
+		std::shared_ptr<Texture> m_pDiffuseTexture{};
+		std::shared_ptr<Texture> m_pNormalTexture{};
+		//Specular in rgb, glossiness in a
+		std::shared_ptr<Texture> m_pSpecularGlossTexture{};
+		//Bound until the maps above are loaded
+		Texture* m_pFallbackDiffuseTexture{};
+		Texture* m_pFallbackNormalTexture{};
+		Texture* m_pFallbackSpecularGlossTexture{};
 
-		Texture* m_pDiffuseTexture{};
-		Texture* m_pNormalTexture{};
-		Texture* m_pSpecularTexture{};
-		Texture* m_pGlossinessTexture{};
+		//SOFTWARE
+		void RenderSoftware() const;
+		SoftwareRasterizer* m_pSoftwareRasterizer{};
+		//F2 cycles it like the techniques of the DirectX backend
+		SamplerFilter m_SoftwareFilter{ SamplerFilter::Point };
+		//The rasterizer reads the vertices and maps straight from system memory, missing maps fall back like above
+		std::unique_ptr<MeshAsset> m_pMeshAsset{};
+		std::unique_ptr<CPUTexture> m_pSoftwareDiffuseTexture{};
+		std::unique_ptr<CPUTexture> m_pSoftwareNormalTexture{};
+		std::unique_ptr<CPUTexture> m_pSoftwareSpecularGlossTexture{};
 	};
 }
@@ -6,10 +6,16 @@ Texture2D gDiffuseMap : DiffuseMap;
 Texture2D gNormalMap : NormalMap;
 Texture2D gSpecularMap : SpecularMap;
 Texture2D gGlossinessMap : GlossinessMap;
+//Specular in rgb and glossiness in a, replaces the two maps above in the Packed techniques
+Texture2D gSpecularGlossMap : SpecularGlossMap;
 
 float4x4 gWorldMatrix : World;
 float4x4 gViewInverseMatrix : ViewInverse;
 
+//Dequantization of VS_INPUT_COMPACT positions: offset + unorm * scale
+float3 gPositionOffset;
+float3 gPositionScale;
+
 // -----------------------------------------------------
 // SamplerStates
 // -----------------------------------------------------
@@ -59,6 +65,15 @@ struct VS_INPUT
     float3 Tangent : TANGENT;
 };
 
+//Matches VertexCompact in Datatypes.h
+struct VS_INPUT_COMPACT
+{
+    float4 Position : POSITION;
+    float2 UV : TEXCOORD;
+    float2 Normal : NORMAL;
+    float2 Tangent : TANGENT;
+};
+
 struct VS_OUTPUT
 {
     float4 Position : SV_POSITION;
@@ -76,16 +91,36 @@ VS_OUTPUT VS(VS_INPUT input)
     VS_OUTPUT output = (VS_OUTPUT)0;
     output.Position = float4(input.Position,1.f);
     output.Position = mul(output.Position, gWorldViewProj);
+    output.WorldPosition = mul(float4(input.Position,1.f), gWorldMatrix);
     output.UV = input.UV;
     output.Normal = mul(normalize(input.Normal),(float3x3)gWorldMatrix);
     output.Tangent = mul(normalize(input.Tangent),(float3x3)gWorldMatrix);
     return output;
 }
 
+//Mirrors Quantization::DecodeOctahedral
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.f - abs(e.x) - abs(e.y));
+    const float t = saturate(-n.z);
+    n.xy += n.xy >= 0.f ? -t : t;
+    return normalize(n);
+}
+
+VS_OUTPUT VS_Compact(VS_INPUT_COMPACT input)
+{
+    VS_INPUT decoded = (VS_INPUT)0;
+    decoded.Position = gPositionOffset + input.Position.xyz * gPositionScale;
+    decoded.UV = input.UV;
+    decoded.Normal = DecodeOctahedral(input.Normal);
+    decoded.Tangent = DecodeOctahedral(input.Tangent);
+    return VS(decoded);
+}
+
 // -----------------------------------------------------
 // Pixel Shader
 // -----------------------------------------------------
-float4 PS_Combined(VS_OUTPUT input, SamplerState currentState) : SV_TARGET
+float4 Shade(VS_OUTPUT input, SamplerState currentState, float4 specularColor, float glossiness)
 {
 	const float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInverseMatrix[3].xyz);
 
@@ -93,8 +128,9 @@ float4 PS_Combined(VS_OUTPUT input, SamplerState currentState) : SV_TARGET
 	const float3 binormal = cross(input.Normal,input.Tangent);
 	const float3x4 tangentSpaceAxis = float3x4(input.Tangent,binormal,input.Normal,float3(0.f,0.f,0.f));
 
-	float3 sampledNormal = gNormalMap.Sample(currentState,input.UV).rgb;
-	sampledNormal = 2.f * sampledNormal - float3( 1.f,1.f,1.f );
+	//BC5 only keeps x and y, z is rebuilt from the unit length
+	const float2 sampledXY = 2.f * gNormalMap.Sample(currentState,input.UV).rg - float2( 1.f,1.f );
+	const float3 sampledNormal = float3( sampledXY, sqrt(saturate(1.f - dot(sampledXY,sampledXY))) );
 
 	const float3 normal = mul(sampledNormal,tangentSpaceAxis);
 
@@ -103,14 +139,27 @@ float4 PS_Combined(VS_OUTPUT input, SamplerState currentState) : SV_TARGET
 	const float intensity = 7.f ;
 	const float shinyness = 25.f ;
 
-	const float specularComponent =  gGlossinessMap.Sample(currentState, input.UV).r ;
-	const float4 specular = gSpecularMap.Sample(currentState, input.UV) * Phong(shinyness,specularComponent,-lightDir,viewDirection,normal);
+	const float4 specular = specularColor * Phong(shinyness,glossiness,-lightDir,viewDirection,normal);
 
 	const float4 finalColor = (Lambert(intensity, gDiffuseMap.Sample(currentState, input.UV)) + specular) * observedArea;
    	 return finalColor;
 	
 }
 
+//Four fetches from four textures
+float4 PS_Combined(VS_OUTPUT input, SamplerState currentState) : SV_TARGET
+{
+	return Shade(input, currentState, gSpecularMap.Sample(currentState, input.UV), gGlossinessMap.Sample(currentState, input.UV).r);
+}
+
+//Three fetches, specular and glossiness come from one texel
+float4 PS_CombinedPacked(VS_OUTPUT input, SamplerState currentState) : SV_TARGET
+{
+	//Alpha holds the glossiness, so the packed specular is opaque
+	const float4 specularGloss = gSpecularGlossMap.Sample(currentState, input.UV);
+	return Shade(input, currentState, float4(specularGloss.rgb, 1.f), specularGloss.a);
+}
+
 float4 PS_PointTechnique(VS_OUTPUT input) : SV_TARGET
 {
     return PS_Combined(input, samPoint);
@@ -126,6 +175,21 @@ float4 PS_AnisotropicTechnique(VS_OUTPUT input) : SV_TARGET
     return PS_Combined(input, samAnisotropic);
 }
 
+float4 PS_PointPackedTechnique(VS_OUTPUT input) : SV_TARGET
+{
+    return PS_CombinedPacked(input, samPoint);
+}
+
+float4 PS_LinearPackedTechnique(VS_OUTPUT input) : SV_TARGET
+{
+    return PS_CombinedPacked(input, samLinear);
+}
+
+float4 PS_AnisotropicPackedTechnique(VS_OUTPUT input) : SV_TARGET
+{
+    return PS_CombinedPacked(input, samAnisotropic);
+}
+
 
 
 
@@ -162,3 +226,95 @@ technique11 AnisotropicTechnique
     }
 }
 
+
+technique11 PointCompactTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_PointTechnique() ) );
+    }
+}
+
+technique11 LinearCompactTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_LinearTechnique() ) );
+    }
+}
+
+technique11 AnisotropicCompactTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_AnisotropicTechnique() ) );
+    }
+}
+
+
+technique11 PointPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_PointPackedTechnique() ) );
+    }
+}
+
+technique11 LinearPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_LinearPackedTechnique() ) );
+    }
+}
+
+technique11 AnisotropicPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_AnisotropicPackedTechnique() ) );
+    }
+}
+
+
+technique11 PointCompactPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_PointPackedTechnique() ) );
+    }
+}
+
+technique11 LinearCompactPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_LinearPackedTechnique() ) );
+    }
+}
+
+technique11 AnisotropicCompactPackedTechnique
+{
+    pass P0
+    {
+  	 SetVertexShader(CompileShader(vs_5_0, VS_Compact() ) );
+	 SetGeometryShader( NULL );
+	 SetPixelShader( CompileShader(ps_5_0, PS_AnisotropicPackedTechnique() ) );
+    }
+}
@@ -0,0 +1,1058 @@
+#include "pch.h"
+#include "SoftwareRasterizer.h"
+#include "CPUFeatures.h"
+#include "DepthFormat.h"
+#include "SoftwareShading.h"
+#include "ThreadPool.h"
+#include <bit>
+#include <cassert>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+#include <numeric>
+
+namespace dae
+{
+	namespace
+	{
+		//Lanes of the raster kernel: how many pixels of a row it handles at once and the operations on them. Every lane computes its
+		//pixel with the same float operations in the same order whatever the width, no FMA, so all kernels give bit-identical results.
+		struct ScalarLanes
+		{
+			static constexpr int width{ 1 };
+			using Float = float;
+			using Int = int32_t;
+
+			static Float Broadcast(float value) { return value; }
+			static Int BroadcastInt(int32_t value) { return value; }
+			//0, 1, 2 ... over the lanes
+			static Float Ramp() { return 0.f; }
+			//0, step, 2 * step ... over the lanes
+			static Int RampInt(int32_t) { return 0; }
+			static Float Load(const float* pValues) { return *pValues; }
+			static void Store(float* pValues, Float value) { *pValues = value; }
+			//A bit per lane whose three edge values are all >= 0
+			static uint32_t InsideMask(Int edge0, Int edge1, Int edge2) { return (edge0 | edge1 | edge2) >= 0; }
+			static uint32_t LessMask(Float left, Float right) { return left < right; }
+			//To the nearest integer, ties to even
+			static Float Round(Float value) { return std::nearbyint(value); }
+		};
+
+		struct FloatSSE { __m128 value; };
+		struct IntSSE { __m128i value; };
+		FloatSSE operator+(FloatSSE left, FloatSSE right) { return { _mm_add_ps(left.value, right.value) }; }
+		FloatSSE operator-(FloatSSE left, FloatSSE right) { return { _mm_sub_ps(left.value, right.value) }; }
+		FloatSSE operator*(FloatSSE left, FloatSSE right) { return { _mm_mul_ps(left.value, right.value) }; }
+		FloatSSE operator/(FloatSSE left, FloatSSE right) { return { _mm_div_ps(left.value, right.value) }; }
+		IntSSE operator+(IntSSE left, IntSSE right) { return { _mm_add_epi32(left.value, right.value) }; }
+
+		struct SSELanes
+		{
+			static constexpr int width{ 4 };
+			using Float = FloatSSE;
+			using Int = IntSSE;
+
+			static Float Broadcast(float value) { return { _mm_set1_ps(value) }; }
+			static Int BroadcastInt(int32_t value) { return { _mm_set1_epi32(value) }; }
+			static Float Ramp() { return { _mm_setr_ps(0.f, 1.f, 2.f, 3.f) }; }
+			static Int RampInt(int32_t step) { return { _mm_setr_epi32(0, step, step * 2, step * 3) }; }
+			static Float Load(const float* pValues) { return { _mm_loadu_ps(pValues) }; }
+			static void Store(float* pValues, Float value) { _mm_storeu_ps(pValues, value.value); }
+			static uint32_t InsideMask(Int edge0, Int edge1, Int edge2)
+			{
+				//The sign bit of the or is set where any edge is negative
+				const __m128i any = _mm_or_si128(_mm_or_si128(edge0.value, edge1.value), edge2.value);
+				return ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(any))) & 0xF;
+			}
+			static uint32_t LessMask(Float left, Float right) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(left.value, right.value))); }
+			//Through int32 in SSE2, ties to even like the others under the default rounding mode
+			static Float Round(Float value) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(value.value)) }; }
+		};
+
+		struct FloatAVX { __m256 value; };
+		struct IntAVX { __m256i value; };
+		DAE_TARGET_AVX2 FloatAVX operator+(FloatAVX left, FloatAVX right) { return { _mm256_add_ps(left.value, right.value) }; }
+		DAE_TARGET_AVX2 FloatAVX operator-(FloatAVX left, FloatAVX right) { return { _mm256_sub_ps(left.value, right.value) }; }
+		DAE_TARGET_AVX2 FloatAVX operator*(FloatAVX left, FloatAVX right) { return { _mm256_mul_ps(left.value, right.value) }; }
+		DAE_TARGET_AVX2 FloatAVX operator/(FloatAVX left, FloatAVX right) { return { _mm256_div_ps(left.value, right.value) }; }
+		DAE_TARGET_AVX2 IntAVX operator+(IntAVX left, IntAVX right) { return { _mm256_add_epi32(left.value, right.value) }; }
+
+		//Only ever runs after GetBestKernel found AVX2, inside RasterizeTriangleAVX
+		struct AVXLanes
+		{
+			static constexpr int width{ 8 };
+			using Float = FloatAVX;
+			using Int = IntAVX;
+
+			DAE_TARGET_AVX2 static Float Broadcast(float value) { return { _mm256_set1_ps(value) }; }
+			DAE_TARGET_AVX2 static Int BroadcastInt(int32_t value) { return { _mm256_set1_epi32(value) }; }
+			DAE_TARGET_AVX2 static Float Ramp() { return { _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f) }; }
+			DAE_TARGET_AVX2 static Int RampInt(int32_t step) { return { _mm256_setr_epi32(0, step, step * 2, step * 3, step * 4, step * 5, step * 6, step * 7) }; }
+			DAE_TARGET_AVX2 static Float Load(const float* pValues) { return { _mm256_loadu_ps(pValues) }; }
+			DAE_TARGET_AVX2 static void Store(float* pValues, Float value) { _mm256_storeu_ps(pValues, value.value); }
+			DAE_TARGET_AVX2 static uint32_t InsideMask(Int edge0, Int edge1, Int edge2)
+			{
+				const __m256i any = _mm256_or_si256(_mm256_or_si256(edge0.value, edge1.value), edge2.value);
+				return ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(any))) & 0xFF;
+			}
+			DAE_TARGET_AVX2 static uint32_t LessMask(Float left, Float right) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(left.value, right.value, _CMP_LT_OQ))); }
+			DAE_TARGET_AVX2 static Float Round(Float value) { return { _mm256_round_ps(value.value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+		};
+
+		//Helpers of SetupTrianglesAVX. Functions rather than lambdas: a lambda's conversion to a function pointer doesn't get the target.
+		DAE_TARGET_AVX2 __m256i LoadInts(const int32_t* pValues)
+		{
+			return _mm256_load_si256(reinterpret_cast<const __m256i*>(pValues));
+		}
+
+		//Twice the signed areas of 4 triangles in doubles
+		DAE_TARGET_AVX2 __m256d GetAreas(__m128i edgeY, __m128i sideX, __m128i edgeX, __m128i sideY)
+		{
+			return _mm256_sub_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(edgeY), _mm256_cvtepi32_pd(sideX)), _mm256_mul_pd(_mm256_cvtepi32_pd(edgeX), _mm256_cvtepi32_pd(sideY)));
+		}
+
+		//A bit per lane of the comparison of 8 doubles with 0
+		template<int comparison>
+		DAE_TARGET_AVX2 uint32_t CompareToZero(__m256d low, __m256d high)
+		{
+			return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(low, _mm256_setzero_pd(), comparison)))
+				| static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(high, _mm256_setzero_pd(), comparison))) << 4;
+		}
+
+		//Rounds towards negative infinity, unlike /
+		int FloorDivide(int64_t numerator, int64_t denominator)
+		{
+			return static_cast<int>(numerator >= 0 ? numerator / denominator : -((-numerator + denominator - 1) / denominator));
+		}
+	}
+
+	SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, ThreadPool* pThreadPool)
+		: m_Width{ width }
+		, m_Height{ height }
+		, m_pThreadPool{ pThreadPool }
+		, m_Kernel{ GetBestKernel() }
+		, m_ColorBuffer(size_t(width) * height)
+		, m_DepthBuffer(size_t(width) * height, 1.f)
+		, m_GuardBandX{ 2.f * m_GuardBandSize / width }
+		, m_GuardBandY{ 2.f * m_GuardBandSize / height }
+		, m_NumBlocksX{ (width + m_BlockSize - 1) / m_BlockSize }
+		, m_BlockDepths(size_t(m_NumBlocksX) * ((height + m_BlockSize - 1) / m_BlockSize))
+		, m_VertexProcessor{ pThreadPool }
+		, m_NumTilesX{ (width + m_TileSize - 1) / m_TileSize }
+		, m_NumTilesY{ (height + m_TileSize - 1) / m_TileSize }
+		, m_TileStats(size_t(m_NumTilesX) * m_NumTilesY)
+		, m_TileOrder(size_t(m_NumTilesX) * m_NumTilesY)
+		, m_TileDepths(size_t(m_NumTilesX) * m_NumTilesY)
+	{
+	}
+
+	RasterKernel SoftwareRasterizer::GetBestKernel()
+	{
+		//SSE2 is part of x64
+		return CPUFeatures::HasAVX2() ? RasterKernel::AVX2 : RasterKernel::SSE;
+	}
+
+	void SoftwareRasterizer::SetDepthFormat(DepthFormat format)
+	{
+		m_DepthFormat = format;
+		m_DepthLevels = static_cast<float>(DepthFormats::GetNumLevels(format));
+	}
+
+	void SoftwareRasterizer::Clear(const ColorRGB& color)
+	{
+		uint32_t texel{ 0xFF000000 };
+		const float channels[3]{ color.r, color.g, color.b };
+		for (int channel{}; channel < 3; ++channel)
+			texel |= static_cast<uint32_t>(Saturate(channels[channel]) * 255.f + 0.5f) << (channel * 8);
+
+		std::fill(m_ColorBuffer.begin(), m_ColorBuffer.end(), texel);
+		//Reversed depth is stored negated, its clear value of 0 as -0
+		const float clearDepth = DepthFormats::IsReversed(m_DepthFormat) ? -DepthFormats::GetClearDepth(m_DepthFormat) : DepthFormats::GetClearDepth(m_DepthFormat);
+		std::fill(m_DepthBuffer.begin(), m_DepthBuffer.end(), clearDepth);
+		std::fill(m_BlockDepths.begin(), m_BlockDepths.end(), DepthRange{ clearDepth, clearDepth });
+		std::fill(m_TileDepths.begin(), m_TileDepths.end(), DepthRange{ clearDepth, clearDepth });
+		m_Stats = {};
+		m_PipelineStatistics = {};
+	}
+
+	void SoftwareRasterizer::Draw(const DrawCall& drawCall)
+	{
+		const Stats previousStats = m_Stats;
+
+		//1. Vertex shader, skipped when the vertices and matrices are the last draw's
+		const uint64_t numTransformed = m_VertexProcessor.GetStats().numTransformed;
+		m_pVertices = &m_VertexProcessor.Process(drawCall.vertices, drawCall.worldMatrix, drawCall.worldViewProjMatrix);
+		m_Stats.numTransformedVertices += m_VertexProcessor.GetStats().numTransformed - numTransformed;
+
+		//2. Triangle setup and binning, a chunk of the draw per batch
+		const uint32_t numTriangles = static_cast<uint32_t>(drawCall.indices.size() / 3);
+		const uint32_t numThreads = m_pThreadPool ? m_pThreadPool->GetNumWorkers() + 1 : 1;
+		const uint32_t numChunks = std::clamp(numTriangles / m_MinChunkSize, 1u, numThreads * 4);
+		const size_t numTiles = m_TileStats.size();
+		if (m_Chunks.size() < numChunks)
+			m_Chunks.resize(numChunks);
+		const auto setupChunks = [this, &drawCall, numTriangles, numChunks, numTiles](size_t begin, size_t end)
+			{
+				for (size_t chunkIndex{ begin }; chunkIndex < end; ++chunkIndex)
+				{
+					Chunk& chunk = m_Chunks[chunkIndex];
+					chunk.triangles.clear();
+					chunk.bins.resize(numTiles);
+					for (std::vector<uint32_t>& bin : chunk.bins)
+						bin.clear();
+					chunk.clippedVertices.clear();
+					chunk.stats = {};
+
+					const size_t firstTriangle = size_t(numTriangles) * chunkIndex / numChunks;
+					const size_t lastTriangle = size_t(numTriangles) * (chunkIndex + 1) / numChunks;
+					//Counter-clockwise front faces are flipped to clockwise by swapping two corners
+					const bool isFlipped = drawCall.isFrontCounterClockwise;
+					if (m_Kernel == RasterKernel::AVX2)
+						SetupTrianglesAVX(&drawCall.indices[firstTriangle * 3], lastTriangle - firstTriangle, isFlipped, chunk);
+					else
+					{
+						for (size_t triangleIndex{ firstTriangle }; triangleIndex < lastTriangle; ++triangleIndex)
+						{
+							const uint32_t* pIndices = &drawCall.indices[triangleIndex * 3];
+							SetupTriangle(pIndices[0], pIndices[isFlipped ? 2 : 1], pIndices[isFlipped ? 1 : 2], chunk);
+						}
+					}
+					chunk.stats.numRasterized = static_cast<uint32_t>(chunk.triangles.size());
+				}
+			};
+		const auto setupStart = std::chrono::steady_clock::now();
+		if (m_pThreadPool)
+			m_pThreadPool->ParallelFor(numChunks, setupChunks);
+		else
+			setupChunks(0, numChunks);
+		m_Stats.setupMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - setupStart).count();
+
+		m_Stats.numTriangles += numTriangles;
+		for (uint32_t chunkIndex{}; chunkIndex < numChunks; ++chunkIndex)
+		{
+			const Stats& chunkStats = m_Chunks[chunkIndex].stats;
+			m_Stats.numOutside += chunkStats.numOutside;
+			m_Stats.numInside += chunkStats.numInside;
+			m_Stats.numGuardBand += chunkStats.numGuardBand;
+			m_Stats.numClipped += chunkStats.numClipped;
+			m_Stats.numClippedTriangles += chunkStats.numClippedTriangles;
+			m_Stats.numBackFacing += chunkStats.numBackFacing;
+			m_Stats.numDegenerate += chunkStats.numDegenerate;
+			m_Stats.numMissingSamples += chunkStats.numMissingSamples;
+			m_Stats.numOutOfRange += chunkStats.numOutOfRange;
+			m_Stats.numRasterized += chunkStats.numRasterized;
+			m_Stats.numBinned += chunkStats.numBinned;
+		}
+
+		//3. Rasterization and pixel shader, a tile at a time so every tile has one owner. Tiles with the most triangles go first.
+		m_PixelShader = m_IsSpecializedShading ? SoftwareShading::GetPixelShader(drawCall) : SoftwareShading::ShadeGeneric;
+		for (size_t tile{}; tile < numTiles; ++tile)
+		{
+			m_TileStats[tile] = {};
+			for (uint32_t chunkIndex{}; chunkIndex < numChunks; ++chunkIndex)
+				m_TileStats[tile].numTriangles += static_cast<uint32_t>(m_Chunks[chunkIndex].bins[tile].size());
+		}
+		std::iota(m_TileOrder.begin(), m_TileOrder.end(), 0);
+		std::stable_sort(m_TileOrder.begin(), m_TileOrder.end(), [this](uint32_t left, uint32_t right) { return m_TileStats[left].numTriangles > m_TileStats[right].numTriangles; });
+
+		m_NumDrawChunks = numChunks;
+		const auto rasterizeTile = [this, &drawCall](size_t index, uint32_t thread) { RasterizeTile(m_TileOrder[index], drawCall, thread); };
+		if (m_pThreadPool)
+			m_Stats.numSteals += m_pThreadPool->ParallelForStealing(numTiles, rasterizeTile);
+		else
+		{
+			for (size_t index{}; index < numTiles; ++index)
+				rasterizeTile(index, 0);
+		}
+
+		for (const TileStats& tileStats : m_TileStats)
+		{
+			m_Stats.numPixelsCovered += tileStats.numPixelsCovered;
+			m_Stats.numPixelsShaded += tileStats.numPixelsShaded;
+			m_Stats.numHiZTriangles += tileStats.numHiZTriangles;
+			m_Stats.numHiZBlocks += tileStats.numHiZBlocks;
+			m_Stats.numHiZPixels += tileStats.numHiZPixels;
+		}
+
+		//The draw's share of the stats as the GPU counts them
+		m_PipelineStatistics.numIAVertices += uint64_t(numTriangles) * 3;
+		m_PipelineStatistics.numIAPrimitives += numTriangles;
+		m_PipelineStatistics.numVSInvocations += m_Stats.numTransformedVertices - previousStats.numTransformedVertices;
+		m_PipelineStatistics.numCInvocations += numTriangles;
+		m_PipelineStatistics.numCPrimitives += (m_Stats.numInside - previousStats.numInside) + (m_Stats.numGuardBand - previousStats.numGuardBand)
+			+ (m_Stats.numClippedTriangles - previousStats.numClippedTriangles) - (m_Stats.numOutOfRange - previousStats.numOutOfRange);
+		m_PipelineStatistics.numRasterizedPrimitives += m_Stats.numRasterized - previousStats.numRasterized;
+		const uint64_t numPassed = m_Stats.numPixelsShaded - previousStats.numPixelsShaded;
+		m_PipelineStatistics.numPSInvocations += drawCall.isDepthOnly ? 0 : numPassed;
+		m_PipelineStatistics.numEarlyZRejects += m_Stats.numPixelsCovered - previousStats.numPixelsCovered - numPassed;
+	}
+
+	void SoftwareRasterizer::SetupTriangle(uint32_t index0, uint32_t index1, uint32_t index2, Chunk& chunk) const
+	{
+		if (index0 == index1 || index1 == index2 || index2 == index0)
+		{
+			++chunk.stats.numDegenerate;
+			return;
+		}
+		const std::vector<uint8_t>& clipCodes = m_pVertices->clipCodes;
+		const uint8_t codes[3]{ clipCodes[index0], clipCodes[index1], clipCodes[index2] };
+		if ((codes[0] & codes[1] & codes[2]) != 0)
+		{
+			++chunk.stats.numOutside;
+			return;
+		}
+
+		TriangleSetup triangle{};
+		triangle.vertices[0] = index0;
+		triangle.vertices[1] = index1;
+		triangle.vertices[2] = index2;
+		const Vector4 positions[3]{ m_pVertices->GetPosition(index0), m_pVertices->GetPosition(index1), m_pVertices->GetPosition(index2) };
+		const uint8_t anyCodes = codes[0] | codes[1] | codes[2];
+		if (anyCodes == 0)
+		{
+			++chunk.stats.numInside;
+			AddTriangle(triangle, positions, chunk);
+			return;
+		}
+
+		//Off screen corners in front of the eye are fine as long as they stay in the guard band, the bounds scissor the rest
+		bool isInGuardBand{ (anyCodes & (ClipNear | ClipFar)) == 0 };
+		for (int corner{}; corner < 3 && isInGuardBand; ++corner)
+		{
+			const Vector4& position = positions[corner];
+			isInGuardBand = m_IsGuardBandEnabled && std::abs(position.x) <= m_GuardBandX * position.w && std::abs(position.y) <= m_GuardBandY * position.w;
+		}
+		if (isInGuardBand)
+		{
+			++chunk.stats.numGuardBand;
+			AddTriangle(triangle, positions, chunk);
+			return;
+		}
+		++chunk.stats.numClipped;
+		ClipTriangle(index0, index1, index2, chunk);
+	}
+
+	DAE_TARGET_AVX2 void SoftwareRasterizer::SetupTrianglesAVX(const uint32_t* pIndices, size_t numTriangles, bool isFlipped, Chunk& chunk) const
+	{
+		const std::vector<uint8_t>& clipCodes = m_pVertices->clipCodes;
+		const auto& streams = m_pVertices->streams;
+		const __m256 signBit = _mm256_set1_ps(-0.f);
+		const __m256 one = _mm256_set1_ps(1.f), half = _mm256_set1_ps(0.5f);
+		const __m256 guardBandX = _mm256_set1_ps(m_GuardBandX), guardBandY = _mm256_set1_ps(m_GuardBandY);
+		const __m256 width = _mm256_set1_ps(static_cast<float>(m_Width)), height = _mm256_set1_ps(static_cast<float>(m_Height));
+		const __m256 subpixelScale = _mm256_set1_ps(static_cast<float>(m_SubpixelScale)), maxCoordinate = _mm256_set1_ps(m_MaxCoordinate);
+		//std::lround: towards zero, then away from it when the part cut off is at least a half
+		const auto roundHalfAway = [half, one](__m256 value) DAE_TARGET_AVX2
+			{
+				const __m256 truncated = _mm256_round_ps(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+				const __m256 fraction = _mm256_sub_ps(value, truncated);
+				const __m256 up = _mm256_and_ps(_mm256_cmp_ps(fraction, half, _CMP_GE_OQ), one);
+				const __m256 down = _mm256_and_ps(_mm256_cmp_ps(fraction, _mm256_sub_ps(_mm256_setzero_ps(), half), _CMP_LE_OQ), one);
+				return _mm256_cvttps_epi32(_mm256_sub_ps(_mm256_add_ps(truncated, up), down));
+			};
+
+		for (size_t first{}; first < numTriangles; first += 8)
+		{
+			//Lanes past the end repeat the last triangle and are ignored
+			const int numLanes = static_cast<int>(std::min<size_t>(8, numTriangles - first));
+			alignas(32) int32_t indices[3][8]{};
+			for (int lane{}; lane < 8; ++lane)
+			{
+				const uint32_t* pTriangle = pIndices + (first + std::min(lane, numLanes - 1)) * 3;
+				indices[0][lane] = static_cast<int32_t>(pTriangle[0]);
+				indices[1][lane] = static_cast<int32_t>(pTriangle[isFlipped ? 2 : 1]);
+				indices[2][lane] = static_cast<int32_t>(pTriangle[isFlipped ? 1 : 2]);
+			}
+
+			//What SnapTriangle and CullTriangle do, a triangle per lane
+			alignas(32) int32_t x[3][8], y[3][8];
+			alignas(32) float z[3][8], invW[3][8];
+			uint32_t guardBandMask{ 0xFF }, rangeMask{ 0xFF };
+			__m256i minX{}, maxX{}, minY{}, maxY{};
+			for (int corner{}; corner < 3; ++corner)
+			{
+				const __m256i vertices = _mm256_load_si256(reinterpret_cast<const __m256i*>(indices[corner]));
+				const __m256 positionX = _mm256_i32gather_ps(streams[TransformedVertices::PositionX].data(), vertices, 4);
+				const __m256 positionY = _mm256_i32gather_ps(streams[TransformedVertices::PositionY].data(), vertices, 4);
+				const __m256 positionZ = _mm256_i32gather_ps(streams[TransformedVertices::PositionZ].data(), vertices, 4);
+				const __m256 positionW = _mm256_i32gather_ps(streams[TransformedVertices::PositionW].data(), vertices, 4);
+				guardBandMask &= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_and_ps(
+					_mm256_cmp_ps(_mm256_andnot_ps(signBit, positionX), _mm256_mul_ps(guardBandX, positionW), _CMP_LE_OQ),
+					_mm256_cmp_ps(_mm256_andnot_ps(signBit, positionY), _mm256_mul_ps(guardBandY, positionW), _CMP_LE_OQ))));
+
+				const __m256 cornerInvW = _mm256_div_ps(one, positionW);
+				const __m256 screenX = _mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(positionX, cornerInvW), one), half), width);
+				const __m256 screenY = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(positionY, cornerInvW)), half), height);
+				rangeMask &= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(_mm256_andnot_ps(signBit, screenX), maxCoordinate, _CMP_LE_OQ),
+					_mm256_cmp_ps(_mm256_andnot_ps(signBit, screenY), maxCoordinate, _CMP_LE_OQ))));
+				const __m256i snappedX = roundHalfAway(_mm256_mul_ps(screenX, subpixelScale));
+				const __m256i snappedY = roundHalfAway(_mm256_mul_ps(screenY, subpixelScale));
+				_mm256_store_si256(reinterpret_cast<__m256i*>(x[corner]), snappedX);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(y[corner]), snappedY);
+				_mm256_store_ps(z[corner], _mm256_mul_ps(positionZ, cornerInvW));
+				_mm256_store_ps(invW[corner], cornerInvW);
+				minX = corner == 0 ? snappedX : _mm256_min_epi32(minX, snappedX);
+				maxX = corner == 0 ? snappedX : _mm256_max_epi32(maxX, snappedX);
+				minY = corner == 0 ? snappedY : _mm256_min_epi32(minY, snappedY);
+				maxY = corner == 0 ? snappedY : _mm256_max_epi32(maxY, snappedY);
+			}
+
+			//The determinant's products reach 2^40 at most, exact in doubles
+			const __m256i edgeY = _mm256_sub_epi32(LoadInts(y[2]), LoadInts(y[1])), edgeX = _mm256_sub_epi32(LoadInts(x[2]), LoadInts(x[1]));
+			const __m256i sideX = _mm256_sub_epi32(LoadInts(x[1]), LoadInts(x[0])), sideY = _mm256_sub_epi32(LoadInts(y[1]), LoadInts(y[0]));
+			const __m256d areaLow = GetAreas(_mm256_castsi256_si128(edgeY), _mm256_castsi256_si128(sideX), _mm256_castsi256_si128(edgeX), _mm256_castsi256_si128(sideY));
+			const __m256d areaHigh = GetAreas(_mm256_extracti128_si256(edgeY, 1), _mm256_extracti128_si256(sideX, 1), _mm256_extracti128_si256(edgeX, 1),
+				_mm256_extracti128_si256(sideY, 1));
+			const uint32_t frontMask = CompareToZero<_CMP_GT_OQ>(areaLow, areaHigh);
+			const uint32_t zeroMask = CompareToZero<_CMP_EQ_OQ>(areaLow, areaHigh);
+
+			//Pixel centers in the bounds, floor divisions by 16 being arithmetic shifts
+			const __m256i halfPixel = _mm256_set1_epi32(m_SubpixelScale / 2);
+			alignas(32) int32_t bounds[4][8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[0]), _mm256_max_epi32(_mm256_sub_epi32(_mm256_setzero_si256(),
+				_mm256_srai_epi32(_mm256_sub_epi32(halfPixel, minX), m_SubpixelBits)), _mm256_setzero_si256()));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[1]), _mm256_max_epi32(_mm256_sub_epi32(_mm256_setzero_si256(),
+				_mm256_srai_epi32(_mm256_sub_epi32(halfPixel, minY), m_SubpixelBits)), _mm256_setzero_si256()));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[2]), _mm256_min_epi32(_mm256_srai_epi32(_mm256_sub_epi32(maxX, halfPixel), m_SubpixelBits),
+				_mm256_set1_epi32(static_cast<int32_t>(m_Width) - 1)));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(bounds[3]), _mm256_min_epi32(_mm256_srai_epi32(_mm256_sub_epi32(maxY, halfPixel), m_SubpixelBits),
+				_mm256_set1_epi32(static_cast<int32_t>(m_Height) - 1)));
+
+			//In order, so the chunk's triangles stay in draw order
+			Stats& stats = chunk.stats;
+			for (int lane{}; lane < numLanes; ++lane)
+			{
+				const uint32_t index0 = indices[0][lane], index1 = indices[1][lane], index2 = indices[2][lane];
+				if (index0 == index1 || index1 == index2 || index2 == index0)
+				{
+					++stats.numDegenerate;
+					continue;
+				}
+				const uint8_t codes[3]{ clipCodes[index0], clipCodes[index1], clipCodes[index2] };
+				if ((codes[0] & codes[1] & codes[2]) != 0)
+				{
+					++stats.numOutside;
+					continue;
+				}
+				const uint8_t anyCodes = codes[0] | codes[1] | codes[2];
+				const uint32_t bit{ 1u << lane };
+				if (anyCodes == 0)
+					++stats.numInside;
+				else if ((anyCodes & (ClipNear | ClipFar)) == 0 && m_IsGuardBandEnabled && (guardBandMask & bit) != 0)
+					++stats.numGuardBand;
+				else
+				{
+					++stats.numClipped;
+					ClipTriangle(index0, index1, index2, chunk);
+					continue;
+				}
+
+				if ((rangeMask & bit) == 0)
+				{
+					++stats.numOutOfRange;
+					continue;
+				}
+				if ((frontMask & bit) == 0)
+				{
+					++((zeroMask & bit) != 0 ? stats.numDegenerate : stats.numBackFacing);
+					continue;
+				}
+				TriangleSetup triangle{};
+				triangle.vertices[0] = index0;
+				triangle.vertices[1] = index1;
+				triangle.vertices[2] = index2;
+				triangle.minX = bounds[0][lane];
+				triangle.minY = bounds[1][lane];
+				triangle.maxX = bounds[2][lane];
+				triangle.maxY = bounds[3][lane];
+				if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+				{
+					++stats.numMissingSamples;
+					continue;
+				}
+				ScreenTriangle screen{};
+				for (int corner{}; corner < 3; ++corner)
+				{
+					screen.x[corner] = x[corner][lane];
+					screen.y[corner] = y[corner][lane];
+					screen.z[corner] = z[corner][lane];
+					screen.invW[corner] = invW[corner][lane];
+				}
+				SetupPlanes(triangle, screen, chunk);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::ClipTriangle(uint32_t index0, uint32_t index1, uint32_t index2, Chunk& chunk) const
+	{
+		using Corner = std::array<float, TransformedVertices::NumStreams>;
+		Corner polygons[2][m_MaxClippedCorners]{};
+		int numCorners{ 3 };
+		const uint32_t indices[3]{ index0, index1, index2 };
+		for (int corner{}; corner < 3; ++corner)
+		{
+			for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+				polygons[0][corner][stream] = m_pVertices->streams[stream][indices[corner]];
+		}
+
+		//Signed distances to the planes in the order of the ClipCode bits, inside is >= 0. Without the guard band x and y are clipped
+		//at the frustum.
+		const float guardBandX = m_IsGuardBandEnabled ? m_GuardBandX : 1.f, guardBandY = m_IsGuardBandEnabled ? m_GuardBandY : 1.f;
+		const auto getDistance = [guardBandX, guardBandY](const Corner& corner, int plane)
+			{
+				const float x = corner[TransformedVertices::PositionX], y = corner[TransformedVertices::PositionY];
+				const float z = corner[TransformedVertices::PositionZ], w = corner[TransformedVertices::PositionW];
+				switch (plane)
+				{
+				case 0: return x + guardBandX * w;
+				case 1: return guardBandX * w - x;
+				case 2: return y + guardBandY * w;
+				case 3: return guardBandY * w - y;
+				case 4: return z;
+				default: return w - z;
+				}
+			};
+
+		//Near and far first, the others are only meaningful in front of the eye. A plane no corner is outside of is skipped.
+		int current{};
+		for (const int plane : { 4, 5, 0, 1, 2, 3 })
+		{
+			const Corner* pInput = polygons[current];
+			Corner* pOutput = polygons[1 - current];
+			float distances[m_MaxClippedCorners]{};
+			bool isAnyOutside{};
+			for (int corner{}; corner < numCorners; ++corner)
+			{
+				distances[corner] = getDistance(pInput[corner], plane);
+				isAnyOutside |= distances[corner] < 0.f;
+			}
+			if (!isAnyOutside)
+				continue;
+
+			int numOutput{};
+			for (int corner{}; corner < numCorners; ++corner)
+			{
+				const int next{ (corner + 1) % numCorners };
+				const bool isInside = distances[corner] >= 0.f, isNextInside = distances[next] >= 0.f;
+				if (isInside)
+					pOutput[numOutput++] = pInput[corner];
+				if (isInside == isNextInside)
+					continue;
+
+				//Always from the inside corner towards the outside one, so a neighbor clipping the shared edge gets the same corner
+				const int in{ isInside ? corner : next }, out{ isInside ? next : corner };
+				const float t = distances[in] / (distances[in] - distances[out]);
+				Corner& intersection = pOutput[numOutput++];
+				for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+					intersection[stream] = pInput[in][stream] + (pInput[out][stream] - pInput[in][stream]) * t;
+			}
+			assert(numOutput <= m_MaxClippedCorners);
+			numCorners = numOutput;
+			current = 1 - current;
+			if (numCorners < 3)
+				return;
+		}
+
+		const Corner* pPolygon = polygons[current];
+		for (int corner{}; corner < numCorners; ++corner)
+		{
+			//Numerically a corner can still end up at w <= 0 when the projection has no near plane, like one with w = z
+			if (!(pPolygon[corner][TransformedVertices::PositionW] > 0.f))
+				return;
+		}
+		const uint32_t firstVertex = static_cast<uint32_t>(chunk.clippedVertices.size() / TransformedVertices::NumStreams);
+		for (int corner{}; corner < numCorners; ++corner)
+			chunk.clippedVertices.insert(chunk.clippedVertices.end(), pPolygon[corner].begin(), pPolygon[corner].end());
+
+		//A fan around the first corner keeps the winding
+		for (int corner{ 1 }; corner + 1 < numCorners; ++corner)
+		{
+			const int fan[3]{ 0, corner, corner + 1 };
+			TriangleSetup triangle{};
+			triangle.isClipped = true;
+			Vector4 positions[3]{};
+			for (int fanCorner{}; fanCorner < 3; ++fanCorner)
+			{
+				const Corner& values = pPolygon[fan[fanCorner]];
+				triangle.vertices[fanCorner] = firstVertex + fan[fanCorner];
+				positions[fanCorner] = { values[TransformedVertices::PositionX], values[TransformedVertices::PositionY], values[TransformedVertices::PositionZ],
+					values[TransformedVertices::PositionW] };
+			}
+			++chunk.stats.numClippedTriangles;
+			AddTriangle(triangle, positions, chunk);
+		}
+	}
+
+	void SoftwareRasterizer::AddTriangle(TriangleSetup& triangle, const Vector4 (&positions)[3], Chunk& chunk) const
+	{
+		ScreenTriangle screen{};
+		if (!SnapTriangle(positions, screen))
+		{
+			++chunk.stats.numOutOfRange;
+			return;
+		}
+		if (CullTriangle(screen, triangle, chunk.stats))
+			SetupPlanes(triangle, screen, chunk);
+	}
+
+	bool SoftwareRasterizer::SnapTriangle(const Vector4 (&positions)[3], ScreenTriangle& screen) const
+	{
+		for (int corner{}; corner < 3; ++corner)
+		{
+			const Vector4& position = positions[corner];
+			screen.invW[corner] = 1.f / position.w;
+			const float screenX = (position.x * screen.invW[corner] + 1.f) * 0.5f * m_Width;
+			const float screenY = (1.f - position.y * screen.invW[corner]) * 0.5f * m_Height;
+			if (!(std::abs(screenX) <= m_MaxCoordinate && std::abs(screenY) <= m_MaxCoordinate))
+				return false;
+			screen.x[corner] = static_cast<int32_t>(std::lround(screenX * m_SubpixelScale));
+			screen.y[corner] = static_cast<int32_t>(std::lround(screenY * m_SubpixelScale));
+			screen.z[corner] = position.z * screen.invW[corner];
+		}
+		return true;
+	}
+
+	bool SoftwareRasterizer::CullTriangle(const ScreenTriangle& screen, TriangleSetup& triangle, Stats& stats) const
+	{
+		const int32_t* x = screen.x;
+		const int32_t* y = screen.y;
+		//Twice the area in subpixels, exact. Clockwise on screen is front facing and positive.
+		const int64_t area = int64_t(y[2] - y[1]) * (x[1] - x[0]) - int64_t(x[2] - x[1]) * (y[1] - y[0]);
+		if (area <= 0)
+		{
+			++(area == 0 ? stats.numDegenerate : stats.numBackFacing);
+			return false;
+		}
+
+		//Pixel x has its center at subpixel x * 16 + 8
+		constexpr int32_t halfPixel{ m_SubpixelScale / 2 };
+		const auto [minX, maxX] = std::minmax({ x[0], x[1], x[2] });
+		const auto [minY, maxY] = std::minmax({ y[0], y[1], y[2] });
+		triangle.minX = std::max(-FloorDivide(halfPixel - minX, m_SubpixelScale), 0);
+		triangle.minY = std::max(-FloorDivide(halfPixel - minY, m_SubpixelScale), 0);
+		triangle.maxX = std::min(FloorDivide(maxX - halfPixel, m_SubpixelScale), static_cast<int>(m_Width) - 1);
+		triangle.maxY = std::min(FloorDivide(maxY - halfPixel, m_SubpixelScale), static_cast<int>(m_Height) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			++stats.numMissingSamples;
+			return false;
+		}
+		return true;
+	}
+
+	void SoftwareRasterizer::SetupPlanes(TriangleSetup& triangle, const ScreenTriangle& screen, Chunk& chunk) const
+	{
+		const int32_t* x = screen.x;
+		const int32_t* y = screen.y;
+		const float* z = screen.z;
+		std::copy(std::begin(screen.invW), std::end(screen.invW), triangle.invW);
+
+		//Edge i runs from corner i + 1 to corner i + 2, the inside of a front facing triangle is positive
+		for (int edge{}; edge < 3; ++edge)
+		{
+			const int from{ (edge + 1) % 3 }, to{ (edge + 2) % 3 };
+			const int32_t dx = x[to] - x[from];
+			const int32_t dy = y[to] - y[from];
+			triangle.edgeA[edge] = -dy;
+			triangle.edgeB[edge] = dx;
+			triangle.edgeC[edge] = int64_t(dy) * x[from] - int64_t(dx) * y[from];
+			//Top-left fill rule: pixels exactly on a top or left edge belong to this triangle
+			triangle.edgeBias[edge] = (dy == 0 && dx > 0) || dy < 0 ? 0 : -1;
+		}
+		const int64_t area = int64_t(triangle.edgeA[0]) * x[0] + int64_t(triangle.edgeB[0]) * y[0] + triangle.edgeC[0];
+
+		//Bounds around a single pixel center, the typical tiny triangle: it covers that one or nothing
+		if (triangle.minX == triangle.maxX && triangle.minY == triangle.maxY)
+		{
+			const int64_t sampleX = int64_t(triangle.minX) * m_SubpixelScale + m_SubpixelScale / 2;
+			const int64_t sampleY = int64_t(triangle.minY) * m_SubpixelScale + m_SubpixelScale / 2;
+			for (int edge{}; edge < 3; ++edge)
+			{
+				if (triangle.edgeA[edge] * sampleX + triangle.edgeB[edge] * sampleY + triangle.edgeC[edge] + triangle.edgeBias[edge] < 0)
+				{
+					++chunk.stats.numMissingSamples;
+					return;
+				}
+			}
+		}
+
+		//Barycentrics are the edge functions over the area. The planes are relative to the bounds so the floats keep their precision
+		//far from the origin. Depth and 1/w are linear in the barycentrics.
+		triangle.planeOriginX = triangle.minX;
+		triangle.planeOriginY = triangle.minY;
+		double planes[NumPlanes][3]{};
+		for (int plane{ Barycentric1 }; plane <= Barycentric2; ++plane)
+		{
+			const int edge{ plane - Barycentric1 + 1 };
+			const double a = double(triangle.edgeA[edge]) * m_SubpixelScale / area;
+			const double b = double(triangle.edgeB[edge]) * m_SubpixelScale / area;
+			planes[plane][0] = a;
+			planes[plane][1] = b;
+			planes[plane][2] = a * triangle.planeOriginX + b * triangle.planeOriginY + double(triangle.edgeC[edge]) / area;
+		}
+		//Reversed depth negated, nearer is still less. Negating is exact, so the buffer holds -depth to the bit.
+		const float depthSign = DepthFormats::IsReversed(m_DepthFormat) ? -1.f : 1.f;
+		const float cornerValues[2][3]{ { z[0] * depthSign, z[1] * depthSign, z[2] * depthSign }, { triangle.invW[0], triangle.invW[1], triangle.invW[2] } };
+		for (int plane{ Depth }; plane <= InvW; ++plane)
+		{
+			const float* pValues = cornerValues[plane - Depth];
+			for (int coefficient{}; coefficient < 3; ++coefficient)
+			{
+				planes[plane][coefficient] = double(pValues[1] - pValues[0]) * planes[Barycentric1][coefficient]
+					+ double(pValues[2] - pValues[0]) * planes[Barycentric2][coefficient];
+			}
+			planes[plane][2] += pValues[0];
+		}
+		for (int plane{}; plane < NumPlanes; ++plane)
+		{
+			triangle.planeA[plane] = static_cast<float>(planes[plane][0]);
+			triangle.planeB[plane] = static_cast<float>(planes[plane][1]);
+			triangle.planeC[plane] = static_cast<float>(planes[plane][2]);
+		}
+
+		BinTriangle(triangle, static_cast<uint32_t>(chunk.triangles.size()), chunk);
+		chunk.triangles.push_back(triangle);
+	}
+
+	void SoftwareRasterizer::BinTriangle(const TriangleSetup& triangle, uint32_t index, Chunk& chunk) const
+	{
+		const uint32_t minTileX = triangle.minX / m_TileSize, maxTileX = triangle.maxX / m_TileSize;
+		const uint32_t minTileY = triangle.minY / m_TileSize, maxTileY = triangle.maxY / m_TileSize;
+		const bool isSingleTile = minTileX == maxTileX && minTileY == maxTileY;
+		for (uint32_t tileY{ minTileY }; tileY <= maxTileY; ++tileY)
+		{
+			for (uint32_t tileX{ minTileX }; tileX <= maxTileX; ++tileX)
+			{
+				//The pixel center of the tile furthest inside each edge, if even that one is outside no pixel of the tile is covered
+				bool isOutside{ false };
+				for (int edge{}; edge < 3 && !isSingleTile && !isOutside; ++edge)
+				{
+					const int64_t x = int64_t(triangle.edgeA[edge] > 0 ? (tileX + 1) * m_TileSize - 1 : tileX * m_TileSize) * m_SubpixelScale + m_SubpixelScale / 2;
+					const int64_t y = int64_t(triangle.edgeB[edge] > 0 ? (tileY + 1) * m_TileSize - 1 : tileY * m_TileSize) * m_SubpixelScale + m_SubpixelScale / 2;
+					isOutside = triangle.edgeA[edge] * x + triangle.edgeB[edge] * y + triangle.edgeC[edge] + triangle.edgeBias[edge] < 0;
+				}
+				if (isOutside)
+					continue;
+
+				chunk.bins[tileY * m_NumTilesX + tileX].push_back(index);
+				++chunk.stats.numBinned;
+			}
+		}
+	}
+
+	void SoftwareRasterizer::RasterizeTile(uint32_t tile, const DrawCall& drawCall, uint32_t thread)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const int tileMinX = static_cast<int>((tile % m_NumTilesX) * m_TileSize);
+		const int tileMinY = static_cast<int>((tile / m_NumTilesX) * m_TileSize);
+		const int tileMaxX = std::min(tileMinX + static_cast<int>(m_TileSize), static_cast<int>(m_Width)) - 1;
+		const int tileMaxY = std::min(tileMinY + static_cast<int>(m_TileSize), static_cast<int>(m_Height)) - 1;
+
+		TileStats& tileStats = m_TileStats[tile];
+		for (uint32_t chunkIndex{}; chunkIndex < m_NumDrawChunks; ++chunkIndex)
+		{
+			const Chunk& chunk = m_Chunks[chunkIndex];
+			for (const uint32_t triangleIndex : chunk.bins[tile])
+			{
+				const TriangleSetup& triangle = chunk.triangles[triangleIndex];
+				const int minX = std::max(triangle.minX, tileMinX), minY = std::max(triangle.minY, tileMinY);
+				const int maxX = std::min(triangle.maxX, tileMaxX), maxY = std::min(triangle.maxY, tileMaxY);
+				switch (m_Kernel)
+				{
+				case RasterKernel::AVX2:
+					RasterizeTriangleAVX(triangle, chunk, drawCall, tile, minX, minY, maxX, maxY, tileStats);
+					break;
+				case RasterKernel::SSE:
+					RasterizeTriangle<SSELanes>(triangle, chunk, drawCall, tile, minX, minY, maxX, maxY, tileStats);
+					break;
+				default:
+					RasterizeTriangle<ScalarLanes>(triangle, chunk, drawCall, tile, minX, minY, maxX, maxY, tileStats);
+					break;
+				}
+			}
+		}
+		tileStats.thread = thread;
+		tileStats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	DAE_TARGET_AVX2 DAE_FLATTEN void SoftwareRasterizer::RasterizeTriangleAVX(const TriangleSetup& triangle, const Chunk& chunk, const DrawCall& drawCall, uint32_t tile, int minX, int minY,
+		int maxX, int maxY, TileStats& tileStats)
+	{
+		RasterizeTriangle<AVXLanes>(triangle, chunk, drawCall, tile, minX, minY, maxX, maxY, tileStats);
+	}
+
+	template<typename Lanes>
+	void SoftwareRasterizer::RasterizeTriangle(const TriangleSetup& triangle, const Chunk& chunk, const DrawCall& drawCall, uint32_t tile, int minX, int minY, int maxX, int maxY,
+		TileStats& tileStats)
+	{
+		using Float = typename Lanes::Float;
+		using Int = typename Lanes::Int;
+		constexpr int width{ Lanes::width };
+		assert(maxX - minX < static_cast<int>(m_TileSize) && maxY - minY < static_cast<int>(m_TileSize));
+
+		//Edge values at the first pixel center, in 64 bits since the triangle can reach far beyond the rectangle. An edge with the whole
+		//rectangle inside never fails and is left out, one with all of it outside rejects the triangle. Every value of an edge that
+		//crosses the rectangle lies within (|a| + |b|) * 16 * 71 of 0, which the coordinate limit keeps in 32 bits.
+		int32_t firstEdges[3]{}, stepsX[3]{}, stepsY[3]{};
+		for (int edge{}; edge < 3; ++edge)
+		{
+			const int64_t stepX = int64_t(triangle.edgeA[edge]) * m_SubpixelScale;
+			const int64_t stepY = int64_t(triangle.edgeB[edge]) * m_SubpixelScale;
+			const int64_t value = triangle.edgeA[edge] * (int64_t(minX) * m_SubpixelScale + m_SubpixelScale / 2)
+				+ triangle.edgeB[edge] * (int64_t(minY) * m_SubpixelScale + m_SubpixelScale / 2) + triangle.edgeC[edge] + triangle.edgeBias[edge];
+			const int64_t spanX = stepX * (maxX - minX), spanY = stepY * (maxY - minY);
+			if (value + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0) < 0)
+				return;
+			if (value + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0) >= 0)
+				continue;
+
+			firstEdges[edge] = static_cast<int32_t>(value);
+			stepsX[edge] = static_cast<int32_t>(stepX);
+			stepsY[edge] = static_cast<int32_t>(stepY);
+		}
+
+		//Behind everything in the tile the triangle is skipped before any setup, a stale far end is tightened first
+		if (m_IsHiZEnabled)
+		{
+			DepthRange& tileDepth = m_TileDepths[tile];
+			const float minDepth = GetDepthRange(triangle, minX, minY, maxX, maxY).first;
+			if (minDepth < tileDepth.max && tileDepth.isMaxStale)
+				UpdateTileMax(tile);
+			if (minDepth >= tileDepth.max)
+			{
+				++tileStats.numHiZTriangles;
+				tileStats.numHiZPixels += (maxX - minX + 1) * (maxY - minY + 1);
+				return;
+			}
+		}
+
+		//uv, normal, tangent and world position: corner 0 plus the perspective correct weights of corners 1 and 2 times their difference.
+		//uv / w and 1 / w are linear on screen, their steps per pixel give the uv derivatives of a quad without shading one.
+		constexpr int numAttributes{ 11 };
+		Float attributeBases[numAttributes], attributeDeltas1[numAttributes], attributeDeltas2[numAttributes];
+		Vector2 uvOverWDx{}, uvOverWDy{};
+		if (!drawCall.isDepthOnly)
+		{
+			//The attributes are the streams from U on in the same order
+			static_assert(TransformedVertices::NumStreams - TransformedVertices::U == numAttributes);
+			float cornerAttributes[3][numAttributes]{};
+			for (int corner{}; corner < 3; ++corner)
+			{
+				const uint32_t vertex = triangle.vertices[corner];
+				for (int attribute{}; attribute < numAttributes; ++attribute)
+				{
+					cornerAttributes[corner][attribute] = triangle.isClipped ? chunk.clippedVertices[vertex * TransformedVertices::NumStreams + TransformedVertices::U + attribute]
+						: m_pVertices->streams[TransformedVertices::U + attribute][vertex];
+				}
+			}
+			for (int attribute{}; attribute < numAttributes; ++attribute)
+			{
+				attributeBases[attribute] = Lanes::Broadcast(cornerAttributes[0][attribute]);
+				attributeDeltas1[attribute] = Lanes::Broadcast(cornerAttributes[1][attribute] - cornerAttributes[0][attribute]);
+				attributeDeltas2[attribute] = Lanes::Broadcast(cornerAttributes[2][attribute] - cornerAttributes[0][attribute]);
+			}
+
+			const float barycentricDx[3]{ -triangle.planeA[Barycentric1] - triangle.planeA[Barycentric2], triangle.planeA[Barycentric1], triangle.planeA[Barycentric2] };
+			const float barycentricDy[3]{ -triangle.planeB[Barycentric1] - triangle.planeB[Barycentric2], triangle.planeB[Barycentric1], triangle.planeB[Barycentric2] };
+			for (int corner{}; corner < 3; ++corner)
+			{
+				const Vector2 uv{ cornerAttributes[corner][0], cornerAttributes[corner][1] };
+				uvOverWDx += uv * (barycentricDx[corner] * triangle.invW[corner]);
+				uvOverWDy += uv * (barycentricDy[corner] * triangle.invW[corner]);
+			}
+		}
+		const Float uvOverWDxLanes[2]{ Lanes::Broadcast(uvOverWDx.x), Lanes::Broadcast(uvOverWDx.y) };
+		const Float uvOverWDyLanes[2]{ Lanes::Broadcast(uvOverWDy.x), Lanes::Broadcast(uvOverWDy.y) };
+		const Float invWDx = Lanes::Broadcast(triangle.planeA[InvW]);
+		const Float invWDy = Lanes::Broadcast(triangle.planeB[InvW]);
+		const Float cornerInvW1 = Lanes::Broadcast(triangle.invW[1]);
+		const Float cornerInvW2 = Lanes::Broadcast(triangle.invW[2]);
+		const Float one = Lanes::Broadcast(1.f);
+		//UNORM formats round to their steps before the test like the GPU does
+		const bool isQuantized{ m_DepthLevels != 0.f };
+		const Float depthLevels = Lanes::Broadcast(m_DepthLevels);
+
+		Float planesDx[NumPlanes];
+		for (int plane{}; plane < NumPlanes; ++plane)
+			planesDx[plane] = Lanes::Broadcast(triangle.planeA[plane]);
+		Int laneSteps[3], blockSteps[3];
+		for (int edge{}; edge < 3; ++edge)
+		{
+			laneSteps[edge] = Lanes::RampInt(stepsX[edge]);
+			blockSteps[edge] = Lanes::BroadcastInt(stepsX[edge] * width);
+		}
+
+		//What the lanes hand to the pixel shader
+		static_assert(width <= PixelInputs::maxPixels && numAttributes == PixelInputs::UDx);
+		PixelInputs inputs;
+		float laneDepths[width];
+
+		//Blocks of the triangle and tile aligned to the 8x8 grid, the far end of each is tested before any pixel in it
+		for (int blockTop{ minY - minY % static_cast<int>(m_BlockSize) }; blockTop <= maxY; blockTop += m_BlockSize)
+		{
+			const int top = std::max(blockTop, minY), bottom = std::min(blockTop + static_cast<int>(m_BlockSize) - 1, maxY);
+			for (int blockLeft{ minX - minX % static_cast<int>(m_BlockSize) }; blockLeft <= maxX; blockLeft += m_BlockSize)
+			{
+				const int left = std::max(blockLeft, minX), right = std::min(blockLeft + static_cast<int>(m_BlockSize) - 1, maxX);
+				const uint32_t blockX = blockLeft / m_BlockSize, blockY = blockTop / m_BlockSize;
+				DepthRange& blockDepth = m_BlockDepths[size_t(blockY) * m_NumBlocksX + blockX];
+				std::pair<float, float> depthRange{};
+				//Nearer than everything in the block, the depth test passes everywhere and the buffer isn't read
+				bool isInFront{ false };
+				if (m_IsHiZEnabled)
+				{
+					depthRange = GetDepthRange(triangle, left, top, right, bottom);
+					if (depthRange.first < blockDepth.max && blockDepth.isMaxStale)
+						UpdateBlockMax(blockX, blockY);
+					if (depthRange.first >= blockDepth.max)
+					{
+						++tileStats.numHiZBlocks;
+						tileStats.numHiZPixels += (right - left + 1) * (bottom - top + 1);
+						continue;
+					}
+					isInFront = depthRange.second < blockDepth.min;
+				}
+
+				uint32_t numBlockShaded{};
+				for (int y{ top }; y <= bottom; ++y)
+				{
+					//The row's part of every plane, the same scalar math whatever the width
+					const float v = static_cast<float>(y - triangle.planeOriginY) + 0.5f;
+					Float rowPlanes[NumPlanes];
+					for (int plane{}; plane < NumPlanes; ++plane)
+						rowPlanes[plane] = Lanes::Broadcast(triangle.planeB[plane] * v + triangle.planeC[plane]);
+
+					Int edges[3];
+					for (int edge{}; edge < 3; ++edge)
+						edges[edge] = Lanes::BroadcastInt(firstEdges[edge] + stepsY[edge] * (y - minY) + stepsX[edge] * (left - minX)) + laneSteps[edge];
+
+					float* pDepthRow = &m_DepthBuffer[size_t(y) * m_Width];
+					uint32_t* pColorRow = &m_ColorBuffer[size_t(y) * m_Width];
+					for (int x{ left }; x <= right; x += width)
+					{
+						const int numLanes = std::min(width, right - x + 1);
+						uint32_t mask = Lanes::InsideMask(edges[0], edges[1], edges[2]) & ((1u << numLanes) - 1);
+						for (int edge{}; edge < 3; ++edge)
+							edges[edge] = edges[edge] + blockSteps[edge];
+						if (mask == 0)
+							continue;
+						tileStats.numPixelsCovered += std::popcount(mask);
+
+						//Depth is linear on screen, D3D11_COMPARISON_LESS against the buffer. Lanes past the block read a copy.
+						const Float u = Lanes::Broadcast(static_cast<float>(x - triangle.planeOriginX) + 0.5f) + Lanes::Ramp();
+						Float depth = planesDx[Depth] * u + rowPlanes[Depth];
+						if (isQuantized)
+							depth = Lanes::Round(depth * depthLevels) / depthLevels;
+						if (!isInFront)
+						{
+							float storedDepths[width]{};
+							const float* pStoredDepths = pDepthRow + x;
+							if (numLanes < width)
+							{
+								std::copy(pDepthRow + x, pDepthRow + x + numLanes, storedDepths);
+								pStoredDepths = storedDepths;
+							}
+							mask &= Lanes::LessMask(depth, Lanes::Load(pStoredDepths));
+							if (mask == 0)
+								continue;
+						}
+						numBlockShaded += std::popcount(mask);
+						Lanes::Store(laneDepths, depth);
+
+						if (!drawCall.isDepthOnly)
+						{
+							//Perspective correct weights of corners 1 and 2
+							const Float w = one / (planesDx[InvW] * u + rowPlanes[InvW]);
+							const Float weight1 = (planesDx[Barycentric1] * u + rowPlanes[Barycentric1]) * cornerInvW1 * w;
+							const Float weight2 = (planesDx[Barycentric2] * u + rowPlanes[Barycentric2]) * cornerInvW2 * w;
+							Float uv[2];
+							for (int attribute{}; attribute < numAttributes; ++attribute)
+							{
+								const Float value = attributeBases[attribute] + weight1 * attributeDeltas1[attribute] + weight2 * attributeDeltas2[attribute];
+								if (attribute < 2)
+									uv[attribute] = value;
+								Lanes::Store(inputs.values[attribute], value);
+							}
+							for (int axis{}; axis < 2; ++axis)
+							{
+								Lanes::Store(inputs.values[PixelInputs::UDx + axis], (uvOverWDxLanes[axis] - uv[axis] * invWDx) * w);
+								Lanes::Store(inputs.values[PixelInputs::UDy + axis], (uvOverWDyLanes[axis] - uv[axis] * invWDy) * w);
+							}
+						}
+
+						for (uint32_t laneMask{ mask }; laneMask != 0; laneMask &= laneMask - 1)
+						{
+							const int lane = std::countr_zero(laneMask);
+							pDepthRow[x + lane] = laneDepths[lane];
+						}
+						if (!drawCall.isDepthOnly)
+							m_PixelShader(inputs, mask, pColorRow + x, drawCall);
+					}
+				}
+				tileStats.numPixelsShaded += numBlockShaded;
+
+				//What was written can only have pulled the block nearer
+				if (m_IsHiZEnabled && numBlockShaded > 0)
+				{
+					blockDepth.min = std::min(blockDepth.min, depthRange.first);
+					blockDepth.isMaxStale = true;
+					DepthRange& tileDepth = m_TileDepths[tile];
+					tileDepth.min = std::min(tileDepth.min, depthRange.first);
+					tileDepth.isMaxStale = true;
+				}
+			}
+		}
+	}
+
+	std::pair<float, float> SoftwareRasterizer::GetDepthRange(const TriangleSetup& triangle, int left, int top, int right, int bottom) const
+	{
+		//The kernel's float math is monotonic in u and v, so its extremes over a rectangle are at the corners
+		const float u0 = static_cast<float>(left - triangle.planeOriginX) + 0.5f, u1 = static_cast<float>(right - triangle.planeOriginX) + 0.5f;
+		const float row0 = triangle.planeB[Depth] * (static_cast<float>(top - triangle.planeOriginY) + 0.5f) + triangle.planeC[Depth];
+		const float row1 = triangle.planeB[Depth] * (static_cast<float>(bottom - triangle.planeOriginY) + 0.5f) + triangle.planeC[Depth];
+		const auto [min, max] = std::minmax({ triangle.planeA[Depth] * u0 + row0, triangle.planeA[Depth] * u1 + row0, triangle.planeA[Depth] * u0 + row1,
+			triangle.planeA[Depth] * u1 + row1 });
+		//Rounding is monotonic too
+		if (m_DepthLevels != 0.f)
+			return { std::nearbyint(min * m_DepthLevels) / m_DepthLevels, std::nearbyint(max * m_DepthLevels) / m_DepthLevels };
+		return { min, max };
+	}
+
+	void SoftwareRasterizer::UpdateBlockMax(uint32_t blockX, uint32_t blockY)
+	{
+		DepthRange& blockDepth = m_BlockDepths[size_t(blockY) * m_NumBlocksX + blockX];
+		const uint32_t right = std::min((blockX + 1) * m_BlockSize, m_Width), bottom = std::min((blockY + 1) * m_BlockSize, m_Height);
+		float max{ -std::numeric_limits<float>::infinity() };
+		for (uint32_t y{ blockY * m_BlockSize }; y < bottom; ++y)
+		{
+			const float* pDepthRow = &m_DepthBuffer[size_t(y) * m_Width];
+			for (uint32_t x{ blockX * m_BlockSize }; x < right; ++x)
+				max = std::max(max, pDepthRow[x]);
+		}
+		blockDepth.max = max;
+		blockDepth.isMaxStale = false;
+	}
+
+	void SoftwareRasterizer::UpdateTileMax(uint32_t tile)
+	{
+		//Stale blocks are tightened too, those written since the last time are usually few
+		DepthRange& tileDepth = m_TileDepths[tile];
+		const uint32_t firstBlockX = (tile % m_NumTilesX) * (m_TileSize / m_BlockSize), firstBlockY = (tile / m_NumTilesX) * (m_TileSize / m_BlockSize);
+		const uint32_t lastBlockX = std::min(firstBlockX + m_TileSize / m_BlockSize, m_NumBlocksX);
+		const uint32_t lastBlockY = std::min(firstBlockY + m_TileSize / m_BlockSize, static_cast<uint32_t>(m_BlockDepths.size() / m_NumBlocksX));
+		float max{ -std::numeric_limits<float>::infinity() };
+		for (uint32_t blockY{ firstBlockY }; blockY < lastBlockY; ++blockY)
+		{
+			for (uint32_t blockX{ firstBlockX }; blockX < lastBlockX; ++blockX)
+			{
+				if (m_BlockDepths[size_t(blockY) * m_NumBlocksX + blockX].isMaxStale)
+					UpdateBlockMax(blockX, blockY);
+				max = std::max(max, m_BlockDepths[size_t(blockY) * m_NumBlocksX + blockX].max);
+			}
+		}
+		tileDepth.max = max;
+		tileDepth.isMaxStale = false;
+	}
+}
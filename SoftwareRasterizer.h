@@ -0,0 +1,334 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "ColorRGB.h"
+#include "Datatypes.h"
+#include "DepthFormat.h"
+#include "VertexProcessing.h"
+
+namespace dae
+{
+	class CPUTexture;
+	class ThreadPool;
+	struct PixelInputs;
+
+	//The sampler states of PosCol3D.fx
+	enum class SamplerFilter
+	{
+		Point,
+		Linear,
+		Anisotropic
+	};
+
+	//Implementations of the raster kernel, they cover and shade exactly the same pixels with the same results
+	enum class RasterKernel
+	{
+		//One pixel at a time
+		Scalar,
+		//4 pixels of a row at once
+		SSE,
+		//8 pixels of a row at once
+		AVX2
+	};
+
+	//Maps of a draw. Missing ones read like the Renderer's fallback textures: grey, flat and without specular.
+	struct SoftwareMaterial
+	{
+		const CPUTexture* pDiffuse{};
+		const CPUTexture* pNormal{};
+		//Specular in rgb and glossiness in a like the Packed techniques, used over the two separate maps when set
+		const CPUTexture* pSpecularGloss{};
+		const CPUTexture* pSpecular{};
+		const CPUTexture* pGlossiness{};
+	};
+
+	//PosCol3D.fx on the CPU: the vertex shader, back face culling and depth testing like the default D3D11 states, and the
+	//Lambert + Phong normal mapped pixel shader. Renders into RGBA8 color and float depth buffers in memory. Triangles are set up and
+	//binned into 64x64 tiles by chunks of the draw in parallel, then tiles are rasterized and shaded independently with work stealing.
+	//Triangles crossing the near or far plane or leaving a guard band around the screen are clipped, the rest only scissored.
+	//A hierarchical Z buffer over tiles and 8x8 blocks skips what is hidden before any pixel of it is touched.
+	//Headless: needs no device, window, SDL or D3D11, and builds into the CPU-only DirectXBenchmark (CMakeLists.txt), whose software
+	//benchmark saves frames as PPM. Only DirectX.exe --software presents through an SDL window surface.
+	class SoftwareRasterizer final
+	{
+	public:
+		struct DrawCall
+		{
+			std::span<const Vertex> vertices{};
+			std::span<const uint32_t> indices{};
+			Matrix worldMatrix{};
+			Matrix worldViewProjMatrix{};
+			Vector3 cameraPosition{};
+			SoftwareMaterial material{};
+			SamplerFilter filter{ SamplerFilter::Linear };
+			//No pixel shader, like a depth prepass: only depth is tested and written
+			bool isDepthOnly{};
+			//Like D3D11_RASTERIZER_DESC::FrontCounterClockwise, for meshes imported without ObjImportOptions::flipAxisAndWinding whose
+			//front faces keep the OBJ's counter-clockwise order. Back faces are culled either way.
+			bool isFrontCounterClockwise{};
+		};
+
+		//Shades the pixels of inputs whose bits are set in mask into pColors, see SoftwareShading
+		using PixelShader = void (*)(const PixelInputs& inputs, uint32_t mask, uint32_t* pColors, const DrawCall& drawCall);
+
+		//Of the draws since the last Clear
+		struct Stats
+		{
+			//Through the vertex shader, none when a draw reuses the last one's results
+			uint64_t numTransformedVertices{};
+			uint32_t numTriangles{};
+			//Every corner outside the same plane of the frustum, dropped whole
+			uint32_t numOutside{};
+			//Entirely inside the frustum
+			uint32_t numInside{};
+			//Off screen but inside the guard band, only scissored by their bounds
+			uint32_t numGuardBand{};
+			//Crossing the near or far plane or leaving the guard band, clipped in homogeneous space into numClippedTriangles triangles
+			uint32_t numClipped{};
+			uint32_t numClippedTriangles{};
+			//Culled before binning, clipped triangles count per piece: facing away, zero area or repeating a vertex, and covering no pixel
+			//center on screen
+			uint32_t numBackFacing{};
+			uint32_t numDegenerate{};
+			uint32_t numMissingSamples{};
+			//Inside, in the guard band or a clipped piece, but snapping beyond the fixed point range: dropped, no clipper output
+			uint32_t numOutOfRange{};
+			uint32_t numRasterized{};
+			//Spent setting up and binning triangles
+			float setupMs{};
+			//Triangle references over all tiles, one triangle counts once for every tile it touches
+			uint64_t numBinned{};
+			uint64_t numPixelsCovered{};
+			uint64_t numPixelsShaded{};
+			//Shares of tiles taken over by idle threads, see ThreadPool::ParallelForStealing
+			uint32_t numSteals{};
+			//Skipped by the hierarchical Z test: triangles for a whole tile, 8x8 blocks of one triangle, and the pixels of the triangles'
+			//bounds in those, none of which were covered, interpolated or shaded
+			uint32_t numHiZTriangles{};
+			uint64_t numHiZBlocks{};
+			uint64_t numHiZPixels{};
+		};
+
+		//The counters of D3D11_QUERY_DATA_PIPELINE_STATISTICS this pipeline has, of the draws since the last Clear
+		struct PipelineStatistics
+		{
+			//Indices read and triangles assembled
+			uint64_t numIAVertices{};
+			uint64_t numIAPrimitives{};
+			//Whole vertex buffers, without a post-transform cache, and none when a draw reuses the last one's vertices
+			uint64_t numVSInvocations{};
+			//Triangles into the clipper and out of it, those outside the frustum or the fixed point range dropped and clipped ones counted per piece
+			uint64_t numCInvocations{};
+			uint64_t numCPrimitives{};
+			//Past culling and binned, there is no such counter in D3D11
+			uint64_t numRasterizedPrimitives{};
+			//None in depth only draws
+			uint64_t numPSInvocations{};
+			//Covered pixels failing the depth test before shading. Pixels in blocks the hierarchical Z skipped are in Stats::numHiZPixels.
+			uint64_t numEarlyZRejects{};
+		};
+
+		//Of one tile in the last Draw
+		struct TileStats
+		{
+			uint32_t numTriangles{};
+			uint32_t numPixelsCovered{};
+			uint32_t numPixelsShaded{};
+			uint32_t numHiZTriangles{};
+			uint32_t numHiZBlocks{};
+			uint32_t numHiZPixels{};
+			float ms{};
+			//Which thread of the pool rasterized it, 0 is the one calling Draw
+			uint32_t thread{};
+		};
+
+		//Tiles are spread over the thread pool when set. Starts on the widest kernel the CPU supports.
+		SoftwareRasterizer(uint32_t width, uint32_t height, ThreadPool* pThreadPool = nullptr);
+
+		void SetKernel(RasterKernel kernel) { m_Kernel = kernel; };
+		RasterKernel GetKernel() const { return m_Kernel; };
+		static RasterKernel GetBestKernel();
+		//On by default, the image is the same either way. Switch only right after a Clear, draws without it don't keep it up to date.
+		void SetHierarchicalZ(bool isEnabled) { m_IsHiZEnabled = isEnabled; };
+		bool IsHierarchicalZEnabled() const { return m_IsHiZEnabled; };
+		//On by default: each draw gets a pixel shader compiled for its filter and maps, off they all share one that branches per pixel
+		void SetSpecializedShading(bool isEnabled) { m_IsSpecializedShading = isEnabled; };
+		bool IsSpecializedShadingEnabled() const { return m_IsSpecializedShading; };
+		//On by default: triangles leaving the screen but not the guard band are only scissored, off every one crossing a side of the
+		//frustum is clipped against it
+		void SetGuardBand(bool isEnabled) { m_IsGuardBandEnabled = isEnabled; };
+		bool IsGuardBandEnabled() const { return m_IsGuardBandEnabled; };
+		//D32F by default. UNORM formats round every depth to their steps before the test, reversed takes the projection of
+		//Matrix::CreatePerspectiveFovReversedLH. Switch only right before a Clear.
+		void SetDepthFormat(DepthFormat format);
+		DepthFormat GetDepthFormat() const { return m_DepthFormat; };
+
+		//Depth back to the far plane of the depth format
+		void Clear(const ColorRGB& color);
+		void Draw(const DrawCall& drawCall);
+
+		uint32_t GetWidth() const { return m_Width; };
+		uint32_t GetHeight() const { return m_Height; };
+		//Rows of GetWidth() texels, RGBA8 with red in the lowest byte like DXGI_FORMAT_R8G8B8A8_UNORM
+		std::span<const uint32_t> GetColorBuffer() const { return m_ColorBuffer; };
+		//Depth after the viewport transform, 0 at the near plane. Reversed formats store it negated so that nearer is less either way,
+		//-1 at the near plane.
+		std::span<const float> GetDepthBuffer() const { return m_DepthBuffer; };
+		const Stats& GetStats() const { return m_Stats; };
+		const PipelineStatistics& GetPipelineStatistics() const { return m_PipelineStatistics; };
+		uint32_t GetNumTilesX() const { return m_NumTilesX; };
+		uint32_t GetNumTilesY() const { return m_NumTilesY; };
+		//Row after row of tiles
+		std::span<const TileStats> GetTileStats() const { return m_TileStats; };
+
+	private:
+		//Pixels along a side of a tile, a tile's color and depth (32 KB) stay in L1/L2 while its triangles are drawn
+		static constexpr uint32_t m_TileSize{ 64 };
+		//Fewest triangles a chunk of the setup gets
+		static constexpr uint32_t m_MinChunkSize{ 1024 };
+		//Pixels along a side of a hierarchical Z block, one AVX2 register per row
+		static constexpr uint32_t m_BlockSize{ 8 };
+		//Corners snap to 1/16 pixel. Inside the coordinate limit every edge value across a tile fits 32 bits, see RasterizeTriangle.
+		static constexpr int32_t m_SubpixelBits{ 4 };
+		static constexpr int32_t m_SubpixelScale{ 1 << m_SubpixelBits };
+		static constexpr float m_MaxCoordinate{ 16384.f };
+		//Pixels from the center of the screen a triangle may reach before it's clipped. Half the coordinate limit, so corners made by
+		//clipping land well inside it whatever the rounding.
+		static constexpr float m_GuardBandSize{ 8192.f };
+		//A convex polygon clipped from a triangle by the 6 planes has at most 9 corners
+		static constexpr int m_MaxClippedCorners{ 9 };
+
+		//Screen space planes value = a * u + b * v + c, u and v being pixel coordinates relative to the triangle's planeOrigin
+		enum Plane
+		{
+			Barycentric1,
+			Barycentric2,
+			Depth,
+			InvW,
+			NumPlanes
+		};
+
+		struct TriangleSetup
+		{
+			uint32_t vertices[3]{};
+			//The vertices index the chunk's clippedVertices instead of the draw's
+			bool isClipped{};
+			//Edge i is opposite corner i: E(x, y) = a * x + b * y + c on positions in 1/16 pixels, positive inside
+			int32_t edgeA[3]{};
+			int32_t edgeB[3]{};
+			int64_t edgeC[3]{};
+			//-1 on edges that are neither top nor left, so a pixel center exactly on them fails E + bias >= 0 (top-left fill rule)
+			int32_t edgeBias[3]{};
+			float planeA[NumPlanes]{};
+			float planeB[NumPlanes]{};
+			float planeC[NumPlanes]{};
+			int planeOriginX{};
+			int planeOriginY{};
+			float invW[3]{};
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+		};
+
+		//Corners after the viewport transform: positions in subpixels, depth and 1/w
+		struct ScreenTriangle
+		{
+			int32_t x[3]{};
+			int32_t y[3]{};
+			float z[3]{};
+			float invW[3]{};
+		};
+
+		//Bounds of the depths in a block or tile. The far end may overestimate: writes only mark it stale, it's recomputed once it's
+		//all that keeps a triangle or block from being skipped.
+		struct DepthRange
+		{
+			float min{ 1.f };
+			float max{ 1.f };
+			bool isMaxStale{};
+		};
+
+		//A contiguous run of the draw's triangles, set up and binned by one thread. Walking the chunks in order then the bin of a tile
+		//in a chunk visits its triangles in draw order, so the depth test resolves ties like the GPU.
+		struct Chunk
+		{
+			std::vector<TriangleSetup> triangles{};
+			//Per tile, indices into triangles
+			std::vector<std::vector<uint32_t>> bins{};
+			//TransformedVertices::NumStreams values per corner made by clipping
+			std::vector<float> clippedVertices{};
+			Stats stats{};
+		};
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		ThreadPool* m_pThreadPool{};
+		RasterKernel m_Kernel{};
+		std::vector<uint32_t> m_ColorBuffer{};
+		std::vector<float> m_DepthBuffer{};
+		bool m_IsHiZEnabled{ true };
+		bool m_IsSpecializedShading{ true };
+		bool m_IsGuardBandEnabled{ true };
+		DepthFormat m_DepthFormat{ DepthFormat::D32F };
+		//Steps of a UNORM m_DepthFormat, 0 for floats
+		float m_DepthLevels{};
+		//The guard band's planes |x| <= m_GuardBandX * w and |y| <= m_GuardBandY * w in clip space
+		float m_GuardBandX{};
+		float m_GuardBandY{};
+		//Of the current draw
+		PixelShader m_PixelShader{};
+		uint32_t m_NumBlocksX{};
+		//Row after row of blocks
+		std::vector<DepthRange> m_BlockDepths{};
+		VertexProcessor m_VertexProcessor;
+		//Of the current draw
+		const TransformedVertices* m_pVertices{};
+		uint32_t m_NumTilesX{};
+		uint32_t m_NumTilesY{};
+		//Only the first m_NumDrawChunks belong to the current draw, the rest keep their allocations
+		std::vector<Chunk> m_Chunks{};
+		uint32_t m_NumDrawChunks{};
+		std::vector<TileStats> m_TileStats{};
+		//Busiest tiles first, they are the ones worth stealing from
+		std::vector<uint32_t> m_TileOrder{};
+		std::vector<DepthRange> m_TileDepths{};
+		Stats m_Stats{};
+		PipelineStatistics m_PipelineStatistics{};
+
+		//Drops, clips or passes the triangle on to AddTriangle by the clip codes of its corners
+		void SetupTriangle(uint32_t index0, uint32_t index1, uint32_t index2, Chunk& chunk) const;
+		//Sutherland-Hodgman against the planes that have a corner outside them, then a fan of the polygon's corners
+		void ClipTriangle(uint32_t index0, uint32_t index1, uint32_t index2, Chunk& chunk) const;
+		//SetupTriangle for 8 triangles at a time: clip codes, the guard band test, the viewport transform, snapping and culling in AVX2
+		//registers, then a setup of the planes for each triangle left. The result is the same to the bit.
+		void SetupTrianglesAVX(const uint32_t* pIndices, size_t numTriangles, bool isFlipped, Chunk& chunk) const;
+		//Snaps, culls and sets up a triangle whose corners are all in front of the eye and inside the guard band
+		void AddTriangle(TriangleSetup& triangle, const Vector4 (&positions)[3], Chunk& chunk) const;
+		//Viewport transform, y pointing down, snapped to the subpixel grid. The guard band keeps every corner well within the fixed point
+		//range, only non-finite positions fail it.
+		bool SnapTriangle(const Vector4 (&positions)[3], ScreenTriangle& screen) const;
+		//False for back facing and zero area triangles and those whose bounds hold no pixel center, otherwise fills in the bounds
+		bool CullTriangle(const ScreenTriangle& screen, TriangleSetup& triangle, Stats& stats) const;
+		//Edges and planes of a triangle that passed culling, drops it if its bounds' only pixel center isn't covered, then bins it
+		void SetupPlanes(TriangleSetup& triangle, const ScreenTriangle& screen, Chunk& chunk) const;
+		//Adds the triangle to every tile its bounds touch unless one of its edges has the whole tile outside
+		void BinTriangle(const TriangleSetup& triangle, uint32_t index, Chunk& chunk) const;
+		void RasterizeTile(uint32_t tile, const DrawCall& drawCall, uint32_t thread);
+		//Covers the pixels [minX, maxX] x [minY, maxY] of the triangle inside the tile, an 8x8 block after the other and Lanes::width
+		//pixels of a row at a time
+		template<typename Lanes>
+		void RasterizeTriangle(const TriangleSetup& triangle, const Chunk& chunk, const DrawCall& drawCall, uint32_t tile, int minX, int minY, int maxX, int maxY,
+			TileStats& tileStats);
+		//RasterizeTriangle<AVXLanes> compiled for AVX2, the rest of the file runs on any x64 CPU
+		void RasterizeTriangleAVX(const TriangleSetup& triangle, const Chunk& chunk, const DrawCall& drawCall, uint32_t tile, int minX, int minY, int maxX, int maxY,
+			TileStats& tileStats);
+		//Exact depth range of the triangle's plane over pixels [left, right] x [top, bottom], as the kernel evaluates it
+		std::pair<float, float> GetDepthRange(const TriangleSetup& triangle, int left, int top, int right, int bottom) const;
+		//Tightens the far ends from the depth buffer, the block's from its pixels and the tile's from its blocks
+		void UpdateBlockMax(uint32_t blockX, uint32_t blockY);
+		void UpdateTileMax(uint32_t tile);
+	};
+}
@@ -0,0 +1,246 @@
+#include "pch.h"
+#include "SoftwareShading.h"
+#include "CPUTexture.h"
+#include <array>
+#include <bit>
+
+namespace dae
+{
+	namespace
+	{
+		enum class SpecularMaps
+		{
+			None,
+			//gSpecularMap and gGlossinessMap
+			Separate,
+			//gSpecularGlossMap
+			Packed
+		};
+
+		//What PosCol3D.fx reads of a pixel
+		Vertex_Out GetInput(const PixelInputs& inputs, int pixel, Vector2& uvDx, Vector2& uvDy)
+		{
+			const auto& values = inputs.values;
+			Vertex_Out input{};
+			input.uv = { values[PixelInputs::U][pixel], values[PixelInputs::V][pixel] };
+			input.normal = { values[PixelInputs::NormalX][pixel], values[PixelInputs::NormalY][pixel], values[PixelInputs::NormalZ][pixel] };
+			input.tangent = { values[PixelInputs::TangentX][pixel], values[PixelInputs::TangentY][pixel], values[PixelInputs::TangentZ][pixel] };
+			input.worldPosition = { values[PixelInputs::WorldX][pixel], values[PixelInputs::WorldY][pixel], values[PixelInputs::WorldZ][pixel] };
+			uvDx = { values[PixelInputs::UDx][pixel], values[PixelInputs::VDx][pixel] };
+			uvDy = { values[PixelInputs::UDy][pixel], values[PixelInputs::VDy][pixel] };
+			return input;
+		}
+
+		//To UNORM8 like the swap chain
+		uint32_t PackColor(const float* pColor)
+		{
+			uint32_t texel{};
+			for (int channel{}; channel < 4; ++channel)
+				texel |= static_cast<uint32_t>(Saturate(pColor[channel]) * 255.f + 0.5f) << (channel * 8);
+			return texel;
+		}
+
+		Vector4 Sample(const CPUTexture& texture, SamplerFilter filter, const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy)
+		{
+			switch (filter)
+			{
+			case SamplerFilter::Point:
+				return texture.SamplePoint(uv, texture.ComputeLOD(uvDx, uvDy));
+			case SamplerFilter::Linear:
+				return texture.SampleTrilinear(uv, texture.ComputeLOD(uvDx, uvDy));
+			default:
+				return texture.SampleAnisotropic(uv, uvDx, uvDy);
+			}
+		}
+
+		//Shade and PS_Combined/PS_CombinedPacked of PosCol3D.fx, deciding everything at run time
+		uint32_t Shade(const Vertex_Out& input, const Vector2& uvDx, const Vector2& uvDy, const SoftwareRasterizer::DrawCall& drawCall)
+		{
+			const SoftwareMaterial& material = drawCall.material;
+			const Vector3 viewDirection = (input.worldPosition - drawCall.cameraPosition).Normalized();
+
+			const Vector3 lightDir{ 0.577f, -0.577f, 0.577f };
+			const Vector3 binormal = Vector3::Cross(input.normal, input.tangent);
+
+			//BC5 only keeps x and y, z is rebuilt from the unit length
+			float sampledX{}, sampledY{};
+			if (material.pNormal)
+			{
+				const Vector4 sampledNormal = Sample(*material.pNormal, drawCall.filter, input.uv, uvDx, uvDy);
+				sampledX = 2.f * sampledNormal.x - 1.f;
+				sampledY = 2.f * sampledNormal.y - 1.f;
+			}
+			const float sampledZ = std::sqrt(Saturate(1.f - sampledX * sampledX - sampledY * sampledY));
+			const Vector3 normal = input.tangent * sampledX + binormal * sampledY + input.normal * sampledZ;
+
+			const float observedArea = Saturate(Vector3::Dot(normal.Normalized(), (-lightDir).Normalized()));
+
+			constexpr float intensity{ 7.f };
+			constexpr float shinyness{ 25.f };
+
+			//The packed map's alpha holds the glossiness, its specular is opaque
+			Vector4 specularColor{ 0.f, 0.f, 0.f, 1.f };
+			float glossiness{};
+			if (material.pSpecularGloss)
+			{
+				const Vector4 specularGloss = Sample(*material.pSpecularGloss, drawCall.filter, input.uv, uvDx, uvDy);
+				specularColor = { specularGloss.x, specularGloss.y, specularGloss.z, 1.f };
+				glossiness = specularGloss.w;
+			}
+			else
+			{
+				if (material.pSpecular)
+					specularColor = Sample(*material.pSpecular, drawCall.filter, input.uv, uvDx, uvDy);
+				if (material.pGlossiness)
+					glossiness = Sample(*material.pGlossiness, drawCall.filter, input.uv, uvDx, uvDy).x;
+			}
+
+			//Phong: reflect(l, n) against the unnormalized normal like the shader
+			const Vector3 l = -lightDir;
+			const Vector3 r = l - normal * (2.f * Vector3::Dot(normal, l));
+			const float cosAlpha = Saturate(Vector3::Dot(r, viewDirection));
+			const float phong = std::pow(cosAlpha, shinyness * glossiness);
+
+			//Lambert
+			const Vector4 diffuse = material.pDiffuse ? Sample(*material.pDiffuse, drawCall.filter, input.uv, uvDx, uvDy) : Vector4{ 0.5f, 0.5f, 0.5f, 1.f };
+			constexpr float diffuseScale{ intensity / PI };
+
+			const float color[4]{
+				(diffuse.x * diffuseScale + specularColor.x * phong) * observedArea,
+				(diffuse.y * diffuseScale + specularColor.y * phong) * observedArea,
+				(diffuse.z * diffuseScale + specularColor.z * phong) * observedArea,
+				(diffuse.w * diffuseScale + specularColor.w * phong) * observedArea };
+			return PackColor(color);
+		}
+
+		template<SamplerFilter filter>
+		Vector4 Sample(const CPUTexture& texture, const Vector2& uv, const Vector2& uvDx, const Vector2& uvDy)
+		{
+			if constexpr (filter == SamplerFilter::Point)
+				return texture.SamplePoint(uv, texture.ComputeLOD(uvDx, uvDy));
+			else if constexpr (filter == SamplerFilter::Linear)
+				return texture.SampleTrilinear(uv, texture.ComputeLOD(uvDx, uvDy));
+			else
+				return texture.SampleAnisotropic(uv, uvDx, uvDy);
+		}
+
+		//Shade with the filter and the bound maps known at compile time, the same math in the same order minus what the missing maps
+		//multiply by 0 or 1
+		template<SamplerFilter filter, bool isNormalMapped, SpecularMaps specularMaps>
+		uint32_t Shade(const Vertex_Out& input, const Vector2& uvDx, const Vector2& uvDy, const SoftwareRasterizer::DrawCall& drawCall)
+		{
+			const SoftwareMaterial& material = drawCall.material;
+			const Vector3 viewDirection = (input.worldPosition - drawCall.cameraPosition).Normalized();
+			const Vector3 lightDir{ 0.577f, -0.577f, 0.577f };
+
+			//BC5 only keeps x and y, z is rebuilt from the unit length
+			Vector3 normal{ input.normal };
+			if constexpr (isNormalMapped)
+			{
+				const Vector3 binormal = Vector3::Cross(input.normal, input.tangent);
+				const Vector4 sampledNormal = Sample<filter>(*material.pNormal, input.uv, uvDx, uvDy);
+				const float sampledX = 2.f * sampledNormal.x - 1.f;
+				const float sampledY = 2.f * sampledNormal.y - 1.f;
+				const float sampledZ = std::sqrt(Saturate(1.f - sampledX * sampledX - sampledY * sampledY));
+				normal = input.tangent * sampledX + binormal * sampledY + input.normal * sampledZ;
+			}
+
+			const float observedArea = Saturate(Vector3::Dot(normal.Normalized(), (-lightDir).Normalized()));
+
+			constexpr float intensity{ 7.f };
+			constexpr float shinyness{ 25.f };
+			const Vector4 diffuse = Sample<filter>(*material.pDiffuse, input.uv, uvDx, uvDy);
+			constexpr float diffuseScale{ intensity / PI };
+
+			//Without specular maps the glossiness is 0 and the Phong term pow(x, 0) = 1 only reaches alpha
+			if constexpr (specularMaps == SpecularMaps::None)
+			{
+				const float color[4]{ diffuse.x * diffuseScale * observedArea, diffuse.y * diffuseScale * observedArea, diffuse.z * diffuseScale * observedArea,
+					(diffuse.w * diffuseScale + 1.f) * observedArea };
+				return PackColor(color);
+			}
+			else
+			{
+				Vector4 specularColor{};
+				float glossiness{};
+				if constexpr (specularMaps == SpecularMaps::Packed)
+				{
+					const Vector4 specularGloss = Sample<filter>(*material.pSpecularGloss, input.uv, uvDx, uvDy);
+					specularColor = { specularGloss.x, specularGloss.y, specularGloss.z, 1.f };
+					glossiness = specularGloss.w;
+				}
+				else
+				{
+					specularColor = Sample<filter>(*material.pSpecular, input.uv, uvDx, uvDy);
+					glossiness = Sample<filter>(*material.pGlossiness, input.uv, uvDx, uvDy).x;
+				}
+
+				//Phong: reflect(l, n) against the unnormalized normal like the shader
+				const Vector3 l = -lightDir;
+				const Vector3 r = l - normal * (2.f * Vector3::Dot(normal, l));
+				const float cosAlpha = Saturate(Vector3::Dot(r, viewDirection));
+				const float phong = std::pow(cosAlpha, shinyness * glossiness);
+
+				const float color[4]{
+					(diffuse.x * diffuseScale + specularColor.x * phong) * observedArea,
+					(diffuse.y * diffuseScale + specularColor.y * phong) * observedArea,
+					(diffuse.z * diffuseScale + specularColor.z * phong) * observedArea,
+					(diffuse.w * diffuseScale + specularColor.w * phong) * observedArea };
+				return PackColor(color);
+			}
+		}
+
+		template<SamplerFilter filter, bool isNormalMapped, SpecularMaps specularMaps>
+		void ShadeSpecialized(const PixelInputs& inputs, uint32_t mask, uint32_t* pColors, const SoftwareRasterizer::DrawCall& drawCall)
+		{
+			for (; mask != 0; mask &= mask - 1)
+			{
+				const int pixel = std::countr_zero(mask);
+				Vector2 uvDx{}, uvDy{};
+				const Vertex_Out input = GetInput(inputs, pixel, uvDx, uvDy);
+				pColors[pixel] = Shade<filter, isNormalMapped, specularMaps>(input, uvDx, uvDy, drawCall);
+			}
+		}
+
+		//Every specialization, indexed [filter][normal mapped][specular maps]
+		template<SamplerFilter filter, bool isNormalMapped>
+		constexpr std::array<SoftwareRasterizer::PixelShader, 3> specularShaders{
+			ShadeSpecialized<filter, isNormalMapped, SpecularMaps::None>,
+			ShadeSpecialized<filter, isNormalMapped, SpecularMaps::Separate>,
+			ShadeSpecialized<filter, isNormalMapped, SpecularMaps::Packed> };
+
+		template<SamplerFilter filter>
+		constexpr std::array<std::array<SoftwareRasterizer::PixelShader, 3>, 2> normalShaders{ specularShaders<filter, false>, specularShaders<filter, true> };
+
+		constexpr std::array<std::array<std::array<SoftwareRasterizer::PixelShader, 3>, 2>, 3> pixelShaders{
+			normalShaders<SamplerFilter::Point>, normalShaders<SamplerFilter::Linear>, normalShaders<SamplerFilter::Anisotropic> };
+	}
+
+	void SoftwareShading::ShadeGeneric(const PixelInputs& inputs, uint32_t mask, uint32_t* pColors, const SoftwareRasterizer::DrawCall& drawCall)
+	{
+		for (; mask != 0; mask &= mask - 1)
+		{
+			const int pixel = std::countr_zero(mask);
+			Vector2 uvDx{}, uvDy{};
+			const Vertex_Out input = GetInput(inputs, pixel, uvDx, uvDy);
+			pColors[pixel] = Shade(input, uvDx, uvDy, drawCall);
+		}
+	}
+
+	SoftwareRasterizer::PixelShader SoftwareShading::GetPixelShader(const SoftwareRasterizer::DrawCall& drawCall)
+	{
+		const SoftwareMaterial& material = drawCall.material;
+		if (!material.pDiffuse)
+			return ShadeGeneric;
+
+		//The packed map wins over the separate ones like in Shade, a separate pair needs both maps
+		SpecularMaps specularMaps{ SpecularMaps::None };
+		if (material.pSpecularGloss)
+			specularMaps = SpecularMaps::Packed;
+		else if (material.pSpecular && material.pGlossiness)
+			specularMaps = SpecularMaps::Separate;
+		else if (material.pSpecular || material.pGlossiness)
+			return ShadeGeneric;
+		return pixelShaders[static_cast<size_t>(drawCall.filter)][material.pNormal != nullptr][static_cast<size_t>(specularMaps)];
+	}
+}
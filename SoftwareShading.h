@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include "SoftwareRasterizer.h"
+
+namespace dae
+{
+	//Interpolated pixel shader inputs of up to a raster kernel's width of pixels in a row, one array per value
+	struct PixelInputs
+	{
+		//Of the widest kernel, AVX2
+		static constexpr int maxPixels{ 8 };
+
+		enum Value
+		{
+			U, V,
+			NormalX, NormalY, NormalZ,
+			TangentX, TangentY, TangentZ,
+			WorldX, WorldY, WorldZ,
+			//uv derivatives per pixel along x and y
+			UDx, VDx,
+			UDy, VDy,
+			NumValues
+		};
+
+		float values[NumValues][maxPixels];
+	};
+
+	//The pixel shaders of PosCol3D.fx on the CPU. Every kernel gives exactly the same colors as the generic one.
+	namespace SoftwareShading
+	{
+		//Branches on the filter and the bound maps at every pixel, like PS_Combined taking its SamplerState as an argument
+		void ShadeGeneric(const PixelInputs& inputs, uint32_t mask, uint32_t* pColors, const SoftwareRasterizer::DrawCall& drawCall);
+
+		//The kernel compiled for the draw's filter, normal map and specular maps. Draws without a diffuse map get the generic one.
+		SoftwareRasterizer::PixelShader GetPixelShader(const SoftwareRasterizer::DrawCall& drawCall);
+	}
+}
@@ -1,65 +1,153 @@
 #include "pch.h"
 #include "Texture.h"
 #include "Vector2.h"
-#include <SDL_image.h>
+#include "TextureAsset.h"
 #include <cassert>
+#include <iomanip>
 
 namespace dae
 {
-	Texture::Texture(const std::string& path, ID3D11Device* pDevice)
+	namespace
 	{
-		SDL_Surface* pSurface = IMG_Load(path.c_str());
+		DXGI_FORMAT GetDXGIFormat(TextureFormat format)
+		{
+			switch (format)
+			{
+			case TextureFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+			case TextureFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+			case TextureFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+			case TextureFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+			default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+			}
+		}
+	}
+
+	Texture::Texture(const std::string& path, ID3D11Device* pDevice, const TextureImportOptions& options)
+		: Texture{ path, pDevice, TextureAsset::Load(path, options).get() }
+	{
+	}
+
+	Texture::Texture(const std::string& name, ID3D11Device* pDevice, const TextureAsset* pAsset)
+	{
+		if (!pAsset)
+		{
+			std::cout << "Couldn't load " << name << "\n";
+			return;
+		}
+
+		Upload(pDevice, *pAsset, 0, pAsset->GetData().data());
+
+		constexpr float bytesPerMB{ 1024.f * 1024.f };
+		const size_t uncompressedSize = pAsset->GetUncompressedSize();
+		std::cout << std::fixed << std::setprecision(2) << "Texture " << name << (pAsset->IsFromCache() ? " from cache" : " encoded") << ": "
+			<< uncompressedSize / bytesPerMB << " MB -> " << pAsset->GetData().size() / bytesPerMB << " MB ("
+			<< 100.f * (1.f - float(pAsset->GetData().size()) / uncompressedSize) << "% saved)";
+		if (BlockCompression::IsBlockCompressed(pAsset->GetFormat()))
+			std::cout << ", PSNR " << pAsset->GetPSNR() << " dB";
+		std::cout << "\n";
+	}
+
+	Texture::Texture(ID3D11Device* pDevice, const ColorRGB& color)
+	{
+		const uint8_t texel[4]{ static_cast<uint8_t>(std::clamp(color.r, 0.f, 1.f) * 255.f + 0.5f), static_cast<uint8_t>(std::clamp(color.g, 0.f, 1.f) * 255.f + 0.5f),
+			static_cast<uint8_t>(std::clamp(color.b, 0.f, 1.f) * 255.f + 0.5f), 255 };
 
-		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		D3D11_TEXTURE2D_DESC desc{};
-		desc.Width = pSurface->w;
-		desc.Height = pSurface->h;
+		desc.Width = 1;
+		desc.Height = 1;
 		desc.MipLevels = 1;
 		desc.ArraySize = 1;
-		desc.Format = format;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
-		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		D3D11_SUBRESOURCE_DATA initData{};
+		initData.pSysMem = texel;
+		initData.SysMemPitch = sizeof(texel);
+		CreateResource(pDevice, desc, &initData);
+		m_Size = sizeof(texel);
+	}
+
+	Texture::~Texture()
+	{
+		ReleaseResource();
+	}
+
+	void Texture::Upload(ID3D11Device* pDevice, const TextureAsset& asset, uint32_t firstLevel, const uint8_t* pLevels)
+	{
+		const std::span<const MipLevel> levels = asset.GetLevels().subspan(firstLevel);
+		D3D11_TEXTURE2D_DESC desc{};
+		desc.Width = levels[0].width;
+		desc.Height = levels[0].height;
+		desc.MipLevels = static_cast<UINT>(levels.size());
+		desc.ArraySize = 1;
+		desc.Format = GetDXGIFormat(asset.GetFormat());
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
 		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 		desc.CPUAccessFlags = 0;
 		desc.MiscFlags = 0;
 
-		D3D11_SUBRESOURCE_DATA initData{};
-		initData.pSysMem = pSurface->pixels;
-		initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-		initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
+		//Every level as initial data, the texture never has to be touched again. Offsets are relative to the first level uploaded.
+		std::vector<D3D11_SUBRESOURCE_DATA> initData(levels.size());
+		for (size_t level{}; level < levels.size(); ++level)
+		{
+			initData[level].pSysMem = pLevels + (levels[level].offset - levels[0].offset);
+			initData[level].SysMemPitch = BlockCompression::GetRowPitch(asset.GetFormat(), levels[level].width);
+			initData[level].SysMemSlicePitch = static_cast<UINT>(BlockCompression::GetLevelSize(asset.GetFormat(), levels[level].width, levels[level].height));
+		}
+
+		ReleaseResource();
+		CreateResource(pDevice, desc, initData.data());
+		m_Size = asset.GetData().size() - levels[0].offset;
+	}
+
+	ID3D11ShaderResourceView* Texture::GetResourceView() const
+	{
+		return m_pResourceView;
+	}
 
-		HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+	size_t Texture::GetSize() const
+	{
+		return m_Size;
+	}
+
+	void Texture::ReleaseResource()
+	{
+		if (m_pResource)
+		{
+			m_pResource->Release();
+			m_pResource = nullptr;
+		}
+
+		if (m_pResourceView)
+		{
+			m_pResourceView->Release();
+			m_pResourceView = nullptr;
+		}
+	}
+
+	void Texture::CreateResource(ID3D11Device* pDevice, const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* pInitData)
+	{
+		HRESULT hr = pDevice->CreateTexture2D(&desc, pInitData, &m_pResource);
 		if (FAILED(hr))
 		{
 			assert(false && "Couldn't create 2D texture");
+			return;
 		}
 
 		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
-		SRVDesc.Format = format;
+		SRVDesc.Format = desc.Format;
 		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		SRVDesc.Texture2D.MipLevels = 1;
+		SRVDesc.Texture2D.MipLevels = desc.MipLevels;
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pResourceView);
 		if (FAILED(hr))
 		{
 			assert(false && "Couldn't create Resource view");
 		}
-
-		SDL_FreeSurface(pSurface);
-	}
-
-	Texture::~Texture()
-	{
-		m_pResource->Release();
-		m_pResource = nullptr;
-
-		m_pResourceView->Release();
-		m_pResourceView = nullptr;
-	}
-
-	ID3D11ShaderResourceView* Texture::GetResourceView() const
-	{
-		return m_pResourceView;
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <SDL_surface.h>
 #include <string>
 #include "ColorRGB.h"
+#include "TextureAsset.h"
 
 namespace dae
 {
@@ -10,12 +11,29 @@ namespace dae
 	class Texture
 	{
 	public:
-		Texture(const std::string& path, ID3D11Device* pDevice);
+		//Uploads the image with a full mip chain generated on the CPU, block compressed when options.format asks for it
+		Texture(const std::string& path, ID3D11Device* pDevice, const TextureImportOptions& options = {});
+		//Uploads an asset imported elsewhere, e.g. on a loader thread. name is only for the log.
+		Texture(const std::string& name, ID3D11Device* pDevice, const TextureAsset* pAsset);
+		//1x1 of a single color, to draw with until the real texture is resident
+		Texture(ID3D11Device* pDevice, const ColorRGB& color);
+		//Empty until Upload, for TextureStreamer to fill in
+		Texture() = default;
 		~Texture();
 
+		//Creates the texture anew from levels [firstLevel, end) of the asset, pLevels holds them laid out like in asset.GetData().
+		//The view changes, so it has to be bound again.
+		void Upload(ID3D11Device* pDevice, const TextureAsset& asset, uint32_t firstLevel, const uint8_t* pLevels);
+
 		ID3D11ShaderResourceView* GetResourceView() const;
+		//Bytes of texel data on the GPU over all levels
+		size_t GetSize() const;
 	private:
+		void CreateResource(ID3D11Device* pDevice, const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* pInitData);
+		void ReleaseResource();
+
 		ID3D11Texture2D* m_pResource{};
 		ID3D11ShaderResourceView* m_pResourceView{};
+		size_t m_Size{};
 	};
 }
@@ -0,0 +1,290 @@
+#include "pch.h"
+#include "TextureAsset.h"
+#include "FileMapping.h"
+#include "Hash.h"
+#include <filesystem>
+#include <fstream>
+#ifdef DAE_CPU_ONLY
+#include <png.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//.dtex layout: header, MipLevel[numLevels], the encoded levels
+		struct DTexHeader
+		{
+			char magic[4]{ 'D', 'T', 'E', 'X' };
+			uint32_t version{};
+			uint64_t sourceHash{};
+			uint64_t optionsHash{};
+			TextureFormat format{};
+			uint32_t numLevels{};
+			uint64_t dataSize{};
+			float psnr{};
+			uint32_t reserved{};
+		};
+
+		//Bump whenever the import, the encoder or the layout changes, old caches are then rebuilt. 2: BC3 for packed specular and gloss.
+		constexpr uint32_t g_DTexVersion{ 2 };
+
+		//D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION, no level in a cache can be larger
+		constexpr uint32_t g_MaxDimension{ 16384 };
+
+		//RGBA8 with rows of width * 4 bytes, no pixels if it couldn't be decoded
+		struct DecodedImage
+		{
+			uint32_t width{};
+			uint32_t height{};
+			std::vector<uint8_t> pixels{};
+		};
+
+		//Decoded from memory that was already mapped and hashed, converted to the RGBA8 the mip generator and the encoder want.
+		//Through SDL_image, or libpng in the CPU-only build, which only reads PNG.
+		DecodedImage DecodeImage(const FileMapping& source)
+		{
+			DecodedImage image{};
+#ifdef DAE_CPU_ONLY
+			png_image png{};
+			png.version = PNG_IMAGE_VERSION;
+			if (!png_image_begin_read_from_memory(&png, source.GetData(), source.GetSize()))
+				return image;
+
+			png.format = PNG_FORMAT_RGBA;
+			image.pixels.resize(PNG_IMAGE_SIZE(png));
+			if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+			{
+				image.pixels.clear();
+				return image;
+			}
+			image.width = png.width;
+			image.height = png.height;
+#else
+			SDL_Surface* pLoadedSurface = IMG_Load_RW(SDL_RWFromConstMem(source.GetData(), static_cast<int>(source.GetSize())), 1);
+			if (!pLoadedSurface)
+				return image;
+
+			SDL_Surface* pSurface = SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(pLoadedSurface);
+			if (!pSurface)
+				return image;
+
+			image.width = static_cast<uint32_t>(pSurface->w);
+			image.height = static_cast<uint32_t>(pSurface->h);
+			image.pixels.resize(size_t(image.width) * image.height * 4);
+			for (uint32_t y{}; y < image.height; ++y)
+				std::memcpy(&image.pixels[size_t(y) * image.width * 4], static_cast<const uint8_t*>(pSurface->pixels) + size_t(y) * pSurface->pitch, size_t(image.width) * 4);
+			SDL_FreeSurface(pSurface);
+#endif
+			return image;
+		}
+	}
+
+	TextureAsset::~TextureAsset() = default;
+
+	std::unique_ptr<TextureAsset> TextureAsset::Load(const std::string& imagePath, const TextureImportOptions& options)
+	{
+		const FileMapping source{ imagePath };
+		if (!source.IsValid())
+			return nullptr;
+
+		std::unique_ptr<TextureAsset> pAsset{ new TextureAsset{} };
+
+		const std::string cachePath = GetCachePath(imagePath);
+		const uint64_t sourceHash = Hash::HashBytes(source.GetData(), source.GetSize());
+		const uint64_t optionsHash = HashOptions(options);
+		pAsset->m_SourceHash = sourceHash;
+		if (pAsset->TryMapCache(cachePath, sourceHash, optionsHash, options.format))
+			return pAsset;
+
+		const DecodedImage image = DecodeImage(source);
+		if (image.pixels.empty())
+			return nullptr;
+
+		pAsset->Import(image.pixels.data(), image.width, image.height, image.width * 4, options, imagePath);
+
+		pAsset->WriteCache(cachePath, sourceHash, optionsHash);
+		return pAsset;
+	}
+
+	std::unique_ptr<TextureAsset> TextureAsset::LoadPacked(const std::string& rgbPath, const std::string& alphaPath, const TextureImportOptions& options)
+	{
+		const FileMapping rgbSource{ rgbPath };
+		const FileMapping alphaSource{ alphaPath };
+		if (!rgbSource.IsValid() || !alphaSource.IsValid())
+			return nullptr;
+
+		std::unique_ptr<TextureAsset> pAsset{ new TextureAsset{} };
+
+		//Chained, so swapping the two images is another texture
+		const std::string cachePath = GetPackedCachePath(rgbPath, alphaPath);
+		const uint64_t sourceHash = Hash::HashBytes(alphaSource.GetData(), alphaSource.GetSize(), Hash::HashBytes(rgbSource.GetData(), rgbSource.GetSize()));
+		const uint64_t optionsHash = HashOptions(options);
+		pAsset->m_SourceHash = sourceHash;
+		if (pAsset->TryMapCache(cachePath, sourceHash, optionsHash, options.format))
+			return pAsset;
+
+		const DecodedImage rgbImage = DecodeImage(rgbSource);
+		const DecodedImage alphaImage = DecodeImage(alphaSource);
+		if (rgbImage.pixels.empty() || alphaImage.pixels.empty())
+			return nullptr;
+		if (rgbImage.width != alphaImage.width || rgbImage.height != alphaImage.height)
+		{
+			std::cout << "Can't pack " << rgbPath << " and " << alphaPath << ", they aren't the same size\n";
+			return nullptr;
+		}
+
+		std::vector<uint8_t> packed(rgbImage.pixels.size());
+		for (size_t pixel{}; pixel < packed.size(); pixel += 4)
+		{
+			std::memcpy(&packed[pixel], &rgbImage.pixels[pixel], 3);
+			packed[pixel + 3] = alphaImage.pixels[pixel];
+		}
+		pAsset->Import(packed.data(), rgbImage.width, rgbImage.height, rgbImage.width * 4, options, rgbPath);
+
+		pAsset->WriteCache(cachePath, sourceHash, optionsHash);
+		return pAsset;
+	}
+
+	std::string TextureAsset::GetCachePath(const std::string& imagePath)
+	{
+		return std::filesystem::path{ imagePath }.replace_extension(".dtex").string();
+	}
+
+	std::string TextureAsset::GetPackedCachePath(const std::string& rgbPath, const std::string& alphaPath)
+	{
+		std::filesystem::path path{ rgbPath };
+		path.replace_filename(path.stem().string() + "+" + std::filesystem::path{ alphaPath }.stem().string() + ".dtex");
+		return path.string();
+	}
+
+	uint64_t TextureAsset::HashOptions(const TextureImportOptions& options)
+	{
+		//Only what changes the output, the thread pool doesn't
+		const uint32_t values[]{ static_cast<uint32_t>(options.mips.filter), static_cast<uint32_t>(options.mips.content), static_cast<uint32_t>(options.format) };
+		return Hash::HashBytes(values, sizeof(values), g_DTexVersion);
+	}
+
+	size_t TextureAsset::GetUncompressedSize() const
+	{
+		size_t size{};
+		for (const MipLevel& level : m_Levels)
+			size += size_t(level.width) * level.height * 4;
+		return size;
+	}
+
+	void TextureAsset::Import(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const TextureImportOptions& options, const std::string& name)
+	{
+		const MipChain mipChain{ MipMaps::GenerateMipChain(pPixels, width, height, pitch, options.mips) };
+
+		//D3D11 wants the top level of a block compressed texture in whole blocks
+		m_Format = options.format;
+		if (BlockCompression::IsBlockCompressed(options.format) && (width % 4 != 0 || height % 4 != 0))
+		{
+			std::cout << name << " is " << width << "x" << height << ", not a multiple of 4, keeping it uncompressed\n";
+			m_Format = TextureFormat::RGBA8;
+		}
+
+		size_t dataSize{};
+		for (const MipLevel& level : mipChain.levels)
+		{
+			m_OwnedLevels.push_back(MipLevel{ dataSize, level.width, level.height });
+			dataSize += BlockCompression::GetLevelSize(m_Format, level.width, level.height);
+		}
+
+		m_OwnedData.resize(dataSize);
+		for (size_t level{}; level < mipChain.levels.size(); ++level)
+		{
+			const MipLevel& mipLevel = mipChain.levels[level];
+			BlockCompression::Compress(&mipChain.pixels[mipLevel.offset], mipLevel.width, mipLevel.height, m_Format,
+				&m_OwnedData[m_OwnedLevels[level].offset], options.mips.pThreadPool);
+		}
+
+		if (BlockCompression::IsBlockCompressed(m_Format))
+		{
+			std::vector<uint8_t> decoded(size_t(width) * height * 4);
+			BlockCompression::Decompress(m_OwnedData.data(), width, height, m_Format, decoded.data());
+			m_PSNR = BlockCompression::ComputePSNR(mipChain.pixels.data(), decoded.data(), size_t(width) * height, BlockCompression::GetNumChannels(m_Format));
+		}
+
+		m_Levels = m_OwnedLevels;
+		m_Data = m_OwnedData;
+	}
+
+	bool TextureAsset::TryMapCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash, TextureFormat format)
+	{
+		auto pMapping = std::make_unique<FileMapping>(cachePath);
+		if (!pMapping->IsValid() || pMapping->GetSize() < sizeof(DTexHeader))
+			return false;
+
+		DTexHeader header{};
+		std::memcpy(&header, pMapping->GetData(), sizeof(header));
+
+		const DTexHeader expected{};
+		if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != g_DTexVersion ||
+			header.sourceHash != sourceHash || header.optionsHash != optionsHash)
+			return false;
+
+		if (header.format != format && header.format != TextureFormat::RGBA8)
+			return false;
+
+		//Sizes checked one at a time so a corrupt count can't wrap the sum around
+		const size_t payloadSize = pMapping->GetSize() - sizeof(DTexHeader);
+		if (header.numLevels == 0 || header.numLevels > payloadSize / sizeof(MipLevel))
+			return false;
+		const size_t levelBytes = size_t(header.numLevels) * sizeof(MipLevel);
+		if (header.dataSize != payloadSize - levelBytes)
+			return false;
+
+		//Every level has to lie inside the data
+		const char* pLevels = pMapping->GetData() + sizeof(DTexHeader);
+		for (uint32_t index{}; index < header.numLevels; ++index)
+		{
+			MipLevel level{};
+			std::memcpy(&level, pLevels + size_t(index) * sizeof(MipLevel), sizeof(MipLevel));
+			if (level.width == 0 || level.height == 0 || level.width > g_MaxDimension || level.height > g_MaxDimension)
+				return false;
+			const size_t size = BlockCompression::GetLevelSize(header.format, level.width, level.height);
+			if (level.offset > header.dataSize || size > header.dataSize - level.offset)
+				return false;
+		}
+
+		//No decoding or encoding: the spans point straight into the mapped file
+		m_Levels = { reinterpret_cast<const MipLevel*>(pLevels), header.numLevels };
+		m_Data = { reinterpret_cast<const uint8_t*>(pLevels + levelBytes), static_cast<size_t>(header.dataSize) };
+		m_Format = header.format;
+		m_PSNR = header.psnr;
+		m_pMapping = std::move(pMapping);
+		return true;
+	}
+
+	void TextureAsset::WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash) const
+	{
+		DTexHeader header{};
+		header.version = g_DTexVersion;
+		header.sourceHash = sourceHash;
+		header.optionsHash = optionsHash;
+		header.format = m_Format;
+		header.numLevels = static_cast<uint32_t>(m_Levels.size());
+		header.dataSize = m_Data.size();
+		header.psnr = m_PSNR;
+
+		//Write next to it and swap in, so a crash never leaves a half-written cache behind
+		const std::string tempPath = cachePath + ".tmp";
+		bool isWritten{};
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(m_Levels.data()), m_Levels.size_bytes());
+			file.write(reinterpret_cast<const char*>(m_Data.data()), m_Data.size_bytes());
+			isWritten = file.good();
+		}
+
+		std::error_code error{};
+		if (isWritten)
+			std::filesystem::rename(tempPath, cachePath, error);
+		if (!isWritten || error)
+			std::filesystem::remove(tempPath, error);
+	}
+}
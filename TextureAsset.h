@@ -0,0 +1,73 @@
+#pragma once
+#include <cmath>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "BlockCompression.h"
+#include "MipMaps.h"
+
+namespace dae
+{
+	class FileMapping;
+
+	struct TextureImportOptions
+	{
+		MipOptions mips{};
+		//Every level is encoded to this, RGBA8 keeps them uncompressed. BC formats fall back to RGBA8 when the size isn't a multiple of 4.
+		TextureFormat format{ TextureFormat::RGBA8 };
+	};
+
+	//Decoded, mipmapped and encoded texture, either freshly imported from the image or mapped straight from its .dtex cache
+	class TextureAsset final
+	{
+	public:
+		~TextureAsset();
+
+		TextureAsset(const TextureAsset&) = delete;
+		TextureAsset(TextureAsset&&) noexcept = delete;
+		TextureAsset& operator=(const TextureAsset&) = delete;
+		TextureAsset& operator=(TextureAsset&&) noexcept = delete;
+
+		//Uses the .dtex next to the image when it was built from the same file and options, otherwise imports and rewrites it
+		static std::unique_ptr<TextureAsset> Load(const std::string& imagePath, const TextureImportOptions& options = {});
+		static std::string GetCachePath(const std::string& imagePath);
+		//Packs the RGB of one image with the red channel of another in alpha, e.g. specular + glossiness for BC3.
+		//Both images must be the same size. Cached like Load, next to the RGB image.
+		static std::unique_ptr<TextureAsset> LoadPacked(const std::string& rgbPath, const std::string& alphaPath, const TextureImportOptions& options = {});
+		static std::string GetPackedCachePath(const std::string& rgbPath, const std::string& alphaPath);
+		//Covers everything in options that changes the imported texture
+		static uint64_t HashOptions(const TextureImportOptions& options);
+
+		TextureFormat GetFormat() const { return m_Format; };
+		//Offsets are into GetData(), rows are GetRowPitch(GetFormat(), width) apart
+		std::span<const MipLevel> GetLevels() const { return m_Levels; };
+		std::span<const uint8_t> GetData() const { return m_Data; };
+		//What the whole chain would take as RGBA8
+		size_t GetUncompressedSize() const;
+		//Level 0 against the source image over the channels the format keeps, infinite for RGBA8
+		float GetPSNR() const { return m_PSNR; };
+		bool IsFromCache() const { return m_pMapping != nullptr; };
+		//Of the image file(s), equal for copies of the same image under another name
+		uint64_t GetSourceHash() const { return m_SourceHash; };
+
+	private:
+		TextureAsset() = default;
+
+		std::unique_ptr<FileMapping> m_pMapping{};
+		std::vector<MipLevel> m_OwnedLevels{};
+		std::vector<uint8_t> m_OwnedData{};
+
+		TextureFormat m_Format{ TextureFormat::RGBA8 };
+		std::span<const MipLevel> m_Levels{};
+		std::span<const uint8_t> m_Data{};
+		float m_PSNR{ INFINITY };
+		uint64_t m_SourceHash{};
+
+		//Mips and encodes RGBA8 pixels, name is only for messages
+		void Import(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t pitch, const TextureImportOptions& options, const std::string& name);
+		//False, so the texture is imported again, unless the file is a complete cache of format or of the RGBA8 Import falls back to
+		bool TryMapCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash, TextureFormat format);
+		void WriteCache(const std::string& cachePath, uint64_t sourceHash, uint64_t optionsHash) const;
+	};
+}
@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "TextureManager.h"
+#include "Hash.h"
+#include <filesystem>
+#include <iomanip>
+
+namespace dae
+{
+	TextureManager::TextureManager(ID3D11Device* pDevice, TextureStreamer* pStreamer)
+		: m_pDevice{ pDevice }
+		, m_pRegistry{ std::make_shared<Registry>() }
+	{
+		m_pRegistry->pStreamer = pStreamer;
+	}
+
+	std::shared_ptr<Texture> TextureManager::Acquire(const std::string& path, const TextureImportOptions& options)
+	{
+		if (std::shared_ptr<Texture> pTexture = Find(path, options))
+			return pTexture;
+
+		const std::unique_ptr<TextureAsset> pAsset{ TextureAsset::Load(path, options) };
+		if (!pAsset)
+		{
+			std::cout << "Couldn't load " << path << "\n";
+			return nullptr;
+		}
+		return Add(path, options, pAsset.get());
+	}
+
+	std::shared_ptr<Texture> TextureManager::Find(const std::string& path, const TextureImportOptions& options)
+	{
+		return FindHit(GetPathKey(path, TextureAsset::HashOptions(options)));
+	}
+
+	std::shared_ptr<Texture> TextureManager::Add(const std::string& path, const TextureImportOptions& options, const TextureAsset* pAsset)
+	{
+		return AddAsset(path, options, pAsset, nullptr);
+	}
+
+	std::shared_ptr<Texture> TextureManager::Add(const std::string& path, const TextureImportOptions& options, std::shared_ptr<const TextureAsset> pAsset)
+	{
+		const TextureAsset* pRawAsset{ pAsset.get() };
+		return AddAsset(path, options, pRawAsset, m_pRegistry->pStreamer ? std::move(pAsset) : nullptr);
+	}
+
+	void TextureManager::Request(const Texture* pTexture, float uvPerPixel)
+	{
+		Registry& registry = *m_pRegistry;
+		const auto it = registry.streamed.find(pTexture);
+		if (it != registry.streamed.end())
+			registry.pStreamer->Request(it->second, uvPerPixel);
+	}
+
+	std::shared_ptr<Texture> TextureManager::AddAsset(const std::string& path, const TextureImportOptions& options, const TextureAsset* pAsset, std::shared_ptr<const TextureAsset> pStreamedAsset)
+	{
+		if (!pAsset)
+			return nullptr;
+
+		//Two loads of the same path can be in flight when both were queued before either finished
+		const uint64_t optionsHash = TextureAsset::HashOptions(options);
+		const std::string pathKey = GetPathKey(path, optionsHash);
+		if (std::shared_ptr<Texture> pTexture = FindHit(pathKey))
+			return pTexture;
+
+		Registry& registry = *m_pRegistry;
+		const uint64_t contentKey = GetContentKey(pAsset->GetSourceHash(), optionsHash);
+		const auto contentIt = registry.byContent.find(contentKey);
+		if (contentIt != registry.byContent.end())
+		{
+			//Another name for a resident image, remembered so the next request for it is a path hit
+			std::shared_ptr<Texture> pTexture = contentIt->second.lock();
+			registry.byPath[pathKey] = pTexture;
+			++registry.stats.numContentHits;
+			registry.stats.sharedBytes += pTexture->GetSize();
+			return pTexture;
+		}
+
+		//The deleter only holds on weakly, the manager may be gone by the time the last handle is
+		const std::weak_ptr<Registry> pWeakRegistry{ m_pRegistry };
+		std::shared_ptr<Texture> pTexture{ pStreamedAsset ? new Texture{} : new Texture{ path, m_pDevice, pAsset }, [pWeakRegistry](Texture* pLastUse)
+			{
+				if (const std::shared_ptr<Registry> pRegistry = pWeakRegistry.lock())
+				{
+					--pRegistry->stats.numResident;
+					const auto streamedIt = pRegistry->streamed.find(pLastUse);
+					if (streamedIt != pRegistry->streamed.end())
+					{
+						pRegistry->pStreamer->Unregister(streamedIt->second);
+						pRegistry->streamed.erase(streamedIt);
+					}
+					else
+					{
+						pRegistry->stats.residentBytes -= pLastUse->GetSize();
+					}
+					std::erase_if(pRegistry->byPath, [](const auto& entry) { return entry.second.expired(); });
+					std::erase_if(pRegistry->byContent, [](const auto& entry) { return entry.second.expired(); });
+				}
+				delete pLastUse;
+			} };
+
+		registry.byPath[pathKey] = pTexture;
+		registry.byContent[contentKey] = pTexture;
+		++registry.stats.numMisses;
+		++registry.stats.numResident;
+		if (pStreamedAsset)
+		{
+			//Weakly, once the manager is gone the last handle can no longer unregister the texture from the streamer
+			const std::weak_ptr<Texture> pWeakTexture{ pTexture };
+			registry.streamed[pTexture.get()] = registry.pStreamer->Register(path, std::move(pStreamedAsset),
+				[pWeakTexture, pDevice = m_pDevice](const TextureAsset& asset, uint32_t firstLevel, const uint8_t* pLevels)
+				{
+					if (const std::shared_ptr<Texture> pStreamedTexture = pWeakTexture.lock())
+						pStreamedTexture->Upload(pDevice, asset, firstLevel, pLevels);
+				});
+			return pTexture;
+		}
+		registry.stats.residentBytes += pTexture->GetSize();
+		registry.stats.peakResidentBytes = std::max(registry.stats.peakResidentBytes, registry.stats.residentBytes);
+		return pTexture;
+	}
+
+	const TextureManager::Stats& TextureManager::GetStats() const
+	{
+		return m_pRegistry->stats;
+	}
+
+	void TextureManager::PrintStats() const
+	{
+		const Stats& stats = m_pRegistry->stats;
+		constexpr double bytesPerMB{ 1024.0 * 1024.0 };
+		const std::ios::fmtflags flags = std::cout.flags();
+		const std::streamsize precision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(2) << "Textures: " << stats.numPathHits << " path hits, " << stats.numContentHits << " content hits, "
+			<< stats.numMisses << " misses, " << stats.numResident << " resident in " << stats.residentBytes / bytesPerMB << " MB (peak "
+			<< stats.peakResidentBytes / bytesPerMB << " MB), " << stats.sharedBytes / bytesPerMB << " MB not uploaded again\n";
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	std::string TextureManager::GetPathKey(const std::string& path, uint64_t optionsHash)
+	{
+		//Different spellings of the same file share a key, an import with other options is another texture
+		std::error_code error{};
+		std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(path, error);
+		if (error)
+			canonicalPath = std::filesystem::path{ path }.lexically_normal();
+		return canonicalPath.generic_string() + '|' + std::to_string(optionsHash);
+	}
+
+	uint64_t TextureManager::GetContentKey(uint64_t sourceHash, uint64_t optionsHash)
+	{
+		return Hash::HashBytes(&sourceHash, sizeof(sourceHash), optionsHash);
+	}
+
+	std::shared_ptr<Texture> TextureManager::FindHit(const std::string& pathKey)
+	{
+		Registry& registry = *m_pRegistry;
+		const auto it = registry.byPath.find(pathKey);
+		if (it == registry.byPath.end())
+			return nullptr;
+
+		std::shared_ptr<Texture> pTexture = it->second.lock();
+		++registry.stats.numPathHits;
+		registry.stats.sharedBytes += pTexture->GetSize();
+		return pTexture;
+	}
+}
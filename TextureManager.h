@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Texture.h"
+#include "TextureStreamer.h"
+
+namespace dae
+{
+	//Hands out shared textures, so a map used by many meshes is decoded and uploaded once. Textures are found by
+	//canonical path and, for copies under another name, by the hash of the image file. The last handle to go frees it.
+	//Only for the thread that owns the device, AssetLoader hands its results back there.
+	class TextureManager final
+	{
+	public:
+		struct Stats
+		{
+			//Requests served by a texture that was already resident, by path or by the content of another file
+			uint32_t numPathHits{};
+			uint32_t numContentHits{};
+			//Requests that uploaded a new texture
+			uint32_t numMisses{};
+			uint32_t numResident{};
+			//Of the textures that aren't streamed, TextureStreamer::Stats has the rest
+			size_t residentBytes{};
+			size_t peakResidentBytes{};
+			//What the hits would have uploaded again without sharing
+			size_t sharedBytes{};
+		};
+
+		//Without a streamer every level of every texture is uploaded. With one, assets added as shared_ptr are streamed, the streamer
+		//has to outlive the manager.
+		TextureManager(ID3D11Device* pDevice, TextureStreamer* pStreamer = nullptr);
+		//Handles still out keep their textures alive, they are just no longer tracked
+		~TextureManager() = default;
+
+		TextureManager(const TextureManager&) = delete;
+		TextureManager(TextureManager&&) noexcept = delete;
+		TextureManager& operator=(const TextureManager&) = delete;
+		TextureManager& operator=(TextureManager&&) noexcept = delete;
+
+		//The resident texture for the path, imported and uploaded on this thread when there is none. nullptr if it can't be loaded.
+		std::shared_ptr<Texture> Acquire(const std::string& path, const TextureImportOptions& options = {});
+		//Only the lookup by path, to skip queuing a load for what is already resident
+		std::shared_ptr<Texture> Find(const std::string& path, const TextureImportOptions& options);
+		//Registers an asset imported elsewhere, returning the resident copy instead when its path or content already is
+		std::shared_ptr<Texture> Add(const std::string& path, const TextureImportOptions& options, const TextureAsset* pAsset);
+		//Same, but the texture starts at a small level and the streamer keeps the asset to load the finer ones from
+		std::shared_ptr<Texture> Add(const std::string& path, const TextureImportOptions& options, std::shared_ptr<const TextureAsset> pAsset);
+		//Passes how much detail a mesh needs this frame on to the streamer, nothing for textures that aren't streamed
+		void Request(const Texture* pTexture, float uvPerPixel);
+
+		const Stats& GetStats() const;
+		void PrintStats() const;
+
+	private:
+		//Shared with the deleters of the handed out textures, which may outlive the manager
+		struct Registry
+		{
+			std::unordered_map<std::string, std::weak_ptr<Texture>> byPath{};
+			std::unordered_map<uint64_t, std::weak_ptr<Texture>> byContent{};
+			std::unordered_map<const Texture*, TextureStreamer::Handle> streamed{};
+			TextureStreamer* pStreamer{};
+			Stats stats{};
+		};
+
+		ID3D11Device* m_pDevice{};
+		std::shared_ptr<Registry> m_pRegistry{};
+
+		static std::string GetPathKey(const std::string& path, uint64_t optionsHash);
+		static uint64_t GetContentKey(uint64_t sourceHash, uint64_t optionsHash);
+		std::shared_ptr<Texture> FindHit(const std::string& pathKey);
+		//pStreamedAsset is pAsset when it should be streamed
+		std::shared_ptr<Texture> AddAsset(const std::string& path, const TextureImportOptions& options, const TextureAsset* pAsset, std::shared_ptr<const TextureAsset> pStreamedAsset);
+	};
+}
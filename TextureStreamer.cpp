@@ -0,0 +1,299 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "Camera.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <iomanip>
+
+namespace dae
+{
+	TextureStreamer::TextureStreamer(ThreadPool* pThreadPool, const TextureStreamingOptions& options)
+		: m_pThreadPool{ pThreadPool }
+		, m_Options{ options }
+	{
+		assert(m_pThreadPool && "TextureStreamer needs a thread pool to load on");
+	}
+
+	TextureStreamer::Handle TextureStreamer::Register(const std::string& name, std::shared_ptr<const TextureAsset> pAsset, UploadFunction upload)
+	{
+		assert(pAsset && !pAsset->GetLevels().empty());
+		const std::span<const MipLevel> levels = pAsset->GetLevels();
+
+		Entry entry{};
+		entry.name = name;
+		entry.upload = std::move(upload);
+		entry.startLevel = static_cast<uint32_t>(levels.size() - 1);
+		for (uint32_t level{}; level < levels.size(); ++level)
+		{
+			if (std::max(levels[level].width, levels[level].height) <= m_Options.startSize)
+			{
+				entry.startLevel = level;
+				break;
+			}
+		}
+		//Nothing is resident yet, one past the coarsest level
+		entry.residentLevel = static_cast<uint32_t>(levels.size());
+		entry.requestedLevel = entry.startLevel;
+		entry.pAsset = std::move(pAsset);
+
+		const Handle handle{ m_NextHandle++ };
+		Entry& registered = m_Entries.emplace(handle, std::move(entry)).first->second;
+		//The small levels are in the mapped cache or in memory already, not worth a trip through the pool
+		Upload(registered, registered.startLevel, registered.pAsset->GetData().data() + registered.pAsset->GetLevels()[registered.startLevel].offset);
+		++m_Stats.numTextures;
+		return handle;
+	}
+
+	void TextureStreamer::Unregister(Handle handle)
+	{
+		const auto it = m_Entries.find(handle);
+		if (it == m_Entries.end())
+			return;
+
+		Entry& entry = it->second;
+		//The load holds on to the asset itself, its result is simply never picked up
+		if (entry.pendingLoad.valid())
+			m_ReservedBytes -= GetResidentSize(*entry.pAsset, entry.pendingLevel) - GetResidentSize(*entry.pAsset, entry.residentLevel);
+		m_Stats.residentBytes -= GetResidentSize(*entry.pAsset, entry.residentLevel);
+		--m_Stats.numTextures;
+		m_Entries.erase(it);
+	}
+
+	void TextureStreamer::Request(Handle handle, float uvPerPixel)
+	{
+		const auto it = m_Entries.find(handle);
+		if (it == m_Entries.end())
+			return;
+
+		Entry& entry = it->second;
+		const uint32_t level = std::min(GetLevelForUVPerPixel(*entry.pAsset, uvPerPixel, m_Options.levelBias), entry.startLevel);
+		entry.requestedLevel = entry.lastRequestFrame == m_Frame ? std::min(entry.requestedLevel, level) : level;
+		entry.lastRequestFrame = m_Frame;
+	}
+
+	bool TextureStreamer::Update()
+	{
+		const uint32_t numUploads{ m_Stats.numUploads };
+		FinishLoads();
+		//Also catches a budget that was lowered since the last frame
+		MakeRoom(0, nullptr);
+		StartLoads();
+		++m_Frame;
+		return m_Stats.numUploads != numUploads;
+	}
+
+	uint32_t TextureStreamer::GetResidentLevel(Handle handle) const
+	{
+		const auto it = m_Entries.find(handle);
+		return it != m_Entries.end() ? it->second.residentLevel : 0;
+	}
+
+	uint32_t TextureStreamer::GetRequestedLevel(Handle handle) const
+	{
+		const auto it = m_Entries.find(handle);
+		return it != m_Entries.end() ? it->second.requestedLevel : 0;
+	}
+
+	bool TextureStreamer::IsLoading(Handle handle) const
+	{
+		const auto it = m_Entries.find(handle);
+		return it != m_Entries.end() && it->second.pendingLoad.valid();
+	}
+
+	uint32_t TextureStreamer::GetNumPendingLoads() const
+	{
+		return static_cast<uint32_t>(std::count_if(m_Entries.begin(), m_Entries.end(), [](const auto& entry) { return entry.second.pendingLoad.valid(); }));
+	}
+
+	void TextureStreamer::SetBudget(size_t budgetBytes)
+	{
+		m_Options.budgetBytes = budgetBytes;
+	}
+
+	const TextureStreamer::Stats& TextureStreamer::GetStats() const
+	{
+		return m_Stats;
+	}
+
+	void TextureStreamer::PrintStats() const
+	{
+		constexpr double bytesPerMB{ 1024.0 * 1024.0 };
+		const std::ios::fmtflags flags = std::cout.flags();
+		const std::streamsize precision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(2) << "Streaming: " << m_Stats.numTextures << " textures in " << m_Stats.residentBytes / bytesPerMB << " of "
+			<< m_Options.budgetBytes / bytesPerMB << " MB (peak " << m_Stats.peakResidentBytes / bytesPerMB << " MB), " << m_Stats.numLoads << " loads ("
+			<< m_Stats.loadedBytes / bytesPerMB << " MB), " << m_Stats.numEvictions << " levels evicted (" << m_Stats.evictedBytes / bytesPerMB << " MB), "
+			<< m_Stats.numClampedLoads << " loads clamped to the budget\n";
+
+		std::vector<const Entry*> entries{};
+		for (const auto& [handle, entry] : m_Entries)
+			entries.push_back(&entry);
+		std::sort(entries.begin(), entries.end(), [](const Entry* pA, const Entry* pB) { return pA->name < pB->name; });
+		for (const Entry* pEntry : entries)
+		{
+			const MipLevel& resident = pEntry->pAsset->GetLevels()[pEntry->residentLevel];
+			std::cout << "  " << std::left << std::setw(32) << pEntry->name << std::right << " level " << pEntry->residentLevel << " (" << resident.width << "x" << resident.height
+				<< "), requested " << pEntry->requestedLevel << ", " << GetResidentSize(*pEntry->pAsset, pEntry->residentLevel) / bytesPerMB << " MB"
+				<< (pEntry->pendingLoad.valid() ? ", loading level " + std::to_string(pEntry->pendingLevel) : std::string{}) << "\n";
+		}
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	float TextureStreamer::ComputeWorldPerUV(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+	{
+		//Ratio of the summed areas, so small triangles with stretched UVs don't outweigh the bulk of the surface
+		double worldArea{}, uvArea{};
+		for (size_t index{}; index + 2 < indices.size(); index += 3)
+		{
+			const Vertex& v0 = vertices[indices[index]];
+			const Vertex& v1 = vertices[indices[index + 1]];
+			const Vertex& v2 = vertices[indices[index + 2]];
+			worldArea += Vector3::Cross(v1.position - v0.position, v2.position - v0.position).Magnitude();
+			uvArea += std::abs(Vector2::Cross(v1.uv - v0.uv, v2.uv - v0.uv));
+		}
+		if (uvArea <= 0.0)
+			return 0.f;
+		return static_cast<float>(std::sqrt(worldArea / uvArea));
+	}
+
+	float TextureStreamer::ComputeUVPerPixel(float worldPerUV, const Vector3& center, float radius, const Camera& camera, float viewportHeight)
+	{
+		//Without UVs any level looks the same, the coarsest will do
+		if (worldPerUV <= 0.f)
+			return INFINITY;
+
+		//Same projection as Mesh::UpdateLOD, camera.fov is tan(fovAngle / 2)
+		const float distance = std::max((center - camera.origin).Magnitude() - radius, camera.nearPlane);
+		const float worldPerPixel = 2.f * camera.fov * distance / viewportHeight;
+		return worldPerPixel / worldPerUV;
+	}
+
+	uint32_t TextureStreamer::GetLevelForUVPerPixel(const TextureAsset& asset, float uvPerPixel, float bias)
+	{
+		const std::span<const MipLevel> levels = asset.GetLevels();
+		const uint32_t coarsest = static_cast<uint32_t>(levels.size() - 1);
+
+		//Texels of level 0 per pixel along the larger axis, each level halves it
+		const float texelsPerPixel = uvPerPixel * std::max(levels[0].width, levels[0].height);
+		const float level = std::floor(std::log2(texelsPerPixel) + bias);
+		if (!(level > 0.f))
+			return 0;
+		return level >= coarsest ? coarsest : static_cast<uint32_t>(level);
+	}
+
+	size_t TextureStreamer::GetResidentSize(const TextureAsset& asset, uint32_t firstLevel)
+	{
+		const std::span<const MipLevel> levels = asset.GetLevels();
+		if (firstLevel >= levels.size())
+			return 0;
+		return asset.GetData().size() - levels[firstLevel].offset;
+	}
+
+	void TextureStreamer::Upload(Entry& entry, uint32_t firstLevel, const uint8_t* pLevels)
+	{
+		m_Stats.residentBytes -= GetResidentSize(*entry.pAsset, entry.residentLevel);
+		entry.upload(*entry.pAsset, firstLevel, pLevels);
+		entry.residentLevel = firstLevel;
+		m_Stats.residentBytes += GetResidentSize(*entry.pAsset, entry.residentLevel);
+		m_Stats.peakResidentBytes = std::max(m_Stats.peakResidentBytes, m_Stats.residentBytes);
+		++m_Stats.numUploads;
+	}
+
+	void TextureStreamer::FinishLoads()
+	{
+		for (auto& [handle, entry] : m_Entries)
+		{
+			if (!entry.pendingLoad.valid() || entry.pendingLoad.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+				continue;
+
+			const std::vector<uint8_t> levels = entry.pendingLoad.get();
+			const size_t addedBytes = GetResidentSize(*entry.pAsset, entry.pendingLevel) - GetResidentSize(*entry.pAsset, entry.residentLevel);
+			m_ReservedBytes -= addedBytes;
+			Upload(entry, entry.pendingLevel, levels.data());
+			++m_Stats.numLoads;
+			m_Stats.loadedBytes += addedBytes;
+		}
+	}
+
+	bool TextureStreamer::MakeRoom(size_t bytes, const Entry* pFor)
+	{
+		const auto fits = [this, bytes]() { return m_Stats.residentBytes + m_ReservedBytes + bytes <= m_Options.budgetBytes; };
+		if (fits())
+			return true;
+
+		//Least recently requested first. What was requested this frame keeps the levels it asked for, the rest can go down to the start level.
+		std::vector<Entry*> victims{};
+		for (auto& [handle, entry] : m_Entries)
+		{
+			if (&entry != pFor && !entry.pendingLoad.valid())
+				victims.push_back(&entry);
+		}
+		std::sort(victims.begin(), victims.end(), [](const Entry* pA, const Entry* pB) { return pA->lastRequestFrame < pB->lastRequestFrame; });
+
+		for (Entry* pVictim : victims)
+		{
+			const uint32_t limit = pVictim->lastRequestFrame == m_Frame ? pVictim->requestedLevel : pVictim->startLevel;
+			if (pVictim->residentLevel >= limit)
+				continue;
+
+			uint32_t level = pVictim->residentLevel;
+			const size_t residentBytes = GetResidentSize(*pVictim->pAsset, level);
+			while (level < limit && m_Stats.residentBytes - (residentBytes - GetResidentSize(*pVictim->pAsset, level)) + m_ReservedBytes + bytes > m_Options.budgetBytes)
+				++level;
+
+			//The coarser levels are still in the asset, nothing to read back
+			m_Stats.numEvictions += level - pVictim->residentLevel;
+			m_Stats.evictedBytes += residentBytes - GetResidentSize(*pVictim->pAsset, level);
+			Upload(*pVictim, level, pVictim->pAsset->GetData().data() + pVictim->pAsset->GetLevels()[level].offset);
+			if (fits())
+				return true;
+		}
+		return false;
+	}
+
+	void TextureStreamer::StartLoads()
+	{
+		//The blurriest textures in use first
+		std::vector<Entry*> wanted{};
+		for (auto& [handle, entry] : m_Entries)
+		{
+			if (entry.lastRequestFrame == m_Frame && entry.requestedLevel < entry.residentLevel && !entry.pendingLoad.valid())
+				wanted.push_back(&entry);
+		}
+		std::sort(wanted.begin(), wanted.end(), [](const Entry* pA, const Entry* pB) { return pA->residentLevel - pA->requestedLevel > pB->residentLevel - pB->requestedLevel; });
+
+		uint32_t numPending{ GetNumPendingLoads() };
+		for (Entry* pEntry : wanted)
+		{
+			if (numPending >= m_Options.maxPendingLoads)
+				break;
+
+			const TextureAsset& asset = *pEntry->pAsset;
+			const size_t residentBytes = GetResidentSize(asset, pEntry->residentLevel);
+			uint32_t level = pEntry->requestedLevel;
+			if (!MakeRoom(GetResidentSize(asset, level) - residentBytes, pEntry))
+			{
+				//Everything that could go is gone, settle for the finest level that still fits
+				const size_t used = m_Stats.residentBytes + m_ReservedBytes;
+				const size_t freeBytes = used < m_Options.budgetBytes ? m_Options.budgetBytes - used : 0;
+				while (level < pEntry->residentLevel && GetResidentSize(asset, level) - residentBytes > freeBytes)
+					++level;
+				if (level == pEntry->residentLevel)
+					continue;
+				++m_Stats.numClampedLoads;
+			}
+
+			m_ReservedBytes += GetResidentSize(asset, level) - residentBytes;
+			pEntry->pendingLevel = level;
+			//Reading the levels out of the mapped cache is what touches the disk
+			const size_t offset = asset.GetLevels()[level].offset;
+			pEntry->pendingLoad = m_pThreadPool->Submit([pAsset = pEntry->pAsset, offset]()
+				{
+					const std::span<const uint8_t> data = pAsset->GetData();
+					return std::vector<uint8_t>(data.begin() + offset, data.end());
+				});
+			++numPending;
+		}
+	}
+}
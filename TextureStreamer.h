@@ -0,0 +1,126 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Datatypes.h"
+#include "TextureAsset.h"
+
+namespace dae
+{
+	class ThreadPool;
+	struct Camera;
+
+	struct TextureStreamingOptions
+	{
+		//Over all streamed textures, the small levels every texture starts with count too and are never dropped
+		size_t budgetBytes{ 32 * 1024 * 1024 };
+		//Largest dimension of the level a texture starts at
+		uint32_t startSize{ 64 };
+		//Reads in flight at once
+		uint32_t maxPendingLoads{ 4 };
+		//Added to the estimated level, above 0 trades sharpness for memory
+		float levelBias{ 0.f };
+	};
+
+	//Keeps only the mip levels the screen needs resident. Every texture starts at a small level, finer levels are read from the asset on
+	//the thread pool when a mesh asks for them and dropped again, least recently used first, when they don't fit the budget.
+	//Knows nothing about the device: textures are (re)created through the upload function each one is registered with, so the
+	//residency logic runs against a null device in the streaming benchmark, also in the CPU-only build on Linux (CMakeLists.txt).
+	//Only for the thread that owns the device, like TextureManager.
+	class TextureStreamer final
+	{
+	public:
+		struct Stats
+		{
+			uint32_t numTextures{};
+			size_t residentBytes{};
+			size_t peakResidentBytes{};
+			//Finer levels read in and dropped again
+			uint32_t numLoads{};
+			uint32_t numEvictions{};
+			size_t loadedBytes{};
+			size_t evictedBytes{};
+			//Loads started coarser than requested because the budget was full of textures in use
+			uint32_t numClampedLoads{};
+			uint32_t numUploads{};
+		};
+
+		using Handle = uint32_t;
+		//Creates the texture anew from levels [firstLevel, end) of the asset, pLevels holds them laid out like in asset.GetData()
+		using UploadFunction = std::function<void(const TextureAsset& asset, uint32_t firstLevel, const uint8_t* pLevels)>;
+
+		TextureStreamer(ThreadPool* pThreadPool, const TextureStreamingOptions& options = {});
+		~TextureStreamer() = default;
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer(TextureStreamer&&) noexcept = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(TextureStreamer&&) noexcept = delete;
+
+		//Uploads the start level right away, name is only for PrintStats
+		Handle Register(const std::string& name, std::shared_ptr<const TextureAsset> pAsset, UploadFunction upload);
+		//Loads still in flight finish on the pool and are thrown away
+		void Unregister(Handle handle);
+
+		//How much of the texture a mesh needs this frame, see ComputeUVPerPixel. The finest request of the frame wins.
+		void Request(Handle handle, float uvPerPixel);
+		//Makes finished loads resident, drops levels over the budget and starts loads for the requests since the last call.
+		//Returns true if a texture was created anew, its view has to be bound again.
+		bool Update();
+
+		//Finest level on the device
+		uint32_t GetResidentLevel(Handle handle) const;
+		//Finest level asked for since the last Update
+		uint32_t GetRequestedLevel(Handle handle) const;
+		bool IsLoading(Handle handle) const;
+		uint32_t GetNumPendingLoads() const;
+
+		void SetBudget(size_t budgetBytes);
+		const Stats& GetStats() const;
+		void PrintStats() const;
+
+		//Object space length per unit of UV, averaged over the surface so a texture's texel density follows from its size
+		static float ComputeWorldPerUV(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+		//UV units covered by one pixel at the closest point of the bounding sphere, which is in world space
+		static float ComputeUVPerPixel(float worldPerUV, const Vector3& center, float radius, const Camera& camera, float viewportHeight);
+		//Level where one texel covers about one pixel, 0 when even level 0 is magnified
+		static uint32_t GetLevelForUVPerPixel(const TextureAsset& asset, float uvPerPixel, float bias = 0.f);
+		//Bytes of levels [firstLevel, end)
+		static size_t GetResidentSize(const TextureAsset& asset, uint32_t firstLevel);
+
+	private:
+		struct Entry
+		{
+			std::string name{};
+			std::shared_ptr<const TextureAsset> pAsset{};
+			UploadFunction upload{};
+			//Coarsest level the texture ever drops to, the one it starts at
+			uint32_t startLevel{};
+			uint32_t residentLevel{};
+			uint32_t requestedLevel{};
+			uint64_t lastRequestFrame{};
+			//Levels [pendingLevel, end) copied out of the asset on the pool
+			std::future<std::vector<uint8_t>> pendingLoad{};
+			uint32_t pendingLevel{};
+		};
+
+		ThreadPool* m_pThreadPool{};
+		TextureStreamingOptions m_Options{};
+		std::unordered_map<Handle, Entry> m_Entries{};
+		Handle m_NextHandle{};
+		uint64_t m_Frame{ 1 };
+		//Bytes the pending loads will add on top of the resident ones
+		size_t m_ReservedBytes{};
+		Stats m_Stats{};
+
+		void Upload(Entry& entry, uint32_t firstLevel, const uint8_t* pLevels);
+		void FinishLoads();
+		//Drops levels of other textures until bytes more fit, those requested this frame only down to what they need
+		bool MakeRoom(size_t bytes, const Entry* pFor);
+		void StartLoads();
+	};
+}
@@ -0,0 +1,187 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include <cassert>
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t numWorkers)
+	{
+		m_Workers.reserve(numWorkers);
+		for (uint32_t i{}; i < numWorkers; ++i)
+			m_Workers.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	void ThreadPool::Enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_Tasks.push_back(std::move(task));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function, size_t minBatchSize)
+	{
+		if (count == 0)
+			return;
+
+		//A few batches per thread so uneven batches still balance out
+		const size_t maxBatches = (count + minBatchSize - 1) / std::max<size_t>(minBatchSize, 1);
+		const size_t numBatches = std::min(maxBatches, (static_cast<size_t>(GetNumWorkers()) + 1) * 4);
+		if (numBatches <= 1 || m_Workers.empty())
+		{
+			function(0, count);
+			return;
+		}
+
+		//Batches are handed out through a counter that only this loop shares. Waiting, the calling thread never runs another task from
+		//the queue, which could be a long import, and helpers that only start once every batch was taken find nothing left, so the
+		//counters live as long as the last of them.
+		struct Batches
+		{
+			const std::function<void(size_t begin, size_t end)>* pFunction{};
+			size_t count{};
+			size_t numBatches{};
+			std::atomic<size_t> nextBatch{};
+			std::atomic<size_t> numRemaining{};
+		};
+		const auto pBatches = std::make_shared<Batches>();
+		pBatches->pFunction = &function;
+		pBatches->count = count;
+		pBatches->numBatches = numBatches;
+		pBatches->numRemaining.store(numBatches, std::memory_order_relaxed);
+		const auto runBatches = [](Batches& batches)
+			{
+				for (size_t batch{ batches.nextBatch.fetch_add(1, std::memory_order_relaxed) }; batch < batches.numBatches;
+					batch = batches.nextBatch.fetch_add(1, std::memory_order_relaxed))
+				{
+					(*batches.pFunction)(batches.count * batch / batches.numBatches, batches.count * (batch + 1) / batches.numBatches);
+					batches.numRemaining.fetch_sub(1, std::memory_order_acq_rel);
+				}
+			};
+
+		const size_t numHelpers = std::min<size_t>(numBatches - 1, GetNumWorkers());
+		for (size_t helper{}; helper < numHelpers; ++helper)
+			Enqueue([pBatches, runBatches]() { runBatches(*pBatches); });
+
+		//Only batches already running on workers are left after this
+		runBatches(*pBatches);
+		while (pBatches->numRemaining.load(std::memory_order_acquire) > 0)
+			std::this_thread::yield();
+	}
+
+	uint32_t ThreadPool::ParallelForStealing(size_t count, const std::function<void(size_t index, uint32_t thread)>& function)
+	{
+		if (count == 0)
+			return 0;
+
+		const uint32_t numThreads = static_cast<uint32_t>(std::min<size_t>(GetNumWorkers() + 1, count));
+		if (numThreads <= 1)
+		{
+			for (size_t index{}; index < count; ++index)
+				function(index, 0);
+			return 0;
+		}
+
+		//A share is [begin, end) packed into one word so the owner taking the front and thieves taking the back agree through one CAS.
+		//Begin only grows and end only shrinks until the share runs dry, and an index is never handed out twice, so no value comes back.
+		//Like ParallelFor's batches the shares are only this loop's, and outlive it for participants that start after everything is done.
+		assert(count <= UINT32_MAX);
+		const auto pack = [](uint64_t begin, uint64_t end) { return (begin << 32) | end; };
+		struct Shares
+		{
+			const std::function<void(size_t index, uint32_t thread)>* pFunction{};
+			std::vector<std::atomic<uint64_t>> ranges{};
+			std::atomic<size_t> numRemaining{};
+			std::atomic<uint32_t> numSteals{};
+			//The calling thread is 0
+			std::atomic<uint32_t> nextThread{ 1 };
+		};
+		const auto pShares = std::make_shared<Shares>();
+		pShares->pFunction = &function;
+		pShares->ranges = std::vector<std::atomic<uint64_t>>(numThreads);
+		for (uint32_t thread{}; thread < numThreads; ++thread)
+			pShares->ranges[thread].store(pack(count * thread / numThreads, count * (thread + 1) / numThreads), std::memory_order_relaxed);
+		pShares->numRemaining.store(count, std::memory_order_relaxed);
+
+		const auto participate = [pack](Shares& shares, uint32_t thread)
+			{
+				const uint32_t numThreads = static_cast<uint32_t>(shares.ranges.size());
+				std::atomic<uint64_t>& share = shares.ranges[thread];
+				while (shares.numRemaining.load(std::memory_order_acquire) > 0)
+				{
+					//Own share first, from the front
+					uint64_t range = share.load(std::memory_order_acquire);
+					const uint64_t begin = range >> 32, end = range & UINT32_MAX;
+					if (begin < end)
+					{
+						if (share.compare_exchange_weak(range, pack(begin + 1, end), std::memory_order_acq_rel))
+						{
+							(*shares.pFunction)(begin, thread);
+							shares.numRemaining.fetch_sub(1, std::memory_order_acq_rel);
+						}
+						continue;
+					}
+
+					//Then the back half of the first other share with anything left
+					bool hasStolen{ false };
+					for (uint32_t offset{ 1 }; offset < numThreads && !hasStolen; ++offset)
+					{
+						std::atomic<uint64_t>& victim = shares.ranges[(thread + offset) % numThreads];
+						uint64_t victimRange = victim.load(std::memory_order_acquire);
+						const uint64_t victimBegin = victimRange >> 32, victimEnd = victimRange & UINT32_MAX;
+						if (victimBegin >= victimEnd)
+							continue;
+
+						const uint64_t stolenBegin = victimEnd - std::max<uint64_t>((victimEnd - victimBegin) / 2, 1);
+						if (victim.compare_exchange_strong(victimRange, pack(victimBegin, stolenBegin), std::memory_order_acq_rel))
+						{
+							//Only this thread writes its own share while it is dry
+							share.store(pack(stolenBegin, victimEnd), std::memory_order_release);
+							shares.numSteals.fetch_add(1, std::memory_order_relaxed);
+							hasStolen = true;
+						}
+					}
+					if (!hasStolen)
+						std::this_thread::yield();
+				}
+			};
+
+		for (uint32_t thread{ 1 }; thread < numThreads; ++thread)
+			Enqueue([pShares, participate]() { participate(*pShares, pShares->nextThread.fetch_add(1, std::memory_order_relaxed)); });
+
+		//Returns once every index has run, whichever thread ran it
+		participate(*pShares, 0);
+		return pShares->numSteals.load(std::memory_order_relaxed);
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_Condition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+				if (m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop_front();
+			}
+			task();
+		}
+	}
+}
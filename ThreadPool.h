@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		//numWorkers can be 0, ParallelFor then runs everything on the calling thread
+		ThreadPool(uint32_t numWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		void Enqueue(std::function<void()> task);
+
+		//Enqueue with a future for the result. Without workers the function runs right away on the calling thread.
+		template<typename Function>
+		auto Submit(Function&& function) -> std::future<std::invoke_result_t<Function>>
+		{
+			auto pTask = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::forward<Function>(function));
+			auto future = pTask->get_future();
+			if (m_Workers.empty())
+				(*pTask)();
+			else
+				Enqueue([pTask]() { (*pTask)(); });
+			return future;
+		}
+
+		//Calls function(begin, end) on batches of [0, count) and returns when all are done.
+		//The calling thread works along, so this is also safe to call from inside a task. It only ever runs this loop's batches,
+		//never other tasks from the queue.
+		void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& function, size_t minBatchSize = 1);
+
+		//Calls function(index, thread) once for every index of [0, count) and returns when all are done. Every thread, the calling one
+		//being thread 0, starts on an equal share and takes one index at a time from its front; a thread that runs dry steals the back
+		//half of another's share, so a few expensive indices don't leave the rest waiting. Like ParallelFor, the calling thread only
+		//runs this loop's indices. Returns the number of steals.
+		uint32_t ParallelForStealing(size_t count, const std::function<void(size_t index, uint32_t thread)>& function);
+
+		uint32_t GetNumWorkers() const { return static_cast<uint32_t>(m_Workers.size()); };
+
+	private:
+		std::vector<std::thread> m_Workers{};
+		std::deque<std::function<void()>> m_Tasks{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		bool m_IsStopping{ false };
+
+		void WorkerLoop();
+	};
+}
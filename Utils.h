@@ -2,6 +2,7 @@
 #include <fstream>
 #include "Math.h"
 #include "Datatypes.h"
+#include "ObjParser.h"
 #include <vector>
 
 namespace dae
@@ -9,9 +10,10 @@ namespace dae
 	namespace Utils
 	{
 		//Just parses vertices and indices
+		//Original ifstream parser, kept as the reference for ParseOBJ (ObjParser.h)
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		static bool ParseOBJReference(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
 		{
 			std::ifstream file(filename);
 			if (!file)
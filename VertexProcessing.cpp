@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "VertexProcessing.h"
+#include "CPUFeatures.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		uint8_t GetClipCode(const Vector4& position)
+		{
+			uint8_t code{};
+			code |= position.x < -position.w ? ClipLeft : 0;
+			code |= position.x > position.w ? ClipRight : 0;
+			code |= position.y < -position.w ? ClipBottom : 0;
+			code |= position.y > position.w ? ClipTop : 0;
+			code |= position.w <= 0.f || position.z < 0.f ? ClipNear : 0;
+			code |= position.z > position.w ? ClipFar : 0;
+			return code;
+		}
+
+		//A matrix as 16 broadcast registers, [row][column]
+		struct MatrixAVX
+		{
+			__m256 m[4][4];
+
+			DAE_TARGET_AVX2 explicit MatrixAVX(const Matrix& matrix)
+			{
+				for (int row{}; row < 4; ++row)
+				{
+					const Vector4 values = matrix[row];
+					m[row][0] = _mm256_set1_ps(values.x);
+					m[row][1] = _mm256_set1_ps(values.y);
+					m[row][2] = _mm256_set1_ps(values.z);
+					m[row][3] = _mm256_set1_ps(values.w);
+				}
+			}
+
+			//Column of Matrix::TransformVector, the same sums in the same order
+			DAE_TARGET_AVX2 __m256 TransformVector(int column, __m256 x, __m256 y, __m256 z) const
+			{
+				return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0][column], x), _mm256_mul_ps(m[1][column], y)), _mm256_mul_ps(m[2][column], z));
+			}
+
+			//Column of Matrix::TransformPoint
+			DAE_TARGET_AVX2 __m256 TransformPoint(int column, __m256 x, __m256 y, __m256 z) const
+			{
+				return _mm256_add_ps(TransformVector(column, x, y, z), m[3][column]);
+			}
+		};
+	}
+
+	VertexProcessor::VertexProcessor(ThreadPool* pThreadPool)
+		: m_pThreadPool{ pThreadPool }
+		, m_IsSIMDEnabled{ CPUFeatures::HasAVX2() }
+	{
+	}
+
+	const TransformedVertices& VertexProcessor::Process(std::span<const Vertex> vertices, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix)
+	{
+		static_assert(sizeof(Matrix) == sizeof(m_CachedMatrices[0]));
+		++m_Stats.numCalls;
+		//Bitwise, a matrix that only differs in the sign of a zero transforms again
+		if (m_IsCached && m_pCachedVertices == vertices.data() && m_NumCachedVertices == vertices.size()
+			&& std::memcmp(m_CachedMatrices[0], &worldMatrix, sizeof(Matrix)) == 0 && std::memcmp(m_CachedMatrices[1], &worldViewProjMatrix, sizeof(Matrix)) == 0)
+		{
+			++m_Stats.numCacheHits;
+			return m_Output;
+		}
+
+		//One allocation, every stream a cache line further into a page than the last. Separate, equally large and page aligned ones would
+		//all map to the same cache sets and evict each other on buffers of a few MB.
+		const size_t numPadded = (vertices.size() + 7) / 8 * 8;
+		const size_t streamStride = numPadded + 16;
+		m_Output.buffer.resize(streamStride * TransformedVertices::NumStreams);
+		for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+			m_Output.streams[stream] = std::span<float>{ m_Output.buffer }.subspan(stream * streamStride, numPadded);
+		m_Output.clipCodes.resize(numPadded);
+		m_Output.numVertices = vertices.size();
+
+		//Chunks of whole blocks of 8 so no two threads write the same cache line of a stream
+		const bool isSIMDEnabled = m_IsSIMDEnabled;
+		const auto transform = [this, vertices, &worldMatrix, &worldViewProjMatrix, isSIMDEnabled](size_t beginBlock, size_t endBlock)
+			{
+				const size_t begin = beginBlock * 8, end = std::min(endBlock * 8, vertices.size());
+				if (isSIMDEnabled)
+					TransformAVX(vertices.data(), vertices.size(), begin, end, worldMatrix, worldViewProjMatrix);
+				else
+					TransformScalar(vertices.data(), begin, end, worldMatrix, worldViewProjMatrix);
+			};
+		const size_t numBlocks = numPadded / 8;
+		if (m_pThreadPool)
+			m_pThreadPool->ParallelFor(numBlocks, transform, m_MinChunkSize / 8);
+		else
+			transform(0, numBlocks);
+		m_Stats.numTransformed += vertices.size();
+
+		m_IsCached = true;
+		m_pCachedVertices = vertices.data();
+		m_NumCachedVertices = vertices.size();
+		std::memcpy(m_CachedMatrices[0], &worldMatrix, sizeof(Matrix));
+		std::memcpy(m_CachedMatrices[1], &worldViewProjMatrix, sizeof(Matrix));
+		return m_Output;
+	}
+
+	void VertexProcessor::TransformScalar(const Vertex* pVertices, size_t begin, size_t end, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix)
+	{
+		float* pStreams[TransformedVertices::NumStreams]{};
+		for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+			pStreams[stream] = m_Output.streams[stream].data();
+		uint8_t* pClipCodes = m_Output.clipCodes.data();
+		for (size_t index{ begin }; index < end; ++index)
+		{
+			const Vertex& vertex = pVertices[index];
+			const Vector4 position = worldViewProjMatrix.TransformPoint(Vector4{ vertex.position, 1.f });
+			const Vector3 normal = worldMatrix.TransformVector(vertex.normal.Normalized());
+			const Vector3 tangent = worldMatrix.TransformVector(vertex.tangent.Normalized());
+			const Vector3 worldPosition = worldMatrix.TransformPoint(vertex.position);
+			const float values[TransformedVertices::NumStreams]{ position.x, position.y, position.z, position.w, vertex.uv.x, vertex.uv.y, normal.x, normal.y, normal.z,
+				tangent.x, tangent.y, tangent.z, worldPosition.x, worldPosition.y, worldPosition.z };
+			for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+				pStreams[stream][index] = values[stream];
+			pClipCodes[index] = GetClipCode(position);
+		}
+	}
+
+	DAE_TARGET_AVX2 void VertexProcessor::TransformAVX(const Vertex* pVertices, size_t numVertices, size_t begin, size_t end, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix)
+	{
+		static_assert(sizeof(Vertex) == 11 * sizeof(float));
+		const MatrixAVX world{ worldMatrix };
+		const MatrixAVX worldViewProj{ worldViewProjMatrix };
+		//Where the 8 vertices of a block start, in floats
+		const __m256i offsets = _mm256_setr_epi32(0, 11, 22, 33, 44, 55, 66, 77);
+		auto& streams = m_Output.streams;
+
+		for (size_t first{ begin }; first < end; first += 8)
+		{
+			//The last block reads a copy padded with zeros
+			const Vertex* pBlock = pVertices + first;
+			Vertex padded[8]{};
+			if (first + 8 > numVertices)
+			{
+				std::copy(pVertices + first, pVertices + numVertices, padded);
+				pBlock = padded;
+			}
+			const float* pFloats = reinterpret_cast<const float*>(pBlock);
+			const auto gather = [pFloats, offsets](int member) DAE_TARGET_AVX2 { return _mm256_i32gather_ps(pFloats + member, offsets, 4); };
+			const __m256 positionX = gather(0), positionY = gather(1), positionZ = gather(2);
+
+			__m256 results[TransformedVertices::NumStreams];
+			for (int column{}; column < 4; ++column)
+				results[TransformedVertices::PositionX + column] = worldViewProj.TransformPoint(column, positionX, positionY, positionZ);
+			results[TransformedVertices::U] = gather(3);
+			results[TransformedVertices::V] = gather(4);
+
+			//Vector3::Normalized: divided by sqrtf(x * x + y * y + z * z)
+			for (int vector{}; vector < 2; ++vector)
+			{
+				const int member{ 5 + vector * 3 };
+				const __m256 x = gather(member), y = gather(member + 1), z = gather(member + 2);
+				const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+				const __m256 normalizedX = _mm256_div_ps(x, length), normalizedY = _mm256_div_ps(y, length), normalizedZ = _mm256_div_ps(z, length);
+				for (int column{}; column < 3; ++column)
+					results[TransformedVertices::NormalX + vector * 3 + column] = world.TransformVector(column, normalizedX, normalizedY, normalizedZ);
+			}
+			for (int column{}; column < 3; ++column)
+				results[TransformedVertices::WorldX + column] = world.TransformPoint(column, positionX, positionY, positionZ);
+
+			for (int stream{}; stream < TransformedVertices::NumStreams; ++stream)
+				_mm256_storeu_ps(&streams[stream][first], results[stream]);
+
+			//A lane mask per plane, then a byte per vertex
+			const __m256 x = results[TransformedVertices::PositionX], y = results[TransformedVertices::PositionY];
+			const __m256 z = results[TransformedVertices::PositionZ], w = results[TransformedVertices::PositionW];
+			const __m256 negativeW = _mm256_sub_ps(_mm256_setzero_ps(), w);
+			const uint32_t planeMasks[6]{
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(x, negativeW, _CMP_LT_OQ))),
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(x, w, _CMP_GT_OQ))),
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(y, negativeW, _CMP_LT_OQ))),
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(y, w, _CMP_GT_OQ))),
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_LE_OQ), _mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ)))),
+				static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(z, w, _CMP_GT_OQ))) };
+			for (int lane{}; lane < 8; ++lane)
+			{
+				uint8_t code{};
+				for (int plane{}; plane < 6; ++plane)
+					code |= static_cast<uint8_t>(((planeMasks[plane] >> lane) & 1) << plane);
+				m_Output.clipCodes[first + lane] = code;
+			}
+		}
+	}
+}
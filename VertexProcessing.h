@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Datatypes.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	//Outcodes of a clip space position, a bit per frustum plane it lies outside of. A triangle whose corners share a bit is invisible.
+	enum ClipCode : uint8_t
+	{
+		ClipLeft = 1 << 0,
+		ClipRight = 1 << 1,
+		ClipBottom = 1 << 2,
+		ClipTop = 1 << 3,
+		//In front of the near plane or behind the eye, z < 0 or w <= 0. A reversed projection swaps the planes, the bits still cover
+		//behind the eye and both get clipped against.
+		ClipNear = 1 << 4,
+		ClipFar = 1 << 5
+	};
+
+	//VS_OUTPUT of PosCol3D.fx for a whole vertex buffer as structure of arrays, each stream padded to a multiple of 8 vertices
+	struct TransformedVertices
+	{
+		enum Stream
+		{
+			//Clip space
+			PositionX, PositionY, PositionZ, PositionW,
+			U, V,
+			//World space
+			NormalX, NormalY, NormalZ,
+			TangentX, TangentY, TangentZ,
+			WorldX, WorldY, WorldZ,
+			NumStreams
+		};
+
+		//Into buffer, see VertexProcessor::Process
+		std::span<float> streams[NumStreams]{};
+		std::vector<uint8_t> clipCodes{};
+		size_t numVertices{};
+		std::vector<float> buffer{};
+
+		TransformedVertices() = default;
+		//The streams point into the buffer
+		TransformedVertices(const TransformedVertices&) = delete;
+		TransformedVertices& operator=(const TransformedVertices&) = delete;
+
+		Vector4 GetPosition(size_t index) const
+		{
+			return { streams[PositionX][index], streams[PositionY][index], streams[PositionZ][index], streams[PositionW][index] };
+		}
+
+		Vertex_Out Get(size_t index) const
+		{
+			Vertex_Out vertex{};
+			vertex.position = GetPosition(index);
+			vertex.uv = { streams[U][index], streams[V][index] };
+			vertex.normal = { streams[NormalX][index], streams[NormalY][index], streams[NormalZ][index] };
+			vertex.tangent = { streams[TangentX][index], streams[TangentY][index], streams[TangentZ][index] };
+			vertex.worldPosition = { streams[WorldX][index], streams[WorldY][index], streams[WorldZ][index] };
+			return vertex;
+		}
+	};
+
+	//VS_MAIN of PosCol3D.fx over a vertex buffer: positions by the world-view-projection matrix, normals and tangents normalized and by
+	//the world matrix, clip codes in the same pass. 8 vertices at a time with AVX2, in chunks over the thread pool when there is one.
+	//The results are the same as Matrix::TransformPoint/TransformVector's to the bit. Processing the same vertices with the same
+	//matrices again returns the last results.
+	class VertexProcessor final
+	{
+	public:
+		struct Stats
+		{
+			uint64_t numTransformed{};
+			uint32_t numCalls{};
+			uint32_t numCacheHits{};
+		};
+
+		//Starts on AVX2 when the CPU has it
+		VertexProcessor(ThreadPool* pThreadPool = nullptr);
+
+		//The span is the cache key, vertices mustn't change in place while they're cached
+		const TransformedVertices& Process(std::span<const Vertex> vertices, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix);
+		//The next Process transforms again
+		void Invalidate() { m_IsCached = false; };
+
+		//One vertex at a time when off, for comparison and CPUs without AVX2
+		void SetSIMD(bool isEnabled) { m_IsSIMDEnabled = isEnabled; };
+		bool IsSIMDEnabled() const { return m_IsSIMDEnabled; };
+		const Stats& GetStats() const { return m_Stats; };
+
+	private:
+		//Vertices a thread takes at least, a multiple of 8
+		static constexpr size_t m_MinChunkSize{ 1024 };
+
+		ThreadPool* m_pThreadPool{};
+		bool m_IsSIMDEnabled{};
+		TransformedVertices m_Output{};
+		Stats m_Stats{};
+
+		bool m_IsCached{};
+		const Vertex* m_pCachedVertices{};
+		size_t m_NumCachedVertices{};
+		//World then world-view-projection, as raw floats so they are compared and stored without Matrix's copy semantics
+		float m_CachedMatrices[2][16]{};
+
+		void TransformScalar(const Vertex* pVertices, size_t begin, size_t end, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix);
+		//begin is a multiple of 8, vertices past the end of the buffer are padding
+		void TransformAVX(const Vertex* pVertices, size_t numVertices, size_t begin, size_t end, const Matrix& worldMatrix, const Matrix& worldViewProjMatrix);
+	};
+}
@@ -6,6 +6,7 @@
 
 #undef main
 #include "Renderer.h"
+#include "Benchmark.h"
 
 using namespace dae;
 
@@ -17,9 +18,15 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Headless benchmarks, no window needed. DirectXBenchmark from CMakeLists.txt runs them without SDL or D3D11.
+	if (argc > 2 && std::string{ args[1] } == "--benchmark")
+	{
+		const std::vector<std::string> arguments(args + 2, args + argc);
+		return Benchmark::Run(arguments) ? 0 : 1;
+	}
+
+	//--software renders on the CPU instead of through D3D11
+	const bool isSoftware = argc > 1 && std::string{ args[1] } == "--software";
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -38,7 +45,7 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = new Renderer(pWindow, isSoftware ? Renderer::Backend::Software : Renderer::Backend::DirectX);
 
 	//Start loop
 	pTimer->Start();
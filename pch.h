@@ -7,6 +7,8 @@
 #include <memory>
 #define NOMINMAX  //for directx
 
+//Defined by CMakeLists.txt, which builds only the files that need neither SDL nor D3D11
+#ifndef DAE_CPU_ONLY
 // SDL Headers
 #include "SDL.h"
 #include "SDL_syswm.h"
@@ -18,6 +20,7 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif
 
 // Framework Headers
 #include "Timer.h"